@@ -0,0 +1,199 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "dary-heap-scheduler.h"
+#include "event-impl.h"
+#include "assert.h"
+#include "log.h"
+#include <algorithm>
+#include <cstring>
+#include <new>
+
+/**
+ * \file
+ * \ingroup scheduler
+ * Implementation of ns3::DaryHeapScheduler class.
+ */
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("DaryHeapScheduler");
+
+NS_OBJECT_ENSURE_REGISTERED (DaryHeapScheduler);
+
+TypeId
+DaryHeapScheduler::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::DaryHeapScheduler")
+    .SetParent<Scheduler> ()
+    .SetGroupName ("Core")
+    .AddConstructor<DaryHeapScheduler> ()
+  ;
+  return tid;
+}
+
+DaryHeapScheduler::DaryHeapScheduler ()
+  : m_heap (0),
+    m_storage (0),
+    m_end (ROOT),
+    m_capacity (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+DaryHeapScheduler::~DaryHeapScheduler ()
+{
+  NS_LOG_FUNCTION (this);
+  ::operator delete (m_storage);
+}
+
+void
+DaryHeapScheduler::Grow (void)
+{
+  NS_LOG_FUNCTION (this);
+  uint32_t capacity = std::max<uint32_t> (2 * m_capacity, 16 * ARITY);
+  void *storage = ::operator new (capacity * sizeof (Event) + CACHE_LINE_SIZE - 1);
+  uintptr_t address = reinterpret_cast<uintptr_t> (storage);
+  address = (address + CACHE_LINE_SIZE - 1) & ~static_cast<uintptr_t> (CACHE_LINE_SIZE - 1);
+  Event *heap = reinterpret_cast<Event *> (address);
+  if (m_heap != 0)
+    {
+      std::memcpy (heap + ROOT, m_heap + ROOT, (m_end - ROOT) * sizeof (Event));
+    }
+  ::operator delete (m_storage);
+  m_storage = storage;
+  m_heap = heap;
+  m_capacity = capacity;
+}
+
+void
+DaryHeapScheduler::SiftUp (uint32_t index, const Event &ev)
+{
+  while (index > ROOT)
+    {
+      uint32_t parent = (index - ROOT - 1) / ARITY + ROOT;
+      if (!(ev < m_heap[parent]))
+        {
+          break;
+        }
+      m_heap[index] = m_heap[parent];
+      index = parent;
+    }
+  m_heap[index] = ev;
+}
+
+void
+DaryHeapScheduler::SiftDown (uint32_t index, const Event &ev)
+{
+  while (true)
+    {
+      uint32_t first = (index - ROOT) * ARITY + ROOT + 1;
+      if (first >= m_end)
+        {
+          break;
+        }
+      uint32_t last = std::min (first + ARITY, m_end);
+      uint32_t smallest = first;
+      for (uint32_t child = first + 1; child < last; child++)
+        {
+          if (m_heap[child] < m_heap[smallest])
+            {
+              smallest = child;
+            }
+        }
+      if (!(m_heap[smallest] < ev))
+        {
+          break;
+        }
+      m_heap[index] = m_heap[smallest];
+      index = smallest;
+    }
+  m_heap[index] = ev;
+}
+
+void
+DaryHeapScheduler::Insert (const Event &ev)
+{
+  NS_LOG_FUNCTION (this << ev.impl << ev.key.m_ts << ev.key.m_uid);
+  if (m_end >= m_capacity)
+    {
+      Grow ();
+    }
+  m_end++;
+  SiftUp (m_end - 1, ev);
+}
+
+bool
+DaryHeapScheduler::IsEmpty (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return m_end == ROOT;
+}
+
+Scheduler::Event
+DaryHeapScheduler::PeekNext (void) const
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT (!IsEmpty ());
+  return m_heap[ROOT];
+}
+
+Scheduler::Event
+DaryHeapScheduler::RemoveNext (void)
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT (!IsEmpty ());
+  Event next = m_heap[ROOT];
+  m_end--;
+  if (m_end > ROOT)
+    {
+      Event last = m_heap[m_end];
+      SiftDown (ROOT, last);
+    }
+  return next;
+}
+
+void
+DaryHeapScheduler::Remove (const Event &ev)
+{
+  NS_LOG_FUNCTION (this << ev.impl << ev.key.m_ts << ev.key.m_uid);
+  uint32_t uid = ev.key.m_uid;
+  for (uint32_t i = ROOT; i < m_end; i++)
+    {
+      if (uid == m_heap[i].key.m_uid)
+        {
+          NS_ASSERT (m_heap[i].impl == ev.impl);
+          m_end--;
+          Event last = m_heap[m_end];
+          if (i < m_end)
+            {
+              // the last event may have to move either up or down
+              if (i > ROOT && last < m_heap[(i - ROOT - 1) / ARITY + ROOT])
+                {
+                  SiftUp (i, last);
+                }
+              else
+                {
+                  SiftDown (i, last);
+                }
+            }
+          return;
+        }
+    }
+  NS_ASSERT (false);
+}
+
+} // namespace ns3
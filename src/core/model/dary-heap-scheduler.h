@@ -0,0 +1,114 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef DARY_HEAP_SCHEDULER_H
+#define DARY_HEAP_SCHEDULER_H
+
+#include "scheduler.h"
+#include <stdint.h>
+
+/**
+ * \file
+ * \ingroup scheduler
+ * ns3::DaryHeapScheduler declaration.
+ */
+
+namespace ns3 {
+
+/**
+ * \ingroup scheduler
+ * \brief a d-ary heap event scheduler
+ *
+ * This scheduler stores the events in an implicit heap in which every
+ * node has ARITY (4) children. Compared to the binary heap of the
+ * HeapScheduler, the heap is half as deep, hence inserting an event
+ * moves half as many events, and removing the next event visits half
+ * as many levels, each of which compares the keys of ARITY contiguous
+ * children, which are likely to share the same cache lines.
+ *
+ * The storage of the events is aligned on a cache line, and the root is
+ * stored at index ARITY - 1, so that the children of every node start at
+ * a multiple of ARITY: the ARITY children of a node (4 events of 24
+ * bytes) then span two cache lines, never three.
+ *
+ * Events are moved into a hole rather than swapped, and the hole left
+ * by the removal of an arbitrary event (Remove) is filled by the last
+ * event of the heap, which is moved either up or down as required.
+ * Remove has to search for the event, hence it takes linear time.
+ */
+class DaryHeapScheduler : public Scheduler
+{
+public:
+  /**
+   *  Register this type.
+   *  \return The object TypeId.
+   */
+  static TypeId GetTypeId (void);
+
+  /** Constructor. */
+  DaryHeapScheduler ();
+  /** Destructor. */
+  virtual ~DaryHeapScheduler ();
+
+  // Inherited
+  virtual void Insert (const Scheduler::Event &ev);
+  virtual bool IsEmpty (void) const;
+  virtual Scheduler::Event PeekNext (void) const;
+  virtual Scheduler::Event RemoveNext (void);
+  virtual void Remove (const Scheduler::Event &ev);
+
+private:
+  /** Number of children of every node. */
+  static const uint32_t ARITY = 4;
+  /** Index of the root, so that every group of children starts at a multiple of ARITY. */
+  static const uint32_t ROOT = ARITY - 1;
+  /** Alignment of the storage of the events. */
+  static const uint32_t CACHE_LINE_SIZE = 64;
+
+  /**
+   * Move an event up the heap, starting from the given position, until
+   * its parent is smaller than it.
+   *
+   * \param [in] index The position of the hole the event is moved from.
+   * \param [in] ev The event.
+   */
+  void SiftUp (uint32_t index, const Scheduler::Event &ev);
+  /**
+   * Move an event down the heap, starting from the given position, until
+   * all of its children are greater than it.
+   *
+   * \param [in] index The position of the hole the event is moved from.
+   * \param [in] ev The event.
+   */
+  void SiftDown (uint32_t index, const Scheduler::Event &ev);
+  /**
+   * Double the number of events the storage can hold.
+   */
+  void Grow (void);
+
+  /** The event list, managed as a heap rooted at index ROOT. */
+  Scheduler::Event *m_heap;
+  /** The block holding m_heap, which is aligned within it. */
+  void *m_storage;
+  /** Index following the last event of the heap. */
+  uint32_t m_end;
+  /** Number of events, padding included, the storage can hold. */
+  uint32_t m_capacity;
+};
+
+} // namespace ns3
+
+#endif /* DARY_HEAP_SCHEDULER_H */
@@ -58,6 +58,8 @@ DefaultSimulatorImpl::GetTypeId (void)
 }
 
 DefaultSimulatorImpl::DefaultSimulatorImpl ()
+  : m_eventsWithContext (EVENTS_WITH_CONTEXT_CAPACITY),
+    m_eventsWithContextOverflowing (false)
 {
   NS_LOG_FUNCTION (this);
   m_stop = false;
@@ -71,7 +73,6 @@ DefaultSimulatorImpl::DefaultSimulatorImpl ()
   m_currentTs = 0;
   m_currentContext = Simulator::NO_CONTEXT;
   m_unscheduledEvents = 0;
-  m_eventsWithContextEmpty = true;
   m_main = SystemThread::Self();
 }
 
@@ -158,33 +159,60 @@ DefaultSimulatorImpl::IsFinished (void) const
   return m_events->IsEmpty () || m_stop;
 }
 
+void
+DefaultSimulatorImpl::InsertEventWithContext (const EventWithContext &event)
+{
+  Scheduler::Event ev;
+  ev.impl = event.event;
+  ev.key.m_ts = m_currentTs + event.timestamp;
+  ev.key.m_context = event.context;
+  ev.key.m_uid = m_uid;
+  m_uid++;
+  m_unscheduledEvents++;
+  m_events->Insert (ev);
+}
+
 void
 DefaultSimulatorImpl::ProcessEventsWithContext (void)
 {
-  if (m_eventsWithContextEmpty)
+  if (m_eventsWithContext.IsEmpty ()
+      && !m_eventsWithContextOverflowing.load (std::memory_order_relaxed))
     {
       return;
     }
 
-  // swap queues
-  EventsWithContext eventsWithContext;
-  {
-    CriticalSection cs (m_eventsWithContextMutex);
-    m_eventsWithContext.swap(eventsWithContext);
-    m_eventsWithContextEmpty = true;
-  }
-  while (!eventsWithContext.empty ())
+  // drain the lock-free queue first: any event a thread appended to the
+  // overflow list was scheduled after its events in the lock-free queue
+  EventWithContext event;
+  while (m_eventsWithContext.Pop (event))
     {
-       EventWithContext event = eventsWithContext.front ();
-       eventsWithContext.pop_front ();
-       Scheduler::Event ev;
-       ev.impl = event.event;
-       ev.key.m_ts = m_currentTs + event.timestamp;
-       ev.key.m_context = event.context;
-       ev.key.m_uid = m_uid;
-       m_uid++;
-       m_unscheduledEvents++;
-       m_events->Insert (ev);
+      InsertEventWithContext (event);
+    }
+
+  if (m_eventsWithContextOverflowing.load (std::memory_order_acquire))
+    {
+      EventsWithContext eventsWithContext;
+      uint64_t pushed;
+      {
+        CriticalSection cs (m_eventsWithContextMutex);
+        m_eventsWithContextOverflow.swap (eventsWithContext);
+        pushed = m_eventsWithContext.GetPushCount ();
+        m_eventsWithContextOverflowing.store (false, std::memory_order_release);
+      }
+      // the events queued before the overflowed ones may still be being
+      // published by their threads: wait for them
+      while (m_eventsWithContext.GetPopCount () < pushed)
+        {
+          if (m_eventsWithContext.Pop (event))
+            {
+              InsertEventWithContext (event);
+            }
+        }
+      for (EventsWithContext::const_iterator i = eventsWithContext.begin ();
+           i != eventsWithContext.end (); i++)
+        {
+          InsertEventWithContext (*i);
+        }
     }
 }
 
@@ -269,10 +297,17 @@ DefaultSimulatorImpl::ScheduleWithContext (uint32_t context, Time const &delay,
       // Current time added in ProcessEventsWithContext()
       ev.timestamp = delay.GetTimeStep ();
       ev.event = event;
+      if (!m_eventsWithContextOverflowing.load (std::memory_order_acquire)
+          && m_eventsWithContext.Push (ev))
+        {
+          return;
+        }
+      // the queue is full, or previous events overflowed and have not
+      // been processed yet
       {
         CriticalSection cs (m_eventsWithContextMutex);
-        m_eventsWithContext.push_back(ev);
-        m_eventsWithContextEmpty = false;
+        m_eventsWithContextOverflow.push_back (ev);
+        m_eventsWithContextOverflowing.store (true, std::memory_order_release);
       }
     }
 }
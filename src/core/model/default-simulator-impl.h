@@ -26,10 +26,12 @@
 #include "event-impl.h"
 #include "system-thread.h"
 #include "system-mutex.h"
+#include "mpsc-queue.h"
 
 #include "ptr.h"
 
 #include <list>
+#include <atomic>
 
 /**
  * \file
@@ -85,7 +87,7 @@ private:
   void ProcessOneEvent (void);
   /** Move events from a different context into the main event queue. */
   void ProcessEventsWithContext (void);
- 
+
   /** Wrap an event with its execution context. */
   struct EventWithContext {
     /** The event context. */
@@ -95,16 +97,33 @@ private:
     /** The event implementation. */
     EventImpl *event;
   };
+  /**
+   * Insert an event from a different context into the main event queue.
+   * \param [in] event The event with its context.
+   */
+  void InsertEventWithContext (const struct EventWithContext &event);
+
+  /** Capacity of the queue of events from a different context. */
+  static const uint32_t EVENTS_WITH_CONTEXT_CAPACITY = 1024;
+  /**
+   * The lock-free queue of events from a different context, filled by
+   * the other threads and drained by the main thread.
+   */
+  MpscQueue<struct EventWithContext> m_eventsWithContext;
   /** Container type for the events from a different context. */
   typedef std::list<struct EventWithContext> EventsWithContext;
-  /** The container of events from a different context. */
-  EventsWithContext m_eventsWithContext;
   /**
-   * Flag \c true if all events with context have been moved to the
-   * primary event queue.
+   * The container of events from a different context which did not fit
+   * in m_eventsWithContext.
+   */
+  EventsWithContext m_eventsWithContextOverflow;
+  /**
+   * Flag \c true if m_eventsWithContextOverflow holds events. While set,
+   * the other threads append to m_eventsWithContextOverflow, so that the
+   * events from each thread are processed in the order they are scheduled.
    */
-  bool m_eventsWithContextEmpty;
-  /** Mutex to control access to the list of events with context. */
+  std::atomic<bool> m_eventsWithContextOverflowing;
+  /** Mutex to control access to the list of overflowed events with context. */
   SystemMutex m_eventsWithContextMutex;
 
   /** Container type for the events to run at Simulator::Destroy() */
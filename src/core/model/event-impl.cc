@@ -20,6 +20,8 @@
 
 #include "event-impl.h"
 #include "log.h"
+#include <atomic>
+#include <new>
 
 /**
  * \file
@@ -31,6 +33,164 @@ namespace ns3 {
 
 NS_LOG_COMPONENT_DEFINE ("EventImpl");
 
+namespace {
+
+class EventPool;
+
+/**
+ * \ingroup events
+ * Header stored in front of every event allocated by EventImpl::operator new.
+ */
+struct EventHeader
+{
+  EventPool *pool;     //!< The pool owning the block, or 0 if the block comes from the global heap
+  uint32_t sizeClass;  //!< The size class of the block
+};
+
+/**
+ * \ingroup events
+ * Size of the event header, rounded up so that events keep the alignment
+ * provided by the global operator new.
+ */
+const std::size_t HEADER_SIZE = 16;
+
+/**
+ * \ingroup events
+ * Pool of the blocks holding the events created by a thread.
+ *
+ * Blocks are carved from slabs and have the size of a multiple of GRANULARITY
+ * bytes (header included). Each size class has a free list, which only the
+ * owning thread accesses, and a list of the blocks freed by other threads,
+ * which is a lock-free stack the owning thread takes all at once when its
+ * free list is empty.
+ *
+ * Slabs are never released: the memory held by a pool is bounded by the peak
+ * number of events the thread had alive at the same time. A pool is never
+ * deleted either, because its blocks may outlive the thread that owns it.
+ */
+class EventPool
+{
+public:
+  static const uint32_t GRANULARITY = 16;     //!< Size of the blocks is a multiple of this
+  static const uint32_t N_SIZE_CLASSES = 16;  //!< Number of size classes
+  static const uint32_t SLAB_SIZE = 16384;    //!< Size of the slabs blocks are carved from
+
+  EventPool ();
+
+  /**
+   * \param [in] size The size of the block, header included.
+   * \returns The size class of the block, or N_SIZE_CLASSES if too large.
+   */
+  static uint32_t GetSizeClass (std::size_t size);
+  /**
+   * \param [in] sizeClass The size class.
+   * \returns A block of the given size class.
+   */
+  void * Allocate (uint32_t sizeClass);
+  /**
+   * Give a block back to the pool from the owning thread.
+   * \param [in] block The block.
+   * \param [in] sizeClass The size class of the block.
+   */
+  void Free (void *block, uint32_t sizeClass);
+  /**
+   * Give a block back to the pool from a thread other than the owning thread.
+   * \param [in] block The block.
+   * \param [in] sizeClass The size class of the block.
+   */
+  void FreeRemote (void *block, uint32_t sizeClass);
+
+private:
+  /** A free block. */
+  struct FreeBlock
+  {
+    FreeBlock *next;  //!< The next free block
+  };
+
+  /**
+   * Carve a new slab into blocks of the given size class.
+   * \param [in] sizeClass The size class.
+   */
+  void Refill (uint32_t sizeClass);
+
+  FreeBlock *m_free[N_SIZE_CLASSES];                 //!< Blocks freed by the owning thread
+  std::atomic<FreeBlock *> m_remote[N_SIZE_CLASSES]; //!< Blocks freed by other threads
+};
+
+EventPool::EventPool ()
+{
+  for (uint32_t i = 0; i < N_SIZE_CLASSES; i++)
+    {
+      m_free[i] = 0;
+      m_remote[i].store (0, std::memory_order_relaxed);
+    }
+}
+
+uint32_t
+EventPool::GetSizeClass (std::size_t size)
+{
+  std::size_t sizeClass = (size - 1) / GRANULARITY;
+  return (sizeClass < N_SIZE_CLASSES) ? static_cast<uint32_t> (sizeClass) : N_SIZE_CLASSES;
+}
+
+void *
+EventPool::Allocate (uint32_t sizeClass)
+{
+  if (m_free[sizeClass] == 0)
+    {
+      m_free[sizeClass] = m_remote[sizeClass].exchange (0, std::memory_order_acquire);
+      if (m_free[sizeClass] == 0)
+        {
+          Refill (sizeClass);
+        }
+    }
+  FreeBlock *block = m_free[sizeClass];
+  m_free[sizeClass] = block->next;
+  return block;
+}
+
+void
+EventPool::Free (void *block, uint32_t sizeClass)
+{
+  FreeBlock *freeBlock = static_cast<FreeBlock *> (block);
+  freeBlock->next = m_free[sizeClass];
+  m_free[sizeClass] = freeBlock;
+}
+
+void
+EventPool::FreeRemote (void *block, uint32_t sizeClass)
+{
+  FreeBlock *freeBlock = static_cast<FreeBlock *> (block);
+  freeBlock->next = m_remote[sizeClass].load (std::memory_order_relaxed);
+  while (!m_remote[sizeClass].compare_exchange_weak (freeBlock->next, freeBlock,
+                                                     std::memory_order_release,
+                                                     std::memory_order_relaxed))
+    {
+    }
+}
+
+void
+EventPool::Refill (uint32_t sizeClass)
+{
+  std::size_t blockSize = (sizeClass + 1) * GRANULARITY;
+  std::size_t nBlocks = SLAB_SIZE / blockSize;
+  char *slab = static_cast<char *> (::operator new (nBlocks * blockSize));
+  NS_LOG_LOGIC ("new slab of " << nBlocks << " blocks of " << blockSize << " bytes");
+
+  for (std::size_t i = nBlocks; i > 0; i--)
+    {
+      Free (slab + (i - 1) * blockSize, sizeClass);
+    }
+}
+
+/** Whether events are allocated from the pools. */
+bool g_poolEnabled = true;
+
+/** The pool of the calling thread, created on first use. */
+thread_local EventPool *t_pool = 0;
+
+} // unnamed namespace
+
 EventImpl::~EventImpl ()
 {
   NS_LOG_FUNCTION (this);
@@ -66,4 +226,62 @@ EventImpl::IsCancelled (void)
   return m_cancel;
 }
 
+void *
+EventImpl::operator new (std::size_t size)
+{
+  static_assert (sizeof (EventHeader) <= HEADER_SIZE, "The event header does not fit");
+
+  uint32_t sizeClass = EventPool::GetSizeClass (size + HEADER_SIZE);
+  EventHeader *header;
+
+  if (g_poolEnabled && sizeClass < EventPool::N_SIZE_CLASSES)
+    {
+      if (t_pool == 0)
+        {
+          t_pool = new EventPool ();
+        }
+      header = static_cast<EventHeader *> (t_pool->Allocate (sizeClass));
+      header->pool = t_pool;
+    }
+  else
+    {
+      header = static_cast<EventHeader *> (::operator new (size + HEADER_SIZE));
+      header->pool = 0;
+    }
+  header->sizeClass = sizeClass;
+  return reinterpret_cast<char *> (header) + HEADER_SIZE;
+}
+
+void
+EventImpl::operator delete (void *p)
+{
+  if (p == 0)
+    {
+      return;
+    }
+
+  EventHeader *header = reinterpret_cast<EventHeader *> (static_cast<char *> (p) - HEADER_SIZE);
+  EventPool *pool = header->pool;
+
+  if (pool == 0)
+    {
+      ::operator delete (header);
+    }
+  else if (pool == t_pool)
+    {
+      pool->Free (header, header->sizeClass);
+    }
+  else
+    {
+      pool->FreeRemote (header, header->sizeClass);
+    }
+}
+
+void
+EventImpl::EnablePool (bool enable)
+{
+  NS_LOG_FUNCTION (enable);
+  g_poolEnabled = enable;
+}
+
 } // namespace ns3
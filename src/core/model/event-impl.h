@@ -21,6 +21,7 @@
 #define EVENT_IMPL_H
 
 #include <stdint.h>
+#include <cstddef>
 #include "simple-ref-count.h"
 
 /**
@@ -40,6 +41,12 @@ namespace ns3 {
  * when it reaches the time associated to this event. Most subclasses
  * are usually created by one of the many Simulator::Schedule
  * methods.
+ *
+ * Events are allocated from per-thread pools of fixed size blocks,
+ * one pool per block size, which recycle the memory of the events
+ * destroyed without going through the global allocator. The memory
+ * of an event destroyed by a thread other than the one that created
+ * it is handed back to the pool of the creating thread.
  */
 class EventImpl : public SimpleRefCount<EventImpl>
 {
@@ -66,6 +73,25 @@ public:
    */
   bool IsCancelled (void);
 
+  /**
+   * Allocate the memory for an event from the pool of the calling thread.
+   * \param [in] size The size of the event.
+   * \returns The memory for the event.
+   */
+  static void * operator new (std::size_t size);
+  /**
+   * Give the memory of an event back to the pool it was allocated from.
+   * \param [in] p The memory of the event.
+   */
+  static void operator delete (void *p);
+  /**
+   * Enable or disable the event pools. When disabled, the events which
+   * are created afterwards are allocated with the global operator new.
+   * The pools are enabled by default.
+   * \param [in] enable Whether the events are allocated from the pools.
+   */
+  static void EnablePool (bool enable);
+
 protected:
   /**
    * Implementation for Invoke().
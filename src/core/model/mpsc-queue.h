@@ -0,0 +1,219 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#ifndef MPSC_QUEUE_H
+#define MPSC_QUEUE_H
+
+#include "assert.h"
+#include <stdint.h>
+#include <atomic>
+
+/**
+ * \file
+ * \ingroup thread
+ * ns3::MpscQueue class template declaration.
+ */
+
+namespace ns3 {
+
+/**
+ * \ingroup thread
+ *
+ * \brief Bounded lock-free queue with multiple producers and a single consumer.
+ *
+ * The queue is a ring of cells, each holding an item and a sequence number
+ * which tells whether the cell is free for the producer claiming the given
+ * position or holds an item for the consumer. Producers claim a position with
+ * a compare-and-swap and then publish their item by updating the sequence
+ * number of the cell, hence Push never blocks nor allocates memory. Items
+ * pushed by the same thread are popped in the same order.
+ *
+ * Push can be called by any thread, while Pop and IsEmpty must only be
+ * called by a single (consumer) thread at a time.
+ *
+ * \tparam T \deduced The type of the items, which must be copy assignable.
+ */
+template <typename T>
+class MpscQueue
+{
+public:
+  /**
+   * Create a queue with the given capacity.
+   * \param [in] capacity The maximum number of items, which must be a power of two.
+   */
+  MpscQueue (uint32_t capacity);
+  ~MpscQueue ();
+
+  /**
+   * Append an item to the queue.
+   * \param [in] item The item.
+   * \returns false if the queue is full and the item was not appended.
+   */
+  bool Push (const T &item);
+
+  /**
+   * Remove the item at the head of the queue.
+   * \param [out] item The item removed.
+   * \returns false if no item is available.
+   */
+  bool Pop (T &item);
+
+  /**
+   * \returns true if no item is available to the consumer.
+   */
+  bool IsEmpty (void) const;
+
+  /**
+   * \returns The number of positions claimed by the producers so far,
+   *          including the items not yet published.
+   */
+  uint64_t GetPushCount (void) const;
+
+  /**
+   * \returns The number of items popped so far.
+   */
+  uint64_t GetPopCount (void) const;
+
+private:
+  /**
+   * Copy constructor.
+   * Defined and unimplemented to avoid misuse.
+   */
+  MpscQueue (const MpscQueue &);
+  /**
+   * Assignment operator.
+   * Defined and unimplemented to avoid misuse.
+   * \returns The queue.
+   */
+  MpscQueue & operator = (const MpscQueue &);
+
+  /** A cell of the ring. */
+  struct Cell
+  {
+    std::atomic<uint64_t> sequence;  //!< The position the cell is ready for
+    T item;                          //!< The item stored in the cell
+  };
+
+  Cell *m_cells;                         //!< The ring of cells
+  uint64_t m_mask;                       //!< The capacity minus one
+  char m_pad0[64];                       //!< Keep the producer position on its own cache line
+  std::atomic<uint64_t> m_enqueuePos;    //!< The next position claimed by producers
+  char m_pad1[64];                       //!< Keep the consumer position on its own cache line
+  uint64_t m_dequeuePos;                 //!< The next position read by the consumer
+};
+
+} // namespace ns3
+
+
+/***************************************************************
+ *  Implementation of the templates declared above.
+ ***************************************************************/
+
+namespace ns3 {
+
+template <typename T>
+MpscQueue<T>::MpscQueue (uint32_t capacity)
+  : m_cells (new Cell[capacity]),
+    m_mask (capacity - 1),
+    m_enqueuePos (0),
+    m_dequeuePos (0)
+{
+  NS_ASSERT_MSG (capacity > 0 && (capacity & (capacity - 1)) == 0,
+                 "The capacity must be a power of two");
+  for (uint32_t i = 0; i < capacity; i++)
+    {
+      m_cells[i].sequence.store (i, std::memory_order_relaxed);
+    }
+}
+
+template <typename T>
+MpscQueue<T>::~MpscQueue ()
+{
+  delete [] m_cells;
+}
+
+template <typename T>
+bool
+MpscQueue<T>::Push (const T &item)
+{
+  uint64_t pos = m_enqueuePos.load (std::memory_order_relaxed);
+  while (true)
+    {
+      Cell &cell = m_cells[pos & m_mask];
+      uint64_t sequence = cell.sequence.load (std::memory_order_acquire);
+      int64_t diff = static_cast<int64_t> (sequence - pos);
+      if (diff == 0)
+        {
+          // the cell is free: try to claim the position
+          if (m_enqueuePos.compare_exchange_weak (pos, pos + 1, std::memory_order_relaxed))
+            {
+              cell.item = item;
+              cell.sequence.store (pos + 1, std::memory_order_release);
+              return true;
+            }
+        }
+      else if (diff < 0)
+        {
+          // the cell still holds the item pushed one lap before
+          return false;
+        }
+      else
+        {
+          // another producer claimed the position
+          pos = m_enqueuePos.load (std::memory_order_relaxed);
+        }
+    }
+}
+
+template <typename T>
+bool
+MpscQueue<T>::Pop (T &item)
+{
+  Cell &cell = m_cells[m_dequeuePos & m_mask];
+  if (cell.sequence.load (std::memory_order_acquire) != m_dequeuePos + 1)
+    {
+      return false;
+    }
+  item = cell.item;
+  cell.sequence.store (m_dequeuePos + m_mask + 1, std::memory_order_release);
+  m_dequeuePos++;
+  return true;
+}
+
+template <typename T>
+bool
+MpscQueue<T>::IsEmpty (void) const
+{
+  const Cell &cell = m_cells[m_dequeuePos & m_mask];
+  return (cell.sequence.load (std::memory_order_acquire) != m_dequeuePos + 1);
+}
+
+template <typename T>
+uint64_t
+MpscQueue<T>::GetPushCount (void) const
+{
+  return m_enqueuePos.load (std::memory_order_relaxed);
+}
+
+template <typename T>
+uint64_t
+MpscQueue<T>::GetPopCount (void) const
+{
+  return m_dequeuePos;
+}
+
+} // namespace ns3
+
+#endif /* MPSC_QUEUE_H */
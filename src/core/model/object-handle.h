@@ -0,0 +1,165 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#ifndef OBJECT_HANDLE_H
+#define OBJECT_HANDLE_H
+
+#include "object.h"
+#include "assert.h"
+
+/**
+ * \file
+ * \ingroup object
+ * ns3::ObjectHandle class template declaration.
+ */
+
+namespace ns3 {
+
+/**
+ * \ingroup object
+ *
+ * \brief Cached result of a GetObject lookup.
+ *
+ * Object::GetObject has to search the aggregation for an object of the
+ * requested type, which is too expensive for code that repeats the same lookup
+ * for every packet. An ObjectHandle performs the lookup once and then gives
+ * access to the object found with a pointer load.
+ *
+ * Objects can be aggregated but never removed from an aggregation, and an
+ * aggregation cannot hold two objects of the same type. Hence, once an object
+ * is found, the handle remains valid as long as the aggregation exists. If no
+ * object is found, the lookup is repeated on the next call to Get, because an
+ * object of the requested type may be aggregated later on.
+ *
+ * The handle holds a reference to the object found, hence it must be reset
+ * (e.g., in DoDispose) if the object holding the handle may be referenced by
+ * the object found.
+ *
+ * \tparam T \deduced The type of the object to look up.
+ */
+template <typename T>
+class ObjectHandle
+{
+public:
+  /** Create a handle that does not refer to any object. */
+  ObjectHandle ();
+
+  /**
+   * \brief Look up an object of type T in the aggregation of the given object.
+   * \param [in] source The object whose aggregation is searched.
+   * \returns true if an object of type T was found.
+   */
+  bool Resolve (Ptr<const Object> source);
+
+  /**
+   * \brief Get the object of type T aggregated to the given object, looking
+   *        it up only if the handle was not resolved against the same object.
+   * \param [in] source The object whose aggregation is searched.
+   * \returns The object of type T, or 0 if there is none.
+   */
+  Ptr<T> Get (Ptr<const Object> source);
+
+  /**
+   * \returns The object found by the last lookup, or 0 if none was found.
+   */
+  Ptr<T> Get (void) const;
+
+  /**
+   * \returns A pointer to the object found by the last lookup, which must exist.
+   */
+  T * operator -> () const;
+
+  /**
+   * \returns true if the last lookup found an object.
+   */
+  bool IsResolved (void) const;
+
+  /** Release the object found, if any. */
+  void Reset (void);
+
+private:
+  const Object *m_source;  //!< The object the handle was last resolved against
+  Ptr<T> m_object;         //!< The object found by the last lookup
+};
+
+} // namespace ns3
+
+
+/***************************************************************
+ *  Implementation of the templates declared above.
+ ***************************************************************/
+
+namespace ns3 {
+
+template <typename T>
+ObjectHandle<T>::ObjectHandle ()
+  : m_source (0),
+    m_object (0)
+{
+}
+
+template <typename T>
+bool
+ObjectHandle<T>::Resolve (Ptr<const Object> source)
+{
+  m_source = PeekPointer (source);
+  m_object = (source != 0) ? source->GetObject<T> () : 0;
+  return (m_object != 0);
+}
+
+template <typename T>
+Ptr<T>
+ObjectHandle<T>::Get (Ptr<const Object> source)
+{
+  if (m_object == 0 || m_source != PeekPointer (source))
+    {
+      Resolve (source);
+    }
+  return m_object;
+}
+
+template <typename T>
+Ptr<T>
+ObjectHandle<T>::Get (void) const
+{
+  return m_object;
+}
+
+template <typename T>
+T *
+ObjectHandle<T>::operator -> () const
+{
+  NS_ASSERT_MSG (m_object != 0, "The handle does not refer to any object");
+  return PeekPointer (m_object);
+}
+
+template <typename T>
+bool
+ObjectHandle<T>::IsResolved (void) const
+{
+  return (m_object != 0);
+}
+
+template <typename T>
+void
+ObjectHandle<T>::Reset (void)
+{
+  m_source = 0;
+  m_object = 0;
+}
+
+} // namespace ns3
+
+#endif /* OBJECT_HANDLE_H */
@@ -21,6 +21,7 @@
 #include "ns3/test.h"
 #include "ns3/object.h"
 #include "ns3/object-factory.h"
+#include "ns3/object-handle.h"
 #include "ns3/assert.h"
 
 /**
@@ -473,6 +474,73 @@ ObjectFactoryTestCase::DoRun (void)
   NS_TEST_ASSERT_MSG_NE (a->GetObject<DerivedA> (), 0, "Unexpectedly able to work around C++ type system");
 }
 
+/**
+ * \ingroup object-tests
+ * Test an ObjectHandle caches the result of GetObject.
+ */
+class ObjectHandleTestCase : public TestCase
+{
+public:
+  /** Constructor. */
+  ObjectHandleTestCase ();
+  /** Destructor. */
+  virtual ~ObjectHandleTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+ObjectHandleTestCase::ObjectHandleTestCase ()
+  : TestCase ("Check ObjectHandle functionality")
+{
+}
+
+ObjectHandleTestCase::~ObjectHandleTestCase ()
+{
+}
+
+void
+ObjectHandleTestCase::DoRun (void)
+{
+  Ptr<BaseA> baseA = CreateObject<BaseA> ();
+  Ptr<BaseB> baseB = CreateObject<BaseB> ();
+
+  ObjectHandle<BaseB> handle;
+  NS_TEST_ASSERT_MSG_EQ (handle.IsResolved (), false, "A new handle should not refer to any object");
+
+  //
+  // There is no BaseB in the aggregation of baseA yet.
+  //
+  NS_TEST_ASSERT_MSG_EQ (handle.Resolve (baseA), false, "Unexpectedly found a BaseB through baseA");
+  NS_TEST_ASSERT_MSG_EQ (handle.Get (baseA), 0, "Unexpectedly found a BaseB through baseA");
+
+  //
+  // The lookup is repeated after a failure, hence the BaseB aggregated later
+  // on is found.
+  //
+  baseA->AggregateObject (baseB);
+  NS_TEST_ASSERT_MSG_EQ (handle.Get (baseA), baseB, "Cannot find the BaseB aggregated to baseA");
+  NS_TEST_ASSERT_MSG_EQ (handle.IsResolved (), true, "The handle should refer to the BaseB");
+  NS_TEST_ASSERT_MSG_EQ (handle.Get (), baseB, "The handle should refer to the BaseB");
+  NS_TEST_ASSERT_MSG_EQ (PeekPointer (handle.Get ()), handle.operator-> (), "The handle should refer to the BaseB");
+
+  //
+  // A handle to the object of the requested type is resolved to the object itself.
+  //
+  NS_TEST_ASSERT_MSG_EQ (handle.Get (baseB), baseB, "Cannot find baseB through itself");
+
+  //
+  // A DerivedA is found through a handle to BaseA.
+  //
+  Ptr<DerivedA> derivedA = CreateObject<DerivedA> ();
+  ObjectHandle<BaseA> handleA;
+  NS_TEST_ASSERT_MSG_EQ (handleA.Resolve (derivedA), true, "Cannot find a BaseA through derivedA");
+  NS_TEST_ASSERT_MSG_EQ (handleA.Get (), derivedA, "Cannot find a BaseA through derivedA");
+
+  handle.Reset ();
+  NS_TEST_ASSERT_MSG_EQ (handle.IsResolved (), false, "A reset handle should not refer to any object");
+}
+
 /**
  * \ingroup object-tests
  * The Test Suite that glues the Test Cases together.
@@ -490,6 +558,7 @@ ObjectTestSuite::ObjectTestSuite ()
   AddTestCase (new CreateObjectTestCase);
   AddTestCase (new AggregateObjectTestCase);
   AddTestCase (new ObjectFactoryTestCase);
+  AddTestCase (new ObjectHandleTestCase);
 }
 
 /**
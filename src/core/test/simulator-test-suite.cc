@@ -23,6 +23,10 @@
 #include "ns3/heap-scheduler.h"
 #include "ns3/map-scheduler.h"
 #include "ns3/calendar-scheduler.h"
+#include "ns3/dary-heap-scheduler.h"
+#include "ns3/rng-seed-manager.h"
+#include "ns3/random-variable-stream.h"
+#include <set>
 
 using namespace ns3;
 
@@ -459,6 +463,126 @@ SimulatorTemplateTestCase::DoRun (void)
   Simulator::Destroy ();
 }
 
+class SimulatorEventPoolTestCase : public TestCase
+{
+public:
+  SimulatorEventPoolTestCase ();
+private:
+  virtual void DoRun (void);
+  void Foo (uint32_t i);
+  uint32_t m_count;
+};
+
+SimulatorEventPoolTestCase::SimulatorEventPoolTestCase ()
+  : TestCase ("Check the recycling of the memory of the events")
+{
+}
+
+void
+SimulatorEventPoolTestCase::Foo (uint32_t i)
+{
+  m_count += i;
+}
+
+void
+SimulatorEventPoolTestCase::DoRun (void)
+{
+  m_count = 0;
+
+  // the memory of a destroyed event is reused by the next event of the same size
+  EventImpl *first = MakeEvent (&SimulatorEventPoolTestCase::Foo, this, 1);
+  EventImpl *firstAddress = first;
+  first->Unref ();
+  EventImpl *second = MakeEvent (&SimulatorEventPoolTestCase::Foo, this, 2);
+  NS_TEST_EXPECT_MSG_EQ (second, firstAddress, "The memory of the first event was not reused");
+  second->Invoke ();
+  second->Unref ();
+  NS_TEST_EXPECT_MSG_EQ (m_count, 2, "The recycled event did not run");
+
+  // recycled events can be cancelled and removed
+  m_count = 0;
+  EventId a = Simulator::Schedule (Seconds (1), &SimulatorEventPoolTestCase::Foo, this, 1);
+  EventId b = Simulator::Schedule (Seconds (2), &SimulatorEventPoolTestCase::Foo, this, 10);
+  EventId c = Simulator::Schedule (Seconds (3), &SimulatorEventPoolTestCase::Foo, this, 100);
+  Simulator::Cancel (a);
+  Simulator::Remove (b);
+  NS_TEST_EXPECT_MSG_EQ (a.IsExpired (), true, "The cancelled event should have expired");
+  NS_TEST_EXPECT_MSG_EQ (b.IsExpired (), true, "The removed event should have expired");
+  for (uint32_t i = 0; i < 1000; i++)
+    {
+      Simulator::Schedule (Seconds (4), &SimulatorEventPoolTestCase::Foo, this, 1000);
+    }
+  Simulator::Run ();
+  NS_TEST_EXPECT_MSG_EQ (c.IsExpired (), true, "The event should have run");
+  NS_TEST_EXPECT_MSG_EQ (m_count, 1000100, "Unexpected events ran");
+
+  // events created while the pools are disabled can be destroyed after the
+  // pools are enabled again
+  EventImpl::EnablePool (false);
+  EventImpl *unpooled = MakeEvent (&SimulatorEventPoolTestCase::Foo, this, 1);
+  EventImpl::EnablePool (true);
+  unpooled->Unref ();
+
+  Simulator::Destroy ();
+}
+
+class SchedulerOrderTestCase : public TestCase
+{
+public:
+  SchedulerOrderTestCase (ObjectFactory schedulerFactory);
+private:
+  virtual void DoRun (void);
+  ObjectFactory m_schedulerFactory;
+};
+
+SchedulerOrderTestCase::SchedulerOrderTestCase (ObjectFactory schedulerFactory)
+  : TestCase ("Check the order of the events removed from a " + schedulerFactory.GetTypeId ().GetName ()),
+    m_schedulerFactory (schedulerFactory)
+{
+}
+
+void
+SchedulerOrderTestCase::DoRun (void)
+{
+  RngSeedManager::SetSeed (1);
+  Ptr<UniformRandomVariable> rand = CreateObject<UniformRandomVariable> ();
+  Ptr<Scheduler> scheduler = m_schedulerFactory.Create<Scheduler> ();
+
+  // insert events with many equal timestamps, remove some of them and check
+  // that the others come out in the order of their keys
+  std::set<Scheduler::EventKey> expected;
+  std::vector<Scheduler::Event> inserted;
+  for (uint32_t uid = 0; uid < 1000; uid++)
+    {
+      Scheduler::Event ev;
+      ev.impl = 0;
+      ev.key.m_ts = rand->GetInteger (0, 200);
+      ev.key.m_uid = uid;
+      ev.key.m_context = 0;
+      scheduler->Insert (ev);
+      inserted.push_back (ev);
+      expected.insert (ev.key);
+    }
+  for (uint32_t i = 0; i < inserted.size (); i += 3)
+    {
+      scheduler->Remove (inserted[i]);
+      expected.erase (inserted[i].key);
+    }
+
+  std::set<Scheduler::EventKey>::const_iterator it = expected.begin ();
+  while (!scheduler->IsEmpty ())
+    {
+      NS_TEST_ASSERT_MSG_EQ ((it != expected.end ()), true, "Too many events in the scheduler");
+      Scheduler::Event next = scheduler->PeekNext ();
+      NS_TEST_EXPECT_MSG_EQ (next.key.m_uid, it->m_uid, "PeekNext returned an unexpected event");
+      next = scheduler->RemoveNext ();
+      NS_TEST_EXPECT_MSG_EQ (next.key.m_ts, it->m_ts, "RemoveNext returned an unexpected timestamp");
+      NS_TEST_EXPECT_MSG_EQ (next.key.m_uid, it->m_uid, "RemoveNext returned an unexpected event");
+      it++;
+    }
+  NS_TEST_EXPECT_MSG_EQ ((it == expected.end ()), true, "Events are missing from the scheduler");
+}
+
 class SimulatorTestSuite : public TestSuite
 {
 public:
@@ -475,5 +599,11 @@ public:
     AddTestCase (new SimulatorEventsTestCase (factory), TestCase::QUICK);
     factory.SetTypeId (CalendarScheduler::GetTypeId ());
     AddTestCase (new SimulatorEventsTestCase (factory), TestCase::QUICK);
+    factory.SetTypeId (DaryHeapScheduler::GetTypeId ());
+    AddTestCase (new SimulatorEventsTestCase (factory), TestCase::QUICK);
+    AddTestCase (new SchedulerOrderTestCase (factory), TestCase::QUICK);
+    factory.SetTypeId (MapScheduler::GetTypeId ());
+    AddTestCase (new SchedulerOrderTestCase (factory), TestCase::QUICK);
+    AddTestCase (new SimulatorEventPoolTestCase (), TestCase::QUICK);
   }
 } g_simulatorTestSuite;
@@ -225,6 +225,92 @@ ThreadedSimulatorEventsTestCase::DoRun (void)
   NS_TEST_EXPECT_MSG_EQ (m_a, m_d, "Bad scheduling");
 }
 
+/**
+ * Check that the events scheduled by other threads while the main thread
+ * is busy are all run, in the order each thread scheduled them, even if
+ * they exceed the capacity of the lock-free queue of DefaultSimulatorImpl.
+ */
+class ThreadedSimulatorOverflowTestCase : public TestCase
+{
+public:
+  ThreadedSimulatorOverflowTestCase ();
+  void StartThreads (void);
+  void Event (unsigned int threadno, uint32_t seq);
+  static void SchedulingThread (std::pair<ThreadedSimulatorOverflowTestCase *, unsigned int> context);
+  static const unsigned int THREADS = 4;
+  static const uint32_t EVENTS = 3000;
+  uint32_t m_next[THREADS];
+  bool m_ordered;
+  uint32_t m_count;
+
+private:
+  virtual void DoRun (void);
+};
+
+ThreadedSimulatorOverflowTestCase::ThreadedSimulatorOverflowTestCase ()
+  : TestCase ("Check that events with context overflowing the lock-free queue are run in order")
+{
+}
+
+void
+ThreadedSimulatorOverflowTestCase::SchedulingThread (std::pair<ThreadedSimulatorOverflowTestCase *, unsigned int> context)
+{
+  ThreadedSimulatorOverflowTestCase *me = context.first;
+  unsigned int threadno = context.second;
+  for (uint32_t seq = 0; seq < EVENTS; ++seq)
+    {
+      Simulator::ScheduleWithContext (threadno, Seconds (0),
+                                      &ThreadedSimulatorOverflowTestCase::Event, me, threadno, seq);
+    }
+}
+
+void
+ThreadedSimulatorOverflowTestCase::StartThreads (void)
+{
+  std::list<Ptr<SystemThread> > threads;
+  for (unsigned int i = 0; i < THREADS; ++i)
+    {
+      threads.push_back (Create<SystemThread> (MakeBoundCallback (
+            &ThreadedSimulatorOverflowTestCase::SchedulingThread,
+                std::pair<ThreadedSimulatorOverflowTestCase *, unsigned int> (this, i))));
+      threads.back ()->Start ();
+    }
+  // block the main thread until all the events have been scheduled
+  for (std::list<Ptr<SystemThread> >::iterator it = threads.begin (); it != threads.end (); ++it)
+    {
+      (*it)->Join ();
+    }
+}
+
+void
+ThreadedSimulatorOverflowTestCase::Event (unsigned int threadno, uint32_t seq)
+{
+  if (m_next[threadno] != seq)
+    {
+      m_ordered = false;
+    }
+  m_next[threadno] = seq + 1;
+  m_count++;
+}
+
+void
+ThreadedSimulatorOverflowTestCase::DoRun (void)
+{
+  for (unsigned int i = 0; i < THREADS; ++i)
+    {
+      m_next[i] = 0;
+    }
+  m_ordered = true;
+  m_count = 0;
+
+  Simulator::Schedule (Seconds (0), &ThreadedSimulatorOverflowTestCase::StartThreads, this);
+  Simulator::Run ();
+  Simulator::Destroy ();
+
+  NS_TEST_EXPECT_MSG_EQ (m_count, THREADS * EVENTS, "Events with context lost");
+  NS_TEST_EXPECT_MSG_EQ (m_ordered, true, "Events with context run out of order");
+}
+
 class ThreadedSimulatorTestSuite : public TestSuite
 {
 public:
@@ -262,5 +348,6 @@ public:
               }
           }
       }
+    AddTestCase (new ThreadedSimulatorOverflowTestCase (), TestCase::QUICK);
   }
 } g_threadedSimulatorTestSuite;
@@ -174,5 +174,14 @@ FlowMonitorHelper::SerializeToXmlFile (std::string fileName, bool enableHistogra
     }
 }
 
+void
+FlowMonitorHelper::SerializeToBinaryFile (std::string fileName, bool enableHistograms)
+{
+  if (m_flowMonitor)
+    {
+      m_flowMonitor->SerializeToBinaryFile (fileName, enableHistograms);
+    }
+}
+
 
 } // namespace ns3
@@ -112,6 +112,14 @@ public:
    */
   void SerializeToXmlFile (std::string fileName, bool enableHistograms, bool enableProbes);
 
+  /**
+   * Serializes the results to a file in binary format, see
+   * FlowMonitor::SerializeToBinaryStream
+   * \param fileName name or path of the output file that will be created
+   * \param enableHistograms if true, include also the histograms in the output
+   */
+  void SerializeToBinaryFile (std::string fileName, bool enableHistograms);
+
 private:
   /**
    * \brief Copy constructor
@@ -39,5 +39,9 @@ FlowClassifier::GetNewFlowId ()
 }
 
 
-} // namespace ns3
+void
+FlowClassifier::SerializeToBinaryTable (FlowMonitorBinaryTable &table, FlowId minFlowId) const
+{
+}
 
+} // namespace ns3
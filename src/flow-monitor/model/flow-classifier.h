@@ -22,6 +22,7 @@
 #define FLOW_CLASSIFIER_H
 
 #include "ns3/simple-ref-count.h"
+#include "ns3/flow-monitor-binary-table.h"
 #include <ostream>
 
 namespace ns3 {
@@ -71,6 +72,13 @@ public:
   /// \param indent number of spaces to use as base indentation level
   virtual void SerializeToXmlStream (std::ostream &os, uint16_t indent) const = 0;
 
+  /// Serializes the flows to a table in binary format.  The default
+  /// implementation leaves the table without columns, which means that
+  /// the classifier does not support this format.
+  /// \param table the table the flows are added to
+  /// \param minFlowId the flows with a lower identifier are skipped
+  virtual void SerializeToBinaryTable (FlowMonitorBinaryTable &table, FlowId minFlowId) const;
+
 protected:
   /// Returns a new, unique Flow Identifier
   /// \returns a new FlowId
@@ -0,0 +1,367 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "flow-monitor-binary-reader.h"
+#include "ns3/log.h"
+#include <fstream>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("FlowMonitorBinaryReader");
+
+/**
+ * \brief Get a value of an optional UNSIGNED column
+ * \param table the table
+ * \param column the index of the column, or -1 if missing
+ * \param index the index of the value
+ * \returns the value, or 0 if the column is missing or too short
+ */
+static uint64_t
+GetUnsigned (const FlowMonitorBinaryTable &table, int32_t column, uint32_t index)
+{
+  if (column < 0 || index >= table.GetNValues (column)
+      || table.GetColumnType (column) != FlowMonitorBinaryTable::UNSIGNED)
+    {
+      return 0;
+    }
+  return table.GetUnsigned (column, index);
+}
+
+/**
+ * \brief Get a time of an optional SIGNED column, in nanoseconds
+ * \param table the table
+ * \param column the index of the column, or -1 if missing
+ * \param index the index of the value
+ * \returns the time, or 0 if the column is missing or too short
+ */
+static Time
+GetTime (const FlowMonitorBinaryTable &table, int32_t column, uint32_t index)
+{
+  if (column < 0 || index >= table.GetNValues (column)
+      || table.GetColumnType (column) != FlowMonitorBinaryTable::SIGNED)
+    {
+      return Seconds (0);
+    }
+  return NanoSeconds (table.GetSigned (column, index));
+}
+
+/// Columns of a histogram in a FlowStats table
+struct HistogramColumns
+{
+  int32_t binWidth;  //!< The bin width of the histogram of each flow
+  int32_t length;    //!< The number of non-empty bins of the histogram of each flow
+  int32_t index;     //!< The indexes of the non-empty bins
+  int32_t count;     //!< The counts of the non-empty bins
+  uint32_t offset;   //!< The index of the first bin of the current flow
+};
+
+/**
+ * \brief Find the columns of a histogram
+ * \param table the table
+ * \param name the name of the histogram
+ * \returns the columns
+ */
+static HistogramColumns
+FindHistogramColumns (const FlowMonitorBinaryTable &table, std::string name)
+{
+  HistogramColumns columns;
+  columns.binWidth = table.FindColumn (name + ".binWidth");
+  columns.length = table.FindColumn (name + ".length");
+  columns.index = table.FindColumn (name + ".index");
+  columns.count = table.FindColumn (name + ".count");
+  columns.offset = 0;
+  return columns;
+}
+
+/**
+ * \brief Read the histogram of a flow
+ * \param table the table
+ * \param columns the columns of the histogram
+ * \param row the row of the flow
+ * \param histogram the histogram
+ */
+static void
+ReadHistogram (const FlowMonitorBinaryTable &table, HistogramColumns &columns, uint32_t row,
+               Histogram &histogram)
+{
+  if (columns.binWidth >= 0 && row < table.GetNValues (columns.binWidth)
+      && table.GetColumnType (columns.binWidth) == FlowMonitorBinaryTable::REAL)
+    {
+      histogram.SetDefaultBinWidth (table.GetReal (columns.binWidth, row));
+    }
+  uint32_t length = GetUnsigned (table, columns.length, row);
+  for (uint32_t i = columns.offset; i < columns.offset + length; i++)
+    {
+      histogram.AddBinCount (GetUnsigned (table, columns.index, i), GetUnsigned (table, columns.count, i));
+    }
+  columns.offset += length;
+}
+
+FlowMonitorBinaryReader::FlowMonitorBinaryReader ()
+  : m_nSnapshots (0)
+{
+}
+
+bool
+FlowMonitorBinaryReader::Read (std::istream &is)
+{
+  if (!FlowMonitorBinaryTable::ReadHeader (is))
+    {
+      NS_LOG_WARN ("Not a FlowMonitor binary stream");
+      return false;
+    }
+  FlowMonitorBinaryTable table;
+  while (is.peek () != std::istream::traits_type::eof ())
+    {
+      if (!table.Read (is))
+        {
+          NS_LOG_WARN ("Truncated or invalid table after " << m_nSnapshots << " snapshots");
+          return false;
+        }
+      NS_LOG_DEBUG ("Table " << table.GetName () << " at " << table.GetTime ().GetSeconds ());
+      if (table.GetName () == "FlowStats")
+        {
+          ReadFlowStats (table);
+        }
+      else if (table.GetName () == "Ipv4FlowClassifier")
+        {
+          ReadIpv4Flows (table);
+        }
+      else if (table.GetName () == "Ipv6FlowClassifier")
+        {
+          ReadIpv6Flows (table);
+        }
+    }
+  return true;
+}
+
+bool
+FlowMonitorBinaryReader::ReadFile (std::string fileName)
+{
+  std::ifstream is (fileName.c_str (), std::ios::in|std::ios::binary);
+  if (!is.is_open ())
+    {
+      NS_LOG_WARN ("Could not open " << fileName);
+      return false;
+    }
+  return Read (is);
+}
+
+void
+FlowMonitorBinaryReader::ReadFlowStats (const FlowMonitorBinaryTable &table)
+{
+  int32_t flowId = table.FindColumn ("flowId");
+  if (flowId < 0 || table.GetColumnType (flowId) != FlowMonitorBinaryTable::UNSIGNED)
+    {
+      NS_LOG_WARN ("FlowStats table without flowId");
+      return;
+    }
+  m_nSnapshots++;
+  m_lastSnapshotTime = table.GetTime ();
+
+  int32_t timeFirstTxPacket = table.FindColumn ("timeFirstTxPacket");
+  int32_t timeFirstRxPacket = table.FindColumn ("timeFirstRxPacket");
+  int32_t timeLastTxPacket = table.FindColumn ("timeLastTxPacket");
+  int32_t timeLastRxPacket = table.FindColumn ("timeLastRxPacket");
+  int32_t delaySum = table.FindColumn ("delaySum");
+  int32_t jitterSum = table.FindColumn ("jitterSum");
+  int32_t lastDelay = table.FindColumn ("lastDelay");
+  int32_t txBytes = table.FindColumn ("txBytes");
+  int32_t rxBytes = table.FindColumn ("rxBytes");
+  int32_t txPackets = table.FindColumn ("txPackets");
+  int32_t rxPackets = table.FindColumn ("rxPackets");
+  int32_t lostPackets = table.FindColumn ("lostPackets");
+  int32_t timesForwarded = table.FindColumn ("timesForwarded");
+  int32_t droppedLength = table.FindColumn ("dropped.length");
+  int32_t packetsDropped = table.FindColumn ("packetsDropped");
+  int32_t bytesDropped = table.FindColumn ("bytesDropped");
+  uint32_t droppedOffset = 0;
+  HistogramColumns delayHistogram = FindHistogramColumns (table, "delayHistogram");
+  HistogramColumns jitterHistogram = FindHistogramColumns (table, "jitterHistogram");
+  HistogramColumns packetSizeHistogram = FindHistogramColumns (table, "packetSizeHistogram");
+  HistogramColumns flowInterruptionsHistogram = FindHistogramColumns (table, "flowInterruptionsHistogram");
+
+  for (uint32_t row = 0; row < table.GetNValues (flowId); row++)
+    {
+      // the last statistics of a flow replace the previous ones
+      FlowMonitor::FlowStats &stats = m_flowStats[table.GetUnsigned (flowId, row)];
+      stats = FlowMonitor::FlowStats ();
+      stats.timeFirstTxPacket = GetTime (table, timeFirstTxPacket, row);
+      stats.timeFirstRxPacket = GetTime (table, timeFirstRxPacket, row);
+      stats.timeLastTxPacket = GetTime (table, timeLastTxPacket, row);
+      stats.timeLastRxPacket = GetTime (table, timeLastRxPacket, row);
+      stats.delaySum = GetTime (table, delaySum, row);
+      stats.jitterSum = GetTime (table, jitterSum, row);
+      stats.lastDelay = GetTime (table, lastDelay, row);
+      stats.txBytes = GetUnsigned (table, txBytes, row);
+      stats.rxBytes = GetUnsigned (table, rxBytes, row);
+      stats.txPackets = GetUnsigned (table, txPackets, row);
+      stats.rxPackets = GetUnsigned (table, rxPackets, row);
+      stats.lostPackets = GetUnsigned (table, lostPackets, row);
+      stats.timesForwarded = GetUnsigned (table, timesForwarded, row);
+      uint32_t length = GetUnsigned (table, droppedLength, row);
+      for (uint32_t i = droppedOffset; i < droppedOffset + length; i++)
+        {
+          stats.packetsDropped.push_back (GetUnsigned (table, packetsDropped, i));
+          stats.bytesDropped.push_back (GetUnsigned (table, bytesDropped, i));
+        }
+      droppedOffset += length;
+      ReadHistogram (table, delayHistogram, row, stats.delayHistogram);
+      ReadHistogram (table, jitterHistogram, row, stats.jitterHistogram);
+      ReadHistogram (table, packetSizeHistogram, row, stats.packetSizeHistogram);
+      ReadHistogram (table, flowInterruptionsHistogram, row, stats.flowInterruptionsHistogram);
+    }
+}
+
+void
+FlowMonitorBinaryReader::ReadIpv4Flows (const FlowMonitorBinaryTable &table)
+{
+  int32_t flowId = table.FindColumn ("flowId");
+  int32_t sourceAddress = table.FindColumn ("sourceAddress");
+  int32_t destinationAddress = table.FindColumn ("destinationAddress");
+  int32_t protocol = table.FindColumn ("protocol");
+  int32_t sourcePort = table.FindColumn ("sourcePort");
+  int32_t destinationPort = table.FindColumn ("destinationPort");
+  if (flowId < 0 || table.GetColumnType (flowId) != FlowMonitorBinaryTable::UNSIGNED)
+    {
+      NS_LOG_WARN ("Ipv4FlowClassifier table without flowId");
+      return;
+    }
+
+  for (uint32_t row = 0; row < table.GetNValues (flowId); row++)
+    {
+      Ipv4FlowClassifier::FiveTuple &tuple = m_ipv4Flows[table.GetUnsigned (flowId, row)];
+      tuple.sourceAddress = Ipv4Address (GetUnsigned (table, sourceAddress, row));
+      tuple.destinationAddress = Ipv4Address (GetUnsigned (table, destinationAddress, row));
+      tuple.protocol = GetUnsigned (table, protocol, row);
+      tuple.sourcePort = GetUnsigned (table, sourcePort, row);
+      tuple.destinationPort = GetUnsigned (table, destinationPort, row);
+    }
+}
+
+void
+FlowMonitorBinaryReader::ReadIpv6Flows (const FlowMonitorBinaryTable &table)
+{
+  int32_t flowId = table.FindColumn ("flowId");
+  int32_t sourceAddress = table.FindColumn ("sourceAddress");
+  int32_t destinationAddress = table.FindColumn ("destinationAddress");
+  int32_t protocol = table.FindColumn ("protocol");
+  int32_t sourcePort = table.FindColumn ("sourcePort");
+  int32_t destinationPort = table.FindColumn ("destinationPort");
+  if (flowId < 0 || table.GetColumnType (flowId) != FlowMonitorBinaryTable::UNSIGNED)
+    {
+      NS_LOG_WARN ("Ipv6FlowClassifier table without flowId");
+      return;
+    }
+  bool addresses = sourceAddress >= 0 && destinationAddress >= 0
+    && table.GetColumnType (sourceAddress) == FlowMonitorBinaryTable::BYTES
+    && table.GetColumnWidth (sourceAddress) == 16
+    && table.GetColumnType (destinationAddress) == FlowMonitorBinaryTable::BYTES
+    && table.GetColumnWidth (destinationAddress) == 16;
+
+  for (uint32_t row = 0; row < table.GetNValues (flowId); row++)
+    {
+      Ipv6FlowClassifier::FiveTuple &tuple = m_ipv6Flows[table.GetUnsigned (flowId, row)];
+      if (addresses && row < table.GetNValues (sourceAddress) && row < table.GetNValues (destinationAddress))
+        {
+          uint8_t buf[16];
+          table.GetBytes (sourceAddress, row, buf);
+          tuple.sourceAddress = Ipv6Address::Deserialize (buf);
+          table.GetBytes (destinationAddress, row, buf);
+          tuple.destinationAddress = Ipv6Address::Deserialize (buf);
+        }
+      tuple.protocol = GetUnsigned (table, protocol, row);
+      tuple.sourcePort = GetUnsigned (table, sourcePort, row);
+      tuple.destinationPort = GetUnsigned (table, destinationPort, row);
+    }
+}
+
+uint32_t
+FlowMonitorBinaryReader::GetNSnapshots (void) const
+{
+  return m_nSnapshots;
+}
+
+Time
+FlowMonitorBinaryReader::GetLastSnapshotTime (void) const
+{
+  return m_lastSnapshotTime;
+}
+
+const FlowMonitor::FlowStatsContainer&
+FlowMonitorBinaryReader::GetFlowStats (void) const
+{
+  return m_flowStats;
+}
+
+const FlowMonitorBinaryReader::Ipv4FlowContainer&
+FlowMonitorBinaryReader::GetIpv4Flows (void) const
+{
+  return m_ipv4Flows;
+}
+
+const FlowMonitorBinaryReader::Ipv6FlowContainer&
+FlowMonitorBinaryReader::GetIpv6Flows (void) const
+{
+  return m_ipv6Flows;
+}
+
+void
+FlowMonitorBinaryReader::SerializeToXmlStream (std::ostream &os, uint16_t indent, bool enableHistograms) const
+{
+  os << std::string ( indent, ' ' ) << "<FlowMonitor>\n";
+  indent += 2;
+  FlowMonitor::SerializeFlowStatsToXmlStream (os, indent, m_flowStats, enableHistograms);
+
+  if (!m_ipv4Flows.empty ())
+    {
+      os << std::string ( indent, ' ' ) << "<Ipv4FlowClassifier>\n";
+      for (Ipv4FlowContainer::const_iterator iter = m_ipv4Flows.begin (); iter != m_ipv4Flows.end (); iter++)
+        {
+          os << std::string ( indent + 2, ' ' )
+             << "<Flow flowId=\"" << iter->first << "\""
+             << " sourceAddress=\"" << iter->second.sourceAddress << "\""
+             << " destinationAddress=\"" << iter->second.destinationAddress << "\""
+             << " protocol=\"" << int(iter->second.protocol) << "\""
+             << " sourcePort=\"" << iter->second.sourcePort << "\""
+             << " destinationPort=\"" << iter->second.destinationPort << "\">\n";
+          os << std::string ( indent + 2, ' ' ) << "</Flow>\n";
+        }
+      os << std::string ( indent, ' ' ) << "</Ipv4FlowClassifier>\n";
+    }
+
+  if (!m_ipv6Flows.empty ())
+    {
+      os << std::string ( indent, ' ' ) << "<Ipv6FlowClassifier>\n";
+      for (Ipv6FlowContainer::const_iterator iter = m_ipv6Flows.begin (); iter != m_ipv6Flows.end (); iter++)
+        {
+          os << std::string ( indent + 2, ' ' )
+             << "<Flow flowId=\"" << iter->first << "\""
+             << " sourceAddress=\"" << iter->second.sourceAddress << "\""
+             << " destinationAddress=\"" << iter->second.destinationAddress << "\""
+             << " protocol=\"" << int(iter->second.protocol) << "\""
+             << " sourcePort=\"" << iter->second.sourcePort << "\""
+             << " destinationPort=\"" << iter->second.destinationPort << "\">\n";
+          os << std::string ( indent + 2, ' ' ) << "</Flow>\n";
+        }
+      os << std::string ( indent, ' ' ) << "</Ipv6FlowClassifier>\n";
+    }
+
+  indent -= 2;
+  os << std::string ( indent, ' ' ) << "</FlowMonitor>\n";
+}
+
+} // namespace ns3
@@ -0,0 +1,110 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef FLOW_MONITOR_BINARY_READER_H
+#define FLOW_MONITOR_BINARY_READER_H
+
+#include <map>
+#include <string>
+#include <istream>
+#include <ostream>
+#include "ns3/flow-monitor.h"
+#include "ns3/ipv4-flow-classifier.h"
+#include "ns3/ipv6-flow-classifier.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup flow-monitor
+ * \brief Reads the results written by FlowMonitor in binary format.
+ *
+ * The reader accepts both the output of FlowMonitor::SerializeToBinaryStream
+ * and the snapshots written by FlowMonitor::StartBinarySnapshots: the
+ * statistics of a flow are the ones of the last table it appears in.
+ * The tables and columns it does not know are ignored.
+ */
+class FlowMonitorBinaryReader
+{
+public:
+  /// FlowId --> Ipv4FlowClassifier::FiveTuple
+  typedef std::map<FlowId, Ipv4FlowClassifier::FiveTuple> Ipv4FlowContainer;
+  /// FlowId --> Ipv6FlowClassifier::FiveTuple
+  typedef std::map<FlowId, Ipv6FlowClassifier::FiveTuple> Ipv6FlowContainer;
+
+  FlowMonitorBinaryReader ();
+
+  /**
+   * \brief Read the results from a stream, after the ones already read
+   * \param is the input stream
+   * \returns false if the stream is not in the binary format or is truncated;
+   *          the results of the complete tables are kept
+   */
+  bool Read (std::istream &is);
+  /**
+   * \brief Read the results from a file, after the ones already read
+   * \param fileName the name of the file
+   * \returns false if the file cannot be read, as Read
+   */
+  bool ReadFile (std::string fileName);
+
+  /// \returns the number of FlowStats tables read (i.e., of snapshots)
+  uint32_t GetNSnapshots (void) const;
+  /// \returns the time of the last snapshot read
+  Time GetLastSnapshotTime (void) const;
+  /// \returns the last statistics of every flow
+  const FlowMonitor::FlowStatsContainer& GetFlowStats (void) const;
+  /// \returns the five-tuples of the flows classified by Ipv4FlowClassifier
+  const Ipv4FlowContainer& GetIpv4Flows (void) const;
+  /// \returns the five-tuples of the flows classified by Ipv6FlowClassifier
+  const Ipv6FlowContainer& GetIpv6Flows (void) const;
+
+  /**
+   * \brief Serializes the results to an std::ostream in the XML format
+   * of FlowMonitor::SerializeToXmlStream, without the DSCP counts of the
+   * classifiers and the per-probe statistics
+   * \param os the output stream
+   * \param indent number of spaces to use as base indentation level
+   * \param enableHistograms if true, include also the histograms in the output
+   */
+  void SerializeToXmlStream (std::ostream &os, uint16_t indent, bool enableHistograms) const;
+
+private:
+  /**
+   * \brief Read a FlowStats table
+   * \param table the table
+   */
+  void ReadFlowStats (const FlowMonitorBinaryTable &table);
+  /**
+   * \brief Read an Ipv4FlowClassifier table
+   * \param table the table
+   */
+  void ReadIpv4Flows (const FlowMonitorBinaryTable &table);
+  /**
+   * \brief Read an Ipv6FlowClassifier table
+   * \param table the table
+   */
+  void ReadIpv6Flows (const FlowMonitorBinaryTable &table);
+
+  uint32_t m_nSnapshots;                      //!< Number of FlowStats tables read
+  Time m_lastSnapshotTime;                    //!< Time of the last snapshot read
+  FlowMonitor::FlowStatsContainer m_flowStats;  //!< FlowId --> FlowStats
+  Ipv4FlowContainer m_ipv4Flows;              //!< FlowId --> IPv4 five-tuple
+  Ipv6FlowContainer m_ipv6Flows;              //!< FlowId --> IPv6 five-tuple
+};
+
+} // namespace ns3
+
+#endif /* FLOW_MONITOR_BINARY_READER_H */
@@ -0,0 +1,412 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "flow-monitor-binary-table.h"
+#include "ns3/assert.h"
+#include "ns3/log.h"
+#include <algorithm>
+#include <cstring>
+
+/// The magic string at the beginning of a binary file, version included
+#define BINARY_TABLE_MAGIC "ns3flowmon-1"
+
+/// The largest number of bytes allocated before they are actually read
+#define BINARY_TABLE_READ_CHUNK 65536
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("FlowMonitorBinaryTable");
+
+/**
+ * \brief Write a little-endian integer
+ * \param os the output stream
+ * \param value the integer
+ * \param width the number of bytes to write
+ */
+static void
+WriteInteger (std::ostream &os, uint64_t value, uint8_t width)
+{
+  char buffer[8];
+  for (uint8_t i = 0; i < width; i++)
+    {
+      buffer[i] = static_cast<char> ((value >> (8 * i)) & 0xff);
+    }
+  os.write (buffer, width);
+}
+
+/**
+ * \brief Read a little-endian integer
+ * \param is the input stream
+ * \param width the number of bytes to read
+ * \param value the integer read
+ * \returns false at the end of the stream
+ */
+static bool
+ReadInteger (std::istream &is, uint8_t width, uint64_t &value)
+{
+  char buffer[8];
+  if (!is.read (buffer, width))
+    {
+      return false;
+    }
+  value = 0;
+  for (uint8_t i = 0; i < width; i++)
+    {
+      value |= static_cast<uint64_t> (static_cast<uint8_t> (buffer[i])) << (8 * i);
+    }
+  return true;
+}
+
+/**
+ * \brief Write a string, preceded by its length
+ * \param os the output stream
+ * \param s the string
+ */
+static void
+WriteString (std::ostream &os, const std::string &s)
+{
+  NS_ASSERT (s.size () <= 0xffff);
+  WriteInteger (os, s.size (), 2);
+  os.write (s.data (), s.size ());
+}
+
+/**
+ * \brief Read a given number of bytes
+ *
+ * The sizes come from the stream itself, so the buffer is grown by bounded
+ * chunks as the bytes are read: a corrupt size makes the read fail at the
+ * end of the stream rather than allocating a huge buffer up front.
+ *
+ * \param is the input stream
+ * \param size the number of bytes to read
+ * \param data the bytes read
+ * \returns false if the stream ends before size bytes are read
+ */
+template <typename Container>
+static bool
+ReadBytes (std::istream &is, uint64_t size, Container &data)
+{
+  data.clear ();
+  while (data.size () < size)
+    {
+      std::size_t offset = data.size ();
+      std::size_t chunk = std::min<uint64_t> (size - offset, BINARY_TABLE_READ_CHUNK);
+      data.resize (offset + chunk);
+      if (!is.read (reinterpret_cast<char *> (&data[offset]), chunk))
+        {
+          return false;
+        }
+    }
+  return true;
+}
+
+/**
+ * \brief Read a string, preceded by its length
+ * \param is the input stream
+ * \param s the string read
+ * \returns false at the end of the stream
+ */
+static bool
+ReadString (std::istream &is, std::string &s)
+{
+  uint64_t size;
+  return ReadInteger (is, 2, size) && ReadBytes (is, size, s);
+}
+
+/**
+ * \brief Check the width of the values of a column
+ * \param type the type of the values
+ * \param width the width of the values, in bytes
+ * \returns true if the values of this type can have this width
+ */
+static bool
+IsValidWidth (uint8_t type, uint8_t width)
+{
+  switch (type)
+    {
+    case FlowMonitorBinaryTable::UNSIGNED:
+    case FlowMonitorBinaryTable::SIGNED:
+      return width == 1 || width == 2 || width == 4 || width == 8;
+    case FlowMonitorBinaryTable::REAL:
+      return width == 8;
+    case FlowMonitorBinaryTable::BYTES:
+      return width > 0;
+    default:
+      return false;
+    }
+}
+
+FlowMonitorBinaryTable::FlowMonitorBinaryTable ()
+{
+}
+
+FlowMonitorBinaryTable::FlowMonitorBinaryTable (std::string name)
+  : m_name (name)
+{
+}
+
+std::string
+FlowMonitorBinaryTable::GetName (void) const
+{
+  return m_name;
+}
+
+void
+FlowMonitorBinaryTable::SetName (std::string name)
+{
+  m_name = name;
+}
+
+Time
+FlowMonitorBinaryTable::GetTime (void) const
+{
+  return m_time;
+}
+
+void
+FlowMonitorBinaryTable::SetTime (Time time)
+{
+  m_time = time;
+}
+
+uint32_t
+FlowMonitorBinaryTable::AddColumn (std::string name, ColumnType type, uint8_t width)
+{
+  NS_ASSERT_MSG (IsValidWidth (type, width), "Invalid width " << (uint32_t) width << " of column " << name);
+  Column column;
+  column.name = name;
+  column.type = type;
+  column.width = width;
+  m_columns.push_back (column);
+  return m_columns.size () - 1;
+}
+
+uint32_t
+FlowMonitorBinaryTable::GetNColumns (void) const
+{
+  return m_columns.size ();
+}
+
+int32_t
+FlowMonitorBinaryTable::FindColumn (std::string name) const
+{
+  for (uint32_t i = 0; i < m_columns.size (); i++)
+    {
+      if (m_columns[i].name == name)
+        {
+          return i;
+        }
+    }
+  return -1;
+}
+
+std::string
+FlowMonitorBinaryTable::GetColumnName (uint32_t column) const
+{
+  return m_columns[column].name;
+}
+
+FlowMonitorBinaryTable::ColumnType
+FlowMonitorBinaryTable::GetColumnType (uint32_t column) const
+{
+  return static_cast<ColumnType> (m_columns[column].type);
+}
+
+uint8_t
+FlowMonitorBinaryTable::GetColumnWidth (uint32_t column) const
+{
+  return m_columns[column].width;
+}
+
+uint32_t
+FlowMonitorBinaryTable::GetNValues (uint32_t column) const
+{
+  return m_columns[column].data.size () / m_columns[column].width;
+}
+
+void
+FlowMonitorBinaryTable::Append (uint32_t column, uint64_t value)
+{
+  Column &c = m_columns[column];
+  for (uint8_t i = 0; i < c.width; i++)
+    {
+      c.data.push_back ((value >> (8 * i)) & 0xff);
+    }
+}
+
+uint64_t
+FlowMonitorBinaryTable::Get (uint32_t column, uint32_t index) const
+{
+  const Column &c = m_columns[column];
+  NS_ASSERT (index < c.data.size () / c.width);
+  const uint8_t *data = &c.data[index * c.width];
+  uint64_t value = 0;
+  for (uint8_t i = 0; i < c.width; i++)
+    {
+      value |= static_cast<uint64_t> (data[i]) << (8 * i);
+    }
+  return value;
+}
+
+void
+FlowMonitorBinaryTable::AddUnsigned (uint32_t column, uint64_t value)
+{
+  NS_ASSERT (m_columns[column].type == UNSIGNED);
+  NS_ASSERT (m_columns[column].width == 8 || value >> (8 * m_columns[column].width) == 0);
+  Append (column, value);
+}
+
+void
+FlowMonitorBinaryTable::AddSigned (uint32_t column, int64_t value)
+{
+  NS_ASSERT (m_columns[column].type == SIGNED);
+  Append (column, static_cast<uint64_t> (value));
+}
+
+void
+FlowMonitorBinaryTable::AddReal (uint32_t column, double value)
+{
+  NS_ASSERT (m_columns[column].type == REAL);
+  uint64_t bits;
+  std::memcpy (&bits, &value, sizeof (bits));
+  Append (column, bits);
+}
+
+void
+FlowMonitorBinaryTable::AddBytes (uint32_t column, const uint8_t *value)
+{
+  Column &c = m_columns[column];
+  NS_ASSERT (c.type == BYTES);
+  c.data.insert (c.data.end (), value, value + c.width);
+}
+
+uint64_t
+FlowMonitorBinaryTable::GetUnsigned (uint32_t column, uint32_t index) const
+{
+  NS_ASSERT (m_columns[column].type == UNSIGNED);
+  return Get (column, index);
+}
+
+int64_t
+FlowMonitorBinaryTable::GetSigned (uint32_t column, uint32_t index) const
+{
+  NS_ASSERT (m_columns[column].type == SIGNED);
+  uint64_t value = Get (column, index);
+  uint8_t bits = 8 * m_columns[column].width;
+  if (bits < 64 && (value >> (bits - 1)) & 1)
+    {
+      // sign extension
+      value |= ~static_cast<uint64_t> (0) << bits;
+    }
+  return static_cast<int64_t> (value);
+}
+
+double
+FlowMonitorBinaryTable::GetReal (uint32_t column, uint32_t index) const
+{
+  NS_ASSERT (m_columns[column].type == REAL);
+  uint64_t bits = Get (column, index);
+  double value;
+  std::memcpy (&value, &bits, sizeof (value));
+  return value;
+}
+
+void
+FlowMonitorBinaryTable::GetBytes (uint32_t column, uint32_t index, uint8_t *value) const
+{
+  const Column &c = m_columns[column];
+  NS_ASSERT (c.type == BYTES);
+  NS_ASSERT (index < c.data.size () / c.width);
+  std::memcpy (value, &c.data[index * c.width], c.width);
+}
+
+void
+FlowMonitorBinaryTable::Write (std::ostream &os) const
+{
+  WriteString (os, m_name);
+  WriteInteger (os, static_cast<uint64_t> (m_time.GetNanoSeconds ()), 8);
+  WriteInteger (os, m_columns.size (), 2);
+  for (std::vector<Column>::const_iterator i = m_columns.begin (); i != m_columns.end (); i++)
+    {
+      WriteString (os, i->name);
+      WriteInteger (os, i->type, 1);
+      WriteInteger (os, i->width, 1);
+      WriteInteger (os, i->data.size () / i->width, 4);
+      if (!i->data.empty ())
+        {
+          os.write (reinterpret_cast<const char *> (&i->data[0]), i->data.size ());
+        }
+    }
+}
+
+bool
+FlowMonitorBinaryTable::Read (std::istream &is)
+{
+  m_columns.clear ();
+  uint64_t time;
+  uint64_t nColumns;
+  if (!ReadString (is, m_name)
+      || !ReadInteger (is, 8, time)
+      || !ReadInteger (is, 2, nColumns))
+    {
+      return false;
+    }
+  m_time = NanoSeconds (static_cast<int64_t> (time));
+  // the columns are appended as they are read, like their values
+  for (uint64_t c = 0; c < nColumns; c++)
+    {
+      m_columns.push_back (Column ());
+      Column &column = m_columns.back ();
+      uint64_t type;
+      uint64_t width;
+      uint64_t nValues;
+      if (!ReadString (is, column.name)
+          || !ReadInteger (is, 1, type)
+          || !ReadInteger (is, 1, width)
+          || !ReadInteger (is, 4, nValues))
+        {
+          return false;
+        }
+      if (!IsValidWidth (type, width))
+        {
+          NS_LOG_WARN ("Invalid column " << column.name << " of table " << m_name);
+          return false;
+        }
+      column.type = type;
+      column.width = width;
+      if (!ReadBytes (is, nValues * width, column.data))
+        {
+          return false;
+        }
+    }
+  return true;
+}
+
+void
+FlowMonitorBinaryTable::WriteHeader (std::ostream &os)
+{
+  os.write (BINARY_TABLE_MAGIC, sizeof (BINARY_TABLE_MAGIC));
+}
+
+bool
+FlowMonitorBinaryTable::ReadHeader (std::istream &is)
+{
+  char magic[sizeof (BINARY_TABLE_MAGIC)];
+  return is.read (magic, sizeof (magic))
+         && std::memcmp (magic, BINARY_TABLE_MAGIC, sizeof (magic)) == 0;
+}
+
+} // namespace ns3
@@ -0,0 +1,223 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef FLOW_MONITOR_BINARY_TABLE_H
+#define FLOW_MONITOR_BINARY_TABLE_H
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <istream>
+#include <ostream>
+#include "ns3/nstime.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup flow-monitor
+ * \brief A self-describing table of columns, used to store the flow
+ * statistics in binary format.
+ *
+ * A table has a name, a time stamp and a list of named columns. The
+ * values of a column are stored contiguously, with a fixed width and
+ * one of the types of ColumnType, so that a reader can load a column
+ * without parsing the other ones and skip the columns it does not know.
+ * The columns do not need to have the same number of values: a list
+ * per row is stored as a column of list lengths followed by a column
+ * of the concatenated lists.
+ *
+ * A binary file is made of a header (see WriteHeader) followed by any
+ * number of tables. All the integers are stored in little-endian
+ * order, whatever the host. A table is stored as:
+ *   - its name: uint16_t length, then the characters,
+ *   - its time, in nanoseconds: int64_t,
+ *   - its number of columns: uint16_t,
+ *   - for each column, its name (as for the table), its type: uint8_t,
+ *     the width of its values in bytes: uint8_t, its number of values:
+ *     uint32_t, then the values.
+ */
+class FlowMonitorBinaryTable
+{
+public:
+  /// The types of the values of a column
+  enum ColumnType
+  {
+    UNSIGNED = 0,  //!< Unsigned integer, 1, 2, 4 or 8 bytes wide
+    SIGNED = 1,    //!< Signed integer, 1, 2, 4 or 8 bytes wide
+    REAL = 2,      //!< IEEE 754 double, 8 bytes wide
+    BYTES = 3      //!< Fixed-size sequence of bytes (e.g., an IPv6 address)
+  };
+
+  FlowMonitorBinaryTable ();
+  /**
+   * \brief Constructor
+   * \param name the name of the table
+   */
+  FlowMonitorBinaryTable (std::string name);
+
+  /// \returns the name of the table
+  std::string GetName (void) const;
+  /// \param name the name of the table
+  void SetName (std::string name);
+  /// \returns the time stamp of the table
+  Time GetTime (void) const;
+  /// \param time the time stamp of the table
+  void SetTime (Time time);
+
+  /**
+   * \brief Add a column to the table
+   * \param name the name of the column
+   * \param type the type of the values
+   * \param width the width of the values, in bytes
+   * \returns the index of the column
+   */
+  uint32_t AddColumn (std::string name, ColumnType type, uint8_t width);
+  /// \returns the number of columns
+  uint32_t GetNColumns (void) const;
+  /**
+   * \brief Find a column by name
+   * \param name the name of the column
+   * \returns the index of the column, or -1 if the table has no such column
+   */
+  int32_t FindColumn (std::string name) const;
+  /**
+   * \param column the index of the column
+   * \returns the name of the column
+   */
+  std::string GetColumnName (uint32_t column) const;
+  /**
+   * \param column the index of the column
+   * \returns the type of the values of the column
+   */
+  ColumnType GetColumnType (uint32_t column) const;
+  /**
+   * \param column the index of the column
+   * \returns the width of the values of the column, in bytes
+   */
+  uint8_t GetColumnWidth (uint32_t column) const;
+  /**
+   * \param column the index of the column
+   * \returns the number of values of the column
+   */
+  uint32_t GetNValues (uint32_t column) const;
+
+  /**
+   * \brief Append a value to an UNSIGNED column
+   * \param column the index of the column
+   * \param value the value, which must fit in the width of the column
+   */
+  void AddUnsigned (uint32_t column, uint64_t value);
+  /**
+   * \brief Append a value to a SIGNED column
+   * \param column the index of the column
+   * \param value the value, which must fit in the width of the column
+   */
+  void AddSigned (uint32_t column, int64_t value);
+  /**
+   * \brief Append a value to a REAL column
+   * \param column the index of the column
+   * \param value the value
+   */
+  void AddReal (uint32_t column, double value);
+  /**
+   * \brief Append a value to a BYTES column
+   * \param column the index of the column
+   * \param value the bytes, as many as the width of the column
+   */
+  void AddBytes (uint32_t column, const uint8_t *value);
+
+  /**
+   * \param column the index of an UNSIGNED column
+   * \param index the index of the value
+   * \returns the value
+   */
+  uint64_t GetUnsigned (uint32_t column, uint32_t index) const;
+  /**
+   * \param column the index of a SIGNED column
+   * \param index the index of the value
+   * \returns the value
+   */
+  int64_t GetSigned (uint32_t column, uint32_t index) const;
+  /**
+   * \param column the index of a REAL column
+   * \param index the index of the value
+   * \returns the value
+   */
+  double GetReal (uint32_t column, uint32_t index) const;
+  /**
+   * \param column the index of a BYTES column
+   * \param index the index of the value
+   * \param value the buffer the bytes are copied to, as many as the
+   *        width of the column
+   */
+  void GetBytes (uint32_t column, uint32_t index, uint8_t *value) const;
+
+  /**
+   * \brief Write the table
+   * \param os the output stream
+   */
+  void Write (std::ostream &os) const;
+  /**
+   * \brief Read a table, replacing the content of this one
+   * \param is the input stream
+   * \returns false if the stream does not contain a valid table
+   */
+  bool Read (std::istream &is);
+
+  /**
+   * \brief Write the header of a binary file
+   * \param os the output stream
+   */
+  static void WriteHeader (std::ostream &os);
+  /**
+   * \brief Read the header of a binary file
+   * \param is the input stream
+   * \returns false if the stream does not start with a supported header
+   */
+  static bool ReadHeader (std::istream &is);
+
+private:
+  /// A column of the table
+  struct Column
+  {
+    std::string name;           //!< The name of the column
+    uint8_t type;               //!< The type of the values
+    uint8_t width;              //!< The width of the values
+    std::vector<uint8_t> data;  //!< The values, in little-endian order
+  };
+
+  /**
+   * \brief Append an integer to a column
+   * \param column the index of the column
+   * \param value the integer
+   */
+  void Append (uint32_t column, uint64_t value);
+  /**
+   * \brief Get an integer of a column
+   * \param column the index of the column
+   * \param index the index of the value
+   * \returns the integer, zero-extended
+   */
+  uint64_t Get (uint32_t column, uint32_t index) const;
+
+  std::string m_name;             //!< The name of the table
+  Time m_time;                    //!< The time stamp of the table
+  std::vector<Column> m_columns;  //!< The columns
+};
+
+} // namespace ns3
+
+#endif /* FLOW_MONITOR_BINARY_TABLE_H */
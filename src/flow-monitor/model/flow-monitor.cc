@@ -24,6 +24,7 @@
 #include "ns3/double.h"
 #include <fstream>
 #include <sstream>
+#include <algorithm>
 
 #define PERIODIC_CHECK_INTERVAL (Seconds (1))
 
@@ -80,7 +81,8 @@ FlowMonitor::GetInstanceTypeId (void) const
 }
 
 FlowMonitor::FlowMonitor ()
-  : m_enabled (false)
+  : m_enabled (false),
+    m_snapshotHistograms (false)
 {
   // m_histogramBinWidth=DEFAULT_BIN_WIDTH;
 }
@@ -99,9 +101,19 @@ FlowMonitor::DoDispose (void)
       m_flowProbes[i]->Dispose ();
       m_flowProbes[i] = 0;
     }
+  // the simulator may already be destroyed: the last snapshot is written
+  // by StopBinarySnapshots, explicitly or when the simulator is destroyed
+  m_snapshotStream.close ();
   Object::DoDispose ();
 }
 
+size_t
+FlowMonitor::TrackedPacketKeyHash::operator() (const TrackedPacketKey &key) const
+{
+  uint64_t k = (static_cast<uint64_t> (key.first) << 32) | key.second;
+  return std::hash<uint64_t> () (k);
+}
+
 inline FlowMonitor::FlowStats&
 FlowMonitor::GetStatsForFlow (FlowId flowId)
 {
@@ -140,7 +152,17 @@ FlowMonitor::ReportFirstTx (Ptr<FlowProbe> probe, uint32_t flowId, uint32_t pack
       return;
     }
   Time now = Simulator::Now ();
-  TrackedPacket &tracked = m_trackedPackets[std::make_pair (flowId, packetId)];
+  TrackedPacketKey key (flowId, packetId);
+  std::pair<TrackedPacketMap::iterator, bool> inserted = m_trackedPackets.insert (std::make_pair (key, TrackedPacket ()));
+  TrackedPacket &tracked = inserted.first->second;
+  if (inserted.second)
+    {
+      tracked.seen = m_lastSeen.insert (m_lastSeen.end (), key);
+    }
+  else
+    {
+      m_lastSeen.splice (m_lastSeen.end (), m_lastSeen, tracked.seen);
+    }
   tracked.firstSeenTime = now;
   tracked.lastSeenTime = tracked.firstSeenTime;
   tracked.timesForwarded = 0;
@@ -178,6 +200,7 @@ FlowMonitor::ReportForwarding (Ptr<FlowProbe> probe, uint32_t flowId, uint32_t p
 
   tracked->second.timesForwarded++;
   tracked->second.lastSeenTime = Simulator::Now ();
+  m_lastSeen.splice (m_lastSeen.end (), m_lastSeen, tracked->second.seen);
 
   Time delay = (Simulator::Now () - tracked->second.firstSeenTime);
   probe->AddPacketStats (flowId, packetSize, delay);
@@ -244,7 +267,7 @@ FlowMonitor::ReportLastRx (Ptr<FlowProbe> probe, uint32_t flowId, uint32_t packe
   NS_LOG_DEBUG ("ReportLastTx: removing tracked packet (flowId="
                 << flowId << ", packetId=" << packetId << ").");
 
-  m_trackedPackets.erase (tracked); // we don't need to track this packet anymore
+  RemoveTrackedPacket (tracked); // we don't need to track this packet anymore
 }
 
 void
@@ -276,10 +299,17 @@ FlowMonitor::ReportDrop (Ptr<FlowProbe> probe, uint32_t flowId, uint32_t packetI
       // FIXME: this will not necessarily be true with broadcast/multicast
       NS_LOG_DEBUG ("ReportDrop: removing tracked packet (flowId="
                     << flowId << ", packetId=" << packetId << ").");
-      m_trackedPackets.erase (tracked);
+      RemoveTrackedPacket (tracked);
     }
 }
 
+void
+FlowMonitor::RemoveTrackedPacket (TrackedPacketMap::iterator tracked)
+{
+  m_lastSeen.erase (tracked->second.seen);
+  m_trackedPackets.erase (tracked);
+}
+
 const FlowMonitor::FlowStatsContainer&
 FlowMonitor::GetFlowStats () const
 {
@@ -292,23 +322,24 @@ FlowMonitor::CheckForLostPackets (Time maxDelay)
 {
   Time now = Simulator::Now ();
 
-  for (TrackedPacketMap::iterator iter = m_trackedPackets.begin ();
-       iter != m_trackedPackets.end (); )
+  // m_lastSeen is sorted by lastSeenTime: stop at the first packet
+  // which has been seen recently enough
+  while (!m_lastSeen.empty ())
     {
-      if (now - iter->second.lastSeenTime >= maxDelay)
+      TrackedPacketMap::iterator iter = m_trackedPackets.find (m_lastSeen.front ());
+      NS_ASSERT (iter != m_trackedPackets.end ());
+      if (now - iter->second.lastSeenTime < maxDelay)
         {
-          // packet is considered lost, add it to the loss statistics
-          FlowStatsContainerI flow = m_flowStats.find (iter->first.first);
-          NS_ASSERT (flow != m_flowStats.end ());
-          flow->second.lostPackets++;
-
-          // we won't track it anymore
-          m_trackedPackets.erase (iter++);
-        }
-      else
-        {
-          iter++;
+          break;
         }
+
+      // packet is considered lost, add it to the loss statistics
+      FlowStatsContainerI flow = m_flowStats.find (iter->first.first);
+      NS_ASSERT (flow != m_flowStats.end ());
+      flow->second.lostPackets++;
+
+      // we won't track it anymore
+      RemoveTrackedPacket (iter);
     }
 }
 
@@ -404,10 +435,40 @@ FlowMonitor::SerializeToXmlStream (std::ostream &os, uint16_t indent, bool enabl
 
   os << std::string ( indent, ' ' ) << "<FlowMonitor>\n";
   indent += 2;
+  SerializeFlowStatsToXmlStream (os, indent, m_flowStats, enableHistograms);
+
+  for (std::list<Ptr<FlowClassifier> >::iterator iter = m_classifiers.begin ();
+      iter != m_classifiers.end ();
+      iter ++)
+    {
+      (*iter)->SerializeToXmlStream (os, indent);
+    }
+
+  if (enableProbes)
+    {
+      os << std::string ( indent, ' ' ) << "<FlowProbes>\n";
+      indent += 2;
+      for (uint32_t i = 0; i < m_flowProbes.size (); i++)
+        {
+          m_flowProbes[i]->SerializeToXmlStream (os, indent, i);
+        }
+      indent -= 2;
+      os << std::string ( indent, ' ' ) << "</FlowProbes>\n";
+    }
+
+  indent -= 2;
+  os << std::string ( indent, ' ' ) << "</FlowMonitor>\n";
+}
+
+
+void
+FlowMonitor::SerializeFlowStatsToXmlStream (std::ostream &os, uint16_t indent,
+                                            const FlowStatsContainer &flowStats, bool enableHistograms)
+{
   os << std::string ( indent, ' ' ) << "<FlowStats>\n";
   indent += 2;
-  for (FlowStatsContainerCI flowI = m_flowStats.begin ();
-       flowI != m_flowStats.end (); flowI++)
+  for (FlowStatsContainerCI flowI = flowStats.begin ();
+       flowI != flowStats.end (); flowI++)
     {
       os << std::string ( indent, ' ' );
 #define ATTRIB(name) << " " # name "=\"" << flowI->second.name << "\""
@@ -456,28 +517,6 @@ FlowMonitor::SerializeToXmlStream (std::ostream &os, uint16_t indent, bool enabl
     }
   indent -= 2;
   os << std::string ( indent, ' ' ) << "</FlowStats>\n";
-
-  for (std::list<Ptr<FlowClassifier> >::iterator iter = m_classifiers.begin ();
-      iter != m_classifiers.end ();
-      iter ++)
-    {
-      (*iter)->SerializeToXmlStream (os, indent);
-    }
-
-  if (enableProbes)
-    {
-      os << std::string ( indent, ' ' ) << "<FlowProbes>\n";
-      indent += 2;
-      for (uint32_t i = 0; i < m_flowProbes.size (); i++)
-        {
-          m_flowProbes[i]->SerializeToXmlStream (os, indent, i);
-        }
-      indent -= 2;
-      os << std::string ( indent, ' ' ) << "</FlowProbes>\n";
-    }
-
-  indent -= 2;
-  os << std::string ( indent, ' ' ) << "</FlowMonitor>\n";
 }
 
 
@@ -500,5 +539,228 @@ FlowMonitor::SerializeToXmlFile (std::string fileName, bool enableHistograms, bo
 }
 
 
-} // namespace ns3
+/// Columns of a histogram in a binary FlowStats table
+struct HistogramColumns
+{
+  uint32_t binWidth;  //!< The bin width of the histogram of each flow
+  uint32_t length;    //!< The number of non-empty bins of the histogram of each flow
+  uint32_t index;     //!< The indexes of the non-empty bins
+  uint32_t count;     //!< The counts of the non-empty bins
+};
+
+/**
+ * \brief Add the columns of a histogram to a binary FlowStats table
+ * \param table the table
+ * \param name the name of the histogram
+ * \returns the columns
+ */
+static HistogramColumns
+AddHistogramColumns (FlowMonitorBinaryTable &table, std::string name)
+{
+  HistogramColumns columns;
+  columns.binWidth = table.AddColumn (name + ".binWidth", FlowMonitorBinaryTable::REAL, 8);
+  columns.length = table.AddColumn (name + ".length", FlowMonitorBinaryTable::UNSIGNED, 4);
+  columns.index = table.AddColumn (name + ".index", FlowMonitorBinaryTable::UNSIGNED, 4);
+  columns.count = table.AddColumn (name + ".count", FlowMonitorBinaryTable::UNSIGNED, 4);
+  return columns;
+}
 
+/**
+ * \brief Add the histogram of a flow to a binary FlowStats table
+ * \param table the table
+ * \param columns the columns of the histogram
+ * \param histogram the histogram
+ */
+static void
+AddHistogram (FlowMonitorBinaryTable &table, const HistogramColumns &columns, Histogram &histogram)
+{
+  uint32_t length = 0;
+  for (uint32_t index = 0; index < histogram.GetNBins (); index++)
+    {
+      uint32_t count = histogram.GetBinCount (index);
+      if (count)
+        {
+          table.AddUnsigned (columns.index, index);
+          table.AddUnsigned (columns.count, count);
+          length++;
+        }
+    }
+  table.AddReal (columns.binWidth, histogram.GetBinWidth (0));
+  table.AddUnsigned (columns.length, length);
+}
+
+void
+FlowMonitor::WriteBinarySnapshot (std::ostream &os, bool enableHistograms, bool incremental)
+{
+  Time now = Simulator::Now ();
+  FlowMonitorBinaryTable table ("FlowStats");
+  table.SetTime (now);
+  uint32_t flowId = table.AddColumn ("flowId", FlowMonitorBinaryTable::UNSIGNED, 4);
+  uint32_t timeFirstTxPacket = table.AddColumn ("timeFirstTxPacket", FlowMonitorBinaryTable::SIGNED, 8);
+  uint32_t timeFirstRxPacket = table.AddColumn ("timeFirstRxPacket", FlowMonitorBinaryTable::SIGNED, 8);
+  uint32_t timeLastTxPacket = table.AddColumn ("timeLastTxPacket", FlowMonitorBinaryTable::SIGNED, 8);
+  uint32_t timeLastRxPacket = table.AddColumn ("timeLastRxPacket", FlowMonitorBinaryTable::SIGNED, 8);
+  uint32_t delaySum = table.AddColumn ("delaySum", FlowMonitorBinaryTable::SIGNED, 8);
+  uint32_t jitterSum = table.AddColumn ("jitterSum", FlowMonitorBinaryTable::SIGNED, 8);
+  uint32_t lastDelay = table.AddColumn ("lastDelay", FlowMonitorBinaryTable::SIGNED, 8);
+  uint32_t txBytes = table.AddColumn ("txBytes", FlowMonitorBinaryTable::UNSIGNED, 8);
+  uint32_t rxBytes = table.AddColumn ("rxBytes", FlowMonitorBinaryTable::UNSIGNED, 8);
+  uint32_t txPackets = table.AddColumn ("txPackets", FlowMonitorBinaryTable::UNSIGNED, 4);
+  uint32_t rxPackets = table.AddColumn ("rxPackets", FlowMonitorBinaryTable::UNSIGNED, 4);
+  uint32_t lostPackets = table.AddColumn ("lostPackets", FlowMonitorBinaryTable::UNSIGNED, 4);
+  uint32_t timesForwarded = table.AddColumn ("timesForwarded", FlowMonitorBinaryTable::UNSIGNED, 4);
+  // packetsDropped and bytesDropped always have the same size
+  uint32_t droppedLength = table.AddColumn ("dropped.length", FlowMonitorBinaryTable::UNSIGNED, 4);
+  uint32_t packetsDropped = table.AddColumn ("packetsDropped", FlowMonitorBinaryTable::UNSIGNED, 4);
+  uint32_t bytesDropped = table.AddColumn ("bytesDropped", FlowMonitorBinaryTable::UNSIGNED, 8);
+  HistogramColumns delayHistogram = HistogramColumns ();
+  HistogramColumns jitterHistogram = HistogramColumns ();
+  HistogramColumns packetSizeHistogram = HistogramColumns ();
+  HistogramColumns flowInterruptionsHistogram = HistogramColumns ();
+  if (enableHistograms)
+    {
+      delayHistogram = AddHistogramColumns (table, "delayHistogram");
+      jitterHistogram = AddHistogramColumns (table, "jitterHistogram");
+      packetSizeHistogram = AddHistogramColumns (table, "packetSizeHistogram");
+      flowInterruptionsHistogram = AddHistogramColumns (table, "flowInterruptionsHistogram");
+    }
+
+  for (FlowStatsContainerI flowI = m_flowStats.begin (); flowI != m_flowStats.end (); flowI++)
+    {
+      FlowStats &stats = flowI->second;
+      if (incremental)
+        {
+          // every change of the statistics of a flow comes with a sent,
+          // received or lost packet
+          uint64_t packets = static_cast<uint64_t> (stats.txPackets) + stats.rxPackets + stats.lostPackets;
+          uint64_t &lastPackets = m_snapshotPackets[flowI->first];
+          if (packets == lastPackets)
+            {
+              continue;
+            }
+          lastPackets = packets;
+        }
+      table.AddUnsigned (flowId, flowI->first);
+      table.AddSigned (timeFirstTxPacket, stats.timeFirstTxPacket.GetNanoSeconds ());
+      table.AddSigned (timeFirstRxPacket, stats.timeFirstRxPacket.GetNanoSeconds ());
+      table.AddSigned (timeLastTxPacket, stats.timeLastTxPacket.GetNanoSeconds ());
+      table.AddSigned (timeLastRxPacket, stats.timeLastRxPacket.GetNanoSeconds ());
+      table.AddSigned (delaySum, stats.delaySum.GetNanoSeconds ());
+      table.AddSigned (jitterSum, stats.jitterSum.GetNanoSeconds ());
+      table.AddSigned (lastDelay, stats.lastDelay.GetNanoSeconds ());
+      table.AddUnsigned (txBytes, stats.txBytes);
+      table.AddUnsigned (rxBytes, stats.rxBytes);
+      table.AddUnsigned (txPackets, stats.txPackets);
+      table.AddUnsigned (rxPackets, stats.rxPackets);
+      table.AddUnsigned (lostPackets, stats.lostPackets);
+      table.AddUnsigned (timesForwarded, stats.timesForwarded);
+      table.AddUnsigned (droppedLength, stats.packetsDropped.size ());
+      for (uint32_t reasonCode = 0; reasonCode < stats.packetsDropped.size (); reasonCode++)
+        {
+          table.AddUnsigned (packetsDropped, stats.packetsDropped[reasonCode]);
+          table.AddUnsigned (bytesDropped, stats.bytesDropped[reasonCode]);
+        }
+      if (enableHistograms)
+        {
+          AddHistogram (table, delayHistogram, stats.delayHistogram);
+          AddHistogram (table, jitterHistogram, stats.jitterHistogram);
+          AddHistogram (table, packetSizeHistogram, stats.packetSizeHistogram);
+          AddHistogram (table, flowInterruptionsHistogram, stats.flowInterruptionsHistogram);
+        }
+    }
+  table.Write (os);
+
+  uint32_t i = 0;
+  for (std::list<Ptr<FlowClassifier> >::iterator iter = m_classifiers.begin ();
+       iter != m_classifiers.end (); iter++, i++)
+    {
+      if (i == m_snapshotFlowIds.size ())
+        {
+          m_snapshotFlowIds.push_back (0);
+        }
+      FlowMonitorBinaryTable classifierTable;
+      (*iter)->SerializeToBinaryTable (classifierTable, incremental ? m_snapshotFlowIds[i] : 0);
+      int32_t classifierFlowId = classifierTable.FindColumn ("flowId");
+      if (classifierFlowId < 0)
+        {
+          // binary format not supported by this classifier
+          continue;
+        }
+      classifierTable.SetTime (now);
+      classifierTable.Write (os);
+      if (incremental)
+        {
+          for (uint32_t row = 0; row < classifierTable.GetNValues (classifierFlowId); row++)
+            {
+              FlowId id = classifierTable.GetUnsigned (classifierFlowId, row);
+              m_snapshotFlowIds[i] = std::max (m_snapshotFlowIds[i], id + 1);
+            }
+        }
+    }
+  os.flush ();
+}
+
+void
+FlowMonitor::SerializeToBinaryStream (std::ostream &os, bool enableHistograms)
+{
+  CheckForLostPackets ();
+
+  FlowMonitorBinaryTable::WriteHeader (os);
+  WriteBinarySnapshot (os, enableHistograms, false);
+}
+
+void
+FlowMonitor::SerializeToBinaryFile (std::string fileName, bool enableHistograms)
+{
+  std::ofstream os (fileName.c_str (), std::ios::out|std::ios::binary);
+  SerializeToBinaryStream (os, enableHistograms);
+  os.close ();
+}
+
+void
+FlowMonitor::StartBinarySnapshots (std::string fileName, Time interval, bool enableHistograms)
+{
+  StopBinarySnapshots ();
+  m_snapshotStream.open (fileName.c_str (), std::ios::out|std::ios::binary);
+  if (!m_snapshotStream.is_open ())
+    {
+      NS_LOG_WARN ("Could not open " << fileName);
+      return;
+    }
+  FlowMonitorBinaryTable::WriteHeader (m_snapshotStream);
+  m_snapshotInterval = interval;
+  m_snapshotHistograms = enableHistograms;
+  m_snapshotPackets.clear ();
+  m_snapshotFlowIds.clear ();
+  m_snapshotEvent = Simulator::Schedule (m_snapshotInterval, &FlowMonitor::PeriodicBinarySnapshot, this);
+  m_snapshotDestroyEvent = Simulator::ScheduleDestroy (&FlowMonitor::StopBinarySnapshots, Ptr<FlowMonitor> (this));
+}
+
+void
+FlowMonitor::PeriodicBinarySnapshot ()
+{
+  if (!m_snapshotStream.is_open ())
+    {
+      return;
+    }
+  CheckForLostPackets ();
+  WriteBinarySnapshot (m_snapshotStream, m_snapshotHistograms, true);
+  m_snapshotEvent = Simulator::Schedule (m_snapshotInterval, &FlowMonitor::PeriodicBinarySnapshot, this);
+}
+
+void
+FlowMonitor::StopBinarySnapshots ()
+{
+  if (!m_snapshotStream.is_open ())
+    {
+      return;
+    }
+  Simulator::Cancel (m_snapshotEvent);
+  Simulator::Cancel (m_snapshotDestroyEvent);
+  CheckForLostPackets ();
+  WriteBinarySnapshot (m_snapshotStream, m_snapshotHistograms, true);
+  m_snapshotStream.close ();
+}
+
+
+} // namespace ns3
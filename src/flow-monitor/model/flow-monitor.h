@@ -23,12 +23,16 @@
 
 #include <vector>
 #include <map>
+#include <list>
+#include <unordered_map>
+#include <fstream>
 
 #include "ns3/ptr.h"
 #include "ns3/object.h"
 #include "ns3/flow-probe.h"
 #include "ns3/flow-classifier.h"
 #include "ns3/histogram.h"
+#include "ns3/flow-monitor-binary-table.h"
 #include "ns3/nstime.h"
 #include "ns3/event-id.h"
 
@@ -206,7 +210,8 @@ public:
 
   /// Check right now for packets that appear to be lost, considering
   /// packets as lost if not seen in the network for a time larger
-  /// than maxDelay
+  /// than maxDelay. Only the packets that are considered lost are
+  /// visited, whatever the number of packets in flight.
   /// \param maxDelay the max delay for a packet
   void CheckForLostPackets (Time maxDelay);
 
@@ -256,6 +261,46 @@ public:
   /// \param enableProbes if true, include also the per-probe/flow pair statistics in the output
   void SerializeToXmlFile (std::string fileName, bool enableHistograms, bool enableProbes);
 
+  /// Serializes the statistics of a set of flows to an std::ostream in XML
+  /// format, as the FlowStats element of SerializeToXmlStream
+  /// \param os the output stream
+  /// \param indent number of spaces to use as base indentation level
+  /// \param flowStats the statistics of the flows
+  /// \param enableHistograms if true, include also the histograms in the output
+  static void SerializeFlowStatsToXmlStream (std::ostream &os, uint16_t indent,
+                                             const FlowStatsContainer &flowStats, bool enableHistograms);
+
+  /// Serializes the results to an std::ostream in a compact binary format,
+  /// made of tables of columns (see FlowMonitorBinaryTable): a FlowStats
+  /// table, with one row per flow, and a table per classifier supporting
+  /// this format (e.g., Ipv4FlowClassifier), with the five-tuple of each
+  /// flow.  The per-probe statistics are not included.
+  /// \param os the output stream
+  /// \param enableHistograms if true, include also the histograms in the output
+  void SerializeToBinaryStream (std::ostream &os, bool enableHistograms);
+
+  /// Same as SerializeToBinaryStream, but writes to a file instead
+  /// \param fileName name or path of the output file that will be created
+  /// \param enableHistograms if true, include also the histograms in the output
+  void SerializeToBinaryFile (std::string fileName, bool enableHistograms);
+
+  /// Starts writing the results to a file in binary format, periodically
+  /// during the simulation.  Every snapshot is written as by
+  /// SerializeToBinaryStream, but only holds the flows whose statistics
+  /// changed since the previous snapshot, and the classifier entries of
+  /// the new flows; a reader keeps the last statistics of every flow
+  /// (see FlowMonitorBinaryReader).
+  /// The last snapshot is written by StopBinarySnapshots, which is called
+  /// when the simulator is destroyed unless it was called before.
+  /// \param fileName name or path of the output file that will be created
+  /// \param interval the time between two snapshots
+  /// \param enableHistograms if true, include also the histograms in the output
+  void StartBinarySnapshots (std::string fileName, Time interval, bool enableHistograms);
+
+  /// Writes a last snapshot and closes the file opened by StartBinarySnapshots.
+  /// It must be called before Simulator::Destroy returns.
+  void StopBinarySnapshots ();
+
 
 protected:
 
@@ -264,20 +309,40 @@ protected:
 
 private:
 
+  /// Identifies a tracked packet: (FlowId,PacketId)
+  typedef std::pair<FlowId, FlowPacketId> TrackedPacketKey;
+
+  /// Hash function of the tracked packet keys
+  struct TrackedPacketKeyHash
+  {
+    /// \param key the key
+    /// \returns the hash of the key
+    size_t operator() (const TrackedPacketKey &key) const;
+  };
+
+  /// Keys of the tracked packets, from the least to the most recently seen
+  typedef std::list<TrackedPacketKey> TrackedPacketList;
+
   /// Structure to represent a single tracked packet data
   struct TrackedPacket
   {
     Time firstSeenTime; //!< absolute time when the packet was first seen by a probe
     Time lastSeenTime; //!< absolute time when the packet was last seen by a probe
     uint32_t timesForwarded; //!< number of times the packet was reportedly forwarded
+    TrackedPacketList::iterator seen; //!< position of the packet in m_lastSeen
   };
 
   /// FlowId --> FlowStats
   FlowStatsContainer m_flowStats;
 
   /// (FlowId,PacketId) --> TrackedPacket
-  typedef std::map< std::pair<FlowId, FlowPacketId>, TrackedPacket> TrackedPacketMap;
+  typedef std::unordered_map<TrackedPacketKey, TrackedPacket, TrackedPacketKeyHash> TrackedPacketMap;
   TrackedPacketMap m_trackedPackets; //!< Tracked packets
+  /// The tracked packets, by increasing lastSeenTime. A packet is moved
+  /// to the end every time it is seen; since it is always seen at the
+  /// current simulation time, the list remains sorted and the packets
+  /// that time out first are at its beginning.
+  TrackedPacketList m_lastSeen;
   Time m_maxPerHopDelay; //!< Minimum per-hop delay
   FlowProbeContainer m_flowProbes; //!< all the FlowProbes
 
@@ -298,8 +363,31 @@ private:
   /// \returns the stats of the flow
   FlowStats& GetStatsForFlow (FlowId flowId);
 
+  /// Stop tracking a packet
+  /// \param tracked the tracked packet
+  void RemoveTrackedPacket (TrackedPacketMap::iterator tracked);
+
   /// Periodic function to check for lost packets and prune statistics
   void PeriodicCheckForLostPackets ();
+
+  /// Writes the results in binary format
+  /// \param os the output stream
+  /// \param enableHistograms if true, include also the histograms in the output
+  /// \param incremental if true, only include the flows which changed since the last snapshot
+  void WriteBinarySnapshot (std::ostream &os, bool enableHistograms, bool incremental);
+
+  /// Periodic function to write a binary snapshot
+  void PeriodicBinarySnapshot ();
+
+  std::ofstream m_snapshotStream;   //!< Output stream of the binary snapshots
+  Time m_snapshotInterval;          //!< Time between two binary snapshots
+  bool m_snapshotHistograms;        //!< Include the histograms in the binary snapshots
+  EventId m_snapshotEvent;          //!< Next binary snapshot event
+  EventId m_snapshotDestroyEvent;   //!< Last binary snapshot, when the simulator is destroyed
+  /// FlowId --> number of sent, received and lost packets at the last snapshot
+  std::unordered_map<FlowId, uint64_t> m_snapshotPackets;
+  /// The first flow of each classifier not written in a snapshot yet
+  std::vector<FlowId> m_snapshotFlowIds;
 };
 
 
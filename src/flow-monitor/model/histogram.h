@@ -103,6 +103,14 @@ public:
    */
   void AddValue (double value);
 
+  /**
+   * \brief Add a number of data to a bin, e.g., to restore a serialized
+   * histogram
+   * \param index the bin index
+   * \param count the number of data to add to the bin
+   */
+  void AddBinCount (uint32_t index, uint32_t count);
+
   /**
    * \brief Serializes the results to an std::ostream in XML format.
    * \param os the output stream
@@ -260,6 +260,32 @@ Ipv4FlowClassifier::SerializeToXmlStream (std::ostream &os, uint16_t indent) con
   Indent (os, indent); os << "</Ipv4FlowClassifier>\n";
 }
 
+void
+Ipv4FlowClassifier::SerializeToBinaryTable (FlowMonitorBinaryTable &table, FlowId minFlowId) const
+{
+  table.SetName ("Ipv4FlowClassifier");
+  uint32_t flowId = table.AddColumn ("flowId", FlowMonitorBinaryTable::UNSIGNED, 4);
+  uint32_t sourceAddress = table.AddColumn ("sourceAddress", FlowMonitorBinaryTable::UNSIGNED, 4);
+  uint32_t destinationAddress = table.AddColumn ("destinationAddress", FlowMonitorBinaryTable::UNSIGNED, 4);
+  uint32_t protocol = table.AddColumn ("protocol", FlowMonitorBinaryTable::UNSIGNED, 1);
+  uint32_t sourcePort = table.AddColumn ("sourcePort", FlowMonitorBinaryTable::UNSIGNED, 2);
+  uint32_t destinationPort = table.AddColumn ("destinationPort", FlowMonitorBinaryTable::UNSIGNED, 2);
+
+  for (std::map<FiveTuple, FlowId>::const_iterator
+       iter = m_flowMap.begin (); iter != m_flowMap.end (); iter++)
+    {
+      if (iter->second < minFlowId)
+        {
+          continue;
+        }
+      table.AddUnsigned (flowId, iter->second);
+      table.AddUnsigned (sourceAddress, iter->first.sourceAddress.Get ());
+      table.AddUnsigned (destinationAddress, iter->first.destinationAddress.Get ());
+      table.AddUnsigned (protocol, iter->first.protocol);
+      table.AddUnsigned (sourcePort, iter->first.sourcePort);
+      table.AddUnsigned (destinationPort, iter->first.destinationPort);
+    }
+}
 
-} // namespace ns3
 
+} // namespace ns3
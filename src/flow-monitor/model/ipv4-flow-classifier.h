@@ -89,6 +89,7 @@ public:
   std::vector<std::pair<Ipv4Header::DscpType, uint32_t> > GetDscpCounts (FlowId flowId) const;
 
   virtual void SerializeToXmlStream (std::ostream &os, uint16_t indent) const;
+  virtual void SerializeToBinaryTable (FlowMonitorBinaryTable &table, FlowId minFlowId) const;
 
 private:
 
@@ -262,6 +262,35 @@ Ipv6FlowClassifier::SerializeToXmlStream (std::ostream &os, uint16_t indent) con
 
 }
 
+void
+Ipv6FlowClassifier::SerializeToBinaryTable (FlowMonitorBinaryTable &table, FlowId minFlowId) const
+{
+  table.SetName ("Ipv6FlowClassifier");
+  uint32_t flowId = table.AddColumn ("flowId", FlowMonitorBinaryTable::UNSIGNED, 4);
+  uint32_t sourceAddress = table.AddColumn ("sourceAddress", FlowMonitorBinaryTable::BYTES, 16);
+  uint32_t destinationAddress = table.AddColumn ("destinationAddress", FlowMonitorBinaryTable::BYTES, 16);
+  uint32_t protocol = table.AddColumn ("protocol", FlowMonitorBinaryTable::UNSIGNED, 1);
+  uint32_t sourcePort = table.AddColumn ("sourcePort", FlowMonitorBinaryTable::UNSIGNED, 2);
+  uint32_t destinationPort = table.AddColumn ("destinationPort", FlowMonitorBinaryTable::UNSIGNED, 2);
+
+  for (std::map<FiveTuple, FlowId>::const_iterator
+       iter = m_flowMap.begin (); iter != m_flowMap.end (); iter++)
+    {
+      if (iter->second < minFlowId)
+        {
+          continue;
+        }
+      table.AddUnsigned (flowId, iter->second);
+      uint8_t buf[16];
+      iter->first.sourceAddress.Serialize (buf);
+      table.AddBytes (sourceAddress, buf);
+      iter->first.destinationAddress.Serialize (buf);
+      table.AddBytes (destinationAddress, buf);
+      table.AddUnsigned (protocol, iter->first.protocol);
+      table.AddUnsigned (sourcePort, iter->first.sourcePort);
+      table.AddUnsigned (destinationPort, iter->first.destinationPort);
+    }
+}
 
-} // namespace ns3
 
+} // namespace ns3
@@ -90,6 +90,7 @@ public:
   std::vector<std::pair<Ipv6Header::DscpType, uint32_t> > GetDscpCounts (FlowId flowId) const;
 
   virtual void SerializeToXmlStream (std::ostream &os, uint16_t indent) const;
+  virtual void SerializeToBinaryTable (FlowMonitorBinaryTable &table, FlowId minFlowId) const;
 
 private:
 
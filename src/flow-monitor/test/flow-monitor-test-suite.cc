@@ -0,0 +1,604 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/flow-monitor.h"
+#include "ns3/flow-probe.h"
+#include "ns3/flow-monitor-binary-reader.h"
+#include "ns3/ipv4-flow-classifier.h"
+#include "ns3/ipv6-flow-classifier.h"
+#include "ns3/ipv4-header.h"
+#include "ns3/ipv6-header.h"
+#include "ns3/udp-header.h"
+#include "ns3/packet.h"
+#include "ns3/simulator.h"
+#include "ns3/nstime.h"
+#include "ns3/random-variable-stream.h"
+#include "ns3/test.h"
+#include <vector>
+#include <sstream>
+#include <fstream>
+
+using namespace ns3;
+
+/**
+ * \ingroup flow-monitor-test
+ * \ingroup tests
+ *
+ * \brief A FlowProbe which is only used to report packets to the FlowMonitor.
+ */
+class FlowMonitorTestProbe : public FlowProbe
+{
+public:
+  /**
+   * Constructor
+   * \param monitor the FlowMonitor
+   */
+  FlowMonitorTestProbe (Ptr<FlowMonitor> monitor)
+    : FlowProbe (monitor)
+  {
+  }
+};
+
+/**
+ * \ingroup flow-monitor-test
+ * \ingroup tests
+ *
+ * \brief FlowMonitor lost packets test
+ *
+ * Checks that the packets which have not been seen for more than the
+ * maximum per-hop delay, and only them, are counted as lost.
+ */
+class FlowMonitorLostPacketsTestCase : public TestCase
+{
+public:
+  FlowMonitorLostPacketsTestCase ();
+  virtual void DoRun (void);
+
+private:
+  /**
+   * Report the first transmission of packets
+   * \param flowId the flow
+   * \param first the first packet
+   * \param n the number of packets
+   */
+  void FirstTx (FlowId flowId, FlowPacketId first, uint32_t n);
+  /**
+   * Report the forwarding of a packet
+   * \param flowId the flow
+   * \param packetId the packet
+   */
+  void Forward (FlowId flowId, FlowPacketId packetId);
+  /**
+   * Report the reception of a packet
+   * \param flowId the flow
+   * \param packetId the packet
+   */
+  void LastRx (FlowId flowId, FlowPacketId packetId);
+  /**
+   * Report the drop of a packet
+   * \param flowId the flow
+   * \param packetId the packet
+   */
+  void Drop (FlowId flowId, FlowPacketId packetId);
+  /**
+   * Check for lost packets and the number of lost packets of a flow
+   * \param maxDelay the delay after which packets are lost (zero for the default)
+   * \param flowId the flow
+   * \param lostPackets the expected number of lost packets
+   */
+  void CheckLost (Time maxDelay, FlowId flowId, uint32_t lostPackets);
+
+  Ptr<FlowMonitor> m_monitor;   //!< The FlowMonitor
+  Ptr<FlowProbe> m_probe;       //!< The probe reporting the packets
+};
+
+FlowMonitorLostPacketsTestCase::FlowMonitorLostPacketsTestCase ()
+  : TestCase ("Packets not seen for more than the maximum per-hop delay are lost")
+{
+}
+
+void
+FlowMonitorLostPacketsTestCase::FirstTx (FlowId flowId, FlowPacketId first, uint32_t n)
+{
+  for (FlowPacketId packetId = first; packetId < first + n; packetId++)
+    {
+      m_monitor->ReportFirstTx (m_probe, flowId, packetId, 100);
+    }
+}
+
+void
+FlowMonitorLostPacketsTestCase::Forward (FlowId flowId, FlowPacketId packetId)
+{
+  m_monitor->ReportForwarding (m_probe, flowId, packetId, 100);
+}
+
+void
+FlowMonitorLostPacketsTestCase::LastRx (FlowId flowId, FlowPacketId packetId)
+{
+  m_monitor->ReportLastRx (m_probe, flowId, packetId, 100);
+}
+
+void
+FlowMonitorLostPacketsTestCase::Drop (FlowId flowId, FlowPacketId packetId)
+{
+  m_monitor->ReportDrop (m_probe, flowId, packetId, 100, 0);
+}
+
+void
+FlowMonitorLostPacketsTestCase::CheckLost (Time maxDelay, FlowId flowId, uint32_t lostPackets)
+{
+  if (maxDelay.IsZero ())
+    {
+      m_monitor->CheckForLostPackets ();
+    }
+  else
+    {
+      m_monitor->CheckForLostPackets (maxDelay);
+    }
+  const FlowMonitor::FlowStatsContainer &stats = m_monitor->GetFlowStats ();
+  FlowMonitor::FlowStatsContainer::const_iterator flow = stats.find (flowId);
+  NS_TEST_ASSERT_MSG_EQ ((flow != stats.end ()), true, "No stats for flow " << flowId);
+  NS_TEST_EXPECT_MSG_EQ (flow->second.lostPackets, lostPackets,
+                         "Wrong number of lost packets of flow " << flowId << " at " << Simulator::Now ().GetSeconds ());
+}
+
+void
+FlowMonitorLostPacketsTestCase::DoRun (void)
+{
+  m_monitor = CreateObject<FlowMonitor> ();
+  m_monitor->SetAttribute ("MaxPerHopDelay", TimeValue (Seconds (1)));
+  m_probe = Create<FlowMonitorTestProbe> (m_monitor);
+  m_monitor->StartRightNow ();
+
+  Time none = Seconds (0);
+  FirstTx (1, 0, 10);
+  FirstTx (2, 0, 5);
+  Simulator::Schedule (MilliSeconds (500), &FlowMonitorLostPacketsTestCase::Forward, this, 1, 3);
+  Simulator::Schedule (MilliSeconds (500), &FlowMonitorLostPacketsTestCase::LastRx, this, 1, 4);
+  Simulator::Schedule (MilliSeconds (500), &FlowMonitorLostPacketsTestCase::Drop, this, 2, 0);
+  Simulator::Schedule (MilliSeconds (600), &FlowMonitorLostPacketsTestCase::FirstTx, this, 1, 10, 5);
+
+  Simulator::Schedule (MilliSeconds (900), &FlowMonitorLostPacketsTestCase::CheckLost, this, none, 1, 0);
+  Simulator::Schedule (MilliSeconds (900), &FlowMonitorLostPacketsTestCase::CheckLost, this, none, 2, 1);
+  // the packets not seen since 0 are lost, except the received and dropped ones
+  Simulator::Schedule (Seconds (1), &FlowMonitorLostPacketsTestCase::CheckLost, this, none, 1, 8);
+  Simulator::Schedule (Seconds (1), &FlowMonitorLostPacketsTestCase::CheckLost, this, none, 2, 5);
+  // packets 10-14 of flow 1 were sent at 0.6, packet 3 forwarded at 0.5
+  Simulator::Schedule (MilliSeconds (1100), &FlowMonitorLostPacketsTestCase::CheckLost, this, MilliSeconds (600), 1, 9);
+  Simulator::Schedule (MilliSeconds (1100), &FlowMonitorLostPacketsTestCase::LastRx, this, 1, 10);
+  Simulator::Schedule (MilliSeconds (1200), &FlowMonitorLostPacketsTestCase::CheckLost, this, MilliSeconds (600), 1, 13);
+  // packet 11 is no longer tracked when it is received
+  Simulator::Schedule (MilliSeconds (1200), &FlowMonitorLostPacketsTestCase::LastRx, this, 1, 11);
+
+  Simulator::Stop (Seconds (2));
+  Simulator::Run ();
+
+  const FlowMonitor::FlowStatsContainer &stats = m_monitor->GetFlowStats ();
+  NS_TEST_EXPECT_MSG_EQ (stats.find (1)->second.rxPackets, 2, "Wrong number of received packets");
+  NS_TEST_EXPECT_MSG_EQ (stats.find (1)->second.timesForwarded, 0, "Wrong number of forwards");
+
+  Simulator::Destroy ();
+  m_monitor->Dispose ();
+  m_monitor = 0;
+  m_probe = 0;
+}
+
+/**
+ * \ingroup flow-monitor-test
+ * \ingroup tests
+ *
+ * \brief FlowMonitor lost packets test, with many packets in flight
+ *
+ * Packets are sent and forwarded at random times; the number of
+ * lost packets is checked against the one counted from the times
+ * each packet was last seen.
+ */
+class FlowMonitorManyLostPacketsTestCase : public TestCase
+{
+public:
+  FlowMonitorManyLostPacketsTestCase ();
+  virtual void DoRun (void);
+
+private:
+  /**
+   * Report the first transmission or the forwarding of a packet
+   * \param packetId the packet
+   */
+  void See (FlowPacketId packetId);
+  /**
+   * Check for lost packets and the number of lost packets
+   */
+  void CheckLost (void);
+
+  Ptr<FlowMonitor> m_monitor;   //!< The FlowMonitor
+  Ptr<FlowProbe> m_probe;       //!< The probe reporting the packets
+  std::vector<Time> m_lastSeen; //!< The time each packet was last seen (negative if lost)
+  uint32_t m_lostPackets;       //!< The expected number of lost packets
+};
+
+FlowMonitorManyLostPacketsTestCase::FlowMonitorManyLostPacketsTestCase ()
+  : TestCase ("Lost packets with many packets in flight"),
+    m_lostPackets (0)
+{
+}
+
+void
+FlowMonitorManyLostPacketsTestCase::See (FlowPacketId packetId)
+{
+  if (m_lastSeen[packetId].IsStrictlyNegative ())
+    {
+      return;
+    }
+  if (m_lastSeen[packetId].IsStrictlyPositive ())
+    {
+      m_monitor->ReportForwarding (m_probe, 1, packetId, 100);
+    }
+  else
+    {
+      m_monitor->ReportFirstTx (m_probe, 1, packetId, 100);
+    }
+  m_lastSeen[packetId] = Simulator::Now ();
+}
+
+void
+FlowMonitorManyLostPacketsTestCase::CheckLost (void)
+{
+  for (uint32_t i = 0; i < m_lastSeen.size (); i++)
+    {
+      if (m_lastSeen[i].IsStrictlyPositive () && Simulator::Now () - m_lastSeen[i] >= Seconds (1))
+        {
+          m_lastSeen[i] = Seconds (-1);
+          m_lostPackets++;
+        }
+    }
+  m_monitor->CheckForLostPackets ();
+  NS_TEST_EXPECT_MSG_EQ (m_monitor->GetFlowStats ().find (1)->second.lostPackets, m_lostPackets,
+                         "Wrong number of lost packets at " << Simulator::Now ().GetSeconds ());
+}
+
+void
+FlowMonitorManyLostPacketsTestCase::DoRun (void)
+{
+  m_monitor = CreateObject<FlowMonitor> ();
+  m_monitor->SetAttribute ("MaxPerHopDelay", TimeValue (Seconds (1)));
+  m_probe = Create<FlowMonitorTestProbe> (m_monitor);
+  m_monitor->StartRightNow ();
+
+  Ptr<UniformRandomVariable> rand = CreateObject<UniformRandomVariable> ();
+  rand->SetStream (1);
+  uint32_t nPackets = 2000;
+  m_lastSeen.resize (nPackets, Seconds (0));
+  for (FlowPacketId packetId = 0; packetId < nPackets; packetId++)
+    {
+      // sent in (0, 5], then seen up to 3 times more
+      Time seen = MicroSeconds (rand->GetInteger (1, 5000000));
+      Simulator::Schedule (seen, &FlowMonitorManyLostPacketsTestCase::See, this, packetId);
+      uint32_t nHops = rand->GetInteger (0, 3);
+      for (uint32_t hop = 0; hop < nHops; hop++)
+        {
+          seen += MicroSeconds (rand->GetInteger (1, 1200000));
+          Simulator::Schedule (seen, &FlowMonitorManyLostPacketsTestCase::See, this, packetId);
+        }
+    }
+  // the checks are run after the periodic ones of the FlowMonitor,
+  // which were scheduled first
+  for (uint32_t i = 1; i <= 20; i++)
+    {
+      Simulator::Schedule (MilliSeconds (500 * i), &FlowMonitorManyLostPacketsTestCase::CheckLost, this);
+    }
+
+  Simulator::Stop (Seconds (11));
+  Simulator::Run ();
+
+  NS_TEST_EXPECT_MSG_EQ (m_lostPackets, nPackets, "All the packets should have been lost");
+
+  Simulator::Destroy ();
+  m_monitor->Dispose ();
+  m_monitor = 0;
+  m_probe = 0;
+}
+
+/**
+ * \ingroup flow-monitor-test
+ * \ingroup tests
+ *
+ * \brief FlowMonitor binary format test
+ *
+ * Checks that the results written in binary format, in one go and as
+ * periodic snapshots, are read back unchanged.
+ */
+class FlowMonitorBinaryTestCase : public TestCase
+{
+public:
+  FlowMonitorBinaryTestCase ();
+  virtual void DoRun (void);
+
+private:
+  /**
+   * Send a packet of an IPv4 flow, then forward, receive or drop it later
+   * \param flow the index of the flow
+   * \param i the index of the packet in the flow
+   */
+  void Send (uint32_t flow, uint32_t i);
+  /**
+   * Report the forwarding of a packet
+   * \param flowId the flow
+   * \param packetId the packet
+   * \param size the packet size
+   */
+  void Forward (FlowId flowId, FlowPacketId packetId, uint32_t size);
+  /**
+   * Report the reception of a packet
+   * \param flowId the flow
+   * \param packetId the packet
+   * \param size the packet size
+   */
+  void LastRx (FlowId flowId, FlowPacketId packetId, uint32_t size);
+  /**
+   * Report the drop of a packet
+   * \param flowId the flow
+   * \param packetId the packet
+   * \param size the packet size
+   * \param reasonCode the drop reason code
+   */
+  void Drop (FlowId flowId, FlowPacketId packetId, uint32_t size, uint32_t reasonCode);
+  /**
+   * Check that the results read back are the ones of the FlowMonitor
+   * \param reader the reader
+   */
+  void CheckResults (const FlowMonitorBinaryReader &reader);
+
+  Ptr<FlowMonitor> m_monitor;               //!< The FlowMonitor
+  Ptr<FlowProbe> m_probe;                   //!< The probe reporting the packets
+  Ptr<Ipv4FlowClassifier> m_classifier;     //!< The IPv4 classifier
+  Ptr<Ipv6FlowClassifier> m_classifier6;    //!< The IPv6 classifier
+};
+
+FlowMonitorBinaryTestCase::FlowMonitorBinaryTestCase ()
+  : TestCase ("Results written in binary format are read back unchanged")
+{
+}
+
+void
+FlowMonitorBinaryTestCase::Send (uint32_t flow, uint32_t i)
+{
+  uint32_t size = 100 + 10 * i;
+  Ptr<Packet> packet = Create<Packet> (size);
+  UdpHeader udpHeader;
+  udpHeader.SetSourcePort (1000 + flow);
+  udpHeader.SetDestinationPort (9);
+  packet->AddHeader (udpHeader);
+  Ipv4Header ipHeader;
+  ipHeader.SetSource (Ipv4Address (0x0a000001 + flow));
+  ipHeader.SetDestination (Ipv4Address ("10.1.0.1"));
+  ipHeader.SetProtocol (17);
+
+  uint32_t flowId;
+  uint32_t packetId;
+  bool classified = m_classifier->Classify (ipHeader, packet, &flowId, &packetId);
+  NS_TEST_ASSERT_MSG_EQ (classified, true, "The packet should have been classified");
+  size = packet->GetSize () + ipHeader.GetSerializedSize ();
+  m_monitor->ReportFirstTx (m_probe, flowId, packetId, size);
+
+  Time delay = MilliSeconds (10 * (flow + 1) + i % 3);
+  if (i % 2 == 0)
+    {
+      Simulator::Schedule (delay / 2, &FlowMonitorBinaryTestCase::Forward, this, flowId, packetId, size);
+    }
+  if (i % 7 == 3)
+    {
+      Simulator::Schedule (delay, &FlowMonitorBinaryTestCase::Drop, this, flowId, packetId, size, i % 2);
+    }
+  else if (i % 5 != 4)
+    {
+      Simulator::Schedule (delay, &FlowMonitorBinaryTestCase::LastRx, this, flowId, packetId, size);
+    }
+  // else the packet is lost
+}
+
+void
+FlowMonitorBinaryTestCase::Forward (FlowId flowId, FlowPacketId packetId, uint32_t size)
+{
+  m_monitor->ReportForwarding (m_probe, flowId, packetId, size);
+}
+
+void
+FlowMonitorBinaryTestCase::LastRx (FlowId flowId, FlowPacketId packetId, uint32_t size)
+{
+  m_monitor->ReportLastRx (m_probe, flowId, packetId, size);
+}
+
+void
+FlowMonitorBinaryTestCase::Drop (FlowId flowId, FlowPacketId packetId, uint32_t size, uint32_t reasonCode)
+{
+  m_monitor->ReportDrop (m_probe, flowId, packetId, size, reasonCode);
+}
+
+void
+FlowMonitorBinaryTestCase::CheckResults (const FlowMonitorBinaryReader &reader)
+{
+  // the XML output includes all the statistics and the histograms
+  std::ostringstream expected;
+  FlowMonitor::SerializeFlowStatsToXmlStream (expected, 0, m_monitor->GetFlowStats (), true);
+  std::ostringstream actual;
+  FlowMonitor::SerializeFlowStatsToXmlStream (actual, 0, reader.GetFlowStats (), true);
+  NS_TEST_EXPECT_MSG_EQ (actual.str (), expected.str (), "The flow statistics differ");
+
+  const FlowMonitor::FlowStatsContainer &stats = reader.GetFlowStats ();
+  NS_TEST_ASSERT_MSG_EQ (stats.size (), 4, "Wrong number of flows");
+  for (FlowMonitor::FlowStatsContainer::const_iterator i = stats.begin (); i != stats.end (); i++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (i->second.delayHistogram.GetBinWidth (0), 0.001, "Wrong delay bin width");
+      NS_TEST_EXPECT_MSG_EQ (i->second.packetSizeHistogram.GetNBins (),
+                             m_monitor->GetFlowStats ().find (i->first)->second.packetSizeHistogram.GetNBins (),
+                             "Wrong number of packet size bins");
+    }
+
+  const FlowMonitorBinaryReader::Ipv4FlowContainer &flows = reader.GetIpv4Flows ();
+  NS_TEST_ASSERT_MSG_EQ (flows.size (), 4, "Wrong number of IPv4 flows");
+  for (FlowMonitorBinaryReader::Ipv4FlowContainer::const_iterator i = flows.begin (); i != flows.end (); i++)
+    {
+      Ipv4FlowClassifier::FiveTuple tuple = m_classifier->FindFlow (i->first);
+      NS_TEST_EXPECT_MSG_EQ (i->second.sourceAddress, tuple.sourceAddress, "Wrong source address");
+      NS_TEST_EXPECT_MSG_EQ (i->second.destinationAddress, tuple.destinationAddress, "Wrong destination address");
+      NS_TEST_EXPECT_MSG_EQ ((uint32_t) i->second.protocol, (uint32_t) tuple.protocol, "Wrong protocol");
+      NS_TEST_EXPECT_MSG_EQ (i->second.sourcePort, tuple.sourcePort, "Wrong source port");
+      NS_TEST_EXPECT_MSG_EQ (i->second.destinationPort, tuple.destinationPort, "Wrong destination port");
+    }
+
+  const FlowMonitorBinaryReader::Ipv6FlowContainer &flows6 = reader.GetIpv6Flows ();
+  NS_TEST_ASSERT_MSG_EQ (flows6.size (), 1, "Wrong number of IPv6 flows");
+  NS_TEST_EXPECT_MSG_EQ (flows6.begin ()->second.sourceAddress, Ipv6Address ("2001:db8::1"), "Wrong IPv6 source address");
+  NS_TEST_EXPECT_MSG_EQ (flows6.begin ()->second.destinationAddress, Ipv6Address ("2001:db8::2"), "Wrong IPv6 destination address");
+  NS_TEST_EXPECT_MSG_EQ (flows6.begin ()->second.destinationPort, 80, "Wrong IPv6 destination port");
+}
+
+void
+FlowMonitorBinaryTestCase::DoRun (void)
+{
+  m_monitor = CreateObject<FlowMonitor> ();
+  m_monitor->SetAttribute ("MaxPerHopDelay", TimeValue (Seconds (1)));
+  m_probe = Create<FlowMonitorTestProbe> (m_monitor);
+  m_classifier = Create<Ipv4FlowClassifier> ();
+  m_classifier6 = Create<Ipv6FlowClassifier> ();
+  m_monitor->AddFlowClassifier (m_classifier);
+  m_monitor->AddFlowClassifier (m_classifier6);
+  m_monitor->StartRightNow ();
+
+  // only the five-tuple of the IPv6 flow is checked
+  Ptr<Packet> packet = Create<Packet> (100);
+  UdpHeader udpHeader;
+  udpHeader.SetSourcePort (5000);
+  udpHeader.SetDestinationPort (80);
+  packet->AddHeader (udpHeader);
+  Ipv6Header ipv6Header;
+  ipv6Header.SetSourceAddress (Ipv6Address ("2001:db8::1"));
+  ipv6Header.SetDestinationAddress (Ipv6Address ("2001:db8::2"));
+  ipv6Header.SetNextHeader (17);
+  uint32_t flowId;
+  uint32_t packetId;
+  m_classifier6->Classify (ipv6Header, packet, &flowId, &packetId);
+
+  for (uint32_t flow = 0; flow < 4; flow++)
+    {
+      for (uint32_t i = 0; i < 20; i++)
+        {
+          Simulator::Schedule (MilliSeconds (100 * (i + 1) + flow), &FlowMonitorBinaryTestCase::Send, this, flow, i);
+        }
+    }
+
+  std::string fileName = CreateTempDirFilename ("flow-monitor-snapshots.bin");
+  m_monitor->StartBinarySnapshots (fileName, Seconds (1), true);
+  Simulator::Stop (MilliSeconds (5500));
+  Simulator::Run ();
+  m_monitor->StopBinarySnapshots ();
+
+  std::stringstream stream;
+  m_monitor->SerializeToBinaryStream (stream, true);
+  FlowMonitorBinaryReader reader;
+  NS_TEST_ASSERT_MSG_EQ (reader.Read (stream), true, "The binary stream could not be read");
+  NS_TEST_EXPECT_MSG_EQ (reader.GetNSnapshots (), 1, "Wrong number of snapshots");
+  CheckResults (reader);
+
+  uint32_t lostPackets = 0;
+  for (FlowMonitor::FlowStatsContainer::const_iterator i = m_monitor->GetFlowStats ().begin ();
+       i != m_monitor->GetFlowStats ().end (); i++)
+    {
+      lostPackets += i->second.lostPackets;
+    }
+  NS_TEST_EXPECT_MSG_GT (lostPackets, 0, "Some packets should have been lost");
+
+  // the snapshots at 1, 2, 3, 4 and 5 s, and when stopped
+  FlowMonitorBinaryReader snapshotReader;
+  NS_TEST_ASSERT_MSG_EQ (snapshotReader.ReadFile (fileName), true, "The snapshots could not be read");
+  NS_TEST_EXPECT_MSG_EQ (snapshotReader.GetNSnapshots (), 6, "Wrong number of snapshots");
+  NS_TEST_EXPECT_MSG_EQ (snapshotReader.GetLastSnapshotTime (), MilliSeconds (5500), "Wrong time of the last snapshot");
+  CheckResults (snapshotReader);
+
+  // the last packet of flow 0, sent at 2 s, is considered lost at 3 s, and
+  // the ones of the other flows, sent just after 2 s, at 4 s; then the
+  // flows no longer change
+  std::ifstream is (fileName.c_str (), std::ios::in|std::ios::binary);
+  NS_TEST_ASSERT_MSG_EQ (FlowMonitorBinaryTable::ReadHeader (is), true, "Wrong header");
+  FlowMonitorBinaryTable table;
+  while (table.Read (is))
+    {
+      if (table.GetName () == "FlowStats")
+        {
+          uint32_t nFlows = table.GetNValues (table.FindColumn ("flowId"));
+          uint32_t nChangedFlows = (table.GetTime () <= Seconds (3) ? 4 : (table.GetTime () == Seconds (4) ? 3 : 0));
+          NS_TEST_EXPECT_MSG_EQ (nFlows, nChangedFlows,
+                                 "Wrong number of flows in the snapshot at " << table.GetTime ().GetSeconds ());
+        }
+      else
+        {
+          uint32_t nFlows = table.GetNValues (table.FindColumn ("flowId"));
+          NS_TEST_EXPECT_MSG_EQ (nFlows, (table.GetTime () <= Seconds (1) ? (table.GetName () == "Ipv4FlowClassifier" ? 4 : 1) : 0),
+                                 "Wrong number of new flows in the snapshot at " << table.GetTime ().GetSeconds ());
+        }
+    }
+
+  // a truncated stream is detected
+  std::string truncated = stream.str ().substr (0, stream.str ().size () - 3);
+  std::istringstream truncatedStream (truncated);
+  FlowMonitorBinaryReader truncatedReader;
+  NS_TEST_EXPECT_MSG_EQ (truncatedReader.Read (truncatedStream), false, "A truncated stream should be detected");
+
+  // a corrupt value count fails at the end of the stream instead of
+  // allocating the whole column: one 255-byte wide column of 2^32 - 1 values
+  const char corrupt[] = "\x01\x00t" "\x00\x00\x00\x00\x00\x00\x00\x00" "\x01\x00"
+                         "\x01\x00c" "\x03\xff" "\xff\xff\xff\xff" "data";
+  std::istringstream corruptStream (std::string (corrupt, sizeof (corrupt) - 1));
+  FlowMonitorBinaryTable corruptTable;
+  NS_TEST_EXPECT_MSG_EQ (corruptTable.Read (corruptStream), false, "A corrupt value count should be detected");
+
+  // the last snapshot is written when the simulator is destroyed, if the
+  // snapshots were not stopped
+  std::string destroyFileName = CreateTempDirFilename ("flow-monitor-destroy.bin");
+  m_monitor->StartBinarySnapshots (destroyFileName, Seconds (1), false);
+  Simulator::Destroy ();
+  FlowMonitorBinaryReader destroyReader;
+  NS_TEST_ASSERT_MSG_EQ (destroyReader.ReadFile (destroyFileName), true, "The snapshot written at destroy time could not be read");
+  NS_TEST_EXPECT_MSG_EQ (destroyReader.GetNSnapshots (), 1, "Wrong number of snapshots written at destroy time");
+  NS_TEST_EXPECT_MSG_EQ (destroyReader.GetLastSnapshotTime (), MilliSeconds (5500), "Wrong time of the snapshot written at destroy time");
+  m_monitor->Dispose ();
+  m_monitor = 0;
+  m_probe = 0;
+  m_classifier = 0;
+  m_classifier6 = 0;
+}
+
+/**
+ * \ingroup flow-monitor-test
+ * \ingroup tests
+ *
+ * \brief FlowMonitor TestSuite
+ */
+class FlowMonitorTestSuite : public TestSuite
+{
+public:
+  FlowMonitorTestSuite ();
+};
+
+FlowMonitorTestSuite::FlowMonitorTestSuite ()
+  : TestSuite ("flow-monitor", UNIT)
+{
+  AddTestCase (new FlowMonitorLostPacketsTestCase, TestCase::QUICK);
+  AddTestCase (new FlowMonitorManyLostPacketsTestCase, TestCase::QUICK);
+  AddTestCase (new FlowMonitorBinaryTestCase, TestCase::QUICK);
+}
+
+static FlowMonitorTestSuite g_flowMonitorTestSuite; //!< Static variable for test initialization
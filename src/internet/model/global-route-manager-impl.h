@@ -27,6 +27,7 @@
 #include <queue>
 #include <map>
 #include <vector>
+#include <atomic>
 #include "ns3/object.h"
 #include "ns3/ptr.h"
 #include "ns3/ipv4-address.h"
@@ -37,6 +38,7 @@ namespace ns3 {
 const uint32_t SPF_INFINITY = 0xffffffff; //!< "infinite" distance between nodes
 
 class CandidateQueue;
+class Ipv4;
 class Ipv4GlobalRouting;
 
 /**
@@ -674,6 +676,17 @@ public:
    */
   uint32_t GetNumExtLSAs () const;
 
+  /**
+   * @brief Get the number of Link State Advertisements, other than the
+   * External ones.
+   *
+   * The positions of these LSAs in the database (see GlobalRoutingLSA::GetIndex)
+   * range from zero to this number.
+   *
+   * @returns the number of Link State Advertisements.
+   */
+  uint32_t GetNumLSAs () const;
+
 
 private:
   typedef std::map<Ipv4Address, GlobalRoutingLSA*> LSDBMap_t; //!< container of IPv4 addresses / Link State Advertisements
@@ -766,8 +779,134 @@ private:
  */
   GlobalRouteManagerImpl& operator= (GlobalRouteManagerImpl& srmi);
 
+/**
+ * @brief Create a Global Route Manager Implementation which reads the
+ * LSDB of another one, to run SPF calculations in a worker thread.
+ *
+ * @param lsdb the LSDB, which is not owned
+ */
+  GlobalRouteManagerImpl (GlobalRouteManagerLSDB* lsdb);
+
+  /**
+   * \brief A route found by the SPF calculation, to be added to the
+   * routing table of the root of the SPF tree.
+   */
+  struct SPFRoute
+  {
+    /// The kind of route
+    enum Type
+    {
+      HOST,        //!< host route (Ipv4GlobalRouting::AddHostRouteTo)
+      NETWORK,     //!< network route (Ipv4GlobalRouting::AddNetworkRouteTo)
+      AS_EXTERNAL  //!< external route (Ipv4GlobalRouting::AddASExternalRouteTo)
+    } type;                //!< the kind of route
+    Ipv4Address dest;      //!< the destination
+    Ipv4Mask mask;         //!< the mask of the destination
+    Ipv4Address nextHop;   //!< the next hop
+    uint32_t interface;    //!< the outgoing interface
+  };
+
+  /**
+   * \brief The SPF calculation rooted at one router, with its results.
+   */
+  struct SPFJob
+  {
+    Ipv4Address root;                  //!< the router ID of the root
+    Ptr<Ipv4> ipv4;                    //!< the IPv4 stack of the root
+    Ptr<Ipv4GlobalRouting> routing;    //!< the global routing protocol of the root
+    std::vector<SPFRoute> routes;      //!< the routes found, in the order they are found
+  };
+
+  /**
+   * \brief The SPF jobs shared by the worker threads.
+   */
+  struct SPFBatch
+  {
+    std::vector<SPFJob> *jobs;         //!< the jobs
+    std::atomic<uint32_t> next;        //!< the index of the next job to run
+    uint32_t end;                      //!< the index past the last job of the batch
+  };
+
   SPFVertex* m_spfroot; //!< the root node
   GlobalRouteManagerLSDB* m_lsdb; //!< the Link State DataBase (LSDB) of the Global Route Manager
+  bool m_ownsLsdb; //!< true if the LSDB is deleted with this object
+  Ipv4* m_spfRootIpv4; //!< the IPv4 stack of the root of the current SPF calculation
+  std::vector<SPFRoute>* m_spfRoutes; //!< the routes found by the current SPF calculation
+  SPFBatch* m_spfBatch; //!< the jobs run by this object, in a worker thread
+  /// the status of the LSAs in the current SPF calculation, indexed by their position in the LSDB
+  std::vector<GlobalRoutingLSA::SPFStatus> m_lsaStatus;
+
+  /**
+   * \brief Get the status of an LSA in the current SPF calculation.
+   *
+   * \param lsa the LSA
+   * \returns the status, LSA_SPF_NOT_EXPLORED if it has not been set
+   */
+  GlobalRoutingLSA::SPFStatus GetLSAStatus (GlobalRoutingLSA* lsa) const;
+
+  /**
+   * \brief Set the status of an LSA in the current SPF calculation.
+   *
+   * \param lsa the LSA
+   * \param status the status
+   */
+  void SetLSAStatus (GlobalRoutingLSA* lsa, GlobalRoutingLSA::SPFStatus status);
+
+  /**
+   * \brief Record a route for the root of the current SPF calculation.
+   *
+   * \param type the kind of route
+   * \param dest the destination
+   * \param mask the mask of the destination
+   * \param nextHop the next hop
+   * \param interface the outgoing interface
+   */
+  void AddSPFRoute (SPFRoute::Type type, Ipv4Address dest, Ipv4Mask mask,
+                    Ipv4Address nextHop, uint32_t interface);
+
+  /**
+   * \brief Find the node, IPv4 stack and global routing protocol of
+   * the roots of SPF jobs.
+   *
+   * Jobs whose root is not found are left without routing protocol.
+   *
+   * \param jobs the jobs
+   */
+  void ResolveSPFRoots (std::vector<SPFJob>& jobs);
+
+  /**
+   * \brief Run the SPF calculation of a job, storing the routes found
+   * in the job.
+   *
+   * \param job the job
+   */
+  void RunSPFJob (SPFJob& job);
+
+  /**
+   * \brief Add the routes found by a job to the routing table of its root.
+   *
+   * \param job the job
+   */
+  void ApplySPFJob (SPFJob& job);
+
+  /**
+   * \brief Run SPF jobs, possibly in several threads, and add their routes.
+   *
+   * The routes are added to the routing tables in the order of the jobs,
+   * whatever the number of threads, hence the routing tables do not
+   * depend on the number of threads.
+   *
+   * \param jobs the jobs
+   * \param threads the number of threads
+   */
+  void RunSPFJobs (std::vector<SPFJob>& jobs, uint32_t threads);
+
+  /**
+   * \brief Run the jobs of m_spfBatch until none is left.
+   *
+   * This is the body of the worker threads.
+   */
+  void RunSPFBatch (void);
 
   /**
    * \brief Test if a node is a stub, from an OSPF sense.
@@ -891,8 +1030,9 @@ private:
    *
    * This method is derived from quagga ospf_intra_add_router ()
    *
-   * This is where we are actually going to add the host routes to the routing
-   * tables of the individual nodes.
+   * This is where we find the host routes of the root of the SPF tree.
+   * They are recorded with AddSPFRoute () and added to its routing table
+   * once the calculation is complete.
    *
    * The vertex passed as a parameter has just been added to the SPF tree.
    * This vertex must have a valid m_root_oid, corresponding to the outgoing
@@ -935,8 +1075,8 @@ private:
   /**
    * \brief Return the interface number corresponding to a given IP address and mask
    *
-   * This is a wrapper around GetInterfaceForPrefix(), but we first
-   * have to find the right node pointer to pass to that function.
+   * This is a wrapper around GetInterfaceForPrefix(), called on the
+   * IPv4 stack of the root of the current SPF calculation.
    * If no such interface is found, return -1 (note:  unit test framework
    * for routing assumes -1 to be a legal return value)
    *
@@ -143,7 +143,8 @@ GlobalRoutingLSA::GlobalRoutingLSA()
     m_networkLSANetworkMask ("0.0.0.0"),
     m_attachedRouters (),
     m_status (GlobalRoutingLSA::LSA_SPF_NOT_EXPLORED),
-    m_node_id (0)
+    m_node_id (0),
+    m_index (0)
 {
   NS_LOG_FUNCTION (this);
 }
@@ -160,7 +161,8 @@ GlobalRoutingLSA::GlobalRoutingLSA (
     m_networkLSANetworkMask ("0.0.0.0"),
     m_attachedRouters (),
     m_status (status),
-    m_node_id (0)
+    m_node_id (0),
+    m_index (0)
 {
   NS_LOG_FUNCTION (this << status << linkStateId << advertisingRtr);
 }
@@ -170,7 +172,8 @@ GlobalRoutingLSA::GlobalRoutingLSA (GlobalRoutingLSA& lsa)
     m_advertisingRtr (lsa.m_advertisingRtr),
     m_networkLSANetworkMask (lsa.m_networkLSANetworkMask),
     m_status (lsa.m_status),
-    m_node_id (lsa.m_node_id)
+    m_node_id (lsa.m_node_id),
+    m_index (lsa.m_index)
 {
   NS_LOG_FUNCTION (this << &lsa);
   NS_ASSERT_MSG (IsEmpty (),
@@ -188,6 +191,7 @@ GlobalRoutingLSA::operator= (const GlobalRoutingLSA& lsa)
   m_networkLSANetworkMask = lsa.m_networkLSANetworkMask, 
   m_status = lsa.m_status;
   m_node_id = lsa.m_node_id;
+  m_index = lsa.m_index;
 
   ClearLinkRecords ();
   CopyLinkRecords (lsa);
@@ -400,6 +404,20 @@ GlobalRoutingLSA::SetNode (Ptr<Node> node)
   m_node_id = node->GetId ();
 }
 
+uint32_t
+GlobalRoutingLSA::GetIndex (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return m_index;
+}
+
+void
+GlobalRoutingLSA::SetIndex (uint32_t index)
+{
+  NS_LOG_FUNCTION (this << index);
+  m_index = index;
+}
+
 void
 GlobalRoutingLSA::Print (std::ostream &os) const
 {
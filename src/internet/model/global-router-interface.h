@@ -497,6 +497,22 @@ public:
  */
   void SetNode (Ptr<Node> node);
 
+/**
+ * @brief Get the position of the LSA in the Link State Database
+ *
+ * The position is set when the LSA is inserted in the database, and lets
+ * the SPF calculations keep the status of the LSAs in arrays.
+ *
+ * @returns the position of the LSA
+ */
+  uint32_t GetIndex (void) const;
+
+/**
+ * @brief Set the position of the LSA in the Link State Database
+ * @param index the position of the LSA
+ */
+  void SetIndex (uint32_t index);
+
 private:
 /**
  * The type of the LSA.  Each LSA type has a separate advertisement
@@ -566,6 +582,7 @@ private:
  */
   SPFStatus m_status;
   uint32_t m_node_id; //!< node ID
+  uint32_t m_index; //!< position in the Link State Database
 };
 
 /**
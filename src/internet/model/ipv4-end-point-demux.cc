@@ -40,23 +40,122 @@ Ipv4EndPointDemux::~Ipv4EndPointDemux ()
   for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++) 
     {
       Ipv4EndPoint *endPoint = *i;
+      endPoint->m_demux = 0;
       delete endPoint;
     }
   m_endPoints.clear ();
+  m_tuples.clear ();
+  m_ports.clear ();
+}
+
+Ipv4EndPointDemux::Tuple::Tuple (Ipv4Address localAddress, uint16_t localPort,
+                                 Ipv4Address peerAddress, uint16_t peerPort)
+  : localAddress (localAddress),
+    localPort (localPort),
+    peerAddress (peerAddress),
+    peerPort (peerPort)
+{
 }
 
 bool
-Ipv4EndPointDemux::LookupPortLocal (uint16_t port)
+Ipv4EndPointDemux::Tuple::operator== (const Tuple &other) const
 {
-  NS_LOG_FUNCTION (this << port);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++) 
+  return localPort == other.localPort && peerPort == other.peerPort
+         && localAddress == other.localAddress && peerAddress == other.peerAddress;
+}
+
+size_t
+Ipv4EndPointDemux::TupleHash::operator() (const Tuple &tuple) const
+{
+  uint64_t h = (static_cast<uint64_t> (tuple.localAddress.Get ()) << 32) | tuple.peerAddress.Get ();
+  h ^= ((static_cast<uint64_t> (tuple.localPort) << 16) | tuple.peerPort) * 0x9e3779b97f4a7c15ULL;
+  // final mix of MurmurHash3, so that all the bits of the tuple affect the low bits
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdULL;
+  h ^= h >> 33;
+  return static_cast<size_t> (h);
+}
+
+Ipv4EndPointDemux::Tuple
+Ipv4EndPointDemux::GetTuple (Ipv4EndPoint *endPoint)
+{
+  return Tuple (endPoint->GetLocalAddress (), endPoint->GetLocalPort (),
+                endPoint->GetPeerAddress (), endPoint->GetPeerPort ());
+}
+
+bool
+Ipv4EndPointDemux::IsWildcard (Ipv4EndPoint *endPoint)
+{
+  return endPoint->GetLocalAddress () == Ipv4Address::GetAny ()
+         || endPoint->GetPeerAddress () == Ipv4Address::GetAny ()
+         || endPoint->GetPeerPort () == 0;
+}
+
+void
+Ipv4EndPointDemux::Index (Ipv4EndPoint *endPoint)
+{
+  NS_LOG_FUNCTION (this << endPoint);
+  Tuple tuple = GetTuple (endPoint);
+  m_tuples[tuple].push_back (endPoint);
+  PortEndPoints &port = m_ports[tuple.localPort];
+  port.nEndPoints++;
+  if (IsWildcard (endPoint))
     {
-      if ((*i)->GetLocalPort  () == port) 
-        {
-          return true;
-        }
+      port.wildcards.push_back (endPoint);
     }
-  return false;
+}
+
+void
+Ipv4EndPointDemux::Unindex (Ipv4EndPoint *endPoint)
+{
+  NS_LOG_FUNCTION (this << endPoint);
+  Tuple tuple = GetTuple (endPoint);
+  TupleIndex::iterator t = m_tuples.find (tuple);
+  NS_ASSERT (t != m_tuples.end ());
+  t->second.remove (endPoint);
+  if (t->second.empty ())
+    {
+      m_tuples.erase (t);
+    }
+  PortIndex::iterator port = m_ports.find (tuple.localPort);
+  NS_ASSERT (port != m_ports.end ());
+  if (IsWildcard (endPoint))
+    {
+      port->second.wildcards.remove (endPoint);
+    }
+  if (--port->second.nEndPoints == 0)
+    {
+      m_ports.erase (port);
+    }
+}
+
+Ipv4Address
+Ipv4EndPointDemux::GetSubnetAny (Ipv4InterfaceAddress addr, Ipv4Address daddr)
+{
+  Ipv4Address addrNetpart = addr.GetLocal ().CombineMask (addr.GetMask ());
+  if (daddr.CombineMask (addr.GetMask ()) != addrNetpart)
+    {
+      return Ipv4Address::GetAny ();
+    }
+  return addrNetpart;
+}
+
+Ipv4EndPoint *
+Ipv4EndPointDemux::Insert (Ipv4EndPoint *endPoint)
+{
+  NS_LOG_FUNCTION (this << endPoint);
+  m_endPoints.push_back (endPoint);
+  endPoint->m_demux = this;
+  Index (endPoint);
+  NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
+  return endPoint;
+}
+
+bool
+Ipv4EndPointDemux::LookupPortLocal (uint16_t port)
+{
+  NS_LOG_FUNCTION (this << port);
+  return m_ports.find (port) != m_ports.end ();
 }
 
 bool
@@ -85,10 +184,7 @@ Ipv4EndPointDemux::Allocate (void)
       NS_LOG_WARN ("Ephemeral port allocation failed.");
       return 0;
     }
-  Ipv4EndPoint *endPoint = new Ipv4EndPoint (Ipv4Address::GetAny (), port);
-  m_endPoints.push_back (endPoint);
-  NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
-  return endPoint;
+  return Insert (new Ipv4EndPoint (Ipv4Address::GetAny (), port));
 }
 
 Ipv4EndPoint *
@@ -101,10 +197,7 @@ Ipv4EndPointDemux::Allocate (Ipv4Address address)
       NS_LOG_WARN ("Ephemeral port allocation failed.");
       return 0;
     }
-  Ipv4EndPoint *endPoint = new Ipv4EndPoint (address, port);
-  m_endPoints.push_back (endPoint);
-  NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
-  return endPoint;
+  return Insert (new Ipv4EndPoint (address, port));
 }
 
 Ipv4EndPoint *
@@ -124,10 +217,7 @@ Ipv4EndPointDemux::Allocate (Ptr<NetDevice> boundNetDevice, Ipv4Address address,
       NS_LOG_WARN ("Duplicated endpoint.");
       return 0;
     }
-  Ipv4EndPoint *endPoint = new Ipv4EndPoint (address, port);
-  m_endPoints.push_back (endPoint);
-  NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
-  return endPoint;
+  return Insert (new Ipv4EndPoint (address, port));
 }
 
 Ipv4EndPoint *
@@ -136,25 +226,21 @@ Ipv4EndPointDemux::Allocate (Ptr<NetDevice> boundNetDevice,
                              Ipv4Address peerAddress, uint16_t peerPort)
 {
   NS_LOG_FUNCTION (this << localAddress << localPort << peerAddress << peerPort << boundNetDevice);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++) 
+  TupleIndex::iterator t = m_tuples.find (Tuple (localAddress, localPort, peerAddress, peerPort));
+  if (t != m_tuples.end ())
     {
-      if ((*i)->GetLocalPort () == localPort &&
-          (*i)->GetLocalAddress () == localAddress &&
-          (*i)->GetPeerPort () == peerPort &&
-          (*i)->GetPeerAddress () == peerAddress &&
-          ((*i)->GetBoundNetDevice () == boundNetDevice || (*i)->GetBoundNetDevice () == 0))
+      for (EndPointsI i = t->second.begin (); i != t->second.end (); i++)
         {
-          NS_LOG_WARN ("Duplicated endpoint.");
-          return 0;
+          if ((*i)->GetBoundNetDevice () == boundNetDevice || (*i)->GetBoundNetDevice () == 0)
+            {
+              NS_LOG_WARN ("Duplicated endpoint.");
+              return 0;
+            }
         }
     }
   Ipv4EndPoint *endPoint = new Ipv4EndPoint (localAddress, localPort);
   endPoint->SetPeer (peerAddress, peerPort);
-  m_endPoints.push_back (endPoint);
-
-  NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
-
-  return endPoint;
+  return Insert (endPoint);
 }
 
 void 
@@ -165,6 +251,8 @@ Ipv4EndPointDemux::DeAllocate (Ipv4EndPoint *endPoint)
     {
       if (*i == endPoint)
         {
+          Unindex (endPoint);
+          endPoint->m_demux = 0;
           delete endPoint;
           m_endPoints.erase (i);
           break;
@@ -190,6 +278,126 @@ Ipv4EndPointDemux::GetAllEndPoints (void)
 }
 
 
+void
+Ipv4EndPointDemux::Match (Ipv4EndPoint *endP,
+                          Ipv4Address daddr, uint16_t dport,
+                          Ipv4Address saddr, uint16_t sport,
+                          Ptr<Ipv4Interface> incomingInterface,
+                          EndPoints &retval1, EndPoints &retval2,
+                          EndPoints &retval3, EndPoints &retval4)
+{
+  NS_LOG_DEBUG ("Looking at endpoint dport=" << endP->GetLocalPort ()
+                                             << " daddr=" << endP->GetLocalAddress ()
+                                             << " sport=" << endP->GetPeerPort ()
+                                             << " saddr=" << endP->GetPeerAddress ());
+
+  if (!endP->IsRxEnabled ())
+    {
+      NS_LOG_LOGIC ("Skipping endpoint " << &endP
+                    << " because endpoint can not receive packets");
+      return;
+    }
+
+  if (endP->GetLocalPort () != dport) 
+    {
+      NS_LOG_LOGIC ("Skipping endpoint " << &endP
+                                         << " because endpoint dport "
+                                         << endP->GetLocalPort ()
+                                         << " does not match packet dport " << dport);
+      return;
+    }
+  if (endP->GetBoundNetDevice ())
+    {
+      if (endP->GetBoundNetDevice () != incomingInterface->GetDevice ())
+        {
+          NS_LOG_LOGIC ("Skipping endpoint " << &endP
+                                             << " because endpoint is bound to specific device and"
+                                             << endP->GetBoundNetDevice ()
+                                             << " does not match packet device " << incomingInterface->GetDevice ());
+          return;
+        }
+    }
+
+  bool localAddressMatchesExact = false;
+  bool localAddressIsAny = false;
+  bool localAddressIsSubnetAny = false;
+
+  // We have 3 cases:
+  // 1) Exact local / destination address match
+  // 2) Local endpoint bound to Any -> matches anything
+  // 3) Local endpoint bound to x.y.z.0 -> matches Subnet-directed broadcast packet (e.g., x.y.z.255 in a /24 net) and direct destination match.
+
+  if (endP->GetLocalAddress () == daddr)
+    {
+      // Case 1:
+      localAddressMatchesExact = true;
+    }
+  else if (endP->GetLocalAddress () == Ipv4Address::GetAny ())
+    {
+      // Case 2:
+      localAddressIsAny = true;
+    }
+  else
+    {
+      // Case 3:
+      for (uint32_t i = 0; i < incomingInterface->GetNAddresses (); i++)
+        {
+          Ipv4InterfaceAddress addr = incomingInterface->GetAddress (i);
+
+          Ipv4Address addrNetpart = addr.GetLocal ().CombineMask (addr.GetMask ());
+          if (endP->GetLocalAddress () == addrNetpart)
+            {
+              NS_LOG_LOGIC ("Endpoint is SubnetDirectedAny " << endP->GetLocalAddress () << "/" << addr.GetMask ().GetPrefixLength ());
+
+              Ipv4Address daddrNetPart = daddr.CombineMask (addr.GetMask ());
+              if (addrNetpart == daddrNetPart)
+                {
+                  localAddressIsSubnetAny = true;
+                }
+            }
+        }
+
+      // if no match here, keep looking
+      if (!localAddressIsSubnetAny)
+        return;
+    }
+
+  bool remotePortMatchesExact = endP->GetPeerPort () == sport;
+  bool remotePortMatchesWildCard = endP->GetPeerPort () == 0;
+  bool remoteAddressMatchesExact = endP->GetPeerAddress () == saddr;
+  bool remoteAddressMatchesWildCard = endP->GetPeerAddress () == Ipv4Address::GetAny ();
+
+  // If remote does not match either with exact or wildcard,
+  // skip this one
+  if (!(remotePortMatchesExact || remotePortMatchesWildCard))
+    return;
+  if (!(remoteAddressMatchesExact || remoteAddressMatchesWildCard))
+    return;
+
+  bool localAddressMatchesWildCard = localAddressIsAny || localAddressIsSubnetAny;
+
+  if (localAddressMatchesExact && remoteAddressMatchesExact && remotePortMatchesExact)
+    { // All 4 match - this is the case of an open TCP connection, for example.
+      NS_LOG_LOGIC ("Found an endpoint for case 4, adding " << endP->GetLocalAddress () << ":" << endP->GetLocalPort ());
+      retval4.push_back (endP);
+    }
+  if (localAddressMatchesWildCard && remoteAddressMatchesExact && remotePortMatchesExact)
+    { // All but local address - no idea what this case could be.
+      NS_LOG_LOGIC ("Found an endpoint for case 3, adding " << endP->GetLocalAddress () << ":" << endP->GetLocalPort ());
+      retval3.push_back (endP);
+    }
+  if (localAddressMatchesExact && remoteAddressMatchesWildCard && remotePortMatchesWildCard)
+    { // Only local port and local address matches exactly - Not yet opened connection
+      NS_LOG_LOGIC ("Found an endpoint for case 2, adding " << endP->GetLocalAddress () << ":" << endP->GetLocalPort ());
+      retval2.push_back (endP);
+    }
+  if (localAddressMatchesWildCard && remoteAddressMatchesWildCard && remotePortMatchesWildCard)
+    { // Only local port matches exactly - Endpoint open to "any" connection
+      NS_LOG_LOGIC ("Found an endpoint for case 1, adding " << endP->GetLocalAddress () << ":" << endP->GetLocalPort ());
+      retval1.push_back (endP);
+    }
+}
+
 /*
  * If we have an exact match, we return it.
  * Otherwise, if we find a generic match, we return it.
@@ -208,119 +416,51 @@ Ipv4EndPointDemux::Lookup (Ipv4Address daddr, uint16_t dport,
   EndPoints retval4; // Exact match on all 4
 
   NS_LOG_DEBUG ("Looking up endpoint for destination address " << daddr << ":" << dport);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++) 
+  PortIndex::iterator port = m_ports.find (dport);
+  if (port != m_ports.end ())
     {
-      Ipv4EndPoint* endP = *i;
-
-      NS_LOG_DEBUG ("Looking at endpoint dport=" << endP->GetLocalPort ()
-                                                 << " daddr=" << endP->GetLocalAddress ()
-                                                 << " sport=" << endP->GetPeerPort ()
-                                                 << " saddr=" << endP->GetPeerAddress ());
-
-      if (!endP->IsRxEnabled ())
+      // The endpoints with a wildcard address or port are all checked.
+      for (EndPointsI i = port->second.wildcards.begin (); i != port->second.wildcards.end (); i++)
         {
-          NS_LOG_LOGIC ("Skipping endpoint " << &endP
-                        << " because endpoint can not receive packets");
-          continue;
+          Match (*i, daddr, dport, saddr, sport, incomingInterface, retval1, retval2, retval3, retval4);
         }
 
-      if (endP->GetLocalPort () != dport) 
-        {
-          NS_LOG_LOGIC ("Skipping endpoint " << &endP
-                                             << " because endpoint dport "
-                                             << endP->GetLocalPort ()
-                                             << " does not match packet dport " << dport);
-          continue;
-        }
-      if (endP->GetBoundNetDevice ())
+      // The other ones can only match if their peer is the source and their
+      // local address is either the destination or the network part of an
+      // address of the incoming interface (for subnet-directed broadcasts).
+      uint32_t nAddresses = (incomingInterface != 0) ? incomingInterface->GetNAddresses () : 0;
+      for (uint32_t i = 0; i <= nAddresses; i++)
         {
-          if (endP->GetBoundNetDevice () != incomingInterface->GetDevice ())
+          Ipv4Address localAddress = daddr;
+          if (i > 0)
+            {
+              localAddress = GetSubnetAny (incomingInterface->GetAddress (i - 1), daddr);
+              if (localAddress == daddr || localAddress == Ipv4Address::GetAny ())
+                {
+                  continue;
+                }
+              bool checked = false;
+              for (uint32_t j = 0; j < i - 1 && !checked; j++)
+                {
+                  checked = (GetSubnetAny (incomingInterface->GetAddress (j), daddr) == localAddress);
+                }
+              if (checked)
+                {
+                  continue;
+                }
+            }
+          TupleIndex::iterator t = m_tuples.find (Tuple (localAddress, dport, saddr, sport));
+          if (t == m_tuples.end ())
             {
-              NS_LOG_LOGIC ("Skipping endpoint " << &endP
-                                                 << " because endpoint is bound to specific device and"
-                                                 << endP->GetBoundNetDevice ()
-                                                 << " does not match packet device " << incomingInterface->GetDevice ());
               continue;
             }
-        }
-
-      bool localAddressMatchesExact = false;
-      bool localAddressIsAny = false;
-      bool localAddressIsSubnetAny = false;
-
-      // We have 3 cases:
-      // 1) Exact local / destination address match
-      // 2) Local endpoint bound to Any -> matches anything
-      // 3) Local endpoint bound to x.y.z.0 -> matches Subnet-directed broadcast packet (e.g., x.y.z.255 in a /24 net) and direct destination match.
-
-      if (endP->GetLocalAddress () == daddr)
-        {
-          // Case 1:
-          localAddressMatchesExact = true;
-        }
-      else if (endP->GetLocalAddress () == Ipv4Address::GetAny ())
-        {
-          // Case 2:
-          localAddressIsAny = true;
-        }
-      else
-        {
-          // Case 3:
-          for (uint32_t i = 0; i < incomingInterface->GetNAddresses (); i++)
+          for (EndPointsI e = t->second.begin (); e != t->second.end (); e++)
             {
-              Ipv4InterfaceAddress addr = incomingInterface->GetAddress (i);
-
-              Ipv4Address addrNetpart = addr.GetLocal ().CombineMask (addr.GetMask ());
-              if (endP->GetLocalAddress () == addrNetpart)
+              if (!IsWildcard (*e))
                 {
-                  NS_LOG_LOGIC ("Endpoint is SubnetDirectedAny " << endP->GetLocalAddress () << "/" << addr.GetMask ().GetPrefixLength ());
-
-                  Ipv4Address daddrNetPart = daddr.CombineMask (addr.GetMask ());
-                  if (addrNetpart == daddrNetPart)
-                    {
-                      localAddressIsSubnetAny = true;
-                    }
+                  Match (*e, daddr, dport, saddr, sport, incomingInterface, retval1, retval2, retval3, retval4);
                 }
             }
-
-          // if no match here, keep looking
-          if (!localAddressIsSubnetAny)
-            continue;
-        }
-
-      bool remotePortMatchesExact = endP->GetPeerPort () == sport;
-      bool remotePortMatchesWildCard = endP->GetPeerPort () == 0;
-      bool remoteAddressMatchesExact = endP->GetPeerAddress () == saddr;
-      bool remoteAddressMatchesWildCard = endP->GetPeerAddress () == Ipv4Address::GetAny ();
-
-      // If remote does not match either with exact or wildcard,
-      // skip this one
-      if (!(remotePortMatchesExact || remotePortMatchesWildCard))
-        continue;
-      if (!(remoteAddressMatchesExact || remoteAddressMatchesWildCard))
-        continue;
-
-      bool localAddressMatchesWildCard = localAddressIsAny || localAddressIsSubnetAny;
-
-      if (localAddressMatchesExact && remoteAddressMatchesExact && remotePortMatchesExact)
-        { // All 4 match - this is the case of an open TCP connection, for example.
-          NS_LOG_LOGIC ("Found an endpoint for case 4, adding " << endP->GetLocalAddress () << ":" << endP->GetLocalPort ());
-          retval4.push_back (endP);
-        }
-      if (localAddressMatchesWildCard && remoteAddressMatchesExact && remotePortMatchesExact)
-        { // All but local address - no idea what this case could be.
-          NS_LOG_LOGIC ("Found an endpoint for case 3, adding " << endP->GetLocalAddress () << ":" << endP->GetLocalPort ());
-          retval3.push_back (endP);
-        }
-      if (localAddressMatchesExact && remoteAddressMatchesWildCard && remotePortMatchesWildCard)
-        { // Only local port and local address matches exactly - Not yet opened connection
-          NS_LOG_LOGIC ("Found an endpoint for case 2, adding " << endP->GetLocalAddress () << ":" << endP->GetLocalPort ());
-          retval2.push_back (endP);
-        }
-      if (localAddressMatchesWildCard && remoteAddressMatchesWildCard && remotePortMatchesWildCard)
-        { // Only local port matches exactly - Endpoint open to "any" connection
-          NS_LOG_LOGIC ("Found an endpoint for case 1, adding " << endP->GetLocalAddress () << ":" << endP->GetLocalPort ());
-          retval1.push_back (endP);
         }
     }
 
@@ -343,6 +483,14 @@ Ipv4EndPointDemux::SimpleLookup (Ipv4Address daddr,
 {
   NS_LOG_FUNCTION (this << daddr << dport << saddr << sport);
 
+  // a single endpoint with this exact four-tuple is the answer; otherwise
+  // the first exact match or the most specific endpoint is searched below
+  TupleIndex::iterator t = m_tuples.find (Tuple (daddr, dport, saddr, sport));
+  if (t != m_tuples.end () && t->second.size () == 1)
+    {
+      return t->second.front ();
+    }
+
   // this code is a copy/paste version of an old BSD ip stack lookup
   // function.
   uint32_t genericity = 3;
@@ -23,8 +23,10 @@
 
 #include <stdint.h>
 #include <list>
+#include <unordered_map>
 #include "ns3/ipv4-address.h"
 #include "ipv4-interface.h"
+#include "ipv4-interface-address.h"
 
 namespace ns3 {
 
@@ -40,6 +42,11 @@ class Ipv4EndPoint;
  * of endpoints, and has APIs to add and find endpoints in this demux.  This
  * code is shared in common to TCP and UDP protocols in ns3.  This demux
  * sits between ns3's layer four and the socket layer
+ *
+ * The endpoints are indexed by four-tuple and by local port, so that a
+ * lookup only checks the endpoints with the four-tuple of the packet and
+ * the ones bound to its destination port with a wildcard address or port
+ * (e.g., listening sockets), whatever the number of connections.
  */
 
 class Ipv4EndPointDemux {
@@ -166,6 +173,134 @@ public:
   void DeAllocate (Ipv4EndPoint *endPoint);
 
 private:
+  friend class Ipv4EndPoint;
+
+  /**
+   * \brief The local and peer addresses and ports of an end point.
+   */
+  struct Tuple
+  {
+    /**
+     * \brief Constructor.
+     * \param localAddress local address
+     * \param localPort local port
+     * \param peerAddress peer address
+     * \param peerPort peer port
+     */
+    Tuple (Ipv4Address localAddress, uint16_t localPort,
+           Ipv4Address peerAddress, uint16_t peerPort);
+    /**
+     * \brief Equality operator.
+     * \param other the other tuple
+     * \returns true if the tuples are equal
+     */
+    bool operator== (const Tuple &other) const;
+
+    Ipv4Address localAddress;  //!< local address
+    uint16_t localPort;        //!< local port
+    Ipv4Address peerAddress;   //!< peer address
+    uint16_t peerPort;         //!< peer port
+  };
+
+  /**
+   * \brief Hash function of the tuples.
+   */
+  struct TupleHash
+  {
+    /**
+     * \param tuple the tuple
+     * \returns the hash of the tuple
+     */
+    size_t operator() (const Tuple &tuple) const;
+  };
+
+  /**
+   * \brief The end points bound to a local port.
+   */
+  struct PortEndPoints
+  {
+    uint32_t nEndPoints;  //!< The number of end points
+    EndPoints wildcards;  //!< The end points with a wildcard address or port
+  };
+
+  /**
+   * \brief Index of the end points by tuple.
+   */
+  typedef std::unordered_map<Tuple, EndPoints, TupleHash> TupleIndex;
+
+  /**
+   * \brief Index of the end points by local port.
+   */
+  typedef std::unordered_map<uint16_t, PortEndPoints> PortIndex;
+
+  /**
+   * \brief Get the tuple of an end point.
+   * \param endPoint the end point
+   * \returns the tuple
+   */
+  static Tuple GetTuple (Ipv4EndPoint *endPoint);
+
+  /**
+   * \brief Checks if an end point accepts packets from any peer or to any
+   * local address.
+   *
+   * Such end points (e.g., listening sockets) are checked one by one by
+   * Lookup, while the other ones are found by tuple.
+   *
+   * \param endPoint the end point
+   * \returns true if the local address, peer address or peer port is a wildcard
+   */
+  static bool IsWildcard (Ipv4EndPoint *endPoint);
+
+  /**
+   * \brief Add an end point to the indexes.
+   * \param endPoint the end point
+   */
+  void Index (Ipv4EndPoint *endPoint);
+
+  /**
+   * \brief Remove an end point from the indexes.
+   * \param endPoint the end point
+   */
+  void Unindex (Ipv4EndPoint *endPoint);
+
+  /**
+   * \brief Get the local address of the endpoints which receive the
+   * subnet-directed packets to an address through an interface address.
+   * \param addr the interface address
+   * \param daddr the destination address
+   * \returns the network part of the interface address, or the any address
+   *          if the destination address is not in this network
+   */
+  static Ipv4Address GetSubnetAny (Ipv4InterfaceAddress addr, Ipv4Address daddr);
+
+  /**
+   * \brief Add a new end point to the list of end points and the indexes.
+   * \param endPoint the end point
+   * \returns the end point
+   */
+  Ipv4EndPoint *Insert (Ipv4EndPoint *endPoint);
+
+  /**
+   * \brief Check if an end point matches a packet and, if so, add it
+   * to the lists of matching end points of the cases it matches.
+   * \param endP the end point
+   * \param daddr destination address to test
+   * \param dport destination port to test
+   * \param saddr source address to test
+   * \param sport source port to test
+   * \param incomingInterface the incoming interface
+   * \param retval1 matches exact on local port, wildcards on others
+   * \param retval2 matches exact on local port/address, wildcards on others
+   * \param retval3 matches all but local address
+   * \param retval4 exact match on all 4
+   */
+  void Match (Ipv4EndPoint *endP,
+              Ipv4Address daddr, uint16_t dport,
+              Ipv4Address saddr, uint16_t sport,
+              Ptr<Ipv4Interface> incomingInterface,
+              EndPoints &retval1, EndPoints &retval2,
+              EndPoints &retval3, EndPoints &retval4);
 
   /**
    * \brief Allocate an ephemeral port.
@@ -192,6 +327,16 @@ private:
    * \brief A list of IPv4 end points.
    */
   EndPoints m_endPoints;
+
+  /**
+   * \brief The IPv4 end points, by tuple.
+   */
+  TupleIndex m_tuples;
+
+  /**
+   * \brief The IPv4 end points, by local port.
+   */
+  PortIndex m_ports;
 };
 
 } // namespace ns3
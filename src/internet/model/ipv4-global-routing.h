@@ -28,6 +28,7 @@
 #include "ns3/ipv4.h"
 #include "ns3/ipv4-routing-protocol.h"
 #include "ns3/random-variable-stream.h"
+#include "ipv4-route-trie.h"
 
 namespace ns3 {
 
@@ -268,10 +269,21 @@ private:
    */
   Ptr<Ipv4Route> LookupGlobal (Ipv4Address dest, Ptr<NetDevice> oif = 0);
 
+  /**
+   * \brief Rebuild the indexes of the routes by destination, if the
+   * routes changed since they were last built.
+   */
+  void UpdateRouteIndexes (void);
+
   HostRoutes m_hostRoutes;             //!< Routes to hosts
   NetworkRoutes m_networkRoutes;       //!< Routes to networks
   ASExternalRoutes m_ASexternalRoutes; //!< External routes imported
 
+  Ipv4RouteTrie m_hostRouteIndex;       //!< Index of the routes to hosts
+  Ipv4RouteTrie m_networkRouteIndex;    //!< Index of the routes to networks
+  Ipv4RouteTrie m_ASexternalRouteIndex; //!< Index of the external routes
+  bool m_routeIndexesValid;             //!< Whether the indexes reflect the routes
+
   Ptr<Ipv4> m_ipv4; //!< associated IPv4 instance
 };
 
@@ -0,0 +1,244 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <algorithm>
+#include "ns3/log.h"
+#include "ipv4-route-trie.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("Ipv4RouteTrie");
+
+namespace {
+
+/**
+ * \param prefix The prefix.
+ * \param length The number of leading bits to keep, at most 32.
+ * \returns The prefix with all the bits past length cleared.
+ */
+inline uint32_t
+MaskPrefix (uint32_t prefix, uint8_t length)
+{
+  return (length == 0) ? 0 : prefix & (0xffffffffU << (32 - length));
+}
+
+/**
+ * \param address The address.
+ * \param position The position of the bit, from 0 (the most significant) to 31.
+ * \returns The bit of the address at the given position.
+ */
+inline uint32_t
+GetBit (uint32_t address, uint8_t position)
+{
+  return (address >> (31 - position)) & 1;
+}
+
+/**
+ * \param a The first prefix.
+ * \param b The second prefix.
+ * \param max The maximum length to compare.
+ * \returns The number of leading bits shared by the two prefixes, at most max.
+ */
+inline uint8_t
+GetCommonLength (uint32_t a, uint32_t b, uint8_t max)
+{
+  uint8_t length = 0;
+  uint32_t diff = a ^ b;
+  while (length < max && !(diff & 0x80000000U))
+    {
+      diff <<= 1;
+      length++;
+    }
+  return length;
+}
+
+/**
+ * \param a The first route.
+ * \param b The second route.
+ * \returns true if the first route was inserted before the second one.
+ */
+inline bool
+InsertedBefore (const std::pair<uint32_t, Ipv4RoutingTableEntry *> &a,
+                const std::pair<uint32_t, Ipv4RoutingTableEntry *> &b)
+{
+  return a.first < b.first;
+}
+
+} // unnamed namespace
+
+Ipv4RouteTrie::Ipv4RouteTrie ()
+  : m_root (NewNode (0, 0)),
+    m_nRoutes (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+Ipv4RouteTrie::~Ipv4RouteTrie ()
+{
+  NS_LOG_FUNCTION (this);
+  DeleteNode (m_root);
+}
+
+Ipv4RouteTrie::Node *
+Ipv4RouteTrie::NewNode (uint32_t prefix, uint8_t length)
+{
+  Node *node = new Node;
+  node->prefix = MaskPrefix (prefix, length);
+  node->length = length;
+  node->child[0] = 0;
+  node->child[1] = 0;
+  return node;
+}
+
+void
+Ipv4RouteTrie::DeleteNode (Node *node)
+{
+  if (node != 0)
+    {
+      DeleteNode (node->child[0]);
+      DeleteNode (node->child[1]);
+      delete node;
+    }
+}
+
+void
+Ipv4RouteTrie::Insert (Ipv4Address network, Ipv4Mask mask, Ipv4RoutingTableEntry *route)
+{
+  NS_LOG_FUNCTION (this << network << mask << route);
+  Route entry (m_nRoutes++, route);
+
+  uint32_t inverse = ~mask.Get ();
+  if ((inverse & (inverse + 1)) != 0)
+    {
+      NS_LOG_LOGIC ("Mask " << mask << " is not contiguous");
+      NonContiguousRoute nonContiguous;
+      nonContiguous.network = network;
+      nonContiguous.mask = mask;
+      nonContiguous.route = entry;
+      m_nonContiguous.push_back (nonContiguous);
+      return;
+    }
+
+  uint8_t length = mask.GetPrefixLength ();
+  uint32_t prefix = MaskPrefix (network.Get (), length);
+  Node *node = m_root;
+  // the prefix of node is a prefix of the one of the route
+  while (node->length < length)
+    {
+      Node *&child = node->child[GetBit (prefix, node->length)];
+      if (child == 0)
+        {
+          child = NewNode (prefix, length);
+          child->routes.push_back (entry);
+          return;
+        }
+      uint8_t common = GetCommonLength (child->prefix, prefix, std::min (child->length, length));
+      if (common == child->length)
+        {
+          node = child;
+          continue;
+        }
+      // the route and the child diverge (or the route ends) before the
+      // end of the prefix of the child: insert the common prefix in between
+      Node *split = NewNode (prefix, common);
+      split->child[GetBit (child->prefix, common)] = child;
+      child = split;
+      if (common == length)
+        {
+          split->routes.push_back (entry);
+        }
+      else
+        {
+          Node *leaf = NewNode (prefix, length);
+          leaf->routes.push_back (entry);
+          split->child[GetBit (prefix, common)] = leaf;
+        }
+      return;
+    }
+  node->routes.push_back (entry);
+}
+
+void
+Ipv4RouteTrie::Lookup (Ipv4Address dest, std::vector<Ipv4RoutingTableEntry *> &routes) const
+{
+  NS_LOG_FUNCTION (this << dest);
+  uint32_t address = dest.Get ();
+  // the nodes along the path whose prefix matches and which hold routes
+  const std::vector<Route> *matches[33];
+  uint32_t nMatches = 0;
+
+  const Node *node = m_root;
+  while (node != 0 && MaskPrefix (address, node->length) == node->prefix)
+    {
+      if (!node->routes.empty ())
+        {
+          matches[nMatches++] = &node->routes;
+        }
+      if (node->length == 32)
+        {
+          break;
+        }
+      node = node->child[GetBit (address, node->length)];
+    }
+
+  std::vector<Route> found;
+  for (std::vector<NonContiguousRoute>::const_iterator i = m_nonContiguous.begin ();
+       i != m_nonContiguous.end (); i++)
+    {
+      if (i->mask.IsMatch (dest, i->network))
+        {
+          found.push_back (i->route);
+        }
+    }
+
+  if (nMatches == 1 && found.empty ())
+    {
+      // common case: the routes of a single node, which are sorted already
+      for (std::vector<Route>::const_iterator i = matches[0]->begin (); i != matches[0]->end (); i++)
+        {
+          routes.push_back (i->second);
+        }
+      return;
+    }
+
+  for (uint32_t m = 0; m < nMatches; m++)
+    {
+      found.insert (found.end (), matches[m]->begin (), matches[m]->end ());
+    }
+  std::sort (found.begin (), found.end (), InsertedBefore);
+  for (std::vector<Route>::const_iterator i = found.begin (); i != found.end (); i++)
+    {
+      routes.push_back (i->second);
+    }
+}
+
+void
+Ipv4RouteTrie::Clear (void)
+{
+  NS_LOG_FUNCTION (this);
+  DeleteNode (m_root);
+  m_root = NewNode (0, 0);
+  m_nonContiguous.clear ();
+  m_nRoutes = 0;
+}
+
+uint32_t
+Ipv4RouteTrie::GetNRoutes (void) const
+{
+  return m_nRoutes;
+}
+
+} // namespace ns3
@@ -0,0 +1,133 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef IPV4_ROUTE_TRIE_H
+#define IPV4_ROUTE_TRIE_H
+
+#include <stdint.h>
+#include <vector>
+#include <utility>
+#include "ns3/ipv4-address.h"
+
+namespace ns3 {
+
+class Ipv4RoutingTableEntry;
+
+/**
+ * \ingroup ipv4Routing
+ *
+ * \brief Index of IPv4 routes by destination prefix.
+ *
+ * The routes are stored in a path-compressed binary trie: every node
+ * represents a prefix, holds the routes to that prefix and has (at most)
+ * two children, whose prefixes extend the prefix of the node with a 0 or
+ * a 1 bit, respectively. Nodes with a single child and no route are not
+ * created, hence the trie has less than two nodes per distinct prefix.
+ *
+ * A lookup follows the bits of the destination address from the root
+ * and visits at most 33 nodes, whatever the number of routes. Unlike
+ * a longest prefix match, it returns all the routes whose prefix
+ * matches the destination, in the order they were inserted, so that
+ * the caller can apply its own selection policy (e.g., equal cost
+ * multi-path). Routes with a non-contiguous mask cannot be stored in
+ * the trie and are matched one by one.
+ *
+ * The trie does not own the routes.
+ */
+class Ipv4RouteTrie
+{
+public:
+  Ipv4RouteTrie ();
+  ~Ipv4RouteTrie ();
+
+  /**
+   * \brief Add a route to the index.
+   * \param network The destination network of the route.
+   * \param mask The mask of the destination network.
+   * \param route The route.
+   */
+  void Insert (Ipv4Address network, Ipv4Mask mask, Ipv4RoutingTableEntry *route);
+
+  /**
+   * \brief Get the routes whose destination network contains an address.
+   * \param dest The address.
+   * \param routes The vector the routes found are appended to, in the
+   *        order they were inserted.
+   */
+  void Lookup (Ipv4Address dest, std::vector<Ipv4RoutingTableEntry *> &routes) const;
+
+  /** Remove all the routes. */
+  void Clear (void);
+
+  /**
+   * \returns The number of routes in the index.
+   */
+  uint32_t GetNRoutes (void) const;
+
+private:
+  /**
+   * Copy constructor.
+   * Defined and unimplemented to avoid misuse.
+   */
+  Ipv4RouteTrie (const Ipv4RouteTrie &);
+  /**
+   * Assignment operator.
+   * Defined and unimplemented to avoid misuse.
+   * \returns The trie.
+   */
+  Ipv4RouteTrie & operator = (const Ipv4RouteTrie &);
+
+  /// A route with its insertion sequence number
+  typedef std::pair<uint32_t, Ipv4RoutingTableEntry *> Route;
+
+  /// A node of the trie
+  struct Node
+  {
+    uint32_t prefix;            //!< The prefix, with all the bits past length cleared
+    uint8_t length;             //!< The length of the prefix
+    Node *child[2];             //!< The children extending the prefix with a 0 and a 1 bit
+    std::vector<Route> routes;  //!< The routes to the prefix
+  };
+
+  /**
+   * \brief Create a node.
+   * \param prefix The prefix.
+   * \param length The length of the prefix.
+   * \returns The node.
+   */
+  static Node * NewNode (uint32_t prefix, uint8_t length);
+  /**
+   * \brief Delete a node and all of its descendants.
+   * \param node The node.
+   */
+  static void DeleteNode (Node *node);
+
+  /// A route with a non-contiguous mask
+  struct NonContiguousRoute
+  {
+    Ipv4Address network;  //!< The destination network
+    Ipv4Mask mask;        //!< The mask of the destination network
+    Route route;          //!< The route
+  };
+
+  Node *m_root;                                    //!< The node of the empty prefix
+  std::vector<NonContiguousRoute> m_nonContiguous; //!< The routes with a non-contiguous mask
+  uint32_t m_nRoutes;                              //!< The number of routes
+};
+
+} // namespace ns3
+
+#endif /* IPV4_ROUTE_TRIE_H */
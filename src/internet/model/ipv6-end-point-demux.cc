@@ -40,22 +40,101 @@ Ipv6EndPointDemux::~Ipv6EndPointDemux ()
   for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++)
     {
       Ipv6EndPoint *endPoint = *i;
+      endPoint->m_demux = 0;
       delete endPoint;
     }
   m_endPoints.clear ();
+  m_tuples.clear ();
+  m_ports.clear ();
 }
 
-bool Ipv6EndPointDemux::LookupPortLocal (uint16_t port)
+Ipv6EndPointDemux::Tuple::Tuple (Ipv6Address localAddress, uint16_t localPort,
+                                 Ipv6Address peerAddress, uint16_t peerPort)
+  : localAddress (localAddress),
+    localPort (localPort),
+    peerAddress (peerAddress),
+    peerPort (peerPort)
 {
-  NS_LOG_FUNCTION (this << port);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++)
+}
+
+bool Ipv6EndPointDemux::Tuple::operator== (const Tuple &other) const
+{
+  return localPort == other.localPort && peerPort == other.peerPort
+         && localAddress == other.localAddress && peerAddress == other.peerAddress;
+}
+
+size_t Ipv6EndPointDemux::TupleHash::operator() (const Tuple &tuple) const
+{
+  Ipv6AddressHash hash;
+  size_t h = hash (tuple.peerAddress);
+  h ^= hash (tuple.localAddress) + 0x9e3779b9 + (h << 6) + (h >> 2);
+  h ^= ((static_cast<size_t> (tuple.localPort) << 16) | tuple.peerPort) + 0x9e3779b9 + (h << 6) + (h >> 2);
+  return h;
+}
+
+Ipv6EndPointDemux::Tuple Ipv6EndPointDemux::GetTuple (Ipv6EndPoint *endPoint)
+{
+  return Tuple (endPoint->GetLocalAddress (), endPoint->GetLocalPort (),
+                endPoint->GetPeerAddress (), endPoint->GetPeerPort ());
+}
+
+bool Ipv6EndPointDemux::IsWildcard (Ipv6EndPoint *endPoint)
+{
+  return endPoint->GetLocalAddress () == Ipv6Address::GetAny ()
+         || endPoint->GetPeerAddress () == Ipv6Address::GetAny ()
+         || endPoint->GetPeerPort () == 0;
+}
+
+void Ipv6EndPointDemux::Index (Ipv6EndPoint *endPoint)
+{
+  NS_LOG_FUNCTION (this << endPoint);
+  Tuple tuple = GetTuple (endPoint);
+  m_tuples[tuple].push_back (endPoint);
+  PortEndPoints &port = m_ports[tuple.localPort];
+  port.nEndPoints++;
+  if (IsWildcard (endPoint))
     {
-      if ((*i)->GetLocalPort  () == port)
-        {
-          return true;
-        }
+      port.wildcards.push_back (endPoint);
+    }
+}
+
+void Ipv6EndPointDemux::Unindex (Ipv6EndPoint *endPoint)
+{
+  NS_LOG_FUNCTION (this << endPoint);
+  Tuple tuple = GetTuple (endPoint);
+  TupleIndex::iterator t = m_tuples.find (tuple);
+  NS_ASSERT (t != m_tuples.end ());
+  t->second.remove (endPoint);
+  if (t->second.empty ())
+    {
+      m_tuples.erase (t);
+    }
+  PortIndex::iterator port = m_ports.find (tuple.localPort);
+  NS_ASSERT (port != m_ports.end ());
+  if (IsWildcard (endPoint))
+    {
+      port->second.wildcards.remove (endPoint);
+    }
+  if (--port->second.nEndPoints == 0)
+    {
+      m_ports.erase (port);
     }
-  return false;
+}
+
+Ipv6EndPoint* Ipv6EndPointDemux::Insert (Ipv6EndPoint *endPoint)
+{
+  NS_LOG_FUNCTION (this << endPoint);
+  m_endPoints.push_back (endPoint);
+  endPoint->m_demux = this;
+  Index (endPoint);
+  NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
+  return endPoint;
+}
+
+bool Ipv6EndPointDemux::LookupPortLocal (uint16_t port)
+{
+  NS_LOG_FUNCTION (this << port);
+  return m_ports.find (port) != m_ports.end ();
 }
 
 bool Ipv6EndPointDemux::LookupLocal (Ptr<NetDevice> boundNetDevice, Ipv6Address addr, uint16_t port)
@@ -82,10 +161,7 @@ Ipv6EndPoint* Ipv6EndPointDemux::Allocate ()
       NS_LOG_WARN ("Ephemeral port allocation failed.");
       return 0;
     }
-  Ipv6EndPoint *endPoint = new Ipv6EndPoint (Ipv6Address::GetAny (), port);
-  m_endPoints.push_back (endPoint);
-  NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
-  return endPoint;
+  return Insert (new Ipv6EndPoint (Ipv6Address::GetAny (), port));
 }
 
 Ipv6EndPoint* Ipv6EndPointDemux::Allocate (Ipv6Address address)
@@ -97,10 +173,7 @@ Ipv6EndPoint* Ipv6EndPointDemux::Allocate (Ipv6Address address)
       NS_LOG_WARN ("Ephemeral port allocation failed.");
       return 0;
     }
-  Ipv6EndPoint *endPoint = new Ipv6EndPoint (address, port);
-  m_endPoints.push_back (endPoint);
-  NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
-  return endPoint;
+  return Insert (new Ipv6EndPoint (address, port));
 }
 
 Ipv6EndPoint* Ipv6EndPointDemux::Allocate (Ptr<NetDevice> boundNetDevice, uint16_t port)
@@ -118,10 +191,7 @@ Ipv6EndPoint* Ipv6EndPointDemux::Allocate (Ptr<NetDevice> boundNetDevice, Ipv6Ad
       NS_LOG_WARN ("Duplicated endpoint.");
       return 0;
     }
-  Ipv6EndPoint *endPoint = new Ipv6EndPoint (address, port);
-  m_endPoints.push_back (endPoint);
-  NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
-  return endPoint;
+  return Insert (new Ipv6EndPoint (address, port));
 }
 
 Ipv6EndPoint* Ipv6EndPointDemux::Allocate (Ptr<NetDevice> boundNetDevice,
@@ -129,25 +199,21 @@ Ipv6EndPoint* Ipv6EndPointDemux::Allocate (Ptr<NetDevice> boundNetDevice,
                                            Ipv6Address peerAddress, uint16_t peerPort)
 {
   NS_LOG_FUNCTION (this << boundNetDevice << localAddress << localPort << peerAddress << peerPort);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++)
+  TupleIndex::iterator t = m_tuples.find (Tuple (localAddress, localPort, peerAddress, peerPort));
+  if (t != m_tuples.end ())
     {
-      if ((*i)->GetLocalPort () == localPort &&
-          (*i)->GetLocalAddress () == localAddress &&
-          (*i)->GetPeerPort () == peerPort &&
-          (*i)->GetPeerAddress () == peerAddress &&
-          ((*i)->GetBoundNetDevice () == boundNetDevice || (*i)->GetBoundNetDevice () == 0))
+      for (EndPointsI i = t->second.begin (); i != t->second.end (); i++)
         {
-          NS_LOG_WARN ("Duplicated endpoint.");
-          return 0;
+          if ((*i)->GetBoundNetDevice () == boundNetDevice || (*i)->GetBoundNetDevice () == 0)
+            {
+              NS_LOG_WARN ("Duplicated endpoint.");
+              return 0;
+            }
         }
     }
   Ipv6EndPoint *endPoint = new Ipv6EndPoint (localAddress, localPort);
   endPoint->SetPeer (peerAddress, peerPort);
-  m_endPoints.push_back (endPoint);
-
-  NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
-
-  return endPoint;
+  return Insert (endPoint);
 }
 
 void Ipv6EndPointDemux::DeAllocate (Ipv6EndPoint *endPoint)
@@ -157,6 +223,8 @@ void Ipv6EndPointDemux::DeAllocate (Ipv6EndPoint *endPoint)
     {
       if (*i == endPoint)
         {
+          Unindex (endPoint);
+          endPoint->m_demux = 0;
           delete endPoint;
           m_endPoints.erase (i);
           break;
@@ -164,6 +232,105 @@ void Ipv6EndPointDemux::DeAllocate (Ipv6EndPoint *endPoint)
     }
 }
 
+void Ipv6EndPointDemux::Match (Ipv6EndPoint *endP,
+                               Ipv6Address daddr, uint16_t dport,
+                               Ipv6Address saddr, uint16_t sport,
+                               Ptr<Ipv6Interface> incomingInterface,
+                               EndPoints &retval1, EndPoints &retval2,
+                               EndPoints &retval3, EndPoints &retval4)
+{
+  NS_LOG_DEBUG ("Looking at endpoint dport=" << endP->GetLocalPort ()
+                                             << " daddr=" << endP->GetLocalAddress ()
+                                             << " sport=" << endP->GetPeerPort ()
+                                             << " saddr=" << endP->GetPeerAddress ());
+
+  if (!endP->IsRxEnabled ())
+    {
+      NS_LOG_LOGIC ("Skipping endpoint " << &endP
+                    << " because endpoint can not receive packets");
+      return;
+    }
+
+  if (endP->GetLocalPort () != dport)
+    {
+      NS_LOG_LOGIC ("Skipping endpoint " << &endP
+                                         << " because endpoint dport "
+                                         << endP->GetLocalPort ()
+                                         << " does not match packet dport " << dport);
+      return;
+    }
+
+  if (endP->GetBoundNetDevice ())
+    {
+      if (!incomingInterface)
+        {
+          return;
+        }
+      if (endP->GetBoundNetDevice () != incomingInterface->GetDevice ())
+        {
+          NS_LOG_LOGIC ("Skipping endpoint " << &endP
+                                             << " because endpoint is bound to specific device and"
+                                             << endP->GetBoundNetDevice ()
+                                             << " does not match packet device " << incomingInterface->GetDevice ());
+          return;
+        }
+    }
+
+  /*    Ipv6Address incomingInterfaceAddr = incomingInterface->GetAddress (); */
+  NS_LOG_DEBUG ("dest addr " << daddr);
+
+  bool localAddressMatchesWildCard = endP->GetLocalAddress () == Ipv6Address::GetAny ();
+  bool localAddressMatchesExact = endP->GetLocalAddress () == daddr;
+  bool localAddressMatchesAllRouters = endP->GetLocalAddress () == Ipv6Address::GetAllRoutersMulticast ();
+
+  /* if no match here, keep looking */
+  if (!(localAddressMatchesExact || localAddressMatchesWildCard))
+    {
+      return;
+    }
+  bool remotePeerMatchesExact = endP->GetPeerPort () == sport;
+  bool remotePeerMatchesWildCard = endP->GetPeerPort () == 0;
+  bool remoteAddressMatchesExact = endP->GetPeerAddress () == saddr;
+  bool remoteAddressMatchesWildCard = endP->GetPeerAddress () == Ipv6Address::GetAny ();
+
+  /* If remote does not match either with exact or wildcard,i
+     skip this one */
+  if (!(remotePeerMatchesExact || remotePeerMatchesWildCard))
+    {
+      return;
+    }
+  if (!(remoteAddressMatchesExact || remoteAddressMatchesWildCard))
+    {
+      return;
+    }
+
+  /* Now figure out which return list to add this one to */
+  if (localAddressMatchesWildCard
+      && remotePeerMatchesWildCard
+      && remoteAddressMatchesWildCard)
+    { /* Only local port matches exactly */
+      retval1.push_back (endP);
+    }
+  if ((localAddressMatchesExact || (localAddressMatchesAllRouters))
+      && remotePeerMatchesWildCard
+      && remoteAddressMatchesWildCard)
+    { /* Only local port and local address matches exactly */
+      retval2.push_back (endP);
+    }
+  if (localAddressMatchesWildCard
+      && remotePeerMatchesExact
+      && remoteAddressMatchesExact)
+    { /* All but local address */
+      retval3.push_back (endP);
+    }
+  if (localAddressMatchesExact
+      && remotePeerMatchesExact
+      && remoteAddressMatchesExact)
+    { /* All 4 match */
+      retval4.push_back (endP);
+    }
+}
+
 /*
  * If we have an exact match, we return it.
  * Otherwise, if we find a generic match, we return it.
@@ -181,100 +348,26 @@ Ipv6EndPointDemux::EndPoints Ipv6EndPointDemux::Lookup (Ipv6Address daddr, uint1
   EndPoints retval4; /* Exact match on all 4 */
 
   NS_LOG_DEBUG ("Looking up endpoint for destination address " << daddr);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++)
+  PortIndex::iterator port = m_ports.find (dport);
+  if (port != m_ports.end ())
     {
-      Ipv6EndPoint* endP = *i;
-
-      NS_LOG_DEBUG ("Looking at endpoint dport=" << endP->GetLocalPort ()
-                                                 << " daddr=" << endP->GetLocalAddress ()
-                                                 << " sport=" << endP->GetPeerPort ()
-                                                 << " saddr=" << endP->GetPeerAddress ());
-
-      if (!endP->IsRxEnabled ())
-        {
-          NS_LOG_LOGIC ("Skipping endpoint " << &endP
-                        << " because endpoint can not receive packets");
-          continue;
-        }
-
-      if (endP->GetLocalPort () != dport)
+      /* The end points with a wildcard address or port are all checked,
+         the other ones can only match the four-tuple of the packet. */
+      for (EndPointsI i = port->second.wildcards.begin (); i != port->second.wildcards.end (); i++)
         {
-          NS_LOG_LOGIC ("Skipping endpoint " << &endP
-                                             << " because endpoint dport "
-                                             << endP->GetLocalPort ()
-                                             << " does not match packet dport " << dport);
-          continue;
+          Match (*i, daddr, dport, saddr, sport, incomingInterface, retval1, retval2, retval3, retval4);
         }
-
-      if (endP->GetBoundNetDevice ())
+      TupleIndex::iterator t = m_tuples.find (Tuple (daddr, dport, saddr, sport));
+      if (t != m_tuples.end ())
         {
-          if (!incomingInterface)
-            {
-              continue;
-            }
-          if (endP->GetBoundNetDevice () != incomingInterface->GetDevice ())
+          for (EndPointsI i = t->second.begin (); i != t->second.end (); i++)
             {
-              NS_LOG_LOGIC ("Skipping endpoint " << &endP
-                                                 << " because endpoint is bound to specific device and"
-                                                 << endP->GetBoundNetDevice ()
-                                                 << " does not match packet device " << incomingInterface->GetDevice ());
-              continue;
+              if (!IsWildcard (*i))
+                {
+                  Match (*i, daddr, dport, saddr, sport, incomingInterface, retval1, retval2, retval3, retval4);
+                }
             }
         }
-
-      /*    Ipv6Address incomingInterfaceAddr = incomingInterface->GetAddress (); */
-      NS_LOG_DEBUG ("dest addr " << daddr);
-
-      bool localAddressMatchesWildCard = endP->GetLocalAddress () == Ipv6Address::GetAny ();
-      bool localAddressMatchesExact = endP->GetLocalAddress () == daddr;
-      bool localAddressMatchesAllRouters = endP->GetLocalAddress () == Ipv6Address::GetAllRoutersMulticast ();
-
-      /* if no match here, keep looking */
-      if (!(localAddressMatchesExact || localAddressMatchesWildCard))
-        {
-          continue;
-        }
-      bool remotePeerMatchesExact = endP->GetPeerPort () == sport;
-      bool remotePeerMatchesWildCard = endP->GetPeerPort () == 0;
-      bool remoteAddressMatchesExact = endP->GetPeerAddress () == saddr;
-      bool remoteAddressMatchesWildCard = endP->GetPeerAddress () == Ipv6Address::GetAny ();
-
-      /* If remote does not match either with exact or wildcard,i
-         skip this one */
-      if (!(remotePeerMatchesExact || remotePeerMatchesWildCard))
-        {
-          continue;
-        }
-      if (!(remoteAddressMatchesExact || remoteAddressMatchesWildCard))
-        {
-          continue;
-        }
-
-      /* Now figure out which return list to add this one to */
-      if (localAddressMatchesWildCard
-          && remotePeerMatchesWildCard
-          && remoteAddressMatchesWildCard)
-        { /* Only local port matches exactly */
-          retval1.push_back (endP);
-        }
-      if ((localAddressMatchesExact || (localAddressMatchesAllRouters))
-          && remotePeerMatchesWildCard
-          && remoteAddressMatchesWildCard)
-        { /* Only local port and local address matches exactly */
-          retval2.push_back (endP);
-        }
-      if (localAddressMatchesWildCard
-          && remotePeerMatchesExact
-          && remoteAddressMatchesExact)
-        { /* All but local address */
-          retval3.push_back (endP);
-        }
-      if (localAddressMatchesExact
-          && remotePeerMatchesExact
-          && remoteAddressMatchesExact)
-        { /* All 4 match */
-          retval4.push_back (endP);
-        }
     }
 
   // Here we find the most exact match
@@ -290,6 +383,14 @@ Ipv6EndPointDemux::EndPoints Ipv6EndPointDemux::Lookup (Ipv6Address daddr, uint1
 
 Ipv6EndPoint* Ipv6EndPointDemux::SimpleLookup (Ipv6Address dst, uint16_t dport, Ipv6Address src, uint16_t sport)
 {
+  /* a single end point with this exact four-tuple is the answer; otherwise
+     the first exact match or the most specific end point is searched below */
+  TupleIndex::iterator t = m_tuples.find (Tuple (dst, dport, src, sport));
+  if (t != m_tuples.end () && t->second.size () == 1)
+    {
+      return t->second.front ();
+    }
+
   uint32_t genericity = 3;
   Ipv6EndPoint *generic = 0;
 
@@ -23,6 +23,7 @@
 
 #include <stdint.h>
 #include <list>
+#include <unordered_map>
 #include "ns3/ipv6-address.h"
 #include "ipv6-interface.h"
 
@@ -34,6 +35,11 @@ class Ipv6EndPoint;
  * \ingroup ipv6
  *
  * \brief Demultiplexer for end points.
+ *
+ * The end points are indexed by four-tuple and by local port, so that a
+ * lookup only checks the end points with the four-tuple of the packet and
+ * the ones bound to its destination port with a wildcard address or port
+ * (e.g., listening sockets), whatever the number of connections.
  */
 class Ipv6EndPointDemux
 {
@@ -153,6 +159,125 @@ public:
   EndPoints GetEndPoints () const;
 
 private:
+  friend class Ipv6EndPoint;
+
+  /**
+   * \brief The local and peer addresses and ports of an end point.
+   */
+  struct Tuple
+  {
+    /**
+     * \brief Constructor.
+     * \param localAddress local address
+     * \param localPort local port
+     * \param peerAddress peer address
+     * \param peerPort peer port
+     */
+    Tuple (Ipv6Address localAddress, uint16_t localPort,
+           Ipv6Address peerAddress, uint16_t peerPort);
+    /**
+     * \brief Equality operator.
+     * \param other the other tuple
+     * \returns true if the tuples are equal
+     */
+    bool operator== (const Tuple &other) const;
+
+    Ipv6Address localAddress;  //!< local address
+    uint16_t localPort;        //!< local port
+    Ipv6Address peerAddress;   //!< peer address
+    uint16_t peerPort;         //!< peer port
+  };
+
+  /**
+   * \brief Hash function of the tuples.
+   */
+  struct TupleHash
+  {
+    /**
+     * \param tuple the tuple
+     * \returns the hash of the tuple
+     */
+    size_t operator() (const Tuple &tuple) const;
+  };
+
+  /**
+   * \brief The end points bound to a local port.
+   */
+  struct PortEndPoints
+  {
+    uint32_t nEndPoints;  //!< The number of end points
+    EndPoints wildcards;  //!< The end points with a wildcard address or port
+  };
+
+  /**
+   * \brief Index of the end points by tuple.
+   */
+  typedef std::unordered_map<Tuple, EndPoints, TupleHash> TupleIndex;
+
+  /**
+   * \brief Index of the end points by local port.
+   */
+  typedef std::unordered_map<uint16_t, PortEndPoints> PortIndex;
+
+  /**
+   * \brief Get the tuple of an end point.
+   * \param endPoint the end point
+   * \returns the tuple
+   */
+  static Tuple GetTuple (Ipv6EndPoint *endPoint);
+
+  /**
+   * \brief Checks if an end point accepts packets from any peer or to any
+   * local address.
+   *
+   * Such end points (e.g., listening sockets) are checked one by one by
+   * Lookup, while the other ones are found by tuple.
+   *
+   * \param endPoint the end point
+   * \returns true if the local address, peer address or peer port is a wildcard
+   */
+  static bool IsWildcard (Ipv6EndPoint *endPoint);
+
+  /**
+   * \brief Add an end point to the indexes.
+   * \param endPoint the end point
+   */
+  void Index (Ipv6EndPoint *endPoint);
+
+  /**
+   * \brief Remove an end point from the indexes.
+   * \param endPoint the end point
+   */
+  void Unindex (Ipv6EndPoint *endPoint);
+
+  /**
+   * \brief Add a new end point to the list of end points and the indexes.
+   * \param endPoint the end point
+   * \returns the end point
+   */
+  Ipv6EndPoint *Insert (Ipv6EndPoint *endPoint);
+
+  /**
+   * \brief Check if an end point matches a packet and, if so, add it
+   * to the lists of matching end points of the cases it matches.
+   * \param endP the end point
+   * \param daddr destination address to test
+   * \param dport destination port to test
+   * \param saddr source address to test
+   * \param sport source port to test
+   * \param incomingInterface the incoming interface
+   * \param retval1 matches exact on local port, wildcards on others
+   * \param retval2 matches exact on local port/address, wildcards on others
+   * \param retval3 matches all but local address
+   * \param retval4 exact match on all 4
+   */
+  void Match (Ipv6EndPoint *endP,
+              Ipv6Address daddr, uint16_t dport,
+              Ipv6Address saddr, uint16_t sport,
+              Ptr<Ipv6Interface> incomingInterface,
+              EndPoints &retval1, EndPoints &retval2,
+              EndPoints &retval3, EndPoints &retval4);
+
   /**
    * \brief Allocate a ephemeral port.
    * \return a port
@@ -178,6 +303,16 @@ private:
    * \brief A list of IPv6 end points.
    */
   EndPoints m_endPoints;
+
+  /**
+   * \brief The IPv6 end points, by tuple.
+   */
+  TupleIndex m_tuples;
+
+  /**
+   * \brief The IPv6 end points, by local port.
+   */
+  PortIndex m_ports;
 };
 
 } /* namespace ns3 */
@@ -83,6 +83,14 @@ public:
   virtual bool Mark (void);
 
 private:
+  /**
+   * \brief Computes the hash of the packet's 5-tuple
+   *
+   * \param perturbation hash perturbation value
+   * \return the hash of the packet's 5-tuple
+   */
+  virtual uint32_t DoHash (uint32_t perturbation) const;
+
   /**
    * \brief Default constructor
    *
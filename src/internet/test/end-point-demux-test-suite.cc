@@ -0,0 +1,251 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/ipv4-end-point.h"
+#include "ns3/ipv4-end-point-demux.h"
+#include "ns3/ipv4-interface.h"
+#include "ns3/ipv6-end-point.h"
+#include "ns3/ipv6-end-point-demux.h"
+#include "ns3/ipv6-interface.h"
+#include <vector>
+
+using namespace ns3;
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief Ipv4EndPointDemux lookups, with listening and connected endpoints.
+ */
+class Ipv4EndPointDemuxTestCase : public TestCase
+{
+public:
+  Ipv4EndPointDemuxTestCase ();
+private:
+  virtual void DoRun (void);
+  /**
+   * \param daddr destination address
+   * \param dport destination port
+   * \param saddr source address
+   * \param sport source port
+   * \returns the endpoint found, 0 if none or more than one
+   */
+  Ipv4EndPoint * Lookup (Ipv4Address daddr, uint16_t dport, Ipv4Address saddr, uint16_t sport);
+
+  Ipv4EndPointDemux m_demux;            //!< The demux
+  Ptr<Ipv4Interface> m_interface;       //!< The incoming interface
+};
+
+Ipv4EndPointDemuxTestCase::Ipv4EndPointDemuxTestCase ()
+  : TestCase ("Ipv4EndPointDemux lookups")
+{
+}
+
+Ipv4EndPoint *
+Ipv4EndPointDemuxTestCase::Lookup (Ipv4Address daddr, uint16_t dport, Ipv4Address saddr, uint16_t sport)
+{
+  Ipv4EndPointDemux::EndPoints endPoints = m_demux.Lookup (daddr, dport, saddr, sport, m_interface);
+  return (endPoints.size () == 1) ? endPoints.front () : 0;
+}
+
+void
+Ipv4EndPointDemuxTestCase::DoRun (void)
+{
+  m_interface = CreateObject<Ipv4Interface> ();
+  m_interface->AddAddress (Ipv4InterfaceAddress (Ipv4Address ("10.0.0.1"), Ipv4Mask ("255.255.255.0")));
+  Ipv4Address local ("10.0.0.1");
+
+  // a server listening on any address, with many connections
+  Ipv4EndPoint *listener = m_demux.Allocate (0, 80);
+  NS_TEST_ASSERT_MSG_NE (listener, 0, "Allocation of the listener failed");
+  std::vector<Ipv4EndPoint *> connections;
+  for (uint32_t i = 0; i < 100; i++)
+    {
+      Ipv4EndPoint *connection = m_demux.Allocate (0, local, 80, Ipv4Address (0x0b000000 + i), 1000 + i);
+      NS_TEST_ASSERT_MSG_NE (connection, 0, "Allocation of a connection failed");
+      connections.push_back (connection);
+    }
+  NS_TEST_EXPECT_MSG_EQ (m_demux.Allocate (0, local, 80, Ipv4Address (0x0b000000), 1000), 0,
+                         "Duplicated connection allocated");
+  NS_TEST_EXPECT_MSG_EQ (m_demux.Allocate (0, 80), 0, "Duplicated listener allocated");
+
+  for (uint32_t i = 0; i < 100; i++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (Lookup (local, 80, Ipv4Address (0x0b000000 + i), 1000 + i), connections[i],
+                             "Wrong endpoint for connection " << i);
+      NS_TEST_EXPECT_MSG_EQ (m_demux.SimpleLookup (local, 80, Ipv4Address (0x0b000000 + i), 1000 + i), connections[i],
+                             "Wrong simple lookup for connection " << i);
+    }
+  NS_TEST_EXPECT_MSG_EQ (Lookup (local, 80, Ipv4Address ("12.0.0.1"), 1000), listener,
+                         "New connections must go to the listener");
+  NS_TEST_EXPECT_MSG_EQ (Lookup (local, 81, Ipv4Address ("12.0.0.1"), 1000), 0,
+                         "Nothing listens on port 81");
+  NS_TEST_EXPECT_MSG_EQ (m_demux.GetAllEndPoints ().size (), 101, "Wrong number of endpoints");
+
+  // a listener bound to the local address is preferred to the wildcard one
+  NS_TEST_EXPECT_MSG_EQ (m_demux.Allocate (0, local, 80), 0, "Address and port of connections allocated");
+  Ipv4EndPoint *any = m_demux.Allocate (0, 81);
+  Ipv4EndPoint *bound = m_demux.Allocate (0, local, 81);
+  NS_TEST_ASSERT_MSG_NE (bound, 0, "Allocation of the bound listener failed");
+  NS_TEST_EXPECT_MSG_EQ (Lookup (local, 81, Ipv4Address ("12.0.0.1"), 1000), bound,
+                         "Listener bound to the address not preferred");
+  NS_TEST_EXPECT_MSG_EQ (Lookup (Ipv4Address ("10.0.0.2"), 81, Ipv4Address ("12.0.0.1"), 1000), any,
+                         "Listener bound to any address not found");
+  Ipv4EndPoint *connection = m_demux.Allocate (0, local, 81, Ipv4Address ("12.0.0.1"), 1000);
+  NS_TEST_EXPECT_MSG_EQ (Lookup (local, 81, Ipv4Address ("12.0.0.1"), 1000), connection,
+                         "Connection not preferred to the listeners");
+  m_demux.DeAllocate (connection);
+  m_demux.DeAllocate (bound);
+  m_demux.DeAllocate (any);
+
+  // a connection whose tuple changes after allocation, as TCP clients do
+  Ipv4EndPoint *client = m_demux.Allocate ();
+  uint16_t clientPort = client->GetLocalPort ();
+  NS_TEST_EXPECT_MSG_EQ (m_demux.LookupPortLocal (clientPort), true, "Ephemeral port not in use");
+  client->SetPeer (Ipv4Address ("12.0.0.2"), 80);
+  client->SetLocalAddress (local);
+  NS_TEST_EXPECT_MSG_EQ (Lookup (local, clientPort, Ipv4Address ("12.0.0.2"), 80), client,
+                         "Client not found after its tuple changed");
+  NS_TEST_EXPECT_MSG_EQ (Lookup (local, clientPort, Ipv4Address ("12.0.0.3"), 80), 0,
+                         "Client found for another peer");
+  NS_TEST_EXPECT_MSG_EQ (m_demux.Allocate (0, local, clientPort, Ipv4Address ("12.0.0.2"), 80), 0,
+                         "Duplicate of the client allocated");
+  m_demux.DeAllocate (client);
+  NS_TEST_EXPECT_MSG_EQ (m_demux.LookupPortLocal (clientPort), false, "Ephemeral port still in use");
+  NS_TEST_EXPECT_MSG_EQ (Lookup (local, clientPort, Ipv4Address ("12.0.0.2"), 80), 0,
+                         "Client found after deallocation");
+
+  // a connection bound to the network address receives subnet-directed broadcasts
+  Ipv4EndPoint *subnet = m_demux.Allocate (0, Ipv4Address ("10.0.0.0"), 90, Ipv4Address ("12.0.0.4"), 9);
+  NS_TEST_EXPECT_MSG_EQ (Lookup (Ipv4Address ("10.0.0.255"), 90, Ipv4Address ("12.0.0.4"), 9), subnet,
+                         "Subnet-directed broadcast not received");
+  NS_TEST_EXPECT_MSG_EQ (Lookup (Ipv4Address ("10.0.1.255"), 90, Ipv4Address ("12.0.0.4"), 9), 0,
+                         "Broadcast to another subnet received");
+
+  // once deallocated, connections go to the listener
+  m_demux.DeAllocate (connections[7]);
+  NS_TEST_EXPECT_MSG_EQ (Lookup (local, 80, Ipv4Address (0x0b000000 + 7), 1007), listener,
+                         "Deallocated connection found");
+  NS_TEST_EXPECT_MSG_EQ (m_demux.SimpleLookup (local, 80, Ipv4Address (0x0b000000 + 7), 1007), connections[0],
+                         "SimpleLookup must return the first most specific endpoint");
+  m_demux.DeAllocate (listener);
+  NS_TEST_EXPECT_MSG_EQ (Lookup (local, 80, Ipv4Address (0x0b000000 + 7), 1007), 0,
+                         "Deallocated listener found");
+  NS_TEST_EXPECT_MSG_EQ (m_demux.LookupPortLocal (80), true, "Port 80 still has connections");
+
+  m_interface = 0;
+}
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief Ipv6EndPointDemux lookups, with listening and connected endpoints.
+ */
+class Ipv6EndPointDemuxTestCase : public TestCase
+{
+public:
+  Ipv6EndPointDemuxTestCase ();
+private:
+  virtual void DoRun (void);
+  /**
+   * \param daddr destination address
+   * \param dport destination port
+   * \param saddr source address
+   * \param sport source port
+   * \returns the endpoint found, 0 if none or more than one
+   */
+  Ipv6EndPoint * Lookup (Ipv6Address daddr, uint16_t dport, Ipv6Address saddr, uint16_t sport);
+
+  Ipv6EndPointDemux m_demux;            //!< The demux
+};
+
+Ipv6EndPointDemuxTestCase::Ipv6EndPointDemuxTestCase ()
+  : TestCase ("Ipv6EndPointDemux lookups")
+{
+}
+
+Ipv6EndPoint *
+Ipv6EndPointDemuxTestCase::Lookup (Ipv6Address daddr, uint16_t dport, Ipv6Address saddr, uint16_t sport)
+{
+  Ipv6EndPointDemux::EndPoints endPoints = m_demux.Lookup (daddr, dport, saddr, sport, 0);
+  return (endPoints.size () == 1) ? endPoints.front () : 0;
+}
+
+void
+Ipv6EndPointDemuxTestCase::DoRun (void)
+{
+  Ipv6Address local ("2001:db8::1");
+  Ipv6EndPoint *listener = m_demux.Allocate (0, 80);
+  NS_TEST_ASSERT_MSG_NE (listener, 0, "Allocation of the listener failed");
+  std::vector<Ipv6EndPoint *> connections;
+  for (uint32_t i = 0; i < 100; i++)
+    {
+      uint8_t peer[16] = { 0x20, 0x01, 0x0d, 0xb8, 0, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, static_cast<uint8_t> (i) };
+      Ipv6EndPoint *connection = m_demux.Allocate (0, local, 80, Ipv6Address (peer), 1000 + i);
+      NS_TEST_ASSERT_MSG_NE (connection, 0, "Allocation of a connection failed");
+      connections.push_back (connection);
+    }
+  for (uint32_t i = 0; i < 100; i++)
+    {
+      uint8_t peer[16] = { 0x20, 0x01, 0x0d, 0xb8, 0, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, static_cast<uint8_t> (i) };
+      NS_TEST_EXPECT_MSG_EQ (Lookup (local, 80, Ipv6Address (peer), 1000 + i), connections[i],
+                             "Wrong endpoint for connection " << i);
+      NS_TEST_EXPECT_MSG_EQ (m_demux.Allocate (0, local, 80, Ipv6Address (peer), 1000 + i), 0,
+                             "Duplicated connection " << i << " allocated");
+    }
+  NS_TEST_EXPECT_MSG_EQ (Lookup (local, 80, Ipv6Address ("2001:db8:2::1"), 1000), listener,
+                         "New connections must go to the listener");
+
+  Ipv6EndPoint *client = m_demux.Allocate ();
+  uint16_t clientPort = client->GetLocalPort ();
+  client->SetPeer (Ipv6Address ("2001:db8:2::2"), 80);
+  client->SetLocalAddress (local);
+  NS_TEST_EXPECT_MSG_EQ (Lookup (local, clientPort, Ipv6Address ("2001:db8:2::2"), 80), client,
+                         "Client not found after its tuple changed");
+  client->SetLocalPort (clientPort + 1);
+  NS_TEST_EXPECT_MSG_EQ (Lookup (local, clientPort, Ipv6Address ("2001:db8:2::2"), 80), 0,
+                         "Client found on its former port");
+  NS_TEST_EXPECT_MSG_EQ (Lookup (local, clientPort + 1, Ipv6Address ("2001:db8:2::2"), 80), client,
+                         "Client not found on its new port");
+  m_demux.DeAllocate (client);
+  NS_TEST_EXPECT_MSG_EQ (m_demux.LookupPortLocal (clientPort + 1), false, "Port still in use");
+
+  m_demux.DeAllocate (connections[7]);
+  uint8_t peer[16] = { 0x20, 0x01, 0x0d, 0xb8, 0, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 7 };
+  NS_TEST_EXPECT_MSG_EQ (Lookup (local, 80, Ipv6Address (peer), 1007), listener,
+                         "Deallocated connection found");
+}
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief End point demux TestSuite
+ */
+class EndPointDemuxTestSuite : public TestSuite
+{
+public:
+  EndPointDemuxTestSuite ()
+    : TestSuite ("end-point-demux", UNIT)
+  {
+    AddTestCase (new Ipv4EndPointDemuxTestCase, TestCase::QUICK);
+    AddTestCase (new Ipv6EndPointDemuxTestCase, TestCase::QUICK);
+  }
+};
+
+static EndPointDemuxTestSuite g_endPointDemuxTestSuite; //!< Static variable for test initialization
@@ -202,6 +202,8 @@ GlobalRouteManagerImplTestCase::DoRun (void)
   srmlsdb->Insert (lsa2->GetLinkStateId (), lsa2);
   srmlsdb->Insert (lsa3->GetLinkStateId (), lsa3);
   NS_ASSERT (lsa2 == srmlsdb->GetLSA (lsa2->GetLinkStateId ()));
+  NS_TEST_ASSERT_MSG_EQ (srmlsdb->GetNumLSAs (), 4, "The LSDB should hold 4 LSAs");
+  NS_TEST_ASSERT_MSG_EQ (lsa3->GetIndex (), 3, "The LSAs should be numbered in the order they are inserted");
 
   // next, calculate routes based on the manually created LSDB
   GlobalRouteManagerImpl* srm = new GlobalRouteManagerImpl ();
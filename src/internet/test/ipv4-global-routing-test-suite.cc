@@ -41,7 +41,12 @@
 #include "ns3/ipv4-routing-protocol.h"
 #include "ns3/ipv4-routing-table-entry.h"
 #include "ns3/ipv4-global-routing.h"
+#include "ns3/ipv4-list-routing.h"
 #include "ns3/bridge-helper.h"
+#include "ns3/ipv4-route-trie.h"
+#include "ns3/random-variable-stream.h"
+#include "ns3/output-stream-wrapper.h"
+#include <sstream>
 
 using namespace ns3;
 
@@ -1244,6 +1249,246 @@ Ipv4GlobalRoutingSlash32TestCase::DoRun (void)
   Simulator::Destroy ();
 }
 
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief Ipv4RouteTrie test: the routes found must be the ones whose
+ * destination network contains the address, in the order they were added.
+ */
+class Ipv4RouteTrieTestCase : public TestCase
+{
+public:
+  Ipv4RouteTrieTestCase ();
+  virtual ~Ipv4RouteTrieTestCase ();
+
+private:
+  virtual void DoRun (void);
+  /**
+   * \brief Add a route to both the trie and the list of routes.
+   * \param network The destination network.
+   * \param mask The mask of the destination network.
+   */
+  void AddRoute (Ipv4Address network, Ipv4Mask mask);
+  /**
+   * \brief Check the routes found for an address.
+   * \param dest The address.
+   */
+  void CheckLookup (Ipv4Address dest);
+
+  Ipv4RouteTrie m_trie;                          //!< The trie
+  std::vector<Ipv4RoutingTableEntry *> m_routes; //!< The routes, in the order they were added
+};
+
+Ipv4RouteTrieTestCase::Ipv4RouteTrieTestCase ()
+  : TestCase ("Ipv4RouteTrie finds all the matching routes in order")
+{
+}
+
+Ipv4RouteTrieTestCase::~Ipv4RouteTrieTestCase ()
+{
+  for (uint32_t i = 0; i < m_routes.size (); i++)
+    {
+      delete m_routes[i];
+    }
+}
+
+void
+Ipv4RouteTrieTestCase::AddRoute (Ipv4Address network, Ipv4Mask mask)
+{
+  Ipv4RoutingTableEntry *route = new Ipv4RoutingTableEntry ();
+  *route = Ipv4RoutingTableEntry::CreateNetworkRouteTo (network, mask, m_routes.size ());
+  m_routes.push_back (route);
+  m_trie.Insert (network, mask, route);
+}
+
+void
+Ipv4RouteTrieTestCase::CheckLookup (Ipv4Address dest)
+{
+  std::vector<Ipv4RoutingTableEntry *> expected;
+  for (uint32_t i = 0; i < m_routes.size (); i++)
+    {
+      if (m_routes[i]->GetDestNetworkMask ().IsMatch (dest, m_routes[i]->GetDestNetwork ()))
+        {
+          expected.push_back (m_routes[i]);
+        }
+    }
+  std::vector<Ipv4RoutingTableEntry *> found;
+  m_trie.Lookup (dest, found);
+  NS_TEST_ASSERT_MSG_EQ (found.size (), expected.size (), "Wrong number of routes to " << dest);
+  for (uint32_t i = 0; i < found.size (); i++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (found[i]->GetInterface (), expected[i]->GetInterface (),
+                             "Wrong route " << i << " to " << dest);
+    }
+}
+
+void
+Ipv4RouteTrieTestCase::DoRun (void)
+{
+  Ptr<UniformRandomVariable> rand = CreateObject<UniformRandomVariable> ();
+  rand->SetStream (1);
+
+  // the addresses are drawn from a small range, so that the networks overlap
+  AddRoute (Ipv4Address ("10.0.0.0"), Ipv4Mask ("255.0.0.0"));
+  for (uint32_t i = 0; i < 500; i++)
+    {
+      uint32_t address = 0x0a000000 | rand->GetInteger (0, 0xfff) << 12 | rand->GetInteger (0, 0xfff);
+      uint32_t length = rand->GetInteger (8, 32);
+      Ipv4Mask mask (length == 32 ? 0xffffffff : ~(0xffffffffU >> length));
+      AddRoute (Ipv4Address (address), mask);
+      if (i % 10 == 0)
+        {
+          // equal cost route
+          AddRoute (Ipv4Address (address), mask);
+        }
+    }
+  AddRoute (Ipv4Address ("0.0.0.0"), Ipv4Mask ("0.0.0.0"));
+  AddRoute (Ipv4Address ("10.0.0.1"), Ipv4Mask ("255.0.0.255"));
+
+  NS_TEST_EXPECT_MSG_EQ (m_trie.GetNRoutes (), m_routes.size (), "Wrong number of routes");
+
+  for (uint32_t i = 0; i < m_routes.size (); i++)
+    {
+      CheckLookup (m_routes[i]->GetDestNetwork ());
+    }
+  for (uint32_t i = 0; i < 2000; i++)
+    {
+      CheckLookup (Ipv4Address (0x0a000000 | rand->GetInteger (0, 0xfff) << 12 | rand->GetInteger (0, 0xfff)));
+    }
+  CheckLookup (Ipv4Address ("11.0.0.1"));
+  CheckLookup (Ipv4Address ("10.255.0.1"));
+
+  m_trie.Clear ();
+  NS_TEST_EXPECT_MSG_EQ (m_trie.GetNRoutes (), 0, "Routes left after Clear");
+  std::vector<Ipv4RoutingTableEntry *> found;
+  m_trie.Lookup (Ipv4Address ("10.0.0.1"), found);
+  NS_TEST_EXPECT_MSG_EQ (found.size (), 0, "Routes found after Clear");
+}
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief Check that the global routes do not depend on the number of
+ * threads running the SPF calculations.
+ */
+class Ipv4GlobalRoutingThreadsTestCase : public TestCase
+{
+public:
+  Ipv4GlobalRoutingThreadsTestCase ();
+  virtual ~Ipv4GlobalRoutingThreadsTestCase ();
+
+private:
+  virtual void DoRun (void);
+  /**
+   * \param nodes the nodes
+   * \returns the routing tables of the nodes
+   */
+  std::string GetRoutingTables (const NodeContainer &nodes);
+};
+
+Ipv4GlobalRoutingThreadsTestCase::Ipv4GlobalRoutingThreadsTestCase ()
+  : TestCase ("Global routes computed by several threads")
+{
+}
+
+Ipv4GlobalRoutingThreadsTestCase::~Ipv4GlobalRoutingThreadsTestCase ()
+{
+}
+
+std::string
+Ipv4GlobalRoutingThreadsTestCase::GetRoutingTables (const NodeContainer &nodes)
+{
+  std::ostringstream oss;
+  Ptr<OutputStreamWrapper> stream = Create<OutputStreamWrapper> (&oss);
+  for (NodeContainer::Iterator i = nodes.Begin (); i != nodes.End (); i++)
+    {
+      Ptr<Ipv4L3Protocol> ipv4 = (*i)->GetObject<Ipv4L3Protocol> ();
+      Ptr<Ipv4ListRouting> list = DynamicCast<Ipv4ListRouting> (ipv4->GetRoutingProtocol ());
+      int16_t priority;
+      for (uint32_t j = 0; j < list->GetNRoutingProtocols (); j++)
+        {
+          Ptr<Ipv4GlobalRouting> global = DynamicCast<Ipv4GlobalRouting> (list->GetRoutingProtocol (j, priority));
+          if (global)
+            {
+              oss << "Node " << (*i)->GetId () << std::endl;
+              global->PrintRoutingTable (stream);
+            }
+        }
+    }
+  return oss.str ();
+}
+
+void
+Ipv4GlobalRoutingThreadsTestCase::DoRun (void)
+{
+  // a 5x5 grid of routers, with plenty of equal cost paths, and a host
+  // on a stub link to each corner; the SPF calculation does not support
+  // equal cost paths through a LAN, hence the LAN is in a separate tree
+  const uint32_t side = 5;
+  NodeContainer routers;
+  routers.Create (side * side);
+  NodeContainer hosts;
+  hosts.Create (4);
+  NodeContainer tree;
+  tree.Create (4);
+  NodeContainer all (routers, hosts, tree);
+
+  InternetStackHelper internet;
+  internet.Install (all);
+
+  SimpleNetDeviceHelper devHelper;
+  devHelper.SetNetDevicePointToPointMode (true);
+  Ipv4AddressHelper ipv4;
+  ipv4.SetBase ("10.0.0.0", "255.255.255.252");
+  for (uint32_t row = 0; row < side; row++)
+    {
+      for (uint32_t col = 0; col < side; col++)
+        {
+          uint32_t n = row * side + col;
+          if (col + 1 < side)
+            {
+              ipv4.Assign (devHelper.Install (NodeContainer (routers.Get (n), routers.Get (n + 1))));
+              ipv4.NewNetwork ();
+            }
+          if (row + 1 < side)
+            {
+              ipv4.Assign (devHelper.Install (NodeContainer (routers.Get (n), routers.Get (n + side))));
+              ipv4.NewNetwork ();
+            }
+        }
+    }
+  uint32_t corners[4] = { 0, side - 1, side * (side - 1), side * side - 1 };
+  for (uint32_t i = 0; i < 4; i++)
+    {
+      ipv4.Assign (devHelper.Install (NodeContainer (routers.Get (corners[i]), hosts.Get (i))));
+      ipv4.NewNetwork ();
+    }
+  ipv4.Assign (devHelper.Install (NodeContainer (tree.Get (0), tree.Get (1))));
+  NodeContainer lan;
+  lan.Add (tree.Get (1));
+  lan.Add (tree.Get (2));
+  lan.Add (tree.Get (3));
+  devHelper.SetNetDevicePointToPointMode (false);
+  ipv4.SetBase ("192.168.1.0", "255.255.255.0");
+  ipv4.Assign (devHelper.Install (lan));
+
+  Config::SetGlobal ("GlobalRoutingThreads", UintegerValue (1));
+  Ipv4GlobalRoutingHelper::PopulateRoutingTables ();
+  std::string sequential = GetRoutingTables (all);
+
+  Config::SetGlobal ("GlobalRoutingThreads", UintegerValue (4));
+  Ipv4GlobalRoutingHelper::RecomputeRoutingTables ();
+  std::string threaded = GetRoutingTables (all);
+  Config::SetGlobal ("GlobalRoutingThreads", UintegerValue (1));
+
+  NS_TEST_EXPECT_MSG_GT (sequential.size (), 0, "No routing table printed");
+  NS_TEST_EXPECT_MSG_EQ (threaded, sequential, "The routes depend on the number of threads");
+
+  Simulator::Destroy ();
+}
+
 /**
  * \ingroup internet-test
  * \ingroup tests
@@ -1267,6 +1512,8 @@ Ipv4GlobalRoutingTestSuite::Ipv4GlobalRoutingTestSuite ()
     AddTestCase (new TwoBridgeTest, TestCase::QUICK);
     AddTestCase (new Ipv4DynamicGlobalRoutingTestCase, TestCase::QUICK);
     AddTestCase (new Ipv4GlobalRoutingSlash32TestCase, TestCase::QUICK);
+    AddTestCase (new Ipv4RouteTrieTestCase, TestCase::QUICK);
+    AddTestCase (new Ipv4GlobalRoutingThreadsTestCase, TestCase::QUICK);
   }
 
 static Ipv4GlobalRoutingTestSuite g_globalRoutingTestSuite; //!< Static variable for test initialization
@@ -28,6 +28,7 @@
 #include "ns3/names.h"
 #include "ns3/net-device.h"
 #include "ns3/pcap-file-wrapper.h"
+#include "ns3/pcapng-file.h"
 
 #include "trace-helper.h"
 
@@ -35,6 +36,16 @@ namespace ns3 {
 
 NS_LOG_COMPONENT_DEFINE ("TraceHelper");
 
+/**
+ * \returns the pcapng file enabled by PcapHelper::EnablePcapNg, if any
+ */
+static Ptr<PcapNgFile> &
+GetPcapNgFile (void)
+{
+  static Ptr<PcapNgFile> file;
+  return file;
+}
+
 PcapHelper::PcapHelper ()
 {
   NS_LOG_FUNCTION_NOARGS ();
@@ -56,7 +67,15 @@ PcapHelper::CreateFile (
   NS_LOG_FUNCTION (filename << filemode << dataLinkType << snapLen << tzCorrection);
 
   Ptr<PcapFileWrapper> file = CreateObject<PcapFileWrapper> ();
-  file->Open (filename, filemode);
+  Ptr<PcapNgFile> pcapNg = GetPcapNgFile ();
+  if (pcapNg && (filemode & std::ios::out))
+    {
+      file->Open (pcapNg, filename);
+    }
+  else
+    {
+      file->Open (filename, filemode);
+    }
   NS_ABORT_MSG_IF (file->Fail (), "Unable to Open " << filename << " for mode " << filemode);
 
   file->Init (dataLinkType, snapLen, tzCorrection);
@@ -76,6 +95,28 @@ PcapHelper::CreateFile (
   return file;
 }
 
+void
+PcapHelper::EnablePcapNg (std::string filename, uint32_t bufferSize, bool async)
+{
+  NS_LOG_FUNCTION (filename << bufferSize << async);
+  Ptr<PcapNgFile> file = Create<PcapNgFile> ();
+  file->Open (filename);
+  NS_ABORT_MSG_IF (file->Fail (), "Unable to Open " << filename);
+  file->SetBuffering (bufferSize, async);
+  GetPcapNgFile () = file;
+}
+
+void
+PcapHelper::DisablePcapNg (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  //
+  // The wrappers created in the meantime keep the file open as long as they
+  // are alive.
+  //
+  GetPcapNgFile () = 0;
+}
+
 std::string
 PcapHelper::GetFilenameFromDevice (std::string prefix, Ptr<NetDevice> device, bool useObjectNames)
 {
@@ -109,6 +109,29 @@ public:
                                    DataLinkType dataLinkType,
                                    uint32_t snapLen = std::numeric_limits<uint32_t>::max (),
                                    int32_t tzCorrection = 0);
+
+  /**
+   * @brief Multiplex the pcap traces created afterwards into a single pcapng file
+   *
+   * Until DisablePcapNg is called, CreateFile does not create a file for
+   * write modes, but adds an interface to the pcapng file, named after the
+   * file that would have been created.  Every pcap trace of every helper thus
+   * goes into a single file, whose packets of an interface are the ones of
+   * the pcap file it replaces (see PcapNgFile::ExtractInterface).  The file
+   * is complete once the objects writing traces are destroyed, at the latest
+   * by Simulator::Destroy, and DisablePcapNg is called.
+   *
+   * @param filename name of the pcapng file
+   * @param bufferSize size of the buffers gathering the packets before they
+   *        are written to the file, or zero to write every packet directly
+   * @param async if true, write the buffers from a background thread
+   */
+  static void EnablePcapNg (std::string filename, uint32_t bufferSize = 0, bool async = false);
+  /**
+   * @brief Go back to one pcap file per trace, and release the pcapng file
+   */
+  static void DisablePcapNg (void);
+
   /**
    * @brief Hook a trace source to the default trace sink
    * 
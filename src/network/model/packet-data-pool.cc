@@ -0,0 +1,454 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <atomic>
+#include <new>
+#include "ns3/assert.h"
+#include "ns3/log.h"
+#include "ns3/unused.h"
+#include "packet-data-pool.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("PacketDataPool");
+
+namespace {
+
+class PacketDataCache;
+
+/**
+ * \ingroup packet
+ * Header stored in front of every block allocated by PacketDataPool.
+ */
+struct BlockHeader
+{
+  PacketDataCache *cache;  //!< The cache owning the block, or 0 if the block comes from the global heap
+  uint32_t sizeClass;      //!< The size class of the block
+};
+
+/**
+ * \ingroup packet
+ * Size of the block header, rounded up so that the blocks keep the
+ * alignment provided by the global operator new.
+ */
+const uint32_t HEADER_SIZE = 16;
+
+/**
+ * \ingroup packet
+ * The free blocks of the size classes of a thread.
+ *
+ * Only the owning thread accesses the free lists and the counters; the
+ * other threads only push onto the lists of remote blocks.  Once the
+ * thread exits, the cache is orphaned: its free blocks are released, and
+ * the blocks freed afterwards go to the global operator delete.  A cache
+ * is never deleted, because its blocks may outlive the thread that owns it.
+ */
+class PacketDataCache
+{
+public:
+  /// Number of size classes
+  static const uint32_t N_SIZE_CLASSES = 11;
+
+  PacketDataCache ();
+
+  /**
+   * \param [in] size The size of the block, header included.
+   * \returns The size class of the block, or N_SIZE_CLASSES if too large.
+   */
+  static uint32_t GetSizeClass (uint32_t size);
+  /**
+   * \param [in] sizeClass The size class.
+   * \returns The size of the blocks of the size class, header included.
+   */
+  static uint32_t GetBlockSize (uint32_t sizeClass);
+
+  /**
+   * \param [in] sizeClass The size class.
+   * \returns A block of the given size class.
+   */
+  BlockHeader * Allocate (uint32_t sizeClass);
+  /**
+   * Count an allocation which does not fit in any size class.
+   */
+  void CountLargeAllocation (void);
+  /**
+   * Give a block back to the cache from the owning thread.
+   * \param [in] block The block.
+   */
+  void Free (BlockHeader *block);
+  /**
+   * Give a block back to the cache from a thread other than the owning thread.
+   * \param [in] block The block.
+   */
+  void FreeRemote (BlockHeader *block);
+  /**
+   * Release the free blocks, including the remote ones.
+   */
+  void Trim (void);
+  /**
+   * Release the free blocks and stop keeping the blocks freed afterwards,
+   * once the owning thread exits.
+   */
+  void Orphan (void);
+
+  /**
+   * \returns The statistics of the cache.
+   */
+  PacketDataPool::Statistics GetStatistics (void) const;
+  /**
+   * Reset the counters of allocations.
+   */
+  void ResetStatistics (void);
+
+private:
+  /** A free block. */
+  struct FreeBlock
+  {
+    FreeBlock *next;  //!< The next free block
+  };
+
+  /**
+   * Release a list of blocks.
+   * \param [in] list The first block of the list.
+   */
+  static void Release (FreeBlock *list);
+
+  FreeBlock *m_free[N_SIZE_CLASSES];                 //!< Blocks freed by the owning thread
+  uint32_t m_nFree[N_SIZE_CLASSES];                  //!< Number of blocks of the free lists
+  std::atomic<FreeBlock *> m_remote[N_SIZE_CLASSES]; //!< Blocks freed by other threads
+  std::atomic<bool> m_orphaned;                      //!< Whether the owning thread exited
+  uint64_t m_allocations;                            //!< Number of blocks allocated
+  uint64_t m_hits;                                   //!< Number of blocks taken from the free lists
+};
+
+PacketDataCache::PacketDataCache ()
+  : m_orphaned (false),
+    m_allocations (0),
+    m_hits (0)
+{
+  for (uint32_t i = 0; i < N_SIZE_CLASSES; i++)
+    {
+      m_free[i] = 0;
+      m_nFree[i] = 0;
+      m_remote[i].store (0, std::memory_order_relaxed);
+    }
+}
+
+uint32_t
+PacketDataCache::GetSizeClass (uint32_t size)
+{
+  uint32_t sizeClass = 0;
+  uint32_t blockSize = PacketDataPool::MIN_BLOCK_SIZE;
+  while (blockSize < size && sizeClass < N_SIZE_CLASSES)
+    {
+      blockSize <<= 1;
+      sizeClass++;
+    }
+  return sizeClass;
+}
+
+uint32_t
+PacketDataCache::GetBlockSize (uint32_t sizeClass)
+{
+  return PacketDataPool::MIN_BLOCK_SIZE << sizeClass;
+}
+
+BlockHeader *
+PacketDataCache::Allocate (uint32_t sizeClass)
+{
+  m_allocations++;
+  if (m_free[sizeClass] == 0)
+    {
+      FreeBlock *remote = m_remote[sizeClass].exchange (0, std::memory_order_acquire);
+      for (FreeBlock *block = remote; block != 0; block = block->next)
+        {
+          m_nFree[sizeClass]++;
+        }
+      m_free[sizeClass] = remote;
+    }
+  FreeBlock *block = m_free[sizeClass];
+  if (block == 0)
+    {
+      NS_LOG_LOGIC ("new block of " << GetBlockSize (sizeClass) << " bytes");
+      return static_cast<BlockHeader *> (::operator new (GetBlockSize (sizeClass)));
+    }
+  m_hits++;
+  m_free[sizeClass] = block->next;
+  m_nFree[sizeClass]--;
+  return reinterpret_cast<BlockHeader *> (block);
+}
+
+void
+PacketDataCache::CountLargeAllocation (void)
+{
+  m_allocations++;
+}
+
+void
+PacketDataCache::Free (BlockHeader *block)
+{
+  uint32_t sizeClass = block->sizeClass;
+  if ((m_nFree[sizeClass] + 1) * static_cast<uint64_t> (GetBlockSize (sizeClass))
+      > PacketDataPool::MAX_RETAINED_BYTES)
+    {
+      ::operator delete (block);
+      return;
+    }
+  FreeBlock *freeBlock = reinterpret_cast<FreeBlock *> (block);
+  freeBlock->next = m_free[sizeClass];
+  m_free[sizeClass] = freeBlock;
+  m_nFree[sizeClass]++;
+}
+
+void
+PacketDataCache::FreeRemote (BlockHeader *block)
+{
+  if (m_orphaned.load ())
+    {
+      ::operator delete (block);
+      return;
+    }
+  uint32_t sizeClass = block->sizeClass;
+  FreeBlock *freeBlock = reinterpret_cast<FreeBlock *> (block);
+  freeBlock->next = m_remote[sizeClass].load (std::memory_order_relaxed);
+  while (!m_remote[sizeClass].compare_exchange_weak (freeBlock->next, freeBlock))
+    {
+    }
+  // The owning thread may have exited in between, after releasing the
+  // remote blocks for the last time
+  if (m_orphaned.load ())
+    {
+      Release (m_remote[sizeClass].exchange (0));
+    }
+}
+
+void
+PacketDataCache::Release (FreeBlock *list)
+{
+  while (list != 0)
+    {
+      FreeBlock *next = list->next;
+      ::operator delete (list);
+      list = next;
+    }
+}
+
+void
+PacketDataCache::Trim (void)
+{
+  for (uint32_t i = 0; i < N_SIZE_CLASSES; i++)
+    {
+      Release (m_free[i]);
+      m_free[i] = 0;
+      m_nFree[i] = 0;
+      Release (m_remote[i].exchange (0));
+    }
+}
+
+void
+PacketDataCache::Orphan (void)
+{
+  m_orphaned.store (true);
+  Trim ();
+}
+
+PacketDataPool::Statistics
+PacketDataCache::GetStatistics (void) const
+{
+  PacketDataPool::Statistics stats;
+  stats.allocations = m_allocations;
+  stats.hits = m_hits;
+  stats.bytesRetained = 0;
+  for (uint32_t i = 0; i < N_SIZE_CLASSES; i++)
+    {
+      stats.bytesRetained += m_nFree[i] * static_cast<uint64_t> (GetBlockSize (i));
+    }
+  return stats;
+}
+
+void
+PacketDataCache::ResetStatistics (void)
+{
+  m_allocations = 0;
+  m_hits = 0;
+}
+
+/** Whether blocks are allocated from the caches. */
+bool g_poolEnabled = true;
+
+/** Value of the cache of a thread once the thread exited. */
+#define CACHE_DESTROYED ((PacketDataCache *) ~(uintptr_t) 0)
+
+/** The cache of the calling thread, created on first use. */
+thread_local PacketDataCache *t_cache = 0;
+
+/**
+ * \ingroup packet
+ * Orphans the cache of a thread when the thread exits.
+ */
+struct CacheDestructor
+{
+  ~CacheDestructor ()
+  {
+    if (t_cache != 0 && t_cache != CACHE_DESTROYED)
+      {
+        t_cache->Orphan ();
+      }
+    t_cache = CACHE_DESTROYED;
+  }
+};
+
+/** Orphans the cache of the calling thread when the thread exits. */
+thread_local CacheDestructor t_cacheDestructor;
+
+/**
+ * \param [in] create Whether to create the cache if the thread has none yet.
+ * \returns The cache of the calling thread, or 0 if there is none.
+ */
+PacketDataCache *
+GetCache (bool create)
+{
+  if (t_cache == CACHE_DESTROYED)
+    {
+      return 0;
+    }
+  if (t_cache == 0 && create)
+    {
+      // Register the destructor of the cache with the thread
+      NS_UNUSED (t_cacheDestructor);
+      t_cache = new PacketDataCache ();
+    }
+  return t_cache;
+}
+
+} // unnamed namespace
+
+double
+PacketDataPool::Statistics::GetHitRate (void) const
+{
+  return allocations == 0 ? 0 : static_cast<double> (hits) / allocations;
+}
+
+void *
+PacketDataPool::Allocate (uint32_t size, uint32_t &capacity)
+{
+  static_assert (sizeof (BlockHeader) <= HEADER_SIZE, "The block header does not fit");
+
+  PacketDataCache *cache = g_poolEnabled ? GetCache (true) : 0;
+  uint32_t sizeClass = PacketDataCache::GetSizeClass (size + HEADER_SIZE);
+  BlockHeader *header;
+
+  if (cache != 0 && sizeClass < PacketDataCache::N_SIZE_CLASSES)
+    {
+      header = cache->Allocate (sizeClass);
+      header->cache = cache;
+      capacity = PacketDataCache::GetBlockSize (sizeClass) - HEADER_SIZE;
+    }
+  else
+    {
+      if (cache != 0)
+        {
+          cache->CountLargeAllocation ();
+        }
+      header = static_cast<BlockHeader *> (::operator new (size + HEADER_SIZE));
+      header->cache = 0;
+      capacity = size;
+    }
+  header->sizeClass = sizeClass;
+  return reinterpret_cast<uint8_t *> (header) + HEADER_SIZE;
+}
+
+void
+PacketDataPool::Free (void *block)
+{
+  BlockHeader *header = reinterpret_cast<BlockHeader *> (static_cast<uint8_t *> (block) - HEADER_SIZE);
+  PacketDataCache *cache = header->cache;
+
+  if (cache == 0)
+    {
+      ::operator delete (header);
+    }
+  else if (cache == t_cache)
+    {
+      cache->Free (header);
+    }
+  else
+    {
+      cache->FreeRemote (header);
+    }
+}
+
+uint32_t
+PacketDataPool::GetMaxCapacity (void)
+{
+  return MAX_BLOCK_SIZE - HEADER_SIZE;
+}
+
+void
+PacketDataPool::EnablePool (bool enable)
+{
+  NS_LOG_FUNCTION (enable);
+  g_poolEnabled = enable;
+}
+
+void
+PacketDataPool::Trim (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  PacketDataCache *cache = GetCache (false);
+  if (cache != 0)
+    {
+      cache->Trim ();
+    }
+}
+
+PacketDataPool::Statistics
+PacketDataPool::GetStatistics (void)
+{
+  PacketDataCache *cache = GetCache (false);
+  if (cache != 0)
+    {
+      return cache->GetStatistics ();
+    }
+  Statistics stats;
+  stats.allocations = 0;
+  stats.hits = 0;
+  stats.bytesRetained = 0;
+  return stats;
+}
+
+void
+PacketDataPool::ResetStatistics (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  PacketDataCache *cache = GetCache (false);
+  if (cache != 0)
+    {
+      cache->ResetStatistics ();
+    }
+}
+
+std::ostream &
+operator << (std::ostream &os, const PacketDataPool::Statistics &stats)
+{
+  os << "allocations=" << stats.allocations
+     << " hits=" << stats.hits
+     << " hit-rate=" << stats.GetHitRate ()
+     << " bytes-retained=" << stats.bytesRetained;
+  return os;
+}
+
+} // namespace ns3
@@ -0,0 +1,117 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef PACKET_DATA_POOL_H
+#define PACKET_DATA_POOL_H
+
+#include <stdint.h>
+#include <ostream>
+
+namespace ns3 {
+
+/**
+ * \ingroup packet
+ *
+ * \brief Size-class allocator of the storage of Buffer and PacketMetadata
+ *
+ * The blocks come in size classes of powers of two, from MIN_BLOCK_SIZE to
+ * MAX_BLOCK_SIZE bytes, a small header included.  Each thread has its own
+ * cache, with a free list per size class: a block freed by the thread
+ * which allocated it goes back to its free list, and a block freed by
+ * another thread is pushed onto a lock-free list which the owning thread
+ * takes back when its free list is empty.  A free list keeps at most
+ * MAX_RETAINED_BYTES bytes; the blocks beyond, and the blocks larger than
+ * MAX_BLOCK_SIZE, are given back to the global operator delete.
+ *
+ * The cache of a thread releases its free blocks when the thread exits;
+ * the blocks still in use are then freed directly when they are released.
+ */
+class PacketDataPool
+{
+public:
+  static const uint32_t MIN_BLOCK_SIZE = 64;          //!< Size of the smallest blocks
+  static const uint32_t MAX_BLOCK_SIZE = 65536;       //!< Size of the largest pooled blocks
+  static const uint32_t MAX_RETAINED_BYTES = 4194304; //!< Maximum size of the free blocks of a size class
+
+  /// The statistics of the cache of a thread
+  struct Statistics
+  {
+    uint64_t allocations;    //!< The number of blocks allocated
+    uint64_t hits;           //!< The number of blocks taken from the cache
+    uint64_t bytesRetained;  //!< The size of the free blocks kept in the cache
+
+    /**
+     * \returns the fraction of the allocations served by the cache, or
+     *          zero if there was no allocation
+     */
+    double GetHitRate (void) const;
+  };
+
+  /**
+   * \brief Allocate a block
+   * \param size the minimum size of the block
+   * \param [out] capacity the usable size of the block, at least size
+   * \returns the block
+   */
+  static void *Allocate (uint32_t size, uint32_t &capacity);
+  /**
+   * \brief Free a block allocated by Allocate, from any thread
+   * \param block the block
+   */
+  static void Free (void *block);
+  /**
+   * \returns the usable size of the largest blocks allocated from the
+   *          size classes
+   */
+  static uint32_t GetMaxCapacity (void);
+
+  /**
+   * \brief Enable or disable the caches
+   *
+   * When disabled, the blocks allocated afterwards come from the global
+   * operator new and are given back to the global operator delete.  The
+   * caches are enabled by default.
+   *
+   * \param enable whether the blocks are allocated from the caches
+   */
+  static void EnablePool (bool enable);
+  /**
+   * \brief Give the free blocks of the cache of the calling thread back to
+   * the global operator delete
+   */
+  static void Trim (void);
+  /**
+   * \returns the statistics of the cache of the calling thread
+   */
+  static Statistics GetStatistics (void);
+  /**
+   * \brief Reset the counters of allocations of the cache of the calling thread
+   */
+  static void ResetStatistics (void);
+};
+
+/**
+ * \brief Stream insertion operator.
+ *
+ * \param os the stream
+ * \param stats the statistics
+ * \returns a reference to the stream
+ */
+std::ostream & operator << (std::ostream &os, const PacketDataPool::Statistics &stats);
+
+} // namespace ns3
+
+#endif /* PACKET_DATA_POOL_H */
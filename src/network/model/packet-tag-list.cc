@@ -29,11 +29,60 @@
 #include "ns3/fatal-error.h"
 #include "ns3/log.h"
 #include <cstring>
+#include <vector>
 
 namespace ns3 {
 
 NS_LOG_COMPONENT_DEFINE ("PacketTagList");
 
+/**
+ * \ingroup packet
+ * \brief Maximum serialized size of the tags whose TagData come from the pool
+ *
+ * The TagData of the pool are all allocated with this size, so that they
+ * can be reused for any of these tags.
+ */
+#define POOLED_TAG_SIZE 48
+
+/**
+ * \ingroup packet
+ * \brief Maximum number of TagData kept in the pool
+ */
+#define MAX_POOLED_TAGS 1000
+
+/**
+ * \ingroup packet
+ * \brief The pool of TagData, with the same three states as the free list
+ * of Buffer: not yet allocated, initialized, and destroyed at exit.
+ */
+typedef std::vector<PacketTagList::TagData *> TagDataPool;
+
+/// Value of the pool once it is destroyed
+#define POOL_DESTROYED ((TagDataPool *) 1)
+
+static TagDataPool *g_tagDataPool = 0;  //!< The pool of TagData
+
+/**
+ * \ingroup packet
+ * \brief Deletes the pool of TagData at exit
+ */
+static struct TagDataPoolDestructor
+{
+  ~TagDataPoolDestructor ()
+  {
+    if (g_tagDataPool != 0 && g_tagDataPool != POOL_DESTROYED)
+      {
+        for (TagDataPool::iterator i = g_tagDataPool->begin (); i != g_tagDataPool->end (); i++)
+          {
+            (*i)->~TagData ();
+            ::operator delete (*i);
+          }
+        delete g_tagDataPool;
+      }
+    g_tagDataPool = POOL_DESTROYED;
+  }
+} g_tagDataPoolDestructor;  //!< Deletes the pool of TagData at exit
+
 PacketTagList::TagData *
 PacketTagList::CreateTagData (size_t dataSize)
 {
@@ -43,14 +92,88 @@ PacketTagList::CreateTagData (size_t dataSize)
                  << " exceeds maximum "
                  << std::numeric_limits<decltype(TagData::size)>::max () );
 
-  void * p = std::malloc (sizeof (TagData) + dataSize - 1);
-  // The matching frees are in RemoveAll and RemoveWriter
-
-  TagData * tag = new (p) TagData;
+  TagData * tag;
+  if (dataSize <= POOLED_TAG_SIZE
+      && g_tagDataPool != 0 && g_tagDataPool != POOL_DESTROYED
+      && !g_tagDataPool->empty ())
+    {
+      tag = g_tagDataPool->back ();
+      g_tagDataPool->pop_back ();
+    }
+  else
+    {
+      size_t allocated = dataSize <= POOLED_TAG_SIZE ? POOLED_TAG_SIZE : dataSize;
+      void * p = ::operator new (sizeof (TagData) + allocated - 1);
+      // The matching delete is in FreeTagData
+      tag = new (p) TagData;
+    }
   tag->size = dataSize;
   return tag;
 }
 
+void
+PacketTagList::FreeTagData (TagData * tag)
+{
+  if (tag->size <= POOLED_TAG_SIZE && g_tagDataPool != POOL_DESTROYED)
+    {
+      if (g_tagDataPool == 0)
+        {
+          g_tagDataPool = new TagDataPool ();
+        }
+      if (g_tagDataPool->size () < MAX_POOLED_TAGS)
+        {
+          g_tagDataPool->push_back (tag);
+          return;
+        }
+    }
+  tag->~TagData ();
+  ::operator delete (tag);
+}
+
+uint32_t
+PacketTagList::GetMaskBit (TypeId tid)
+{
+  return 1U << (tid.GetUid () & 31);
+}
+
+uint32_t
+PacketTagList::FindInline (TypeId tid) const
+{
+  for (uint32_t i = 0; i < m_nInline; i++)
+    {
+      if (m_inline[i].tid == tid)
+        {
+          return i;
+        }
+    }
+  return INLINE_TAGS;
+}
+
+void
+PacketTagList::RemoveInline (uint32_t index)
+{
+  NS_ASSERT (index < m_nInline);
+  for (uint32_t i = index + 1; i < m_nInline; i++)
+    {
+      m_inline[i - 1] = m_inline[i];
+    }
+  m_nInline--;
+}
+
+void
+PacketTagList::UpdateMask (void)
+{
+  m_mask = 0;
+  for (uint32_t i = 0; i < m_nInline; i++)
+    {
+      m_mask |= GetMaskBit (m_inline[i].tid);
+    }
+  for (struct TagData *cur = m_next; cur != 0; cur = cur->next)
+    {
+      m_mask |= GetMaskBit (cur->tid);
+    }
+}
+
 bool
 PacketTagList::COWTraverse (Tag & tag, PacketTagList::COWWriter Writer)
 {
@@ -175,7 +298,29 @@ PacketTagList::COWTraverse (Tag & tag, PacketTagList::COWWriter Writer)
 bool
 PacketTagList::Remove (Tag & tag)
 {
-  return COWTraverse (tag, &PacketTagList::RemoveWriter);
+  TypeId tid = tag.GetInstanceTypeId ();
+  if ((m_mask & GetMaskBit (tid)) == 0)
+    {
+      return false;
+    }
+  bool found;
+  uint32_t index = FindInline (tid);
+  if (index < INLINE_TAGS)
+    {
+      struct InlineTag &cur = m_inline[index];
+      tag.Deserialize (TagBuffer (cur.data, cur.data + cur.size));
+      RemoveInline (index);
+      found = true;
+    }
+  else
+    {
+      found = COWTraverse (tag, &PacketTagList::RemoveWriter);
+    }
+  if (found)
+    {
+      UpdateMask ();
+    }
+  return found;
 }
 
 // COWWriter implementing Remove
@@ -194,8 +339,7 @@ PacketTagList::RemoveWriter (Tag & tag, bool preMerge,
   if (preMerge)
     {
       // found tid before first merge, so delete cur
-      cur->~TagData ();
-      std::free (cur);
+      FreeTagData (cur);
     }
   else
     {
@@ -214,12 +358,35 @@ PacketTagList::RemoveWriter (Tag & tag, bool preMerge,
 bool
 PacketTagList::Replace (Tag & tag)
 {
-  bool found = COWTraverse (tag, &PacketTagList::ReplaceWriter);
-  if (!found)
+  TypeId tid = tag.GetInstanceTypeId ();
+  if ((m_mask & GetMaskBit (tid)) != 0)
     {
-      Add (tag);
+      uint32_t index = FindInline (tid);
+      if (index < INLINE_TAGS)
+        {
+          uint32_t size = tag.GetSerializedSize ();
+          if (size <= INLINE_TAG_SIZE)
+            {
+              struct InlineTag &cur = m_inline[index];
+              cur.size = size;
+              tag.Serialize (TagBuffer (cur.data, cur.data + cur.size));
+            }
+          else
+            {
+              // the new value does not fit inline any more
+              RemoveInline (index);
+              UpdateMask ();
+              Add (tag);
+            }
+          return true;
+        }
+      if (COWTraverse (tag, &PacketTagList::ReplaceWriter))
+        {
+          return true;
+        }
     }
-  return found;
+  Add (tag);
+  return false;
 }
 
 // COWWriter implementing Replace
@@ -259,28 +426,64 @@ PacketTagList::ReplaceWriter (Tag & tag, bool preMerge,
 void 
 PacketTagList::Add (const Tag &tag) const
 {
-  NS_LOG_FUNCTION (this << tag.GetInstanceTypeId ());
+  TypeId tid = tag.GetInstanceTypeId ();
+  NS_LOG_FUNCTION (this << tid);
+  uint32_t bit = GetMaskBit (tid);
+  PacketTagList *self = const_cast<PacketTagList *> (this);
   // ensure this id was not yet added
-  for (struct TagData *cur = m_next; cur != 0; cur = cur->next) 
+  if ((m_mask & bit) != 0)
     {
-      NS_ASSERT_MSG (cur->tid != tag.GetInstanceTypeId (),
+      NS_ASSERT_MSG (FindInline (tid) == INLINE_TAGS,
                      "Error: cannot add the same kind of tag twice.");
+      for (struct TagData *cur = m_next; cur != 0; cur = cur->next) 
+        {
+          NS_ASSERT_MSG (cur->tid != tid,
+                         "Error: cannot add the same kind of tag twice.");
+        }
+    }
+  self->m_mask |= bit;
+
+  uint32_t size = tag.GetSerializedSize ();
+  if (m_next == 0 && m_nInline < INLINE_TAGS && size <= INLINE_TAG_SIZE)
+    {
+      struct InlineTag &cur = self->m_inline[self->m_nInline++];
+      cur.tid = tid;
+      cur.size = size;
+      tag.Serialize (TagBuffer (cur.data, cur.data + cur.size));
+      return;
     }
-  struct TagData * head = CreateTagData (tag.GetSerializedSize ());
+
+  struct TagData * head = CreateTagData (size);
   head->count = 1;
   head->next = 0;
-  head->tid = tag.GetInstanceTypeId ();
+  head->tid = tid;
   head->next = m_next;
   tag.Serialize (TagBuffer (head->data, head->data + head->size));
 
-  const_cast<PacketTagList *> (this)->m_next = head;
+  self->m_next = head;
 }
 
 bool
 PacketTagList::Peek (Tag &tag) const
 {
-  NS_LOG_FUNCTION (this << tag.GetInstanceTypeId ());
   TypeId tid = tag.GetInstanceTypeId ();
+  NS_LOG_FUNCTION (this << tid);
+  if ((m_mask & GetMaskBit (tid)) == 0)
+    {
+      /* no tag found */
+      return false;
+    }
+  for (uint32_t i = 0; i < m_nInline; i++)
+    {
+      if (m_inline[i].tid == tid)
+        {
+          /* found tag */
+          const struct InlineTag &cur = m_inline[i];
+          tag.Deserialize (TagBuffer (const_cast<uint8_t *> (cur.data),
+                                      const_cast<uint8_t *> (cur.data) + cur.size));
+          return true;
+        }
+    }
   for (struct TagData *cur = m_next; cur != 0; cur = cur->next) 
     {
       if (cur->tid == tid) 
@@ -300,5 +503,17 @@ PacketTagList::Head (void) const
   return m_next;
 }
 
+const struct PacketTagList::InlineTag *
+PacketTagList::GetInlineTags (void) const
+{
+  return m_inline;
+}
+
+uint32_t
+PacketTagList::GetNInlineTags (void) const
+{
+  return m_nInline;
+}
+
 } /* namespace ns3 */
 
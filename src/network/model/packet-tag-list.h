@@ -119,6 +119,23 @@ class Tag;
  *       The portion of the list between the first branch and the target is
  *       shared. This portion is copied before the #Remove or #Replace is
  *       performed.
+ *
+ * \par <b> Inline tags </b>
+ *
+ *   - The tree above only holds the tags which do not fit in the
+ *     PacketTagList itself.  The first #INLINE_TAGS tags of a packet whose
+ *     serialized size is at most #INLINE_TAG_SIZE are stored in an array
+ *     of InlineTag, in the order they were added, and copied along with
+ *     the PacketTagList.  Once a tag goes to the tree, the tags added
+ *     afterwards go there too, as long as the tree is not empty, so that
+ *     the tree always holds the most recent tags.
+ *
+ *   - The TagData structures are taken from a pool, and given back to it
+ *     when they are deleted.
+ *
+ *   - A 32-bit mask summarizes the TypeId's of all the tags of the packet,
+ *     one bit per TypeId uid modulo 32, so that looking for a tag the
+ *     packet does not hold usually takes constant time.
  */
 class PacketTagList 
 {
@@ -147,6 +164,23 @@ public:
     uint8_t data[1];            /**< Serialization buffer */
   };  /* struct TagData */
 
+  /// Maximum number of tags stored in the PacketTagList itself
+  static const uint32_t INLINE_TAGS = 4;
+  /// Maximum serialized size of a tag stored in the PacketTagList itself
+  static const uint32_t INLINE_TAG_SIZE = 21;
+
+  /**
+   * A tag stored in the PacketTagList itself.
+   *
+   * Public for the same reason as TagData.
+   */
+  struct InlineTag
+  {
+    TypeId tid;                       /**< Type of the tag serialized into #data */
+    uint8_t size;                     /**< Size of the serialized tag */
+    uint8_t data[INLINE_TAG_SIZE];    /**< Serialization buffer */
+  };  /* struct InlineTag */
+
   /**
    * Create a new PacketTagList.
    */
@@ -214,9 +248,17 @@ public:
    */
   inline void RemoveAll (void);
   /**
-   * \returns pointer to head of tag list
+   * \returns pointer to head of the list of the tags which are not inline
    */
   const struct PacketTagList::TagData *Head (void) const;
+  /**
+   * \returns the tags stored inline, the most recent last
+   */
+  const struct PacketTagList::InlineTag *GetInlineTags (void) const;
+  /**
+   * \returns the number of tags stored inline
+   */
+  uint32_t GetNInlineTags (void) const;
 
 private:
   /**
@@ -228,6 +270,36 @@ private:
    */
   static
   TagData * CreateTagData (size_t dataSize);
+  /**
+   * Destroy a TagData struct, giving it back to the pool if possible.
+   *
+   * \param [in] tag The TagData object.
+   */
+  static
+  void FreeTagData (TagData * tag);
+  /**
+   * \param [in] tid A tag type.
+   * \returns The bit of the tag type in #m_mask.
+   */
+  static
+  uint32_t GetMaskBit (TypeId tid);
+  /**
+   * Find a tag among the inline tags.
+   *
+   * \param [in] tid The tag type.
+   * \returns The index of the tag, or #INLINE_TAGS if not found.
+   */
+  uint32_t FindInline (TypeId tid) const;
+  /**
+   * Remove an inline tag, keeping the order of the other ones.
+   *
+   * \param [in] index The index of the tag.
+   */
+  void RemoveInline (uint32_t index);
+  /**
+   * Recompute #m_mask from the tags of the list.
+   */
+  void UpdateMask (void);
   
   /**
    * Typedef of method function pointer for copy-on-write operations
@@ -282,6 +354,18 @@ private:
    * Pointer to first \ref TagData on the list
    */
   struct TagData *m_next;
+  /**
+   * The tags stored inline, the most recent last
+   */
+  struct InlineTag m_inline[INLINE_TAGS];
+  /**
+   * Number of tags stored inline
+   */
+  uint8_t m_nInline;
+  /**
+   * The bits (see GetMaskBit) of the types of all the tags
+   */
+  uint32_t m_mask;
 };
 
 } // namespace ns3
@@ -293,13 +377,21 @@ private:
 namespace ns3 {
 
 PacketTagList::PacketTagList ()
-  : m_next ()
+  : m_next (),
+    m_nInline (0),
+    m_mask (0)
 {
 }
 
 PacketTagList::PacketTagList (PacketTagList const &o)
-  : m_next (o.m_next)
+  : m_next (o.m_next),
+    m_nInline (o.m_nInline),
+    m_mask (o.m_mask)
 {
+  for (uint32_t i = 0; i < m_nInline; i++)
+    {
+      m_inline[i] = o.m_inline[i];
+    }
   if (m_next != 0)
     {
       m_next->count++;
@@ -310,16 +402,25 @@ PacketTagList &
 PacketTagList::operator = (PacketTagList const &o)
 {
   // self assignment
-  if (m_next == o.m_next) 
+  if (this == &o)
     {
       return *this;
     }
-  RemoveAll ();
-  m_next = o.m_next;
-  if (m_next != 0) 
+  if (m_next != o.m_next)
     {
-      m_next->count++;
+      RemoveAll ();
+      m_next = o.m_next;
+      if (m_next != 0)
+        {
+          m_next->count++;
+        }
+    }
+  for (uint32_t i = 0; i < o.m_nInline; i++)
+    {
+      m_inline[i] = o.m_inline[i];
     }
+  m_nInline = o.m_nInline;
+  m_mask = o.m_mask;
   return *this;
 }
 
@@ -331,6 +432,8 @@ PacketTagList::~PacketTagList ()
 void
 PacketTagList::RemoveAll (void)
 {
+  m_nInline = 0;
+  m_mask = 0;
   struct TagData *prev = 0;
   for (struct TagData *cur = m_next; cur != 0; cur = cur->next)
     {
@@ -341,15 +444,13 @@ PacketTagList::RemoveAll (void)
         }
       if (prev != 0) 
         {
-          prev->~TagData ();
-          std::free (prev);
+          FreeTagData (prev);
         }
       prev = cur;
     }
   if (prev != 0) 
     {
-      prev->~TagData ();
-      std::free (prev);
+      FreeTagData (prev);
     }
   m_next = 0;
 }
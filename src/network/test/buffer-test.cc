@@ -22,6 +22,12 @@
 #include "ns3/random-variable-stream.h"
 #include "ns3/double.h"
 #include "ns3/test.h"
+#include "ns3/packet-data-pool.h"
+#include "ns3/core-config.h"
+#ifdef HAVE_PTHREAD_H
+#include "ns3/system-thread.h"
+#include "ns3/callback.h"
+#endif
 
 using namespace ns3;
 
@@ -378,6 +384,145 @@ BufferTest::DoRun (void)
   NS_TEST_ASSERT_MSG_EQ (val1, val2, "Bad ReadNtohU16()");
 }
 
+/**
+ * \ingroup network-test
+ * \ingroup tests
+ *
+ * PacketDataPool unit tests.
+ */
+class PacketDataPoolTest : public TestCase {
+public:
+  virtual void DoRun (void);
+  PacketDataPoolTest ();
+private:
+  /**
+   * Free a block, from another thread
+   * \param block The block
+   */
+  static void FreeBlock (void *block);
+  /**
+   * Allocate a block and free it, from another thread
+   */
+  void AllocateAndFree (void);
+};
+
+PacketDataPoolTest::PacketDataPoolTest ()
+  : TestCase ("PacketDataPool")
+{
+}
+
+void
+PacketDataPoolTest::FreeBlock (void *block)
+{
+  PacketDataPool::Free (block);
+}
+
+void
+PacketDataPoolTest::AllocateAndFree (void)
+{
+  uint32_t capacity;
+  void *block = PacketDataPool::Allocate (1000, capacity);
+  PacketDataPool::Free (block);
+}
+
+void
+PacketDataPoolTest::DoRun (void)
+{
+  PacketDataPool::Trim ();
+  PacketDataPool::ResetStatistics ();
+
+  uint32_t capacity;
+  uint8_t *block = static_cast<uint8_t *> (PacketDataPool::Allocate (100, capacity));
+  NS_TEST_ASSERT_MSG_GT_OR_EQ (capacity, 100, "block too small");
+  NS_TEST_ASSERT_MSG_LT (capacity, PacketDataPool::MIN_BLOCK_SIZE * 2, "block too large");
+  for (uint32_t i = 0; i < capacity; i++)
+    {
+      block[i] = i;
+    }
+  PacketDataPool::Free (block);
+  PacketDataPool::Statistics stats = PacketDataPool::GetStatistics ();
+  NS_TEST_EXPECT_MSG_EQ (stats.allocations, 1, "allocations");
+  NS_TEST_EXPECT_MSG_EQ (stats.hits, 0, "first allocation");
+  NS_TEST_EXPECT_MSG_EQ (stats.bytesRetained, PacketDataPool::MIN_BLOCK_SIZE * 2, "free block kept");
+
+  uint32_t capacity2;
+  uint8_t *block2 = static_cast<uint8_t *> (PacketDataPool::Allocate (80, capacity2));
+  NS_TEST_EXPECT_MSG_EQ (static_cast<void *> (block2), static_cast<void *> (block), "free block reused");
+  NS_TEST_EXPECT_MSG_EQ (capacity2, capacity, "same size class");
+  stats = PacketDataPool::GetStatistics ();
+  NS_TEST_EXPECT_MSG_EQ (stats.hits, 1, "second allocation");
+  NS_TEST_EXPECT_MSG_EQ (stats.GetHitRate (), 0.5, "hit rate");
+  NS_TEST_EXPECT_MSG_EQ (stats.bytesRetained, 0, "free block taken");
+
+  // blocks larger than the size classes come from the global heap
+  uint8_t *large = static_cast<uint8_t *> (PacketDataPool::Allocate (PacketDataPool::MAX_BLOCK_SIZE, capacity));
+  NS_TEST_EXPECT_MSG_EQ (capacity, PacketDataPool::MAX_BLOCK_SIZE, "large block");
+  large[capacity - 1] = 1;
+  PacketDataPool::Free (large);
+  PacketDataPool::Free (block2);
+  stats = PacketDataPool::GetStatistics ();
+  NS_TEST_EXPECT_MSG_EQ (stats.allocations, 3, "allocations");
+  NS_TEST_EXPECT_MSG_EQ (stats.bytesRetained, PacketDataPool::MIN_BLOCK_SIZE * 2, "large block not kept");
+
+  // the free lists are bounded
+  std::vector<void *> blocks;
+  for (uint32_t i = 0; i < 100; i++)
+    {
+      blocks.push_back (PacketDataPool::Allocate (PacketDataPool::MAX_BLOCK_SIZE / 2, capacity));
+    }
+  for (uint32_t i = 0; i < blocks.size (); i++)
+    {
+      PacketDataPool::Free (blocks[i]);
+    }
+  stats = PacketDataPool::GetStatistics ();
+  NS_TEST_EXPECT_MSG_EQ (stats.bytesRetained,
+                         PacketDataPool::MIN_BLOCK_SIZE * 2 + PacketDataPool::MAX_RETAINED_BYTES,
+                         "free list bounded");
+  PacketDataPool::Trim ();
+  NS_TEST_EXPECT_MSG_EQ (PacketDataPool::GetStatistics ().bytesRetained, 0, "trim");
+
+  // buffers and metadata come from the pool
+  PacketDataPool::ResetStatistics ();
+  for (uint32_t i = 0; i < 10; i++)
+    {
+      Buffer buffer;
+      buffer.AddAtStart (100);
+      buffer.Begin ().WriteU8 (1, 100);
+    }
+  stats = PacketDataPool::GetStatistics ();
+  NS_TEST_EXPECT_MSG_GT_OR_EQ (stats.allocations, 10, "buffer allocations");
+  NS_TEST_EXPECT_MSG_GT_OR_EQ (stats.hits, 9, "buffer allocations from the pool");
+
+  // disabled pool
+  PacketDataPool::EnablePool (false);
+  PacketDataPool::ResetStatistics ();
+  block = static_cast<uint8_t *> (PacketDataPool::Allocate (100, capacity));
+  NS_TEST_EXPECT_MSG_EQ (capacity, 100, "block from the global heap");
+  PacketDataPool::EnablePool (true);
+  PacketDataPool::Free (block);
+  NS_TEST_EXPECT_MSG_EQ (PacketDataPool::GetStatistics ().allocations, 0, "disabled pool");
+
+#ifdef HAVE_PTHREAD_H
+  // a block freed by another thread goes back to the cache of its thread
+  PacketDataPool::Trim ();
+  PacketDataPool::ResetStatistics ();
+  block = static_cast<uint8_t *> (PacketDataPool::Allocate (1000, capacity));
+  Ptr<SystemThread> thread = Create<SystemThread> (MakeBoundCallback (&PacketDataPoolTest::FreeBlock, static_cast<void *> (block)));
+  thread->Start ();
+  thread->Join ();
+  NS_TEST_EXPECT_MSG_EQ (PacketDataPool::GetStatistics ().bytesRetained, 0, "remote block not counted yet");
+  block2 = static_cast<uint8_t *> (PacketDataPool::Allocate (1000, capacity));
+  NS_TEST_EXPECT_MSG_EQ (static_cast<void *> (block2), static_cast<void *> (block), "remote block reused");
+  NS_TEST_EXPECT_MSG_EQ (PacketDataPool::GetStatistics ().hits, 1, "remote block reused");
+
+  // the cache of a thread is released when the thread exits
+  thread = Create<SystemThread> (MakeCallback (&PacketDataPoolTest::AllocateAndFree, this));
+  thread->Start ();
+  thread->Join ();
+  PacketDataPool::Free (block2);
+#endif
+}
+
 /**
  * \ingroup network-test
  * \ingroup tests
@@ -394,6 +539,7 @@ BufferTestSuite::BufferTestSuite ()
   : TestSuite ("buffer", UNIT)
 {
   AddTestCase (new BufferTest, TestCase::QUICK);
+  AddTestCase (new PacketDataPoolTest, TestCase::QUICK);
 }
 
 static BufferTestSuite g_bufferTestSuite; //!< Static variable for test initialization
@@ -0,0 +1,162 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2017 NITK Surathkal
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/drop-from-queue.h"
+#include "ns3/uinteger.h"
+
+using namespace ns3;
+
+/**
+ * \ingroup network-test
+ * \ingroup tests
+ *
+ * DropFromQueue unit tests.
+ */
+class DropFromQueueTestCase : public TestCase
+{
+public:
+  DropFromQueueTestCase ();
+  virtual void DoRun (void);
+};
+
+DropFromQueueTestCase::DropFromQueueTestCase ()
+  : TestCase ("Sanity check on the drop from queue implementation")
+{
+}
+void
+DropFromQueueTestCase::DoRun (void)
+{
+  Ptr<DropFromQueue<Packet> > queue = CreateObject<DropFromQueue<Packet> > ();
+  NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("MaxPackets", UintegerValue (40)), true,
+                         "Verify that we can actually set the attribute");
+
+  std::vector<Ptr<Packet> > p;
+  for (uint32_t i = 0; i < 40; i++)
+    {
+      p.push_back (Create<Packet> ());
+      queue->Enqueue (p[i]);
+    }
+  NS_TEST_EXPECT_MSG_EQ (queue->GetNPackets (), 40, "There should be 40 packets in there");
+  NS_TEST_EXPECT_MSG_EQ (queue->Enqueue (Create<Packet> ()), false, "The queue should be full");
+  NS_TEST_EXPECT_MSG_EQ (queue->GetNSlots (), 40, "There should be no holes in the queue");
+  NS_TEST_EXPECT_MSG_EQ (queue->PeekAt (7)->GetUid (), p[7]->GetUid (), "Was this the eighth packet ?");
+
+  // remove packets from the middle of the queue
+  Ptr<Packet> packet = queue->RemoveFrom (7);
+  NS_TEST_EXPECT_MSG_EQ (packet->GetUid (), p[7]->GetUid (), "Was this the eighth packet ?");
+  NS_TEST_EXPECT_MSG_EQ (queue->GetNPackets (), 39, "There should be 39 packets in there");
+  NS_TEST_EXPECT_MSG_EQ (queue->GetNSlots (), 40, "The slot of the eighth packet should be a hole");
+  NS_TEST_EXPECT_MSG_EQ ((queue->PeekAt (7) == 0), true, "The slot of the eighth packet should be a hole");
+  NS_TEST_EXPECT_MSG_EQ ((queue->RemoveFrom (7) == 0), true, "Nothing can be removed from a hole");
+  NS_TEST_EXPECT_MSG_EQ (queue->PeekAt (8)->GetUid (), p[8]->GetUid (), "Was this the ninth packet ?");
+  queue->RemoveFrom (8);
+
+  // removing the tail discards the holes preceding it
+  queue->RemoveFrom (38);
+  queue->RemoveFrom (39);
+  NS_TEST_EXPECT_MSG_EQ (queue->GetNPackets (), 36, "There should be 36 packets in there");
+  NS_TEST_EXPECT_MSG_EQ (queue->GetNSlots (), 38, "Two holes should be left");
+  NS_TEST_EXPECT_MSG_EQ (queue->PeekAt (37)->GetUid (), p[37]->GetUid (), "Was this the tail packet ?");
+
+  // dequeueing the packets preceding a hole discards the hole
+  for (uint32_t i = 0; i < 7; i++)
+    {
+      packet = queue->Dequeue ();
+      NS_TEST_EXPECT_MSG_EQ (packet->GetUid (), p[i]->GetUid (), "Packets should be dequeued in order");
+    }
+  NS_TEST_EXPECT_MSG_EQ (queue->GetNSlots (), 29, "No hole should be left");
+  NS_TEST_EXPECT_MSG_EQ (queue->Peek ()->GetUid (), p[9]->GetUid (), "Was this the tenth packet ?");
+
+  // positions do not change across consecutive RemoveFrom calls
+  for (uint32_t i = 1; i < 28; i += 2)
+    {
+      packet = queue->RemoveFrom (i);
+      NS_TEST_EXPECT_MSG_EQ (packet->GetUid (), p[9 + i]->GetUid (), "Was this the right packet ?");
+    }
+  NS_TEST_EXPECT_MSG_EQ (queue->GetNPackets (), 15, "There should be 15 packets in there");
+  NS_TEST_EXPECT_MSG_EQ (queue->GetNSlots (), 29, "Holes should be left in the middle of the queue");
+  queue->Squeeze ();
+  NS_TEST_EXPECT_MSG_EQ (queue->GetNSlots (), 29, "The holes do not outnumber the packets yet");
+
+  // insert a packet in the second position
+  Ptr<Packet> inserted = Create<Packet> ();
+  NS_TEST_EXPECT_MSG_EQ (queue->EnqueueAt (1, inserted), true, "The packet should be enqueued");
+  NS_TEST_EXPECT_MSG_EQ (queue->GetNSlots (), queue->GetNPackets (), "No hole should be left");
+
+  uint32_t expected[] = { 9, 0, 11, 13, 15, 17, 19, 21, 23, 25, 27, 29, 31, 33, 35, 37 };
+  for (uint32_t i = 0; i < 16; i++)
+    {
+      packet = queue->Dequeue ();
+      uint64_t uid = (i == 1 ? inserted->GetUid () : p[expected[i]]->GetUid ());
+      NS_TEST_EXPECT_MSG_EQ (packet->GetUid (), uid, "Packets should be dequeued in order");
+    }
+  NS_TEST_EXPECT_MSG_EQ (queue->GetNPackets (), 0, "There should be no packets in there");
+  NS_TEST_EXPECT_MSG_EQ (queue->GetNSlots (), 0, "There should be no slots in there");
+  NS_TEST_EXPECT_MSG_EQ ((queue->Dequeue () == 0), true, "There are really no packets in there");
+
+  // the statistics account for the packets removed from the middle as dequeued
+  NS_TEST_EXPECT_MSG_EQ (queue->GetTotalReceivedPackets (), 41, "41 packets should have been received");
+  NS_TEST_EXPECT_MSG_EQ (queue->GetTotalDroppedPackets (), 1, "One packet should have been dropped");
+
+  // holes left by RemoveFrom calls alone are squeezed out by Squeeze
+  for (uint32_t i = 0; i < 10; i++)
+    {
+      queue->Enqueue (p[i]);
+    }
+  for (uint32_t i = 1; i < 9; i++)
+    {
+      queue->RemoveFrom (i);
+    }
+  NS_TEST_EXPECT_MSG_EQ (queue->GetNSlots (), 10, "Holes should be left in the middle of the queue");
+  queue->Squeeze ();
+  NS_TEST_EXPECT_MSG_EQ (queue->GetNSlots (), 2, "The holes outnumbered the packets and should be squeezed out");
+  NS_TEST_EXPECT_MSG_EQ (queue->PeekAt (1)->GetUid (), p[9]->GetUid (), "Was this the tenth packet ?");
+
+  // a full slot array with a few holes is doubled rather than compacted
+  queue = CreateObject<DropFromQueue<Packet> > ();
+  queue->SetAttribute ("MaxPackets", UintegerValue (32));
+  for (uint32_t i = 0; i < 32; i++)
+    {
+      queue->Enqueue (p[i]);
+    }
+  queue->RemoveFrom (5);
+  NS_TEST_EXPECT_MSG_EQ (queue->GetNSlots (), 32, "The slot array should be full");
+  NS_TEST_EXPECT_MSG_EQ (queue->Enqueue (p[32]), true, "The queue should not be full");
+  NS_TEST_EXPECT_MSG_EQ (queue->GetNSlots (), 33, "The hole should be kept when the slot array is full");
+  NS_TEST_EXPECT_MSG_EQ (queue->PeekAt (6)->GetUid (), p[6]->GetUid (), "The positions should not change");
+  NS_TEST_EXPECT_MSG_EQ (queue->PeekAt (32)->GetUid (), p[32]->GetUid (), "Was this the tail packet ?");
+}
+
+/**
+ * \ingroup network-test
+ * \ingroup tests
+ *
+ * \brief DropFrom Queue TestSuite
+ */
+class DropFromQueueTestSuite : public TestSuite
+{
+public:
+  DropFromQueueTestSuite ()
+    : TestSuite ("drop-from-queue", UNIT)
+  {
+    AddTestCase (new DropFromQueueTestCase (), TestCase::QUICK);
+  }
+};
+
+static DropFromQueueTestSuite g_dropFromQueueTestSuite; //!< Static variable for test initialization
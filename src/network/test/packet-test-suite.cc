@@ -27,6 +27,8 @@
 #include <iostream>
 #include <iomanip>
 #include <ctime>
+#include <vector>
+#include <algorithm>
 
 using namespace ns3;
 
@@ -1035,6 +1037,142 @@ PacketTagListTest::DoRun (void)
     
 }
 
+/**
+ * \ingroup network-test
+ * \ingroup tests
+ *
+ * Packet Tag list storage tests: tags stored inline and in the tree.
+ */
+class PacketTagListStorageTest : public TestCase
+{
+public:
+  PacketTagListStorageTest ();
+private:
+  void DoRun (void);
+  /**
+   * Checks the tags of a packet, in the order of the tag iterator
+   * \param p The packet
+   * \param expected The types of the expected tags, most recent first
+   * \param msg Message
+   */
+  void CheckOrder (Ptr<const Packet> p, const std::vector<TypeId> &expected,
+                   const char * msg);
+  /**
+   * Checks that a packet holds a tag with the value of a reference tag
+   * \param p The packet
+   * \param t The reference tag
+   * \param msg Message
+   */
+  void CheckTag (Ptr<const Packet> p, ATestTagBase & t, const char * msg);
+};
+
+PacketTagListStorageTest::PacketTagListStorageTest ()
+  : TestCase ("PacketTagListStorageTest: ")
+{
+}
+
+void
+PacketTagListStorageTest::CheckOrder (Ptr<const Packet> p,
+                                      const std::vector<TypeId> &expected,
+                                      const char * msg)
+{
+  std::vector<TypeId> found;
+  PacketTagIterator i = p->GetPacketTagIterator ();
+  while (i.HasNext ())
+    {
+      found.push_back (i.Next ().GetTypeId ());
+    }
+  NS_TEST_EXPECT_MSG_EQ (found.size (), expected.size (), msg << ": number of tags");
+  for (uint32_t j = 0; j < std::min (found.size (), expected.size ()); ++j)
+    {
+      NS_TEST_EXPECT_MSG_EQ (found[j], expected[j], msg << ": tag " << j);
+    }
+}
+
+void
+PacketTagListStorageTest::CheckTag (Ptr<const Packet> p, ATestTagBase & t,
+                                    const char * msg)
+{
+  int expect = t.GetData ();
+  NS_TEST_EXPECT_MSG_EQ (p->PeekPacketTag (t), true,
+                         msg << ": contains " << t.GetTypeId ().GetName ());
+  NS_TEST_EXPECT_MSG_EQ (t.GetData (), expect,
+                         msg << ": " << t.GetTypeId ().GetName () << " = " << expect);
+}
+
+void
+PacketTagListStorageTest::DoRun (void)
+{
+  MAKE_TEST_TAGS ;
+  ALargeTestTag large;
+
+  Ptr<Packet> p = Create<Packet> (10);
+  p->AddPacketTag (t1);
+  p->AddPacketTag (t2);
+  p->AddPacketTag (large);  // too large to be inline
+  p->AddPacketTag (t3);     // in the tree, after the large tag
+  std::vector<TypeId> expected;
+  expected.push_back (t3.GetTypeId ());
+  expected.push_back (large.GetTypeId ());
+  expected.push_back (t2.GetTypeId ());
+  expected.push_back (t1.GetTypeId ());
+  CheckOrder (p, expected, "inline and tree");
+
+  ALargeTestTag peeked;
+  NS_TEST_EXPECT_MSG_EQ (p->PeekPacketTag (peeked), true, "large tag");
+  NS_TEST_EXPECT_MSG_EQ (peeked.GetSerializedSize (), LARGE_TAG_BUFFER_SIZE, "large tag size");
+
+  // Once the tree is empty, the tags are inline again
+  p->RemovePacketTag (t3);
+  p->RemovePacketTag (large);
+  p->AddPacketTag (t4);
+  expected.clear ();
+  expected.push_back (t4.GetTypeId ());
+  expected.push_back (t2.GetTypeId ());
+  expected.push_back (t1.GetTypeId ());
+  CheckOrder (p, expected, "inline only");
+
+  // Copies do not share the changes of the inline tags
+  Ptr<Packet> c = p->Copy ();
+  c->RemovePacketTag (t2);
+  ATestTag<4> t4b (9);
+  c->ReplacePacketTag (t4b);
+  CheckTag (p, t2, "copy, removed from the copy");
+  CheckTag (p, t4, "copy, replaced in the copy");
+  CheckTag (c, t4b, "copy, replaced value");
+  ATestTag<2> t2b (1);
+  NS_TEST_EXPECT_MSG_EQ (c->PeekPacketTag (t2b), false, "copy, removed tag");
+
+  // More tags than the inline ones
+  Ptr<Packet> q = Create<Packet> (10);
+  q->AddPacketTag (t1);
+  q->AddPacketTag (t2);
+  q->AddPacketTag (t3);
+  q->AddPacketTag (t4);
+  q->AddPacketTag (t5);
+  q->AddPacketTag (t6);
+  q->AddPacketTag (t7);
+  Ptr<Packet> r = q->Copy ();
+  r->RemovePacketTag (t1);
+  r->RemovePacketTag (t7);
+  expected.clear ();
+  expected.push_back (t6.GetTypeId ());
+  expected.push_back (t5.GetTypeId ());
+  expected.push_back (t4.GetTypeId ());
+  expected.push_back (t3.GetTypeId ());
+  expected.push_back (t2.GetTypeId ());
+  CheckOrder (r, expected, "copy of a long list");
+  CheckTag (q, t1, "long list, removed from the copy");
+  CheckTag (q, t7, "long list, removed from the copy");
+
+  ATestTag<10> t10;
+  NS_TEST_EXPECT_MSG_EQ (q->PeekPacketTag (t10), false, "missing tag");
+  NS_TEST_EXPECT_MSG_EQ (q->RemovePacketTag (t10), false, "missing tag");
+  q->RemoveAllPacketTags ();
+  CheckOrder (q, std::vector<TypeId> (), "no tags");
+  NS_TEST_EXPECT_MSG_EQ (q->PeekPacketTag (t1), false, "no tags");
+}
+
 /**
  * \ingroup network-test
  * \ingroup tests
@@ -1052,6 +1190,7 @@ PacketTestSuite::PacketTestSuite ()
 {
   AddTestCase (new PacketTest, TestCase::QUICK);
   AddTestCase (new PacketTagListTest, TestCase::QUICK);
+  AddTestCase (new PacketTagListStorageTest, TestCase::QUICK);
 }
 
 static PacketTestSuite g_packetTestSuite; //!< Static variable for test initialization
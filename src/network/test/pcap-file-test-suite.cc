@@ -20,11 +20,19 @@
 #include <cstdio>
 #include <cstdlib>
 #include <sstream>
+#include <fstream>
 #include <cstring>
 
 #include "ns3/log.h"
 #include "ns3/test.h"
 #include "ns3/pcap-file.h"
+#include "ns3/pcapng-file.h"
+#include "ns3/pcap-file-wrapper.h"
+#include "ns3/trace-helper.h"
+#include "ns3/packet.h"
+#include "ns3/ethernet-header.h"
+#include "ns3/uinteger.h"
+#include "ns3/boolean.h"
 
 using namespace ns3;
 
@@ -77,6 +85,15 @@ CheckFileLength (std::string filename, uint64_t sizeExpected)
   return sizeActual == sizeExpected;
 }
 
+static std::string
+ReadFileContents (std::string filename)
+{
+  std::ifstream f (filename.c_str (), std::ios::in | std::ios::binary);
+  std::ostringstream contents;
+  contents << f.rdbuf ();
+  return contents.str ();
+}
+
 /**
  * \ingroup network-test
  * \ingroup tests
@@ -1144,6 +1161,280 @@ DiffTestCase::DoRun (void)
   NS_TEST_EXPECT_MSG_EQ (usec, 3696, "Files are different from 2.3696 seconds");
 }
 
+/**
+ * \ingroup network-test
+ * \ingroup tests
+ *
+ * \brief Test case to make sure that the buffered writes of a pcap file
+ * store the same bytes as the direct ones.
+ */
+class BufferedWriteTestCase : public TestCase
+{
+public:
+  BufferedWriteTestCase ();
+
+private:
+  virtual void DoRun (void);
+  /**
+   * \brief Write records of various sizes and kinds to a pcap file
+   * \param filename the name of the file
+   * \param bufferSize the size of the buffers, or zero
+   * \param async whether the buffers are written by the background thread
+   */
+  void WriteRecords (std::string filename, uint32_t bufferSize, bool async);
+};
+
+BufferedWriteTestCase::BufferedWriteTestCase ()
+  : TestCase ("Check that the buffered writes produce the same file as the direct ones")
+{
+}
+
+void
+BufferedWriteTestCase::WriteRecords (std::string filename, uint32_t bufferSize, bool async)
+{
+  PcapFile f;
+  f.Open (filename, std::ios::out);
+  NS_TEST_ASSERT_MSG_EQ (f.Fail (), false, "Open (" << filename << ", \"std::ios::out\") returns error");
+  f.Init (1, 128);
+  f.SetBuffering (bufferSize, async);
+
+  uint8_t data[300];
+  for (uint32_t i = 0; i < 300; ++i)
+    {
+      data[i] = i;
+    }
+  for (uint32_t i = 0; i < 1000; ++i)
+    {
+      uint32_t size = (i * 37) % 300;
+      uint32_t tsSec = i / 10;
+      uint32_t tsUsec = (i % 10) * 100000;
+      switch (i % 3)
+        {
+        case 0:
+          f.Write (tsSec, tsUsec, data, size);
+          break;
+        case 1:
+          f.Write (tsSec, tsUsec, Create<Packet> (data, size));
+          break;
+        default:
+          {
+            EthernetHeader header;
+            header.SetLengthType (i);
+            f.Write (tsSec, tsUsec, header, Create<Packet> (data, size));
+          }
+        }
+    }
+  NS_TEST_EXPECT_MSG_EQ (f.Fail (), false, "Write must not fail");
+  f.Close ();
+}
+
+void
+BufferedWriteTestCase::DoRun (void)
+{
+  std::string reference = CreateTempDirFilename ("direct.pcap");
+  WriteRecords (reference, 0, false);
+  std::string expected = ReadFileContents (reference);
+
+  // Buffers smaller than a record, of a few records and of all the records
+  uint32_t bufferSizes[] = { 100, 100, 4096, 4096, 1000000 };
+  bool async[] = { false, true, false, true, true };
+  for (uint32_t i = 0; i < 5; ++i)
+    {
+      std::stringstream filename;
+      filename << "buffered-" << i << ".pcap";
+      std::string buffered = CreateTempDirFilename (filename.str ());
+      WriteRecords (buffered, bufferSizes[i], async[i]);
+
+      NS_TEST_EXPECT_MSG_EQ ((ReadFileContents (buffered) == expected), true,
+                             "Buffers of " << bufferSizes[i] << " bytes, async " << async[i] << ": different bytes");
+      uint32_t sec (0), usec (0), packets (0);
+      bool diff = PcapFile::Diff (reference, buffered, sec, usec, packets);
+      NS_TEST_EXPECT_MSG_EQ (diff, false, "Buffers of " << bufferSizes[i] << " bytes, async " << async[i] << ": different packets");
+      NS_TEST_EXPECT_MSG_EQ (packets, 1000, "Unexpected number of packets");
+      remove (buffered.c_str ());
+    }
+  remove (reference.c_str ());
+}
+
+/**
+ * \ingroup network-test
+ * \ingroup tests
+ *
+ * \brief Test case to make sure that the interfaces of a pcapng file hold
+ * the packets of the pcap files they replace.
+ */
+class PcapNgTestCase : public TestCase
+{
+public:
+  PcapNgTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+PcapNgTestCase::PcapNgTestCase ()
+  : TestCase ("Check that the interfaces extracted from a pcapng file are the pcap files")
+{
+}
+
+void
+PcapNgTestCase::DoRun (void)
+{
+  std::string ngFilename = CreateTempDirFilename ("multiplexed.pcapng");
+  PcapNgFile ng;
+  ng.Open (ngFilename);
+  NS_TEST_ASSERT_MSG_EQ (ng.Fail (), false, "Open (" << ngFilename << ") returns error");
+  ng.SetBuffering (1024, true);
+
+  const uint32_t nInterfaces = 4;
+  std::string names[nInterfaces] = { "eth0", "ppp0", "wifi0", "lo" };
+  uint32_t dataLinkTypes[nInterfaces] = { 1, 9, 105, 0 };
+  uint32_t snapLens[nInterfaces] = { 65535, 61, 65535, 65535 };
+  bool nanosecModes[nInterfaces] = { false, false, true, false };
+  PcapFile pcaps[nInterfaces];
+  std::string pcapFilenames[nInterfaces];
+  for (uint32_t k = 0; k < nInterfaces; ++k)
+    {
+      pcapFilenames[k] = CreateTempDirFilename (names[k] + ".pcap");
+      pcaps[k].Open (pcapFilenames[k], std::ios::out);
+      pcaps[k].Init (dataLinkTypes[k], snapLens[k], 0, false, nanosecModes[k]);
+      uint32_t id = ng.AddInterface (names[k], dataLinkTypes[k], snapLens[k], nanosecModes[k]);
+      NS_TEST_EXPECT_MSG_EQ (id, k, "Unexpected interface identifier");
+    }
+  NS_TEST_EXPECT_MSG_EQ (ng.GetNInterfaces (), nInterfaces, "Unexpected number of interfaces");
+
+  // Interleave the packets of the first three interfaces
+  uint8_t data[200];
+  for (uint32_t i = 0; i < 200; ++i)
+    {
+      data[i] = 255 - i;
+    }
+  for (uint32_t i = 0; i < 600; ++i)
+    {
+      uint32_t k = (i * 7) % 3;
+      uint32_t size = (i * 13) % 200;
+      uint32_t tsSec = 1000 + i;
+      uint32_t tsFrac = nanosecModes[k] ? i * 1000003 : i * 1009;
+      if (i % 2)
+        {
+          pcaps[k].Write (tsSec, tsFrac, data, size);
+          ng.Write (k, tsSec, tsFrac, data, size);
+        }
+      else
+        {
+          Ptr<Packet> p = Create<Packet> (data, size);
+          EthernetHeader header;
+          pcaps[k].Write (tsSec, tsFrac, header, p);
+          ng.Write (k, tsSec, tsFrac, header, p);
+        }
+    }
+  NS_TEST_EXPECT_MSG_EQ (ng.Fail (), false, "Write must not fail");
+  ng.Close ();
+
+  for (uint32_t k = 0; k < nInterfaces; ++k)
+    {
+      pcaps[k].Close ();
+      std::string extracted = CreateTempDirFilename (names[k] + "-extracted.pcap");
+      bool ok = PcapNgFile::ExtractInterface (ngFilename, names[k], extracted);
+      NS_TEST_ASSERT_MSG_EQ (ok, true, "Interface " << names[k] << " not extracted");
+      NS_TEST_EXPECT_MSG_EQ ((ReadFileContents (extracted) == ReadFileContents (pcapFilenames[k])), true,
+                             "Interface " << names[k] << ": different bytes");
+      uint32_t sec (0), usec (0), packets (0);
+      bool diff = PcapFile::Diff (pcapFilenames[k], extracted, sec, usec, packets);
+      NS_TEST_EXPECT_MSG_EQ (diff, false, "Interface " << names[k] << ": different packets");
+      remove (extracted.c_str ());
+      remove (pcapFilenames[k].c_str ());
+    }
+
+  std::string extracted = CreateTempDirFilename ("unknown.pcap");
+  bool ok = PcapNgFile::ExtractInterface (ngFilename, "unknown", extracted);
+  NS_TEST_EXPECT_MSG_EQ (ok, false, "No interface must be extracted");
+  remove (ngFilename.c_str ());
+}
+
+/**
+ * \ingroup network-test
+ * \ingroup tests
+ *
+ * \brief Test case to make sure that PcapHelper multiplexes the pcap
+ * traces into a pcapng file, and that the buffered wrappers write the
+ * same pcap files.
+ */
+class PcapHelperPcapNgTestCase : public TestCase
+{
+public:
+  PcapHelperPcapNgTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+PcapHelperPcapNgTestCase::PcapHelperPcapNgTestCase ()
+  : TestCase ("Check that PcapHelper writes the pcap traces to a pcapng file")
+{
+}
+
+void
+PcapHelperPcapNgTestCase::DoRun (void)
+{
+  std::string ngFilename = CreateTempDirFilename ("helper.pcapng");
+  std::string filenameA = CreateTempDirFilename ("helper-0-0.pcap");
+  std::string filenameB = CreateTempDirFilename ("helper-1-0.pcap");
+  PcapHelper helper;
+
+  PcapHelper::EnablePcapNg (ngFilename, 512, true);
+  Ptr<PcapFileWrapper> ngA = helper.CreateFile (filenameA, std::ios::out, PcapHelper::DLT_PPP);
+  Ptr<PcapFileWrapper> ngB = helper.CreateFile (filenameB, std::ios::out, PcapHelper::DLT_EN10MB, 100);
+  PcapHelper::DisablePcapNg ();
+  NS_TEST_EXPECT_MSG_EQ (CheckFileExists (filenameA), false, "No pcap file must be created for a pcapng interface");
+
+  Ptr<PcapFileWrapper> pcapA = helper.CreateFile (filenameA, std::ios::out, PcapHelper::DLT_PPP);
+  Ptr<PcapFileWrapper> pcapB = CreateObjectWithAttributes<PcapFileWrapper> ("BufferSize", UintegerValue (256),
+                                                                            "AsyncWrite", BooleanValue (true));
+  pcapB->Open (filenameB, std::ios::out);
+  pcapB->Init (PcapHelper::DLT_EN10MB, 100);
+
+  uint8_t data[150];
+  std::memset (data, 0x5a, sizeof (data));
+  for (uint32_t i = 0; i < 300; ++i)
+    {
+      Time t = MicroSeconds (i * 12345);
+      Ptr<Packet> p = Create<Packet> (data, i % 150);
+      if (i % 2)
+        {
+          ngA->Write (t, p);
+          pcapA->Write (t, p);
+        }
+      else
+        {
+          ngB->Write (t, p);
+          pcapB->Write (t, p);
+        }
+    }
+  // The last wrappers using the pcapng file close it
+  ngA = 0;
+  ngB = 0;
+  pcapA->Close ();
+  pcapB->Close ();
+
+  std::string filenames[2] = { filenameA, filenameB };
+  for (uint32_t k = 0; k < 2; ++k)
+    {
+      std::string extracted = CreateTempDirFilename ("helper-extracted.pcap");
+      bool ok = PcapNgFile::ExtractInterface (ngFilename, filenames[k], extracted);
+      NS_TEST_ASSERT_MSG_EQ (ok, true, "Interface " << filenames[k] << " not extracted");
+      uint32_t sec (0), usec (0), packets (0);
+      bool diff = PcapFile::Diff (filenames[k], extracted, sec, usec, packets);
+      NS_TEST_EXPECT_MSG_EQ (diff, false, "Interface " << filenames[k] << ": different packets");
+      NS_TEST_EXPECT_MSG_EQ (packets, 150, "Unexpected number of packets");
+      NS_TEST_EXPECT_MSG_EQ ((ReadFileContents (extracted) == ReadFileContents (filenames[k])), true,
+                             "Interface " << filenames[k] << ": different bytes");
+      remove (extracted.c_str ());
+      remove (filenames[k].c_str ());
+    }
+  remove (ngFilename.c_str ());
+}
+
 /**
  * \ingroup network-test
  * \ingroup tests
@@ -1167,6 +1458,9 @@ PcapFileTestSuite::PcapFileTestSuite ()
   AddTestCase (new RecordHeaderTestCase, TestCase::QUICK);
   AddTestCase (new ReadFileTestCase, TestCase::QUICK);
   AddTestCase (new DiffTestCase, TestCase::QUICK);
+  AddTestCase (new BufferedWriteTestCase, TestCase::QUICK);
+  AddTestCase (new PcapNgTestCase, TestCase::QUICK);
+  AddTestCase (new PcapHelperPcapNgTestCase, TestCase::QUICK);
 }
 
 static PcapFileTestSuite pcapFileTestSuite; //!< Static variable for test initialization
@@ -24,6 +24,7 @@
 #define DROPFROM_H
 
 #include "ns3/queue.h"
+#include <vector>
 
 namespace ns3 {
 
@@ -31,6 +32,26 @@ namespace ns3 {
  * \ingroup queue
  *
  * \brief A FIFO packet queue that drops packets from a position in queue
+ *
+ * Items are stored in a circular array of slots, so that the item at a given
+ * position can be accessed in constant time. Removing an item from the middle
+ * of the queue (RemoveFrom) leaves a hole in its slot instead of shifting the
+ * following items; holes at the head or at the tail are discarded right away,
+ * while holes in the middle are squeezed out by the next Enqueue, Dequeue,
+ * Remove or Squeeze once they outnumber the stored items. When the slot array
+ * is full, it is compacted only if at least half of its slots are holes, and
+ * doubled otherwise, so that a few holes do not make every Enqueue pay a
+ * linear pass. Hence, RemoveFrom has an amortized constant cost and the
+ * position of the items that are not removed does not change across
+ * consecutive RemoveFrom calls at positions greater than zero; removing the
+ * head (position 0) is a Dequeue, which shifts all the positions. Users which
+ * only remove items from the middle of the queue, without enqueueing or
+ * dequeueing, call Squeeze between their rounds of RemoveFrom calls, so that
+ * the holes stay fewer than the items.
+ *
+ * Positions used by PeekAt and RemoveFrom are slot positions relative to the
+ * head of the queue, ranging from 0 to GetNSlots () - 1. When no hole is
+ * present, the position of an item matches its rank in the queue.
  */
 template <typename Item>
 class DropFromQueue : public Queue<Item>
@@ -52,16 +73,70 @@ public:
   virtual Ptr<Item> Dequeue (void);
   virtual Ptr<Item> Remove (void);
   virtual Ptr<const Item> Peek (void) const;
-  Ptr<Item> RemoveFrom (uint32_t);
-  bool EnqueueAt (uint32_t,Ptr<Item> item);
+
+  /**
+   * \return the number of slots between the head and the tail of the queue,
+   * i.e., the number of stored items plus the number of holes
+   */
+  uint32_t GetNSlots (void) const;
+  /**
+   * Get the item stored in the given slot without removing it
+   * \param pos the slot position, relative to the head of the queue
+   * \return 0 if the slot is a hole; the item otherwise.
+   */
+  Ptr<const Item> PeekAt (uint32_t pos) const;
+  /**
+   * Extract the item stored in the given slot, counting it as dequeued
+   * \param pos the slot position, relative to the head of the queue
+   * \return 0 if the slot is a hole; the item otherwise.
+   */
+  Ptr<Item> RemoveFrom (uint32_t pos);
+  /**
+   * Insert an item so that it is stored at the given rank in the queue. The
+   * following items are shifted, hence the cost is linear in the queue size.
+   * \param pos the rank of the inserted item (0 for the head)
+   * \param item the item to enqueue
+   * \return true if success, false if the packet has been dropped.
+   */
+  bool EnqueueAt (uint32_t pos, Ptr<Item> item);
+  /**
+   * Squeeze out the holes if they outnumber the stored items. The positions
+   * of the items change if so.
+   */
+  void Squeeze (void);
 
 private:
-  using Queue<Item>::Head;
-  using Queue<Item>::Tail;
-  using Queue<Item>::DoEnqueue;
-  using Queue<Item>::DoDequeue;
-  using Queue<Item>::DoRemove;
-  using Queue<Item>::DoPeek;
+  using Queue<Item>::NotifyEnqueue;
+  using Queue<Item>::NotifyDequeue;
+  using Queue<Item>::NotifyRemove;
+
+  /**
+   * \param pos a slot position relative to the head of the queue
+   * \return the index in m_slots of the given slot
+   */
+  uint32_t Index (uint32_t pos) const;
+  /**
+   * Extract the item at the head of the queue, discard the holes that
+   * follow it and squeeze out the other holes if they outnumber the items
+   * \return the item at the head of the queue
+   */
+  Ptr<Item> PopHead (void);
+  /**
+   * Make room for one more slot at the tail, by squeezing out the holes if
+   * they fill at least half of the slot array, or by doubling its size
+   */
+  void Grow (void);
+  /**
+   * Move the stored items towards the head so that no hole is left
+   */
+  void Compact (void);
+
+  std::vector<Ptr<Item> > m_slots;  //!< circular array of slots (size is a power of two)
+  uint32_t m_head;                  //!< index in m_slots of the head slot
+  uint32_t m_nSlots;                //!< number of slots between head and tail
+  uint32_t m_nHoles;                //!< number of holes between head and tail
+
+  NS_LOG_TEMPLATE_DECLARE;     //!< redefinition of the log component
 };
 
 
@@ -83,35 +158,58 @@ DropFromQueue<Item>::GetTypeId (void)
 
 template <typename Item>
 DropFromQueue<Item>::DropFromQueue ()
-  : Queue<Item> ()
+  : Queue<Item> (),
+    m_head (0),
+    m_nSlots (0),
+    m_nHoles (0),
+    NS_LOG_TEMPLATE_DEFINE ("DropFromQueue")
 {
-  QUEUE_LOG (LOG_LOGIC, "DropFromQueue(" << this << ")");
+  NS_LOG_FUNCTION (this);
 }
 
 template <typename Item>
 DropFromQueue<Item>::~DropFromQueue ()
 {
-  QUEUE_LOG (LOG_LOGIC, "~DropFromQueue(" << this << ")");
+  NS_LOG_FUNCTION (this);
 }
 
 template <typename Item>
 bool
 DropFromQueue<Item>::Enqueue (Ptr<Item> item)
 {
-  QUEUE_LOG (LOG_LOGIC, "DropFromQueue:Enqueue(" << this << ", " << item << ")");
+  NS_LOG_FUNCTION (this << item);
+
+  if (!NotifyEnqueue (item))
+    {
+      return false;
+    }
 
-  return DoEnqueue (Tail (), item);
+  Squeeze ();
+  if (m_nSlots == m_slots.size ())
+    {
+      Grow ();
+    }
+  m_slots[Index (m_nSlots)] = item;
+  m_nSlots++;
+  return true;
 }
 
 template <typename Item>
 Ptr<Item>
 DropFromQueue<Item>::Dequeue (void)
 {
-  QUEUE_LOG (LOG_LOGIC, "DropFromQueue:Dequeue(" << this << ")");
+  NS_LOG_FUNCTION (this);
 
-  Ptr<Item> item = DoDequeue (Head ());
+  if (m_nSlots == 0)
+    {
+      NS_LOG_LOGIC ("Queue empty");
+      return 0;
+    }
+
+  Ptr<Item> item = PopHead ();
+  NotifyDequeue (item);
 
-  QUEUE_LOG (LOG_LOGIC, "Popped " << item);
+  NS_LOG_LOGIC ("Popped " << item);
 
   return item;
 }
@@ -120,11 +218,18 @@ template <typename Item>
 Ptr<Item>
 DropFromQueue<Item>::Remove (void)
 {
-  QUEUE_LOG (LOG_LOGIC, "DropFromQueue:Remove(" << this << ")");
+  NS_LOG_FUNCTION (this);
 
-  Ptr<Item> item = DoRemove (Head ());
+  if (m_nSlots == 0)
+    {
+      NS_LOG_LOGIC ("Queue empty");
+      return 0;
+    }
+
+  Ptr<Item> item = PopHead ();
+  NotifyRemove (item);
 
-  QUEUE_LOG (LOG_LOGIC, "Removed " << item);
+  NS_LOG_LOGIC ("Removed " << item);
 
   return item;
 }
@@ -133,45 +238,195 @@ template <typename Item>
 Ptr<const Item>
 DropFromQueue<Item>::Peek (void) const
 {
-  QUEUE_LOG (LOG_LOGIC, "DropFromQueue:Peek(" << this << ")");
+  NS_LOG_FUNCTION (this);
+
+  if (m_nSlots == 0)
+    {
+      NS_LOG_LOGIC ("Queue empty");
+      return 0;
+    }
+
+  return m_slots[m_head];
+}
+
+template <typename Item>
+uint32_t
+DropFromQueue<Item>::GetNSlots (void) const
+{
+  return m_nSlots;
+}
 
-  return DoPeek (Head ());
+template <typename Item>
+Ptr<const Item>
+DropFromQueue<Item>::PeekAt (uint32_t pos) const
+{
+  NS_LOG_FUNCTION (this << pos);
+
+  NS_ASSERT_MSG (pos < m_nSlots, "Position " << pos << " is beyond the tail of the queue");
+  return m_slots[Index (pos)];
 }
 
 template <typename Item>
 Ptr<Item>
 DropFromQueue<Item>::RemoveFrom (uint32_t pos)
 {
-  QUEUE_LOG (LOG_LOGIC, "DropFromQueue:RemoveFrom(" << this << ")");
+  NS_LOG_FUNCTION (this << pos);
+
+  NS_ASSERT_MSG (pos < m_nSlots, "Position " << pos << " is beyond the tail of the queue");
+
+  if (pos == 0)
+    {
+      return Dequeue ();
+    }
 
-  auto ptr = Head ();
-  for (uint32_t i = 0; i < pos; i++)
+  Ptr<Item> item = m_slots[Index (pos)];
+  if (item == 0)
     {
-      ptr++;
+      NS_LOG_LOGIC ("Slot " << pos << " is a hole");
+      return 0;
     }
-  Ptr<Item> item = DoDequeue (ptr);
+  m_slots[Index (pos)] = 0;
 
-  QUEUE_LOG (LOG_LOGIC, "Removed " << item);
+  if (pos == m_nSlots - 1)
+    {
+      // discard the holes preceding the old tail
+      m_nSlots--;
+      while (m_slots[Index (m_nSlots - 1)] == 0)
+        {
+          m_nSlots--;
+          m_nHoles--;
+        }
+    }
+  else
+    {
+      m_nHoles++;
+    }
+
+  NotifyDequeue (item);
+
+  NS_LOG_LOGIC ("Removed " << item);
 
   return item;
 }
 
+template <typename Item>
+bool
+DropFromQueue<Item>::EnqueueAt (uint32_t pos, Ptr<Item> item)
+{
+  NS_LOG_FUNCTION (this << pos);
+
+  if (!NotifyEnqueue (item))
+    {
+      return false;
+    }
 
+  Compact ();
+  if (m_nSlots == m_slots.size ())
+    {
+      Grow ();
+    }
 
+  if (pos > m_nSlots)
+    {
+      pos = m_nSlots;
+    }
+  for (uint32_t i = m_nSlots; i > pos; i--)
+    {
+      m_slots[Index (i)] = m_slots[Index (i - 1)];
+    }
+  m_slots[Index (pos)] = item;
+  m_nSlots++;
+  return true;
+}
 
 template <typename Item>
-bool
-DropFromQueue<Item>::EnqueueAt (uint32_t pos,Ptr<Item> item)
+void
+DropFromQueue<Item>::Squeeze (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  if (2 * m_nHoles > m_nSlots)
+    {
+      Compact ();
+    }
+}
+
+template <typename Item>
+uint32_t
+DropFromQueue<Item>::Index (uint32_t pos) const
+{
+  return (m_head + pos) & (m_slots.size () - 1);
+}
+
+template <typename Item>
+Ptr<Item>
+DropFromQueue<Item>::PopHead (void)
+{
+  Ptr<Item> item = m_slots[m_head];
+  NS_ASSERT (item != 0);
+  m_slots[m_head] = 0;
+  m_head = Index (1);
+  m_nSlots--;
+
+  // discard the holes following the old head
+  while (m_nSlots > 0 && m_slots[m_head] == 0)
+    {
+      m_head = Index (1);
+      m_nSlots--;
+      m_nHoles--;
+    }
+
+  if (2 * m_nHoles > m_nSlots)
+    {
+      Compact ();
+    }
+  return item;
+}
+
+template <typename Item>
+void
+DropFromQueue<Item>::Grow (void)
 {
-  QUEUE_LOG (LOG_LOGIC, "DropFromQueue:EnqueueAt(" << this << ")");
+  if (m_nHoles > 0 && 2 * m_nHoles >= m_slots.size ())
+    {
+      Compact ();
+      return;
+    }
 
-  auto ptr = Head ();
-  for (uint32_t i = 1; i < pos; i++)
+  // the holes are copied along with the items, so that positions are kept
+  std::vector<Ptr<Item> > slots (m_slots.empty () ? 16 : 2 * m_slots.size ());
+  for (uint32_t i = 0; i < m_nSlots; i++)
     {
-      ptr++;
+      slots[i] = m_slots[Index (i)];
     }
-  return DoEnqueue (ptr, item);
+  m_slots.swap (slots);
+  m_head = 0;
+}
 
+template <typename Item>
+void
+DropFromQueue<Item>::Compact (void)
+{
+  if (m_nHoles == 0)
+    {
+      return;
+    }
+
+  uint32_t n = 0;
+  for (uint32_t i = 0; i < m_nSlots; i++)
+    {
+      if (m_slots[Index (i)] != 0)
+        {
+          if (i != n)
+            {
+              m_slots[Index (n)] = m_slots[Index (i)];
+              m_slots[Index (i)] = 0;
+            }
+          n++;
+        }
+    }
+  m_nSlots = n;
+  m_nHoles = 0;
 }
 
 } // namespace ns3
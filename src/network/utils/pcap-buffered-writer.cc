@@ -0,0 +1,315 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <cstring>
+#include <deque>
+
+#include "ns3/assert.h"
+#include "ns3/log.h"
+#include "ns3/core-config.h"
+#ifdef HAVE_PTHREAD_H
+#include "ns3/ptr.h"
+#include "ns3/callback.h"
+#include "ns3/system-thread.h"
+#include <mutex>
+#include <condition_variable>
+#endif
+#include "pcap-buffered-writer.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("PcapBufferedWriter");
+
+#ifdef HAVE_PTHREAD_H
+
+/**
+ * \brief The background thread writing the buffers of the asynchronous
+ * PcapBufferedWriter objects
+ *
+ * The thread runs as long as there is at least one asynchronous writer.
+ * Its mutex protects the queue of buffers and the members of the writers
+ * shared with the thread, and the conditions are waited for with this
+ * mutex held, hence an idle thread or writer sleeps until it is notified.
+ */
+class PcapWriterThread
+{
+public:
+  /// \returns the thread, which is never destroyed
+  static PcapWriterThread *Get (void);
+
+  /// \brief Register an asynchronous writer, starting the thread if needed
+  void Acquire (void);
+  /// \brief Unregister an asynchronous writer, stopping the thread if it was the last one
+  void Release (void);
+  /**
+   * \brief Queue the current buffer of a writer
+   * \param writer the writer
+   */
+  void Submit (PcapBufferedWriter *writer);
+  /**
+   * \brief Wait until few enough buffers of a writer are queued
+   * \param writer the writer
+   * \param maxPending the maximum number of queued buffers
+   */
+  void Wait (PcapBufferedWriter *writer, uint32_t maxPending);
+
+private:
+  PcapWriterThread ();
+
+  /// \brief The body of the thread
+  void Run (void);
+
+  /// A buffer waiting to be written
+  struct Job
+  {
+    PcapBufferedWriter *writer;        //!< The writer
+    PcapBufferedWriter::Chunk *chunk;  //!< The buffer
+  };
+
+  std::mutex m_mutex;                   //!< Protects everything shared with the thread
+  std::condition_variable m_queued;     //!< Notified when a buffer is queued or the thread must stop
+  std::condition_variable m_written;    //!< Notified when a buffer is written
+  std::deque<Job> m_jobs;        //!< The queued buffers
+  uint32_t m_nWriters;           //!< The number of asynchronous writers
+  bool m_stop;                   //!< Whether the thread must stop once the queue is empty
+  Ptr<SystemThread> m_thread;    //!< The thread, if running
+};
+
+PcapWriterThread *
+PcapWriterThread::Get (void)
+{
+  // Never destroyed, so that the writers destroyed at exit can still flush
+  static PcapWriterThread *thread = new PcapWriterThread ();
+  return thread;
+}
+
+PcapWriterThread::PcapWriterThread ()
+  : m_nWriters (0),
+    m_stop (false)
+{
+}
+
+void
+PcapWriterThread::Acquire (void)
+{
+  std::lock_guard<std::mutex> lock (m_mutex);
+  if (m_nWriters++ == 0)
+    {
+      NS_LOG_LOGIC ("Start the writer thread");
+      m_stop = false;
+      m_thread = Create<SystemThread> (MakeCallback (&PcapWriterThread::Run, this));
+      m_thread->Start ();
+    }
+}
+
+void
+PcapWriterThread::Release (void)
+{
+  Ptr<SystemThread> thread;
+  {
+    std::lock_guard<std::mutex> lock (m_mutex);
+    NS_ASSERT (m_nWriters > 0);
+    if (--m_nWriters > 0)
+      {
+        return;
+      }
+    m_stop = true;
+    thread = m_thread;
+    m_thread = 0;
+  }
+  NS_LOG_LOGIC ("Stop the writer thread");
+  m_queued.notify_one ();
+  thread->Join ();
+}
+
+void
+PcapWriterThread::Submit (PcapBufferedWriter *writer)
+{
+  {
+    std::lock_guard<std::mutex> lock (m_mutex);
+    Job job;
+    job.writer = writer;
+    job.chunk = writer->m_current;
+    m_jobs.push_back (job);
+    writer->m_pending++;
+    if (writer->m_free.empty ())
+      {
+        writer->m_current = 0;
+      }
+    else
+      {
+        writer->m_current = writer->m_free.back ();
+        writer->m_free.pop_back ();
+      }
+  }
+  m_queued.notify_one ();
+}
+
+void
+PcapWriterThread::Wait (PcapBufferedWriter *writer, uint32_t maxPending)
+{
+  std::unique_lock<std::mutex> lock (m_mutex);
+  while (writer->m_pending > maxPending)
+    {
+      m_written.wait (lock);
+    }
+}
+
+void
+PcapWriterThread::Run (void)
+{
+  std::unique_lock<std::mutex> lock (m_mutex);
+  while (true)
+    {
+      while (m_jobs.empty () && !m_stop)
+        {
+          m_queued.wait (lock);
+        }
+      if (m_jobs.empty ())
+        {
+          return;
+        }
+      Job job = m_jobs.front ();
+      m_jobs.pop_front ();
+
+      lock.unlock ();
+      job.writer->m_os->write (reinterpret_cast<const char *> (&job.chunk->data[0]), job.chunk->used);
+      lock.lock ();
+
+      job.chunk->used = 0;
+      job.writer->m_free.push_back (job.chunk);
+      job.writer->m_pending--;
+      m_written.notify_all ();
+    }
+}
+
+#endif /* HAVE_PTHREAD_H */
+
+PcapBufferedWriter::PcapBufferedWriter (std::ostream *os, uint32_t bufferSize, bool async)
+  : m_os (os),
+    m_bufferSize (bufferSize),
+    m_async (async),
+    m_current (0),
+    m_pending (0)
+{
+  NS_LOG_FUNCTION (this << os << bufferSize << async);
+  NS_ASSERT (bufferSize > 0);
+#ifdef HAVE_PTHREAD_H
+  if (m_async)
+    {
+      PcapWriterThread::Get ()->Acquire ();
+    }
+#else
+  m_async = false;
+#endif
+}
+
+PcapBufferedWriter::~PcapBufferedWriter ()
+{
+  NS_LOG_FUNCTION (this);
+  Flush ();
+#ifdef HAVE_PTHREAD_H
+  if (m_async)
+    {
+      PcapWriterThread::Get ()->Release ();
+    }
+#endif
+  delete m_current;
+  for (std::vector<Chunk *>::iterator i = m_free.begin (); i != m_free.end (); i++)
+    {
+      delete *i;
+    }
+}
+
+uint32_t
+PcapBufferedWriter::GetBufferSize (void) const
+{
+  return m_bufferSize;
+}
+
+bool
+PcapBufferedWriter::IsAsync (void) const
+{
+  return m_async;
+}
+
+uint8_t *
+PcapBufferedWriter::Reserve (uint32_t size)
+{
+  if (m_current != 0 && m_current->used > 0 && m_current->used + size > m_bufferSize)
+    {
+      Submit ();
+    }
+  if (m_current == 0)
+    {
+      m_current = new Chunk;
+      m_current->data.resize (m_bufferSize);
+      m_current->used = 0;
+    }
+  if (m_current->used + size > m_current->data.size ())
+    {
+      // A record larger than the buffer, alone in this one
+      m_current->data.resize (m_current->used + size);
+    }
+  uint8_t *data = &m_current->data[m_current->used];
+  m_current->used += size;
+  return data;
+}
+
+void
+PcapBufferedWriter::Write (const void *data, uint32_t size)
+{
+  if (size > 0)
+    {
+      std::memcpy (Reserve (size), data, size);
+    }
+}
+
+void
+PcapBufferedWriter::Submit (void)
+{
+  NS_LOG_FUNCTION (this << m_current->used);
+#ifdef HAVE_PTHREAD_H
+  if (m_async)
+    {
+      PcapWriterThread *thread = PcapWriterThread::Get ();
+      thread->Wait (this, MAX_PENDING - 1);
+      thread->Submit (this);
+      return;
+    }
+#endif
+  m_os->write (reinterpret_cast<const char *> (&m_current->data[0]), m_current->used);
+  m_current->used = 0;
+}
+
+void
+PcapBufferedWriter::Flush (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (m_current != 0 && m_current->used > 0)
+    {
+      Submit ();
+    }
+#ifdef HAVE_PTHREAD_H
+  if (m_async)
+    {
+      PcapWriterThread::Get ()->Wait (this, 0);
+    }
+#endif
+  m_os->flush ();
+}
+
+} // namespace ns3
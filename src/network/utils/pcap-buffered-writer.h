@@ -0,0 +1,109 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef PCAP_BUFFERED_WRITER_H
+#define PCAP_BUFFERED_WRITER_H
+
+#include <ostream>
+#include <vector>
+#include <stdint.h>
+
+namespace ns3 {
+
+class PcapWriterThread;
+
+/**
+ * \brief Gathers the records of a capture file into large buffers
+ *
+ * The records are appended to a buffer of a fixed size, which is written
+ * to the output stream in a single call once it is full.  In asynchronous
+ * mode the full buffers are handed to a background thread, shared by all
+ * the asynchronous writers, and the simulation goes on filling another
+ * buffer; at most MAX_PENDING buffers per writer wait for the thread, after
+ * which the caller blocks until one of them is written.
+ *
+ * The output stream must not be used by anybody else until Flush returns.
+ * Without thread support, the asynchronous mode falls back to the
+ * synchronous one.
+ */
+class PcapBufferedWriter
+{
+public:
+  static const uint32_t MAX_PENDING = 4;  //!< Maximum number of buffers waiting for the thread
+
+  /**
+   * \brief Constructor
+   * \param os the output stream
+   * \param bufferSize the size of the buffers, in bytes
+   * \param async if true, write the buffers from the background thread
+   */
+  PcapBufferedWriter (std::ostream *os, uint32_t bufferSize, bool async);
+  /// Destructor, which flushes the buffered records
+  ~PcapBufferedWriter ();
+
+  /**
+   * \brief Append bytes to the current record
+   * \param data the bytes
+   * \param size the number of bytes
+   */
+  void Write (const void *data, uint32_t size);
+  /**
+   * \brief Append bytes to the current record, to be filled by the caller
+   *
+   * The bytes are contiguous, even if there are more than the size of the
+   * buffers.  The pointer is valid until the next call to any method.
+   *
+   * \param size the number of bytes
+   * \returns a pointer to the bytes
+   */
+  uint8_t *Reserve (uint32_t size);
+  /**
+   * \brief Write all the buffered bytes to the output stream and flush it
+   */
+  void Flush (void);
+
+  /// \returns the size of the buffers, in bytes
+  uint32_t GetBufferSize (void) const;
+  /// \returns true if the buffers are written by the background thread
+  bool IsAsync (void) const;
+
+private:
+  friend class PcapWriterThread;
+
+  /// A buffer of records
+  struct Chunk
+  {
+    std::vector<uint8_t> data;  //!< The storage, at least the buffer size
+    uint32_t used;              //!< The number of bytes filled
+  };
+
+  /**
+   * \brief Write the current buffer, or hand it to the background thread
+   */
+  void Submit (void);
+
+  std::ostream *m_os;           //!< The output stream
+  uint32_t m_bufferSize;        //!< The size of the buffers
+  bool m_async;                 //!< Whether the background thread is used
+  Chunk *m_current;             //!< The buffer being filled
+  // The following ones are shared with the background thread
+  std::vector<Chunk *> m_free;  //!< The buffers already written
+  uint32_t m_pending;           //!< The number of buffers waiting for the thread
+};
+
+} // namespace ns3
+
+#endif /* PCAP_BUFFERED_WRITER_H */
@@ -46,12 +46,25 @@ PcapFileWrapper::GetTypeId (void)
                    BooleanValue (false),
                    MakeBooleanAccessor (&PcapFileWrapper::m_nanosecMode),
                    MakeBooleanChecker())
+    .AddAttribute ("BufferSize",
+                   "Size in bytes of the buffers gathering the records before they are written "
+                   "to the file, or zero to write every record directly.  The records still "
+                   "buffered are written by Flush, Close and on destruction.",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&PcapFileWrapper::m_bufferSize),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("AsyncWrite",
+                   "Whether the full buffers are written by a background thread (see BufferSize).",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&PcapFileWrapper::m_asyncWrite),
+                   MakeBooleanChecker())
   ;
   return tid;
 }
 
 
 PcapFileWrapper::PcapFileWrapper ()
+  : m_interface (0)
 {
   NS_LOG_FUNCTION (this);
 }
@@ -66,6 +79,10 @@ bool
 PcapFileWrapper::Fail (void) const
 {
   NS_LOG_FUNCTION (this);
+  if (m_pcapNg)
+    {
+      return m_pcapNg->Fail ();
+    }
   return m_file.Fail ();
 }
 
@@ -86,14 +103,41 @@ void
 PcapFileWrapper::Close (void)
 {
   NS_LOG_FUNCTION (this);
+  m_pcapNg = 0;
   m_file.Close ();
 }
 
+void
+PcapFileWrapper::Flush (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (m_pcapNg)
+    {
+      m_pcapNg->Flush ();
+    }
+  else
+    {
+      m_file.Flush ();
+    }
+}
+
 void
 PcapFileWrapper::Open (std::string const &filename, std::ios::openmode mode)
 {
   NS_LOG_FUNCTION (this << filename << mode);
   m_file.Open (filename, mode);
+  if (m_bufferSize > 0 && (mode & std::ios::out))
+    {
+      m_file.SetBuffering (m_bufferSize, m_asyncWrite);
+    }
+}
+
+void
+PcapFileWrapper::Open (Ptr<PcapNgFile> file, std::string const &interfaceName)
+{
+  NS_LOG_FUNCTION (this << file << interfaceName);
+  m_pcapNg = file;
+  m_interfaceName = interfaceName;
 }
 
 void
@@ -105,33 +149,50 @@ PcapFileWrapper::Init (uint32_t dataLinkType, uint32_t snapLen, int32_t tzCorrec
   // a snaplen, we use the one provided.
   //
   NS_LOG_FUNCTION (this << dataLinkType << snapLen << tzCorrection);
-  if (snapLen != std::numeric_limits<uint32_t>::max ())
+  if (snapLen == std::numeric_limits<uint32_t>::max ())
+    {
+      snapLen = m_snapLen;
+    }
+  if (m_pcapNg)
+    {
+      m_interface = m_pcapNg->AddInterface (m_interfaceName, dataLinkType, snapLen, m_nanosecMode);
+    }
+  else
     {
       m_file.Init (dataLinkType, snapLen, tzCorrection, false, m_nanosecMode);
-    } 
+    }
+}
+
+void
+PcapFileWrapper::SplitTime (Time t, uint32_t &sec, uint32_t &frac)
+{
+  if (m_pcapNg ? m_nanosecMode : m_file.IsNanoSecMode ())
+    {
+      uint64_t current = t.GetNanoSeconds ();
+      sec  = current / 1000000000;
+      frac = current % 1000000000;
+    }
   else
     {
-      m_file.Init (dataLinkType, m_snapLen, tzCorrection, false, m_nanosecMode);
-    } 
+      uint64_t current = t.GetMicroSeconds ();
+      sec  = current / 1000000;
+      frac = current % 1000000;
+    }
 }
 
 void
 PcapFileWrapper::Write (Time t, Ptr<const Packet> p)
 {
   NS_LOG_FUNCTION (this << t << p);
-  if (m_file.IsNanoSecMode())
+  uint32_t s, frac;
+  SplitTime (t, s, frac);
+  if (m_pcapNg)
     {
-      uint64_t current = t.GetNanoSeconds ();
-      uint64_t s       = current / 1000000000;
-      uint64_t ns      = current % 1000000000;
-      m_file.Write (s, ns, p);
+      m_pcapNg->Write (m_interface, s, frac, p);
     }
   else
     {
-      uint64_t current = t.GetMicroSeconds ();
-      uint64_t s       = current / 1000000;
-      uint64_t us      = current % 1000000;
-      m_file.Write (s, us, p);
+      m_file.Write (s, frac, p);
     }
 }
 
@@ -139,19 +200,15 @@ void
 PcapFileWrapper::Write (Time t, const Header &header, Ptr<const Packet> p)
 {
   NS_LOG_FUNCTION (this << t << &header << p);
-  if (m_file.IsNanoSecMode())
+  uint32_t s, frac;
+  SplitTime (t, s, frac);
+  if (m_pcapNg)
     {
-      uint64_t current = t.GetNanoSeconds ();
-      uint64_t s       = current / 1000000000;
-      uint64_t ns      = current % 1000000000;
-      m_file.Write (s, ns, header, p);
+      m_pcapNg->Write (m_interface, s, frac, header, p);
     }
   else
     {
-      uint64_t current = t.GetMicroSeconds ();
-      uint64_t s       = current / 1000000;
-      uint64_t us      = current % 1000000;
-      m_file.Write (s, us, header, p);
+      m_file.Write (s, frac, header, p);
     }
 }
 
@@ -159,19 +216,15 @@ void
 PcapFileWrapper::Write (Time t, uint8_t const *buffer, uint32_t length)
 {
   NS_LOG_FUNCTION (this << t << &buffer << length);
-  if (m_file.IsNanoSecMode())
+  uint32_t s, frac;
+  SplitTime (t, s, frac);
+  if (m_pcapNg)
     {
-      uint64_t current = t.GetNanoSeconds ();
-      uint64_t s       = current / 1000000000;
-      uint64_t ns      = current % 1000000000;
-      m_file.Write (s, ns, buffer, length);
+      m_pcapNg->Write (m_interface, s, frac, buffer, length);
     }
   else
     {
-      uint64_t current = t.GetMicroSeconds ();
-      uint64_t s       = current / 1000000;
-      uint64_t us      = current % 1000000;
-      m_file.Write (s, us, buffer, length);
+      m_file.Write (s, frac, buffer, length);
     }
 }
 
@@ -27,6 +27,7 @@
 #include "ns3/object.h"
 #include "ns3/nstime.h"
 #include "pcap-file.h"
+#include "pcapng-file.h"
 
 namespace ns3 {
 
@@ -77,11 +78,29 @@ public:
    */
   void Open (std::string const &filename, std::ios::openmode mode);
 
+  /**
+   * Write the packets to an interface of a pcapng file instead of a pcap
+   * file.  The interface is added to the pcapng file by Init, which takes
+   * the same parameters, except for the time zone correction which is
+   * ignored.
+   *
+   * \param file The pcapng file, which may be shared with other wrappers.
+   *
+   * \param interfaceName The name of the interface.
+   */
+  void Open (Ptr<PcapNgFile> file, std::string const &interfaceName);
+
   /**
    * Close the underlying pcap file.
    */
   void Close (void);
 
+  /**
+   * Write the packets still buffered (see the BufferSize attribute) and
+   * flush the underlying file.
+   */
+  void Flush (void);
+
   /**
    * Initialize the pcap file associated with this wrapper.  This file must have
    * been previously opened with write permissions.
@@ -221,9 +240,22 @@ public:
   uint32_t GetDataLinkType (void);
 
 private:
+  /**
+   * \brief Split a timestamp as stored in the file
+   * \param t the timestamp
+   * \param sec the seconds of the timestamp
+   * \param frac the microseconds or nanoseconds of the timestamp
+   */
+  void SplitTime (Time t, uint32_t &sec, uint32_t &frac);
+
   PcapFile m_file; //!< Pcap file
   uint32_t m_snapLen; //!< max length of saved packets
   bool     m_nanosecMode; //!< Timestamps in nanosecond mode
+  uint32_t m_bufferSize; //!< Size of the buffers of the records, or zero
+  bool     m_asyncWrite; //!< Whether the buffers are written by a background thread
+  Ptr<PcapNgFile> m_pcapNg; //!< pcapng file, if the packets are written there
+  std::string m_interfaceName; //!< Name of the interface in the pcapng file
+  uint32_t m_interface; //!< Identifier of the interface in the pcapng file
 };
 
 } // namespace ns3
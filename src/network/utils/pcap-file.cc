@@ -27,6 +27,7 @@
 #include "ns3/header.h"
 #include "ns3/buffer.h"
 #include "pcap-file.h"
+#include "pcap-buffered-writer.h"
 #include "ns3/log.h"
 #include "ns3/build-profile.h"
 //
@@ -50,7 +51,8 @@ const uint16_t VERSION_MINOR = 4;             /**< Minor version of supported pc
 PcapFile::PcapFile ()
   : m_file (),
     m_swapMode (false),
-    m_nanosecMode (false)
+    m_nanosecMode (false),
+    m_writer (0)
 {
   NS_LOG_FUNCTION (this);
   FatalImpl::RegisterStream (&m_file); 
@@ -68,6 +70,10 @@ bool
 PcapFile::Fail (void) const
 {
   NS_LOG_FUNCTION (this);
+  if (m_writer)
+    {
+      m_writer->Flush ();
+    }
   return m_file.fail ();
 }
 bool 
@@ -88,9 +94,37 @@ void
 PcapFile::Close (void)
 {
   NS_LOG_FUNCTION (this);
+  SetBuffering (0, false);
   m_file.close ();
 }
 
+void
+PcapFile::SetBuffering (uint32_t bufferSize, bool async)
+{
+  NS_LOG_FUNCTION (this << bufferSize << async);
+  // deleting the writer flushes the records it buffered
+  delete m_writer;
+  m_writer = 0;
+  if (bufferSize > 0)
+    {
+      m_writer = new PcapBufferedWriter (&m_file, bufferSize, async);
+    }
+}
+
+void
+PcapFile::Flush (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (m_writer)
+    {
+      m_writer->Flush ();
+    }
+  else
+    {
+      m_file.flush ();
+    }
+}
+
 uint32_t
 PcapFile::GetMagic (void)
 {
@@ -206,6 +240,10 @@ PcapFile::WriteFileHeader (void)
   // If we're initializing the file, we need to write the pcap file header
   // at the start of the file.
   //
+  if (m_writer)
+    {
+      m_writer->Flush ();
+    }
   m_file.seekp (0, std::ios::beg);
  
   //
@@ -422,6 +460,14 @@ PcapFile::WritePacketHeader (uint32_t tsSec, uint32_t tsUsec, uint32_t totalLen)
   // Watch out for memory alignment differences between machines, so write
   // them all individually.
   //
+  if (m_writer)
+    {
+      m_writer->Write (&header.m_tsSec, sizeof(header.m_tsSec));
+      m_writer->Write (&header.m_tsUsec, sizeof(header.m_tsUsec));
+      m_writer->Write (&header.m_inclLen, sizeof(header.m_inclLen));
+      m_writer->Write (&header.m_origLen, sizeof(header.m_origLen));
+      return inclLen;
+    }
   m_file.write ((const char *)&header.m_tsSec, sizeof(header.m_tsSec));
   m_file.write ((const char *)&header.m_tsUsec, sizeof(header.m_tsUsec));
   m_file.write ((const char *)&header.m_inclLen, sizeof(header.m_inclLen));
@@ -435,6 +481,11 @@ PcapFile::Write (uint32_t tsSec, uint32_t tsUsec, uint8_t const * const data, ui
 {
   NS_LOG_FUNCTION (this << tsSec << tsUsec << &data << totalLen);
   uint32_t inclLen = WritePacketHeader (tsSec, tsUsec, totalLen);
+  if (m_writer)
+    {
+      m_writer->Write (data, inclLen);
+      return;
+    }
   m_file.write ((const char *)data, inclLen);
   NS_BUILD_DEBUG(m_file.flush());
 }
@@ -444,6 +495,11 @@ PcapFile::Write (uint32_t tsSec, uint32_t tsUsec, Ptr<const Packet> p)
 {
   NS_LOG_FUNCTION (this << tsSec << tsUsec << p);
   uint32_t inclLen = WritePacketHeader (tsSec, tsUsec, p->GetSize ());
+  if (m_writer)
+    {
+      p->CopyData (m_writer->Reserve (inclLen), inclLen);
+      return;
+    }
   p->CopyData (&m_file, inclLen);
   NS_BUILD_DEBUG(m_file.flush());
 }
@@ -460,6 +516,13 @@ PcapFile::Write (uint32_t tsSec, uint32_t tsUsec, const Header &header, Ptr<cons
   headerBuffer.AddAtStart (headerSize);
   header.Serialize (headerBuffer.Begin ());
   uint32_t toCopy = std::min (headerSize, inclLen);
+  if (m_writer)
+    {
+      uint8_t *data = m_writer->Reserve (inclLen);
+      headerBuffer.CopyData (data, toCopy);
+      p->CopyData (data + toCopy, inclLen - toCopy);
+      return;
+    }
   headerBuffer.CopyData (&m_file, toCopy);
   inclLen -= toCopy;
   p->CopyData (&m_file, inclLen);
@@ -476,6 +539,10 @@ PcapFile::Read (
   uint32_t &readLen)
 {
   NS_LOG_FUNCTION (this << &data <<maxBytes << tsSec << tsUsec << inclLen << origLen << readLen);
+  if (m_writer)
+    {
+      m_writer->Flush ();
+    }
   NS_ASSERT (m_file.good ());
 
   PcapRecordHeader header;
@@ -30,6 +30,7 @@ namespace ns3 {
 
 class Packet;
 class Header;
+class PcapBufferedWriter;
 
 
 /**
@@ -51,6 +52,9 @@ public:
 
   /**
    * \return true if the 'fail' bit is set in the underlying iostream, false otherwise.
+   *
+   * The records still buffered (see SetBuffering) are written first, so that
+   * the state reflects all the writes.
    */
   bool Fail (void) const;
   /**
@@ -85,6 +89,31 @@ public:
    */
   void Close (void);
 
+  /**
+   * \brief Gather the records written into large buffers
+   *
+   * Instead of writing every field of every record to the stream, the
+   * records are copied into buffers of \p bufferSize bytes, and each full
+   * buffer is written in a single call.  If \p async is true, the full
+   * buffers are written by a background thread, while the records go on
+   * filling another buffer.  The content of the file is the same in every
+   * mode.
+   *
+   * Buffering lasts until the file is closed.  The records still buffered
+   * are lost if the simulation aborts, since only the stream is flushed
+   * then: call Flush to make sure the file is complete.
+   *
+   * \param bufferSize the size of the buffers in bytes, or zero to write
+   *        the records directly
+   * \param async if true, write the buffers from a background thread
+   */
+  void SetBuffering (uint32_t bufferSize, bool async);
+
+  /**
+   * \brief Write the records still buffered and flush the file
+   */
+  void Flush (void);
+
   /**
    * Initialize the pcap file associated with this object.  This file must have
    * been previously opened with write permissions.
@@ -371,6 +400,7 @@ private:
   PcapFileHeader m_fileHeader;  //!< file header
   bool m_swapMode;              //!< swap mode
   bool m_nanosecMode;           //!< nanosecond timestamp mode
+  PcapBufferedWriter *m_writer; //!< the buffers of the records, if any
 };
 
 } // namespace ns3
@@ -0,0 +1,475 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <cstring>
+#include <algorithm>
+#include "ns3/assert.h"
+#include "ns3/log.h"
+#include "ns3/packet.h"
+#include "ns3/header.h"
+#include "ns3/buffer.h"
+#include "ns3/fatal-impl.h"
+#include "ns3/build-profile.h"
+#include "pcapng-file.h"
+#include "pcap-buffered-writer.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("PcapNgFile");
+
+const uint32_t SECTION_HEADER_BLOCK = 0x0a0d0d0a;   /**< Block type of a Section Header Block */
+const uint32_t INTERFACE_DESCRIPTION_BLOCK = 1;     /**< Block type of an Interface Description Block */
+const uint32_t ENHANCED_PACKET_BLOCK = 6;           /**< Block type of an Enhanced Packet Block */
+const uint32_t BYTE_ORDER_MAGIC = 0x1a2b3c4d;       /**< Byte-order magic of the Section Header Block */
+const uint32_t SWAPPED_BYTE_ORDER_MAGIC = 0x4d3c2b1a; /**< Looks this way if byte swapping is required */
+const uint16_t OPT_ENDOFOPT = 0;                    /**< Option ending the list of options */
+const uint16_t OPT_IF_NAME = 2;                     /**< Option holding the name of an interface */
+const uint16_t OPT_IF_TSRESOL = 9;                  /**< Option holding the timestamp resolution of an interface */
+
+/**
+ * \param length a length in bytes
+ * \returns the length rounded up to a multiple of 32 bits
+ */
+static uint32_t
+Pad32 (uint32_t length)
+{
+  return (length + 3) & ~3U;
+}
+
+/**
+ * \param value an integer
+ * \param swap whether the byte order must be swapped
+ * \returns the integer, byte-swapped if requested
+ */
+static uint16_t
+Swap16 (uint16_t value, bool swap)
+{
+  return swap ? ((value & 0xff) << 8) | (value >> 8) : value;
+}
+
+/**
+ * \param value an integer
+ * \param swap whether the byte order must be swapped
+ * \returns the integer, byte-swapped if requested
+ */
+static uint32_t
+Swap32 (uint32_t value, bool swap)
+{
+  return swap ? ((value & 0xff) << 24) | ((value & 0xff00) << 8)
+         | ((value >> 8) & 0xff00) | (value >> 24) : value;
+}
+
+/**
+ * \brief Read a 16-bit integer from a block
+ * \param data the bytes of the block
+ * \param offset the offset of the integer
+ * \param swap whether the byte order must be swapped
+ * \returns the integer
+ */
+static uint16_t
+Get16 (const std::vector<uint8_t> &data, uint32_t offset, bool swap)
+{
+  uint16_t value;
+  std::memcpy (&value, &data[offset], sizeof (value));
+  return Swap16 (value, swap);
+}
+
+/**
+ * \brief Read a 32-bit integer from a block
+ * \param data the bytes of the block
+ * \param offset the offset of the integer
+ * \param swap whether the byte order must be swapped
+ * \returns the integer
+ */
+static uint32_t
+Get32 (const std::vector<uint8_t> &data, uint32_t offset, bool swap)
+{
+  uint32_t value;
+  std::memcpy (&value, &data[offset], sizeof (value));
+  return Swap32 (value, swap);
+}
+
+PcapNgFile::PcapNgFile ()
+  : m_writer (0)
+{
+  NS_LOG_FUNCTION (this);
+  FatalImpl::RegisterStream (&m_file);
+}
+
+PcapNgFile::~PcapNgFile ()
+{
+  NS_LOG_FUNCTION (this);
+  FatalImpl::UnregisterStream (&m_file);
+  Close ();
+}
+
+bool
+PcapNgFile::Fail (void) const
+{
+  NS_LOG_FUNCTION (this);
+  if (m_writer)
+    {
+      m_writer->Flush ();
+    }
+  return m_file.fail ();
+}
+
+void
+PcapNgFile::Open (std::string const &filename)
+{
+  NS_LOG_FUNCTION (this << filename);
+  NS_ASSERT (!m_file.is_open ());
+  m_interfaces.clear ();
+  m_file.open (filename.c_str (), std::ios::out | std::ios::binary);
+
+  WriteUint32 (SECTION_HEADER_BLOCK);
+  WriteUint32 (28);
+  WriteUint32 (BYTE_ORDER_MAGIC);
+  uint16_t version[2] = { 1, 0 };
+  WriteBytes (version, sizeof (version));
+  int64_t sectionLength = -1;  // unspecified
+  WriteBytes (&sectionLength, sizeof (sectionLength));
+  WriteUint32 (28);
+}
+
+void
+PcapNgFile::Close (void)
+{
+  NS_LOG_FUNCTION (this);
+  SetBuffering (0, false);
+  m_file.close ();
+}
+
+void
+PcapNgFile::SetBuffering (uint32_t bufferSize, bool async)
+{
+  NS_LOG_FUNCTION (this << bufferSize << async);
+  delete m_writer;
+  m_writer = 0;
+  if (bufferSize > 0)
+    {
+      m_writer = new PcapBufferedWriter (&m_file, bufferSize, async);
+    }
+}
+
+void
+PcapNgFile::Flush (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (m_writer)
+    {
+      m_writer->Flush ();
+    }
+  else
+    {
+      m_file.flush ();
+    }
+}
+
+void
+PcapNgFile::WriteBytes (const void *data, uint32_t size)
+{
+  if (m_writer)
+    {
+      m_writer->Write (data, size);
+    }
+  else
+    {
+      m_file.write (static_cast<const char *> (data), size);
+      NS_BUILD_DEBUG (m_file.flush ());
+    }
+}
+
+void
+PcapNgFile::WriteUint32 (uint32_t value)
+{
+  WriteBytes (&value, sizeof (value));
+}
+
+uint32_t
+PcapNgFile::AddInterface (std::string const &name, uint32_t dataLinkType, uint32_t snapLen, bool nanosecMode)
+{
+  NS_LOG_FUNCTION (this << name << dataLinkType << snapLen << nanosecMode);
+  NS_ASSERT (name.size () <= 0xffff);
+  Interface interface;
+  interface.snapLen = snapLen;
+  interface.nanosecMode = nanosecMode;
+  m_interfaces.push_back (interface);
+
+  uint32_t optionsLen = 4 + Pad32 (name.size ()) + 4 + 4 + 4;
+  uint32_t blockLen = 20 + optionsLen;
+  WriteUint32 (INTERFACE_DESCRIPTION_BLOCK);
+  WriteUint32 (blockLen);
+  uint16_t linkType[2] = { static_cast<uint16_t> (dataLinkType), 0 };
+  WriteBytes (linkType, sizeof (linkType));
+  WriteUint32 (snapLen);
+
+  uint16_t option[2] = { OPT_IF_NAME, static_cast<uint16_t> (name.size ()) };
+  WriteBytes (option, sizeof (option));
+  WriteBytes (name.data (), name.size ());
+  uint8_t padding[4] = { 0, 0, 0, 0 };
+  WriteBytes (padding, Pad32 (name.size ()) - name.size ());
+  option[0] = OPT_IF_TSRESOL;
+  option[1] = 1;
+  WriteBytes (option, sizeof (option));
+  uint8_t resolution[4] = { static_cast<uint8_t> (nanosecMode ? 9 : 6), 0, 0, 0 };
+  WriteBytes (resolution, sizeof (resolution));
+  option[0] = OPT_ENDOFOPT;
+  option[1] = 0;
+  WriteBytes (option, sizeof (option));
+  WriteUint32 (blockLen);
+
+  return m_interfaces.size () - 1;
+}
+
+uint32_t
+PcapNgFile::GetNInterfaces (void) const
+{
+  return m_interfaces.size ();
+}
+
+uint32_t
+PcapNgFile::WritePacketHeader (uint32_t interface, uint32_t tsSec, uint32_t tsFrac, uint32_t totalLen)
+{
+  NS_LOG_FUNCTION (this << interface << tsSec << tsFrac << totalLen);
+  NS_ASSERT_MSG (interface < m_interfaces.size (), "Unknown interface " << interface);
+  const Interface &iface = m_interfaces[interface];
+  uint32_t inclLen = std::min (totalLen, iface.snapLen);
+  uint64_t timestamp = static_cast<uint64_t> (tsSec) * (iface.nanosecMode ? 1000000000 : 1000000) + tsFrac;
+
+  uint32_t header[7];
+  header[0] = ENHANCED_PACKET_BLOCK;
+  header[1] = 32 + Pad32 (inclLen);
+  header[2] = interface;
+  header[3] = static_cast<uint32_t> (timestamp >> 32);
+  header[4] = static_cast<uint32_t> (timestamp);
+  header[5] = inclLen;
+  header[6] = totalLen;
+  WriteBytes (header, sizeof (header));
+  return inclLen;
+}
+
+void
+PcapNgFile::WritePacketTrailer (uint32_t inclLen)
+{
+  uint32_t trailer[2] = { 0, 32 + Pad32 (inclLen) };
+  uint32_t padding = Pad32 (inclLen) - inclLen;
+  WriteBytes (reinterpret_cast<uint8_t *> (trailer) + 4 - padding, padding + 4);
+}
+
+void
+PcapNgFile::Write (uint32_t interface, uint32_t tsSec, uint32_t tsFrac, uint8_t const * const data, uint32_t totalLen)
+{
+  NS_LOG_FUNCTION (this << interface << tsSec << tsFrac << &data << totalLen);
+  uint32_t inclLen = WritePacketHeader (interface, tsSec, tsFrac, totalLen);
+  WriteBytes (data, inclLen);
+  WritePacketTrailer (inclLen);
+}
+
+void
+PcapNgFile::Write (uint32_t interface, uint32_t tsSec, uint32_t tsFrac, Ptr<const Packet> p)
+{
+  NS_LOG_FUNCTION (this << interface << tsSec << tsFrac << p);
+  uint32_t inclLen = WritePacketHeader (interface, tsSec, tsFrac, p->GetSize ());
+  if (m_writer)
+    {
+      p->CopyData (m_writer->Reserve (inclLen), inclLen);
+    }
+  else
+    {
+      p->CopyData (&m_file, inclLen);
+    }
+  WritePacketTrailer (inclLen);
+}
+
+void
+PcapNgFile::Write (uint32_t interface, uint32_t tsSec, uint32_t tsFrac, const Header &header, Ptr<const Packet> p)
+{
+  NS_LOG_FUNCTION (this << interface << tsSec << tsFrac << &header << p);
+  uint32_t headerSize = header.GetSerializedSize ();
+  uint32_t inclLen = WritePacketHeader (interface, tsSec, tsFrac, headerSize + p->GetSize ());
+
+  Buffer headerBuffer;
+  headerBuffer.AddAtStart (headerSize);
+  header.Serialize (headerBuffer.Begin ());
+  uint32_t toCopy = std::min (headerSize, inclLen);
+  if (m_writer)
+    {
+      uint8_t *data = m_writer->Reserve (inclLen);
+      headerBuffer.CopyData (data, toCopy);
+      p->CopyData (data + toCopy, inclLen - toCopy);
+    }
+  else
+    {
+      headerBuffer.CopyData (&m_file, toCopy);
+      p->CopyData (&m_file, inclLen - toCopy);
+    }
+  WritePacketTrailer (inclLen);
+}
+
+bool
+PcapNgFile::ExtractInterface (std::string const &filename, std::string const &name,
+                              std::string const &pcapFilename)
+{
+  NS_LOG_FUNCTION (filename << name << pcapFilename);
+  std::ifstream in (filename.c_str (), std::ios::in | std::ios::binary);
+  bool swap = false;
+  bool inSection = false;
+  bool found = false;
+  uint32_t interface = 0;
+  uint32_t nInterfaces = 0;
+  uint64_t unitsPerSecond = 0;
+  uint32_t fracPerUnit = 0;
+  PcapFile pcap;
+  std::vector<uint8_t> body;
+
+  while (true)
+    {
+      uint32_t blockHeader[2];
+      if (!in.read (reinterpret_cast<char *> (blockHeader), sizeof (blockHeader)))
+        {
+          // end of the file
+          break;
+        }
+      uint32_t type = blockHeader[0];
+      if (type == SECTION_HEADER_BLOCK)
+        {
+          if (inSection)
+            {
+              break;
+            }
+          uint32_t magic;
+          if (!in.read (reinterpret_cast<char *> (&magic), sizeof (magic))
+              || (magic != BYTE_ORDER_MAGIC && magic != SWAPPED_BYTE_ORDER_MAGIC))
+            {
+              NS_LOG_WARN ("Invalid section header in " << filename);
+              return false;
+            }
+          swap = magic == SWAPPED_BYTE_ORDER_MAGIC;
+          inSection = true;
+          in.seekg (-4, std::ios::cur);
+        }
+      else if (!inSection)
+        {
+          NS_LOG_WARN (filename << " does not start with a section header");
+          return false;
+        }
+      type = Swap32 (type, swap);
+      uint32_t blockLen = Swap32 (blockHeader[1], swap);
+      if (blockLen < 12 || blockLen % 4 != 0)
+        {
+          NS_LOG_WARN ("Invalid block length " << blockLen << " in " << filename);
+          return false;
+        }
+      body.resize (blockLen - 8);
+      if (!in.read (reinterpret_cast<char *> (&body[0]), body.size ()))
+        {
+          NS_LOG_WARN ("Truncated block in " << filename);
+          return false;
+        }
+
+      if (type == INTERFACE_DESCRIPTION_BLOCK && body.size () >= 12)
+        {
+          uint32_t id = nInterfaces++;
+          if (found)
+            {
+              continue;
+            }
+          uint16_t linkType = Get16 (body, 0, swap);
+          uint32_t snapLen = Get32 (body, 4, swap);
+          std::string ifName;
+          uint8_t resolution = 6;
+          for (uint32_t offset = 8; offset + 4 <= body.size () - 4; )
+            {
+              uint16_t code = Get16 (body, offset, swap);
+              uint16_t length = Get16 (body, offset + 2, swap);
+              offset += 4;
+              if (code == OPT_ENDOFOPT || offset + length > body.size () - 4)
+                {
+                  break;
+                }
+              if (code == OPT_IF_NAME)
+                {
+                  ifName.assign (reinterpret_cast<const char *> (&body[offset]), length);
+                  // the name may be null-terminated
+                  ifName = ifName.substr (0, ifName.find ('\0'));
+                }
+              else if (code == OPT_IF_TSRESOL && length >= 1)
+                {
+                  resolution = body[offset];
+                }
+              offset += Pad32 (length);
+            }
+          if (ifName != name)
+            {
+              continue;
+            }
+          if ((resolution & 0x80) || resolution > 9)
+            {
+              NS_LOG_WARN ("Unsupported timestamp resolution of interface " << name);
+              return false;
+            }
+          found = true;
+          interface = id;
+          unitsPerSecond = 1;
+          for (uint8_t i = 0; i < resolution; i++)
+            {
+              unitsPerSecond *= 10;
+            }
+          // keep the resolution of the interface, within the ones of pcap
+          bool nanosecMode = resolution > 6;
+          fracPerUnit = 1;
+          for (uint8_t i = resolution; i < (nanosecMode ? 9 : 6); i++)
+            {
+              fracPerUnit *= 10;
+            }
+          pcap.Open (pcapFilename, std::ios::out);
+          pcap.Init (linkType, snapLen, 0, false, nanosecMode);
+          if (pcap.Fail ())
+            {
+              return false;
+            }
+        }
+      else if (type == ENHANCED_PACKET_BLOCK && found && body.size () >= 24
+               && Get32 (body, 0, swap) == interface)
+        {
+          uint64_t timestamp = (static_cast<uint64_t> (Get32 (body, 4, swap)) << 32) | Get32 (body, 8, swap);
+          uint32_t inclLen = Get32 (body, 12, swap);
+          uint32_t origLen = Get32 (body, 16, swap);
+          if (20 + inclLen > body.size () - 4)
+            {
+              NS_LOG_WARN ("Invalid packet length in " << filename);
+              return false;
+            }
+          // PcapFile::Write stores min (origLen, snapLen) bytes
+          uint32_t toWrite = std::min (origLen, pcap.GetSnapLen ());
+          std::vector<uint8_t> data (std::max (toWrite, inclLen) + 1, 0);
+          std::memcpy (&data[0], &body[20], inclLen);
+          pcap.Write (timestamp / unitsPerSecond, (timestamp % unitsPerSecond) * fracPerUnit,
+                      &data[0], std::max (origLen, inclLen));
+        }
+    }
+
+  if (!found)
+    {
+      NS_LOG_WARN ("No interface " << name << " in " << filename);
+      return false;
+    }
+  pcap.Close ();
+  return true;
+}
+
+} // namespace ns3
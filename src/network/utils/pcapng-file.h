@@ -0,0 +1,183 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef PCAPNG_FILE_H
+#define PCAPNG_FILE_H
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <stdint.h>
+#include "ns3/ptr.h"
+#include "ns3/simple-ref-count.h"
+#include "pcap-file.h"
+
+namespace ns3 {
+
+class Packet;
+class Header;
+class PcapBufferedWriter;
+
+/**
+ * \brief A pcapng file, which multiplexes the packets of several interfaces
+ *
+ * The file is made of a single section: a Section Header Block, then an
+ * Interface Description Block per interface, with its name (if_name) and
+ * its timestamp resolution (if_tsresol, microseconds or nanoseconds), and
+ * an Enhanced Packet Block per packet.  The blocks are written in the byte
+ * order of the host, as the format allows.
+ *
+ * The timestamps and the captured data of the packets of an interface are
+ * the ones a PcapFile with the same data link type, snapshot length and
+ * timestamp resolution would store, so that ExtractInterface gives back
+ * that file.
+ */
+class PcapNgFile : public SimpleRefCount<PcapNgFile>
+{
+public:
+  PcapNgFile ();
+  ~PcapNgFile ();
+
+  /**
+   * \return true if the 'fail' bit is set in the underlying iostream, false otherwise.
+   *
+   * The blocks still buffered are written first, as for PcapFile::Fail.
+   */
+  bool Fail (void) const;
+
+  /**
+   * \brief Create a new pcapng file and write its section header
+   * \param filename the name of the file
+   */
+  void Open (std::string const &filename);
+  /**
+   * \brief Close the file
+   */
+  void Close (void);
+
+  /**
+   * \brief Gather the blocks written into large buffers
+   * \param bufferSize the size of the buffers in bytes, or zero to write
+   *        the blocks directly
+   * \param async if true, write the buffers from a background thread
+   *
+   * \see PcapFile::SetBuffering
+   */
+  void SetBuffering (uint32_t bufferSize, bool async);
+  /**
+   * \brief Write the blocks still buffered and flush the file
+   */
+  void Flush (void);
+
+  /**
+   * \brief Add an interface to the file
+   * \param name the name of the interface
+   * \param dataLinkType the data link type of the packets
+   * \param snapLen the maximum number of bytes captured per packet
+   * \param nanosecMode if true, the timestamps are in nanoseconds,
+   *        otherwise in microseconds
+   * \returns the identifier of the interface
+   */
+  uint32_t AddInterface (std::string const &name, uint32_t dataLinkType,
+                         uint32_t snapLen = PcapFile::SNAPLEN_DEFAULT, bool nanosecMode = false);
+  /// \returns the number of interfaces added
+  uint32_t GetNInterfaces (void) const;
+
+  /**
+   * \brief Write the next packet of an interface
+   * \param interface the identifier of the interface
+   * \param tsSec the seconds of the timestamp
+   * \param tsFrac the microseconds or nanoseconds of the timestamp, as
+   *        chosen for the interface
+   * \param data the packet data
+   * \param totalLen the length of the packet
+   */
+  void Write (uint32_t interface, uint32_t tsSec, uint32_t tsFrac, uint8_t const * const data, uint32_t totalLen);
+  /**
+   * \brief Write the next packet of an interface
+   * \param interface the identifier of the interface
+   * \param tsSec the seconds of the timestamp
+   * \param tsFrac the microseconds or nanoseconds of the timestamp
+   * \param p the packet
+   */
+  void Write (uint32_t interface, uint32_t tsSec, uint32_t tsFrac, Ptr<const Packet> p);
+  /**
+   * \brief Write the next packet of an interface, preceded by a header
+   * \param interface the identifier of the interface
+   * \param tsSec the seconds of the timestamp
+   * \param tsFrac the microseconds or nanoseconds of the timestamp
+   * \param header the header, serialized before the packet
+   * \param p the packet
+   */
+  void Write (uint32_t interface, uint32_t tsSec, uint32_t tsFrac, const Header &header, Ptr<const Packet> p);
+
+  /**
+   * \brief Write the packets of an interface of a pcapng file to a pcap file
+   *
+   * The pcap file has the data link type, the snapshot length and the
+   * timestamp resolution of the interface.  Only the first section of the
+   * pcapng file is read.
+   *
+   * \param filename the name of the pcapng file
+   * \param name the name of the interface
+   * \param pcapFilename the name of the pcap file to create
+   * \returns false if the pcapng file cannot be read or has no such interface
+   */
+  static bool ExtractInterface (std::string const &filename, std::string const &name,
+                                std::string const &pcapFilename);
+
+private:
+  /// An interface of the file
+  struct Interface
+  {
+    uint32_t snapLen;   //!< The maximum number of bytes captured per packet
+    bool nanosecMode;   //!< Whether the timestamps are in nanoseconds
+  };
+
+  /**
+   * \brief Write bytes to the file
+   * \param data the bytes
+   * \param size the number of bytes
+   */
+  void WriteBytes (const void *data, uint32_t size);
+  /**
+   * \brief Write a 32-bit integer to the file
+   * \param value the integer
+   */
+  void WriteUint32 (uint32_t value);
+  /**
+   * \brief Write the beginning of an Enhanced Packet Block
+   * \param interface the identifier of the interface
+   * \param tsSec the seconds of the timestamp
+   * \param tsFrac the fraction of second of the timestamp
+   * \param totalLen the length of the packet
+   * \returns the number of bytes of the packet to write
+   */
+  uint32_t WritePacketHeader (uint32_t interface, uint32_t tsSec, uint32_t tsFrac, uint32_t totalLen);
+  /**
+   * \brief Write the end of an Enhanced Packet Block
+   * \param inclLen the number of bytes of the packet written
+   */
+  void WritePacketTrailer (uint32_t inclLen);
+
+  std::ofstream m_file;               //!< The file stream
+  std::vector<Interface> m_interfaces;  //!< The interfaces, by identifier
+  PcapBufferedWriter *m_writer;       //!< The buffers of the blocks, if any
+};
+
+} // namespace ns3
+
+#endif /* PCAPNG_FILE_H */
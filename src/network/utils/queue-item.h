@@ -215,7 +215,32 @@ public:
    */
   virtual bool Mark (void) = 0;
 
+  /**
+   * \brief Computes the hash of the packet's 5-tuple
+   *
+   * The hash is computed by DoHash the first time this method is called and
+   * then stored in the item, so that the packet headers are parsed only once
+   * even if the item is classified multiple times (e.g., by several queue
+   * discs or filters, or by CHOKe when the item is drawn as a victim). The
+   * stored hash is reused as long as the perturbation does not change.
+   *
+   * \param perturbation hash perturbation value
+   * \return the hash of the packet's 5-tuple
+   */
+  uint32_t Hash (uint32_t perturbation = 0) const;
+
 private:
+  /**
+   * \brief Computes the hash of the packet's 5-tuple
+   *
+   * Subclasses can redefine this method to return a hash of the packet's
+   * 5-tuple. The implementation of the base class returns zero.
+   *
+   * \param perturbation hash perturbation value
+   * \return the hash of the packet's 5-tuple
+   */
+  virtual uint32_t DoHash (uint32_t perturbation) const;
+
   /**
    * \brief Default constructor
    *
@@ -240,6 +265,9 @@ private:
   uint16_t m_protocol;    //!< L3 Protocol number
   uint8_t m_txq;          //!< Transmission queue index
   Time m_tstamp;          //!< timestamp when the packet was enqueued
+  mutable bool m_hashValid;             //!< True if m_hash has been computed
+  mutable uint32_t m_hashPerturbation;  //!< Perturbation used to compute m_hash
+  mutable uint32_t m_hash;              //!< Hash of the packet's 5-tuple
 };
 
 } // namespace ns3
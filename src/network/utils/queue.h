@@ -386,6 +386,31 @@ protected:
    */
   Ptr<const Item> DoPeek (ConstIterator pos) const;
 
+  /**
+   * Check whether an item can be stored without exceeding the queue limit and,
+   * if so, update the statistics and fire the Enqueue trace. This method is
+   * meant for subclasses that keep the items in their own container rather
+   * than in the list managed by this class; the caller stores the item only
+   * if true is returned.
+   * \param item the item to enqueue
+   * \return true if success, false if the packet has been dropped.
+   */
+  bool NotifyEnqueue (Ptr<Item> item);
+
+  /**
+   * Update the statistics and fire the Dequeue trace for an item extracted by
+   * a subclass from its own container.
+   * \param item the dequeued item
+   */
+  void NotifyDequeue (Ptr<Item> item);
+
+  /**
+   * Update the statistics and fire the Dequeue and drop traces for an item
+   * removed by a subclass from its own container.
+   * \param item the removed item
+   */
+  void NotifyRemove (Ptr<Item> item);
+
   /**
    * \brief Drop a packet before enqueue
    * \param item item that was dropped
@@ -471,32 +496,12 @@ Queue<Item>::DoEnqueue (ConstIterator pos, Ptr<Item> item)
 {
   NS_LOG_FUNCTION (this << item);
 
-  if (m_mode == QUEUE_MODE_PACKETS && (m_nPackets.Get () >= m_maxPackets))
-    {
-      NS_LOG_LOGIC ("Queue full (at max packets) -- dropping pkt");
-      DropBeforeEnqueue (item);
-      return false;
-    }
-
-  if (m_mode == QUEUE_MODE_BYTES && (m_nBytes.Get () + item->GetSize () > m_maxBytes))
+  if (!NotifyEnqueue (item))
     {
-      NS_LOG_LOGIC ("Queue full (packet would exceed max bytes) -- dropping pkt");
-      DropBeforeEnqueue (item);
       return false;
     }
 
   m_packets.insert (pos, item);
-
-  uint32_t size = item->GetSize ();
-  m_nBytes += size;
-  m_nTotalReceivedBytes += size;
-
-  m_nPackets++;
-  m_nTotalReceivedPackets++;
-
-  NS_LOG_LOGIC ("m_traceEnqueue (p)");
-  m_traceEnqueue (item);
-
   return true;
 }
 
@@ -517,14 +522,7 @@ Queue<Item>::DoDequeue (ConstIterator pos)
 
   if (item != 0)
     {
-      NS_ASSERT (m_nBytes.Get () >= item->GetSize ());
-      NS_ASSERT (m_nPackets.Get () > 0);
-
-      m_nBytes -= item->GetSize ();
-      m_nPackets--;
-
-      NS_LOG_LOGIC ("m_traceDequeue (p)");
-      m_traceDequeue (item);
+      NotifyDequeue (item);
     }
   return item;
 }
@@ -546,19 +544,69 @@ Queue<Item>::DoRemove (ConstIterator pos)
 
   if (item != 0)
     {
-      NS_ASSERT (m_nBytes.Get () >= item->GetSize ());
-      NS_ASSERT (m_nPackets.Get () > 0);
+      NotifyRemove (item);
+    }
+  return item;
+}
 
-      m_nBytes -= item->GetSize ();
-      m_nPackets--;
+template <typename Item>
+bool
+Queue<Item>::NotifyEnqueue (Ptr<Item> item)
+{
+  NS_LOG_FUNCTION (this << item);
 
-      // packets are first dequeued and then dropped
-      NS_LOG_LOGIC ("m_traceDequeue (p)");
-      m_traceDequeue (item);
+  if (m_mode == QUEUE_MODE_PACKETS && (m_nPackets.Get () >= m_maxPackets))
+    {
+      NS_LOG_LOGIC ("Queue full (at max packets) -- dropping pkt");
+      DropBeforeEnqueue (item);
+      return false;
+    }
 
-      DropAfterDequeue (item);
+  if (m_mode == QUEUE_MODE_BYTES && (m_nBytes.Get () + item->GetSize () > m_maxBytes))
+    {
+      NS_LOG_LOGIC ("Queue full (packet would exceed max bytes) -- dropping pkt");
+      DropBeforeEnqueue (item);
+      return false;
     }
-  return item;
+
+  uint32_t size = item->GetSize ();
+  m_nBytes += size;
+  m_nTotalReceivedBytes += size;
+
+  m_nPackets++;
+  m_nTotalReceivedPackets++;
+
+  NS_LOG_LOGIC ("m_traceEnqueue (p)");
+  m_traceEnqueue (item);
+
+  return true;
+}
+
+template <typename Item>
+void
+Queue<Item>::NotifyDequeue (Ptr<Item> item)
+{
+  NS_LOG_FUNCTION (this << item);
+
+  NS_ASSERT (m_nBytes.Get () >= item->GetSize ());
+  NS_ASSERT (m_nPackets.Get () > 0);
+
+  m_nBytes -= item->GetSize ();
+  m_nPackets--;
+
+  NS_LOG_LOGIC ("m_traceDequeue (p)");
+  m_traceDequeue (item);
+}
+
+template <typename Item>
+void
+Queue<Item>::NotifyRemove (Ptr<Item> item)
+{
+  NS_LOG_FUNCTION (this << item);
+
+  // packets are first dequeued and then dropped
+  NotifyDequeue (item);
+  DropAfterDequeue (item);
 }
 
 template <typename Item>
@@ -485,6 +485,88 @@ FqCoDelQueueDiscUDPFlowsSeparation::DoRun (void)
   Simulator::Destroy ();
 }
 
+/**
+ * This class tests that flows whose hashes collide share a flow queue
+ */
+class FqCoDelQueueDiscHashCollisions : public TestCase
+{
+public:
+  FqCoDelQueueDiscHashCollisions ();
+  virtual ~FqCoDelQueueDiscHashCollisions ();
+
+private:
+  virtual void DoRun (void);
+  void AddPacket (Ptr<FqCoDelQueueDisc> queue, Ipv4Header hdr);
+};
+
+FqCoDelQueueDiscHashCollisions::FqCoDelQueueDiscHashCollisions ()
+  : TestCase ("Test flows sharing a flow queue")
+{
+}
+
+FqCoDelQueueDiscHashCollisions::~FqCoDelQueueDiscHashCollisions ()
+{
+}
+
+void
+FqCoDelQueueDiscHashCollisions::AddPacket (Ptr<FqCoDelQueueDisc> queue, Ipv4Header hdr)
+{
+  Ptr<Packet> p = Create<Packet> (100);
+  Address dest;
+  Ptr<Ipv4QueueDiscItem> item = Create<Ipv4QueueDiscItem> (p, dest, 0, hdr);
+  queue->Enqueue (item);
+}
+
+void
+FqCoDelQueueDiscHashCollisions::DoRun (void)
+{
+  // With a single flow queue, the hashes of all the flows collide
+  Ptr<FqCoDelQueueDisc> queueDisc = CreateObjectWithAttributes<FqCoDelQueueDisc> ("Flows", UintegerValue (1));
+  Ptr<FqCoDelIpv4PacketFilter> ipv4Filter = CreateObject<FqCoDelIpv4PacketFilter> ();
+  queueDisc->AddPacketFilter (ipv4Filter);
+
+  queueDisc->SetQuantum (90);
+  queueDisc->Initialize ();
+
+  Ipv4Header hdr;
+  hdr.SetPayloadSize (100);
+  hdr.SetSource (Ipv4Address ("10.10.1.1"));
+  hdr.SetProtocol (7);
+
+  for (uint32_t i = 1; i <= 3; i++)
+    {
+      hdr.SetDestination (Ipv4Address (0x0a0a0200 + i));
+      AddPacket (queueDisc, hdr);
+    }
+  NS_TEST_ASSERT_MSG_EQ (queueDisc->GetNQueueDiscClasses (), 1, "a single flow queue should have been created");
+  NS_TEST_ASSERT_MSG_EQ (queueDisc->GetQueueDiscClass (0)->GetQueueDisc ()->GetNPackets (), 3, "unexpected number of packets in the flow queue");
+  Ptr<FqCoDelFlow> flow = StaticCast<FqCoDelFlow> (queueDisc->GetQueueDiscClass (0));
+  NS_TEST_ASSERT_MSG_EQ (flow->GetStatus (), FqCoDelFlow::NEW_FLOW, "the flow must be in the list of new flows");
+
+  // The quantum is smaller than a packet, hence the deficit of the flow is
+  // exhausted by the first dequeue and the flow is served from the list of
+  // old flows afterwards
+  NS_TEST_EXPECT_MSG_NE (queueDisc->Dequeue (), 0, "a packet should have been dequeued");
+  NS_TEST_ASSERT_MSG_EQ (flow->GetStatus (), FqCoDelFlow::NEW_FLOW, "the flow must be in the list of new flows");
+  for (uint32_t i = 2; i > 0; i--)
+    {
+      NS_TEST_EXPECT_MSG_NE (queueDisc->Dequeue (), 0, "a packet should have been dequeued");
+      NS_TEST_ASSERT_MSG_EQ (flow->GetStatus (), FqCoDelFlow::OLD_FLOW, "the flow must be in the list of old flows");
+      NS_TEST_ASSERT_MSG_EQ (flow->GetQueueDisc ()->GetNPackets (), i - 1, "unexpected number of packets in the flow queue");
+    }
+  NS_TEST_EXPECT_MSG_EQ (queueDisc->Dequeue (), 0, "no packet should have been dequeued");
+  NS_TEST_ASSERT_MSG_EQ (flow->GetStatus (), FqCoDelFlow::INACTIVE, "the flow must be inactive");
+
+  // A packet of yet another flow reactivates the same flow queue
+  hdr.SetDestination (Ipv4Address ("10.10.3.1"));
+  AddPacket (queueDisc, hdr);
+  NS_TEST_ASSERT_MSG_EQ (queueDisc->GetNQueueDiscClasses (), 1, "no other flow queue should have been created");
+  NS_TEST_ASSERT_MSG_EQ (flow->GetStatus (), FqCoDelFlow::NEW_FLOW, "the flow must be in the list of new flows");
+  NS_TEST_EXPECT_MSG_NE (queueDisc->Dequeue (), 0, "a packet should have been dequeued");
+
+  Simulator::Destroy ();
+}
+
 class FqCoDelQueueDiscTestSuite : public TestSuite
 {
 public:
@@ -499,6 +581,7 @@ FqCoDelQueueDiscTestSuite::FqCoDelQueueDiscTestSuite ()
   AddTestCase (new FqCoDelQueueDiscDeficit, TestCase::QUICK);
   AddTestCase (new FqCoDelQueueDiscTCPFlowsSeparation, TestCase::QUICK);
   AddTestCase (new FqCoDelQueueDiscUDPFlowsSeparation, TestCase::QUICK);
+  AddTestCase (new FqCoDelQueueDiscHashCollisions, TestCase::QUICK);
 }
 
 static FqCoDelQueueDiscTestSuite fqCoDelQueueDiscTestSuite;
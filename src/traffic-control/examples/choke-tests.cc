@@ -13,33 +13,29 @@ NS_LOG_COMPONENT_DEFINE ("ChokeTests");
 
 uint32_t checkTimes;
 double avgQueueSize;
-std::stringstream filePlotQueue;
-std::stringstream filePlotQueueAvg;
+std::ofstream filePlotQueue;
+std::ofstream filePlotQueueAvg;
 
 void
 CheckQueueSize (Ptr<QueueDisc> queue)
 {
-  uint32_t qSize;
-  qSize = StaticCast<ChokeQueueDisc> (queue)->GetQueueSize ();
+  uint32_t qSize = queue->GetNPackets ();
   avgQueueSize += qSize;
   checkTimes++;
 
   Simulator::Schedule (Seconds (0.01), &CheckQueueSize, queue);
 
-  std::ofstream fPlotQueue (filePlotQueue.str ().c_str (), std::ios::out | std::ios::app);
-  fPlotQueue << Simulator::Now ().GetSeconds () << " " << qSize << std::endl;
-  fPlotQueue.close ();
-
-  std::ofstream fPlotQueueAvg (filePlotQueueAvg.str ().c_str (), std::ios::out | std::ios::app);
-  fPlotQueueAvg << Simulator::Now ().GetSeconds () << " " << avgQueueSize / checkTimes << std::endl;
-  fPlotQueueAvg.close ();
+  // the files are opened once and flushed when closed at the end of the simulation
+  filePlotQueue << Simulator::Now ().GetSeconds () << " " << qSize << "\n";
+  filePlotQueueAvg << Simulator::Now ().GetSeconds () << " " << avgQueueSize / checkTimes << "\n";
 }
 
 int
 main (int argc, char *argv[])
 {
-  std::string pathOut;
+  std::string pathOut = ".";
 
+  bool verbose = false;
   bool writeForPlot = false;
   bool writePcap = true;
   bool printStats = true;
@@ -50,16 +46,20 @@ main (int argc, char *argv[])
   cmd.AddValue ("writePcap", "<0/1> to write results in pcapfile", writePcap);
   cmd.AddValue ("writeForPlot", "<0/1> to write results for plot (gnuplot)", writeForPlot);
   cmd.AddValue ("queueDiscType", "queueDiscType", queueDiscType);
+  cmd.AddValue ("printStats", "<0/1> to print the queue disc statistics", printStats);
+  cmd.AddValue ("verbose", "<0/1> to enable the logging of the queue discs", verbose);
   cmd.Parse (argc, argv);
 
   if ((queueDiscType != "RED") && (queueDiscType != "PfifoFast") && (queueDiscType != "CHOKe"))
     {
-      NS_ABORT_MSG ("Invalid queue disc type: Use --queueDiscType=RED or --queueDiscType=PfifoFast");
+      NS_ABORT_MSG ("Invalid queue disc type: Use --queueDiscType=RED, --queueDiscType=PfifoFast or --queueDiscType=CHOKe");
     }
 
-  pathOut = ".";
-  LogComponentEnable ("ChokeQueueDisc", LOG_LEVEL_INFO);
-  LogComponentEnable ("RedQueueDisc", LOG_LEVEL_INFO);
+  if (verbose)
+    {
+      LogComponentEnable ("ChokeQueueDisc", LOG_LEVEL_INFO);
+      LogComponentEnable ("RedQueueDisc", LOG_LEVEL_INFO);
+    }
 
   Config::SetDefault ("ns3::TcpL4Protocol::SocketType", StringValue ("ns3::TcpNewReno"));
   Config::SetDefault ("ns3::TcpSocket::SegmentSize", UintegerValue (1000));
@@ -171,11 +171,8 @@ main (int argc, char *argv[])
 
   if (writeForPlot)
     {
-      filePlotQueue << pathOut << "/" << "queue.plotme";
-      filePlotQueueAvg << pathOut << "/" << "queue_avg.plotme";
-
-      remove (filePlotQueue.str ().c_str ());
-      remove (filePlotQueueAvg.str ().c_str ());
+      filePlotQueue.open ((pathOut + "/queue.plotme").c_str (), std::ios::out | std::ios::trunc);
+      filePlotQueueAvg.open ((pathOut + "/queue_avg.plotme").c_str (), std::ios::out | std::ios::trunc);
       Simulator::ScheduleNow (&CheckQueueSize, q1);
     }
 
@@ -189,6 +186,12 @@ main (int argc, char *argv[])
   Simulator::Stop (Seconds (120.0));
   Simulator::Run ();
 
+  if (writeForPlot)
+    {
+      filePlotQueue.close ();
+      filePlotQueueAvg.close ();
+    }
+
   if (printStats)
     {
       QueueDisc::Stats st = q1->GetStats ();
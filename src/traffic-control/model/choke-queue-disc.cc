@@ -20,15 +20,17 @@
  */
 
 #include "ns3/log.h"
+#include "ns3/unused.h"
 #include "ns3/enum.h"
 #include "ns3/uinteger.h"
 #include "ns3/double.h"
 #include "ns3/simulator.h"
 #include "ns3/abort.h"
+#include "ns3/pointer.h"
 #include "choke-queue-disc.h"
 #include "ns3/drop-from-queue.h"
-#include "ns3/ipv4-packet-filter.h"
-#include "ns3/ipv6-packet-filter.h"
+#include <cmath>
+#include <algorithm>
 
 namespace ns3 {
 
@@ -36,6 +38,14 @@ NS_LOG_COMPONENT_DEFINE ("ChokeQueueDisc");
 
 NS_OBJECT_ENSURE_REGISTERED (ChokeQueueDisc);
 
+const uint16_t ChokeQueueDisc::UNFORCED_DROP_ID = QueueDisc::InternReason (ChokeQueueDisc::UNFORCED_DROP);
+const uint16_t ChokeQueueDisc::FORCED_DROP_ID = QueueDisc::InternReason (ChokeQueueDisc::FORCED_DROP);
+const uint16_t ChokeQueueDisc::CHOKE_DROP_ID = QueueDisc::InternReason (ChokeQueueDisc::CHOKE_DROP);
+const uint16_t ChokeQueueDisc::HOT_FLOW_DROP_ID = QueueDisc::InternReason (ChokeQueueDisc::HOT_FLOW_DROP);
+const uint16_t ChokeQueueDisc::UNFORCED_MARK_ID = QueueDisc::InternReason (ChokeQueueDisc::UNFORCED_MARK);
+const uint16_t ChokeQueueDisc::FORCED_MARK_ID = QueueDisc::InternReason (ChokeQueueDisc::FORCED_MARK);
+const uint16_t ChokeQueueDisc::RANDOM_MARK_ID = QueueDisc::InternReason (ChokeQueueDisc::RANDOM_MARK);
+
 TypeId ChokeQueueDisc::GetTypeId (void)
 {
   static TypeId tid = TypeId ("ns3::ChokeQueueDisc")
@@ -108,6 +118,34 @@ TypeId ChokeQueueDisc::GetTypeId (void)
                    BooleanValue (true),
                    MakeBooleanAccessor (&ChokeQueueDisc::m_useHardDrop),
                    MakeBooleanChecker ())
+    .AddAttribute ("NumDraws",
+                   "The number of victims drawn from the queue for each arriving packet",
+                   UintegerValue (1),
+                   MakeUintegerAccessor (&ChokeQueueDisc::m_nDraws),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("AdaptiveDraws",
+                   "True to draw from 1 to NumDraws victims as the average queue size ranges from MinTh to MaxTh",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&ChokeQueueDisc::m_adaptiveDraws),
+                   MakeBooleanChecker ())
+    .AddAttribute ("UseFlowStats",
+                   "True to keep track of the packets/bytes held by each flow and drop the "
+                   "packets of the flows holding too much buffer (xCHOKe)",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&ChokeQueueDisc::m_useFlowStats),
+                   MakeBooleanChecker ())
+    .AddAttribute ("HotFlowFactor",
+                   "If UseFlowStats is true, packets of flows holding more than this times "
+                   "their fair share of the queue are dropped",
+                   DoubleValue (2.0),
+                   MakeDoubleAccessor (&ChokeQueueDisc::m_hotFlowFactor),
+                   MakeDoubleChecker<double> (1.0))
+    .AddAttribute ("ShardGroup",
+                   "The group of CHOKe queue discs attached to the transmission queues of "
+                   "a multi-queue device, whose total queue size is averaged",
+                   PointerValue (),
+                   MakePointerAccessor (&ChokeQueueDisc::m_shards),
+                   MakePointerChecker<ChokeShardGroup> ())
    ;
 
   return tid;
@@ -119,6 +157,9 @@ ChokeQueueDisc::ChokeQueueDisc ()
   NS_LOG_FUNCTION (this);
   m_uv = CreateObject<UniformRandomVariable> ();
   m_rnd = CreateObject<UniformRandomVariable> ();
+  m_shardIndex = 0;
+  m_classes.resize (1);
+  std::fill (m_dscpClass, m_dscpClass + 64, 0);
 }
 
 ChokeQueueDisc::~ChokeQueueDisc ()
@@ -132,6 +173,8 @@ ChokeQueueDisc::DoDispose (void)
   NS_LOG_FUNCTION (this);
   m_uv = 0;
   m_rnd = 0;
+  m_queue.Reset ();
+  m_shards = 0;
   QueueDisc::DoDispose ();
 }
 
@@ -166,6 +209,49 @@ ChokeQueueDisc::SetTh (double minTh, double maxTh)
 }
 
 
+void
+ChokeQueueDisc::SetDscpClass (uint8_t dscp, double minTh, double maxTh, double matchDropProb)
+{
+  NS_LOG_FUNCTION (this << (uint16_t) dscp << minTh << maxTh << matchDropProb);
+  NS_ABORT_MSG_IF (dscp >= 64, "Invalid DSCP " << (uint16_t) dscp);
+  NS_ABORT_MSG_IF (minTh > maxTh, "The minimum threshold exceeds the maximum threshold");
+  NS_ABORT_MSG_IF (matchDropProb < 0 || matchDropProb > 1, "Invalid match drop probability");
+
+  if (m_dscpClass[dscp] == 0)
+    {
+      NS_ABORT_MSG_IF (m_classes.size () > 64, "Too many DiffServ classes");
+      m_dscpClass[dscp] = m_classes.size ();
+      m_classes.push_back (DscpClass ());
+    }
+  SetClassParams (m_classes[m_dscpClass[dscp]], minTh, maxTh, matchDropProb);
+}
+
+void
+ChokeQueueDisc::SetClassParams (DscpClass &cls, double minTh, double maxTh, double matchDropProb)
+{
+  double th_diff = (maxTh - minTh);
+  if (th_diff == 0)
+    {
+      th_diff = 1.0;
+    }
+  cls.minTh = minTh;
+  cls.maxTh = maxTh;
+  cls.matchDropProb = matchDropProb;
+  cls.vA = 1.0 / th_diff;
+  cls.vB = -minTh / th_diff;
+}
+
+const ChokeQueueDisc::DscpClass&
+ChokeQueueDisc::GetDscpClass (Ptr<const QueueDiscItem> item) const
+{
+  uint8_t dsField;
+  if (m_classes.size () == 1 || !item->GetUint8Value (QueueItem::IP_DSFIELD, dsField))
+    {
+      return m_classes[0];
+    }
+  return m_classes[m_dscpClass[dsField >> 2]];
+}
+
 int64_t
 ChokeQueueDisc::AssignStreams (int64_t stream)
 {
@@ -193,18 +279,26 @@ ChokeQueueDisc::DoEnqueue (Ptr<QueueDiscItem> item)
       nQueued = GetInternalQueue (0)->GetNPackets ();
     }
 
-  // simulate number of packets arrival during idle period
-  uint32_t m = 0;
-
-  if (m_idle == true)
+  if (m_shards != 0)
     {
-      NS_LOG_DEBUG ("CHOKe Queue Disc is idle.");
-      Time now = Simulator::Now ();
-      m = uint32_t (m_ptc * (now - m_idleTime).GetSeconds ());
-      m_idle = false;
+      // the average is computed on the total queue size of the shards
+      m_qAvg = m_shards->Estimate (m_qW, m_ptc);
     }
+  else
+    {
+      // simulate number of packets arrival during idle period
+      uint32_t m = 0;
 
-  m_qAvg = Estimator (nQueued, m + 1, m_qAvg, m_qW);
+      if (m_idle == true)
+        {
+          NS_LOG_DEBUG ("CHOKe Queue Disc is idle.");
+          Time now = Simulator::Now ();
+          m = uint32_t (m_ptc * (now - m_idleTime).GetSeconds ());
+          m_idle = false;
+        }
+
+      m_qAvg = Estimator (nQueued, m + 1, m_qAvg, m_qW);
+    }
 
   NS_LOG_DEBUG ("\t bytesInQueue  " << GetInternalQueue (0)->GetNBytes () << "\tQavg " << m_qAvg);
   NS_LOG_DEBUG ("\t packetsInQueue  " << GetInternalQueue (0)->GetNPackets () << "\tQavg " << m_qAvg);
@@ -212,28 +306,100 @@ ChokeQueueDisc::DoEnqueue (Ptr<QueueDiscItem> item)
   m_countBytes += item->GetSize ();
 
   uint32_t dropType = DTYPE_NONE;
-  if (m_qAvg >= m_minTh && nQueued > 1)
-    {
-      m_rnd->SetAttribute ("Min", DoubleValue (1));
-      m_rnd->SetAttribute ("Max", DoubleValue (nQueued - 1));
-      
-      uint32_t randompos = m_rnd->GetInteger ();
-      Ptr<Queue<QueueDiscItem> > queue =  GetInternalQueue (0);
-      Ptr<DropFromQueue<QueueDiscItem> > q = queue->GetObject<DropFromQueue<QueueDiscItem> > ();
-      Ptr<const QueueDiscItem> randomit = q->PeekAt (randompos);
-      QueueDiscItem * randomitem = const_cast<QueueDiscItem *> (GetPointer (randomit))
-
-      int32_t hash = Classify (item);
-      int32_t hashrnd = Classify (randomitem);
-      
-      if (hash == hashrnd)
+  int32_t hash = Classify (item);
+  const DscpClass &cls = GetDscpClass (item);
+  DropFromQueue<QueueDiscItem> *queue = PeekPointer (m_queue.Get ());
+  if (m_qAvg >= cls.minTh && queue->GetNPackets () > 1)
+    {
+      if (m_useFlowStats)
+        {
+          // Drop the packets of the flows holding more than their fair share
+          // of the queue, without waiting for them to be sampled
+          uint32_t held = (GetMode () == QUEUE_DISC_MODE_BYTES) ? m_flowTable.GetNBytes (hash)
+                                                                : m_flowTable.GetNPackets (hash);
+          double fairShare = static_cast<double> (nQueued) / m_flowTable.GetNFlows ();
+          if (held > m_hotFlowFactor * fairShare)
+            {
+              NS_LOG_DEBUG ("Flow " << hash << " holds " << held << " out of " << nQueued);
+              DropBeforeEnqueue (item, HOT_FLOW_DROP_ID);
+              return false;
+            }
+        }
+
+      // Draw the random victims (with replacement). Slots left empty by previous
+      // victims are squeezed out once they outnumber the queued packets, even
+      // if no packet was enqueued or dequeued since, hence less than two draws
+      // per victim are expected
+      queue->Squeeze ();
+      uint32_t nDraws = GetNDraws (cls.minTh, cls.vA);
+      if (m_drawPos.size () < nDraws)
+        {
+          m_drawPos.resize (nDraws);
+          m_drawFlow.resize (nDraws);
+          m_drawMatch.resize (nDraws);
+        }
+      uint32_t maxPos = queue->GetNSlots () - 1;
+
+      for (uint32_t i = 0; i < nDraws; i++)
         {
-          DropBeforeEnqueue (item,CHOKE_MARK);
-          q->RemoveFrom (randompos);
+          uint32_t randompos;
+          Ptr<const QueueDiscItem> randomitem;
+          do
+            {
+              randompos = m_rnd->GetInteger (1, maxPos);
+              randomitem = queue->PeekAt (randompos);
+            }
+          while (randomitem == 0);
+
+          m_drawPos[i] = randompos;
+          m_drawFlow[i] = Classify (ConstCast<QueueDiscItem> (randomitem));
+        }
+
+      // Compare the flow identifiers of all the victims at once
+      const int32_t* flows = m_drawFlow.data ();
+      uint8_t* match = m_drawMatch.data ();
+      uint32_t nMatches = 0;
+      for (uint32_t i = 0; i < nDraws; i++)
+        {
+          match[i] = (flows[i] == hash);
+          nMatches += match[i];
+        }
+
+      // The classes with a match drop probability below one spare some matches,
+      // without drawing a random number otherwise
+      if (nMatches > 0 && cls.matchDropProb < 1 && m_uv->GetValue () >= cls.matchDropProb)
+        {
+          NS_LOG_DEBUG ("Flow match spared by the class of the arriving packet");
+          nMatches = 0;
+        }
+
+      if (nMatches > 0)
+        {
+          NS_LOG_DEBUG ("Arriving packet and " << nMatches << " out of " << nDraws
+                        << " victims belong to the same flow");
+          DropBeforeEnqueue (item, CHOKE_DROP_ID);
+          // The positions of the queued packets do not change across RemoveFrom
+          // calls. The same victim may have been drawn more than once, though
+          for (uint32_t i = 0; i < nDraws; i++)
+            {
+              if (match[i] && queue->GetNSlots () > m_drawPos[i])
+                {
+                  Ptr<QueueDiscItem> victim = queue->RemoveFrom (m_drawPos[i]);
+                  if (victim != 0)
+                    {
+                      if (m_useFlowStats)
+                        {
+                          m_flowTable.Remove (hash, victim->GetSize ());
+                        }
+                      DropAfterDequeue (victim, CHOKE_DROP_ID);
+                    }
+                }
+            }
+          UpdateShardSize ();
           return false;
         }
-    
-      if (m_qAvg >= m_maxTh)
+
+      if (m_qAvg >= cls.maxTh)
         {
           NS_LOG_DEBUG ("adding DROP FORCED MARK");
           dropType = DTYPE_FORCED;
@@ -244,7 +410,7 @@ ChokeQueueDisc::DoEnqueue (Ptr<QueueDiscItem> item)
           m_countBytes = item->GetSize ();
           m_old = 1;
         }
-      else if (DropEarly (item, nQueued))
+      else if (DropEarly (item, nQueued, cls.vA, cls.vB, cls.maxTh))
         {
           NS_LOG_LOGIC ("DropEarly returns 1");
           dropType = DTYPE_UNFORCED;
@@ -258,17 +424,17 @@ ChokeQueueDisc::DoEnqueue (Ptr<QueueDiscItem> item)
     }
   if (dropType == DTYPE_UNFORCED)
     {
-      if (!m_useEcn || !Mark (item, UNFORCED_MARK))
+      if (!m_useEcn || !Mark (item, UNFORCED_MARK_ID))
         {
-          DropBeforeEnqueue (item, UNFORCED_DROP);
+          DropBeforeEnqueue (item, UNFORCED_DROP_ID);
           return false;
         }
     }
   else if (dropType == DTYPE_FORCED)
     {
-      if (m_useHardDrop || !m_useEcn || !Mark (item, FORCED_MARK))
+      if (m_useHardDrop || !m_useEcn || !Mark (item, FORCED_MARK_ID))
         {
-          DropBeforeEnqueue (item, FORCED_DROP);
+          DropBeforeEnqueue (item, FORCED_DROP_ID);
           if (m_isNs1Compat)
             {
               m_count = 0;
@@ -280,6 +446,12 @@ ChokeQueueDisc::DoEnqueue (Ptr<QueueDiscItem> item)
 
   bool retval = GetInternalQueue (0)->Enqueue (item);
 
+  if (retval && m_useFlowStats)
+    {
+      m_flowTable.Add (hash, item->GetSize ());
+    }
+  UpdateShardSize ();
+
   // If Queue::Enqueue fails, QueueDisc::Drop is called by the internal queue
   // because QueueDisc::AddInternalQueue sets the drop callback
 
@@ -311,7 +483,13 @@ ChokeQueueDisc::InitializeParams (void)
   m_vA = 1.0 / th_diff;
   m_curMaxP = 1.0 / m_lInterm;
   m_vB = -m_minTh / th_diff;
+  SetClassParams (m_classes[0], m_minTh, m_maxTh, 1.0);
   m_idleTime = NanoSeconds (0);
+  m_flowTable.Clear ();
+  if (m_shards != 0)
+    {
+      m_shardIndex = m_shards->AddShard ();
+    }
 
   NS_LOG_DEBUG ("\tm_delay " << m_linkDelay.GetSeconds () << "; m_isWait "
                              << m_isWait << "; m_qW " << m_qW << "; m_ptc " << m_ptc
@@ -326,17 +504,45 @@ ChokeQueueDisc::Estimator (uint32_t nQueued, uint32_t m, double qAvg, double qW)
 {
   NS_LOG_FUNCTION (this << nQueued << m << qAvg << qW);
 
-  double newAve = qAvg * pow (1.0 - qW, m);
-  newAve += qW * nQueued;
+  double newAve = m_estimator.Estimate (nQueued, m, qAvg, qW);
   return newAve;
 }
 
+uint32_t
+ChokeQueueDisc::GetNDraws (double minTh, double vA) const
+{
+  if (!m_adaptiveDraws)
+    {
+      return m_nDraws;
+    }
+
+  double nDraws = std::ceil ((m_qAvg - minTh) * vA * m_nDraws);
+  if (nDraws < 1)
+    {
+      return 1;
+    }
+  if (nDraws > m_nDraws)
+    {
+      return m_nDraws;
+    }
+  return static_cast<uint32_t> (nDraws);
+}
+
+void
+ChokeQueueDisc::UpdateShardSize (void)
+{
+  if (m_shards != 0)
+    {
+      m_shards->SetShardSize (m_shardIndex, GetQueueSize ());
+    }
+}
+
 // Check if packet p needs to be dropped due to probability mark
 uint32_t
-ChokeQueueDisc::DropEarly (Ptr<QueueDiscItem> item, uint32_t qSize)
+ChokeQueueDisc::DropEarly (Ptr<QueueDiscItem> item, uint32_t qSize, double vA, double vB, double maxTh)
 {
-  NS_LOG_FUNCTION (this << item << qSize);
-  m_vProb1 = CalculatePNew (m_qAvg, m_maxTh, m_vA, m_vB, m_curMaxP);
+  NS_LOG_FUNCTION (this << item << qSize << vA << vB << maxTh);
+  m_vProb1 = CalculatePNew (m_qAvg, maxTh, vA, vB, m_curMaxP);
   m_vProb = ModifyP (m_vProb1, m_count, m_countBytes, m_meanPktSize, m_isWait, item->GetSize ());
 
   // Drop probability is computed, pick random number and act
@@ -479,6 +685,11 @@ ChokeQueueDisc::DoDequeue (void)
 
       NS_LOG_LOGIC ("Popped " << item);
 
+      if (m_useFlowStats)
+        {
+          m_flowTable.Remove (Classify (item), item->GetSize ());
+        }
+
       NS_LOG_LOGIC ("Number packets " << GetInternalQueue (0)->GetNPackets ());
       NS_LOG_LOGIC ("Number bytes " << GetInternalQueue (0)->GetNBytes ());
       if (GetInternalQueue (0)->IsEmpty ())
@@ -486,10 +697,50 @@ ChokeQueueDisc::DoDequeue (void)
           m_idle = true;
           m_idleTime = Simulator::Now ();
         }
+      UpdateShardSize ();
       return item;
     }
 }
 
+uint32_t
+ChokeQueueDisc::DoDequeueBatch (std::vector<Ptr<QueueDiscItem> > &items, uint32_t maxPackets,
+                                uint32_t maxBytes)
+{
+  NS_LOG_FUNCTION (this << maxPackets << maxBytes);
+
+  Ptr<InternalQueue> queue = GetInternalQueue (0);
+  uint32_t nDequeued = 0;
+  uint32_t nBytes = 0;
+  while (nDequeued < maxPackets && nBytes < maxBytes && !queue->IsEmpty ())
+    {
+      Ptr<QueueDiscItem> item = queue->Dequeue ();
+      NS_LOG_LOGIC ("Popped " << item);
+
+      if (m_useFlowStats)
+        {
+          m_flowTable.Remove (Classify (item), item->GetSize ());
+        }
+
+      items.push_back (item);
+      nDequeued++;
+      nBytes += item->GetSize ();
+    }
+
+  NS_LOG_LOGIC ("Number packets " << queue->GetNPackets ());
+  NS_LOG_LOGIC ("Number bytes " << queue->GetNBytes ());
+
+  if (nDequeued > 0)
+    {
+      m_idle = queue->IsEmpty ();
+      if (m_idle)
+        {
+          m_idleTime = Simulator::Now ();
+        }
+      UpdateShardSize ();
+    }
+  return nDequeued;
+}
+
 Ptr<const QueueDiscItem>
 ChokeQueueDisc::DoPeek (void) const
 {
@@ -546,6 +797,12 @@ ChokeQueueDisc::CheckConfig (void)
       return false;
     }
 
+  if (!GetInternalQueue (0, m_queue))
+    {
+      NS_LOG_ERROR ("The internal queue of a ChokeQueueDisc must be a DropFromQueue");
+      return false;
+    }
+
   if ((GetInternalQueue (0)->GetMode () == QueueBase::QUEUE_MODE_PACKETS && m_mode == QUEUE_DISC_MODE_BYTES)
       || (GetInternalQueue (0)->GetMode () == QueueBase::QUEUE_MODE_BYTES && m_mode == QUEUE_DISC_MODE_PACKETS))
     {
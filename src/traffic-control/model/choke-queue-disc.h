@@ -29,6 +29,11 @@
 #include "ns3/boolean.h"
 #include "ns3/data-rate.h"
 #include "ns3/random-variable-stream.h"
+#include "ns3/drop-from-queue.h"
+#include "red-estimator.h"
+#include "flow-occupancy-table.h"
+#include "choke-shard-group.h"
+#include <vector>
 
 namespace ns3 {
 
@@ -38,6 +43,12 @@ class TraceContainer;
  * \ingroup traffic-control
  *
  * \brief A Choke packet queue disc
+ *
+ * On multi-queue devices, a CHOKe queue disc can be attached to each device
+ * transmission queue through an mq root queue disc. If such CHOKe queue discs
+ * share a ChokeShardGroup (see the ShardGroup attribute), each of them draws
+ * the victims from its own queue while the average queue size is computed on
+ * the total size of their queues.
  */
 class ChokeQueueDisc : public QueueDisc
 {
@@ -126,14 +137,43 @@ public:
    * \return the number of stream indices assigned by this model
    */
   int64_t AssignStreams (int64_t stream);
+
+  /**
+   * \brief Give the packets with the given DSCP their own CHOKe parameters
+   *
+   * All the classes share the buffer, the average queue size and the victim
+   * selection. A class only sets the thresholds compared with the average
+   * queue size when a packet of the class arrives, and the probability that
+   * the packet and its victims are dropped when they belong to the same flow.
+   * The packets whose DSCP has no class (and the non-IP packets) use MinTh
+   * and MaxTh and are always dropped on a flow match, as in plain CHOKe.
+   *
+   * \param dscp the DSCP, e.g., 46 for expedited forwarding (Ipv4Header::DSCP_EF)
+   * \param minTh the minimum threshold in bytes or packets
+   * \param maxTh the maximum threshold in bytes or packets
+   * \param matchDropProb the probability to drop on a flow match
+   */
+  void SetDscpClass (uint8_t dscp, double minTh, double maxTh, double matchDropProb);
+
   // Reasons for dropping packets
   static constexpr const char* UNFORCED_DROP = "Unforced drop";  //!< Early probability drops
   static constexpr const char* FORCED_DROP = "Forced drop";      //!< Forced drops, m_qAvg > m_maxTh
+  static constexpr const char* CHOKE_DROP = "Choke drop";        //!< Arriving packet and random victim from the same flow
+  static constexpr const char* HOT_FLOW_DROP = "Hot flow drop";  //!< Arriving packet from a flow holding too much buffer
   // Reasons for marking packets
   static constexpr const char* UNFORCED_MARK = "Unforced mark";  //!< Early probability marks
   static constexpr const char* FORCED_MARK = "Forced mark";      //!< Forced marks, m_qAvg > m_maxTh
   static constexpr const char* RANDOM_MARK = "Random mark";
 
+  // Identifiers of the reasons, to pass to the drop and mark methods
+  static const uint16_t UNFORCED_DROP_ID;  //!< Identifier of UNFORCED_DROP
+  static const uint16_t FORCED_DROP_ID;    //!< Identifier of FORCED_DROP
+  static const uint16_t CHOKE_DROP_ID;     //!< Identifier of CHOKE_DROP
+  static const uint16_t HOT_FLOW_DROP_ID;  //!< Identifier of HOT_FLOW_DROP
+  static const uint16_t UNFORCED_MARK_ID;  //!< Identifier of UNFORCED_MARK
+  static const uint16_t FORCED_MARK_ID;    //!< Identifier of FORCED_MARK
+  static const uint16_t RANDOM_MARK_ID;    //!< Identifier of RANDOM_MARK
+
 protected:
   /**
    * \brief Dispose of the object
@@ -144,6 +184,8 @@ private:
   virtual bool DoEnqueue (Ptr<QueueDiscItem> item);
   virtual Ptr<QueueDiscItem> DoDequeue (void);
   virtual Ptr<const QueueDiscItem> DoPeek (void) const;
+  virtual uint32_t DoDequeueBatch (std::vector<Ptr<QueueDiscItem> > &items, uint32_t maxPackets,
+                                   uint32_t maxBytes);
   virtual bool CheckConfig (void);
 
   /**
@@ -164,13 +206,31 @@ private:
    * \returns new average queue size
    */
   double Estimator (uint32_t nQueued, uint32_t m, double qAvg, double qW);
+  /**
+   * \brief Get the number of victims to draw for an arriving packet
+   *
+   * If AdaptiveDraws is false, NumDraws victims are drawn. Otherwise, the
+   * number of victims grows linearly from 1 to NumDraws as the average queue
+   * size ranges from the minimum to the maximum threshold.
+   * \param minTh the minimum threshold of the class of the arriving packet
+   * \param vA the vA of the class of the arriving packet
+   * \returns the number of victims to draw
+   */
+  uint32_t GetNDraws (double minTh, double vA) const;
+  /**
+   * \brief Store the queue size in the shard group, if any
+   */
+  void UpdateShardSize (void);
   /**
    * \brief Check if a packet needs to be dropped due to probability mark
    * \param item queue item
    * \param qSize queue size
+   * \param vA the vA of the class of the packet
+   * \param vB the vB of the class of the packet
+   * \param maxTh the maximum threshold of the class of the packet
    * \returns 0 for no drop/mark, 1 for drop
    */
-  uint32_t DropEarly (Ptr<QueueDiscItem> item, uint32_t qSize);
+  uint32_t DropEarly (Ptr<QueueDiscItem> item, uint32_t qSize, double vA, double vB, double maxTh);
   /**
    * \brief Returns a probability using these function parameters for the DropEarly function
    * \param qAvg Average queue length
@@ -196,6 +256,31 @@ private:
   double ModifyP (double p, uint32_t count, uint32_t countBytes,
                   uint32_t meanPktSize, bool wait, uint32_t size);
 
+  /// CHOKe parameters of a DiffServ class
+  struct DscpClass
+  {
+    double minTh;          //!< Min avg length threshold
+    double maxTh;          //!< Max avg length threshold
+    double matchDropProb;  //!< Probability to drop on a flow match
+    double vA;             //!< 1.0 / (maxTh - minTh)
+    double vB;             //!< -minTh / (maxTh - minTh)
+  };
+
+  /**
+   * \brief Set the parameters of a DiffServ class
+   * \param cls the class
+   * \param minTh the minimum threshold
+   * \param maxTh the maximum threshold
+   * \param matchDropProb the probability to drop on a flow match
+   */
+  static void SetClassParams (DscpClass &cls, double minTh, double maxTh, double matchDropProb);
+  /**
+   * \brief Get the DiffServ class of a packet
+   * \param item the packet
+   * \returns the class of the packet
+   */
+  const DscpClass& GetDscpClass (Ptr<const QueueDiscItem> item) const;
+
   // ** Variables supplied by user
   QueueDiscMode m_mode;     //!< Mode (Bytes or packets)
   uint32_t m_meanPktSize;   //!< Avg pkt size
@@ -210,6 +295,10 @@ private:
   Time m_linkDelay;         //!< Link delay
   bool m_useEcn;            //!< True if ECN is used (packets are marked instead of being dropped)
   bool m_useHardDrop;       //!< True if packets are always dropped above max threshold
+  uint32_t m_nDraws;        //!< Number of victims drawn for each arriving packet
+  bool m_adaptiveDraws;     //!< True if the number of victims depends on the average queue size
+  bool m_useFlowStats;      //!< True to keep track of the buffer held by each flow
+  double m_hotFlowFactor;   //!< Packets of flows holding more than this times their fair share are dropped
 
   // ** Variables maintained by CHOKe
   double m_vProb1;          //!< Prob. of packet drop before "count"
@@ -224,9 +313,19 @@ private:
   double m_qAvg;            //!< Average queue length
   uint32_t m_count;         //!< Number of packets since last random number generation
   Time m_idleTime;          //!< Start of current idle period
+  RedEstimator m_estimator; //!< Average queue size estimator
 
   Ptr<UniformRandomVariable> m_uv;  //!< rng stream
-  Ptr<UniformRandomVariable> m_rnd;
+  Ptr<UniformRandomVariable> m_rnd; //!< rng stream used to draw the victims
+  std::vector<uint32_t> m_drawPos;  //!< Positions of the drawn victims
+  std::vector<int32_t> m_drawFlow;  //!< Flow identifiers of the drawn victims
+  std::vector<uint8_t> m_drawMatch; //!< Whether the drawn victims belong to the flow of the arriving packet
+  FlowOccupancyTable m_flowTable;   //!< Buffer held by each flow, if UseFlowStats is true
+  ObjectHandle<DropFromQueue<QueueDiscItem> > m_queue; //!< The internal queue, resolved by CheckConfig
+  Ptr<ChokeShardGroup> m_shards;    //!< Shard group this queue disc belongs to, if any
+  uint32_t m_shardIndex;            //!< Index of this queue disc in the shard group
+  std::vector<DscpClass> m_classes; //!< DiffServ classes, class 0 being used for the DSCPs without a class
+  uint8_t m_dscpClass[64];          //!< Index of the class of each DSCP
 };
 
 }; // namespace ns3
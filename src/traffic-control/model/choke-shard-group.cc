@@ -0,0 +1,131 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2017 NITK Surathkal
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/log.h"
+#include "ns3/assert.h"
+#include "ns3/simulator.h"
+#include "choke-shard-group.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("ChokeShardGroup");
+
+NS_OBJECT_ENSURE_REGISTERED (ChokeShardGroup);
+
+TypeId ChokeShardGroup::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::ChokeShardGroup")
+    .SetParent<Object> ()
+    .SetGroupName ("TrafficControl")
+    .AddConstructor<ChokeShardGroup> ()
+  ;
+  return tid;
+}
+
+ChokeShardGroup::ChokeShardGroup ()
+  : m_size (0),
+    m_qAvg (0.0),
+    m_idle (true),
+    m_idleTime (NanoSeconds (0))
+{
+  NS_LOG_FUNCTION (this);
+}
+
+ChokeShardGroup::~ChokeShardGroup ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+ChokeShardGroup::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_sizes.clear ();
+  Object::DoDispose ();
+}
+
+uint32_t
+ChokeShardGroup::AddShard (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_sizes.push_back (0);
+  return m_sizes.size () - 1;
+}
+
+uint32_t
+ChokeShardGroup::GetNShards (void) const
+{
+  return m_sizes.size ();
+}
+
+void
+ChokeShardGroup::SetShardSize (uint32_t shard, uint32_t size)
+{
+  NS_LOG_FUNCTION (this << shard << size);
+  NS_ASSERT (shard < m_sizes.size ());
+  NS_ASSERT (m_size >= m_sizes[shard]);
+
+  m_size = m_size - m_sizes[shard] + size;
+  m_sizes[shard] = size;
+
+  if (m_size == 0 && !m_idle)
+    {
+      NS_LOG_LOGIC ("All the shards are empty");
+      m_idle = true;
+      m_idleTime = Simulator::Now ();
+    }
+}
+
+uint32_t
+ChokeShardGroup::GetShardSize (uint32_t shard) const
+{
+  NS_ASSERT (shard < m_sizes.size ());
+  return m_sizes[shard];
+}
+
+uint64_t
+ChokeShardGroup::GetSize (void) const
+{
+  return m_size;
+}
+
+double
+ChokeShardGroup::Estimate (double qW, double ptc)
+{
+  NS_LOG_FUNCTION (this << qW << ptc);
+
+  // simulate number of packets arrival during idle period
+  uint32_t m = 0;
+  if (m_idle)
+    {
+      m = uint32_t (ptc * (Simulator::Now () - m_idleTime).GetSeconds ());
+      m_idle = false;
+    }
+
+  m_qAvg = m_estimator.Estimate (m_size, m + 1, m_qAvg, qW);
+  NS_LOG_DEBUG ("Total size " << m_size << " Qavg " << m_qAvg);
+  return m_qAvg;
+}
+
+double
+ChokeShardGroup::GetAverage (void) const
+{
+  return m_qAvg;
+}
+
+} // namespace ns3
@@ -0,0 +1,109 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2017 NITK Surathkal
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef CHOKE_SHARD_GROUP_H
+#define CHOKE_SHARD_GROUP_H
+
+#include "ns3/object.h"
+#include "ns3/nstime.h"
+#include "red-estimator.h"
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \ingroup traffic-control
+ *
+ * \brief State shared by the shards of a multi-queue CHOKe
+ *
+ * A multi-queue CHOKe is made of an mq root queue disc whose children are
+ * CHOKe queue discs (the shards) sharing the same ChokeShardGroup through their
+ * ShardGroup attribute. Each shard holds the packets destined to a device
+ * transmission queue and draws its victims from its own queue, whereas the
+ * average queue size compared with the thresholds is computed on the total
+ * size of the shards.
+ *
+ * Each shard stores its queue size in its own slot of the group after every
+ * enqueue and dequeue, and the total size is updated with the difference
+ * from the previous value. Hence, the total size is available in constant
+ * time, whatever the number of shards.
+ */
+class ChokeShardGroup : public Object
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+
+  ChokeShardGroup ();
+  virtual ~ChokeShardGroup ();
+
+  /**
+   * \brief Add a shard to the group
+   * \return the index of the shard
+   */
+  uint32_t AddShard (void);
+  /**
+   * \return the number of shards
+   */
+  uint32_t GetNShards (void) const;
+  /**
+   * \brief Set the queue size of a shard
+   * \param shard the index of the shard
+   * \param size the queue size of the shard, in bytes or packets
+   */
+  void SetShardSize (uint32_t shard, uint32_t size);
+  /**
+   * \param shard the index of the shard
+   * \return the queue size of the shard
+   */
+  uint32_t GetShardSize (uint32_t shard) const;
+  /**
+   * \return the total queue size of the shards
+   */
+  uint64_t GetSize (void) const;
+  /**
+   * \brief Update the average queue size upon a packet arrival
+   * \param qW the queue weight given to the current queue size sample
+   * \param ptc the packet time constant in packets/second, used to simulate
+   *        the packet arrivals during an idle period
+   * \return the new average queue size
+   */
+  double Estimate (double qW, double ptc);
+  /**
+   * \return the average queue size
+   */
+  double GetAverage (void) const;
+
+protected:
+  virtual void DoDispose (void);
+
+private:
+  std::vector<uint32_t> m_sizes;  //!< Queue size of each shard
+  uint64_t m_size;                //!< Total queue size of the shards
+  double m_qAvg;                  //!< Average of the total queue size
+  bool m_idle;                    //!< True if all the shards are empty
+  Time m_idleTime;                //!< Start of current idle period
+  RedEstimator m_estimator;       //!< Average queue size estimator
+};
+
+} // namespace ns3
+
+#endif /* CHOKE_SHARD_GROUP_H */
@@ -26,6 +26,7 @@
 */
 
 #include "ns3/log.h"
+#include "ns3/unused.h"
 #include "ns3/enum.h"
 #include "ns3/uinteger.h"
 #include "ns3/abort.h"
@@ -68,6 +69,9 @@ static uint32_t CoDelGetTime (void)
 
 NS_OBJECT_ENSURE_REGISTERED (CoDelQueueDisc);
 
+const uint16_t CoDelQueueDisc::TARGET_EXCEEDED_DROP_ID = QueueDisc::InternReason (CoDelQueueDisc::TARGET_EXCEEDED_DROP);
+const uint16_t CoDelQueueDisc::OVERLIMIT_DROP_ID = QueueDisc::InternReason (CoDelQueueDisc::OVERLIMIT_DROP);
+
 TypeId CoDelQueueDisc::GetTypeId (void)
 {
   static TypeId tid = TypeId ("ns3::CoDelQueueDisc")
@@ -190,14 +194,14 @@ CoDelQueueDisc::DoEnqueue (Ptr<QueueDiscItem> item)
   if (m_mode == QUEUE_DISC_MODE_PACKETS && (GetInternalQueue (0)->GetNPackets () + 1 > m_maxPackets))
     {
       NS_LOG_LOGIC ("Queue full (at max packets) -- dropping pkt");
-      DropBeforeEnqueue (item, OVERLIMIT_DROP);
+      DropBeforeEnqueue (item, OVERLIMIT_DROP_ID);
       return false;
     }
 
   if (m_mode == QUEUE_DISC_MODE_BYTES && (GetInternalQueue (0)->GetNBytes () + item->GetSize () > m_maxBytes))
     {
       NS_LOG_LOGIC ("Queue full (packet would exceed max bytes) -- dropping pkt");
-      DropBeforeEnqueue (item, OVERLIMIT_DROP);
+      DropBeforeEnqueue (item, OVERLIMIT_DROP_ID);
       return false;
     }
 
@@ -298,7 +302,7 @@ CoDelQueueDisc::DoDequeue (void)
               // rates so high that the next drop should happen now,
               // hence the while loop.
               NS_LOG_LOGIC ("Sojourn time is still above target and it's time for next drop; dropping " << item);
-              DropAfterDequeue (item, TARGET_EXCEEDED_DROP);
+              DropAfterDequeue (item, TARGET_EXCEEDED_DROP_ID);
 
               ++m_count;
               NewtonStep ();
@@ -336,7 +340,7 @@ CoDelQueueDisc::DoDequeue (void)
         {
           // Drop the first packet and enter dropping state unless the queue is empty
           NS_LOG_LOGIC ("Sojourn time goes above target, dropping the first packet " << item << " and entering the dropping state");
-          DropAfterDequeue (item, TARGET_EXCEEDED_DROP);
+          DropAfterDequeue (item, TARGET_EXCEEDED_DROP_ID);
 
           item = GetInternalQueue (0)->Dequeue ();
 
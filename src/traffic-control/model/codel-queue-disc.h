@@ -133,6 +133,10 @@ public:
   static constexpr const char* TARGET_EXCEEDED_DROP = "Target exceeded drop";  //!< Sojourn time above target
   static constexpr const char* OVERLIMIT_DROP = "Overlimit drop";  //!< Overlimit dropped packet
 
+  // Identifiers of the reasons, to pass to the drop and mark methods
+  static const uint16_t TARGET_EXCEEDED_DROP_ID;  //!< Identifier of TARGET_EXCEEDED_DROP
+  static const uint16_t OVERLIMIT_DROP_ID;        //!< Identifier of OVERLIMIT_DROP
+
 private:
   friend class::CoDelQueueDiscNewtonStepTest;  // Test code
   friend class::CoDelQueueDiscControlLawTest;  // Test code
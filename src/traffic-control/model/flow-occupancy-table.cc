@@ -0,0 +1,182 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2017 NITK Surathkal
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/log.h"
+#include "ns3/assert.h"
+#include "flow-occupancy-table.h"
+#include <algorithm>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("FlowOccupancyTable");
+
+FlowOccupancyTable::FlowOccupancyTable ()
+  : m_entries (16),
+    m_shift (28),
+    m_nFlows (0)
+{
+  NS_LOG_FUNCTION (this);
+  Clear ();
+}
+
+uint32_t
+FlowOccupancyTable::Home (int32_t flow) const
+{
+  // flow identifiers may be small consecutive integers, hence they are
+  // scrambled by a multiplicative hash. Its top bits depend on all the bits
+  // of the identifier, unlike its low bits
+  return (static_cast<uint32_t> (flow) * 0x9e3779b9u) >> m_shift;
+}
+
+uint32_t
+FlowOccupancyTable::Find (int32_t flow) const
+{
+  uint32_t mask = m_entries.size () - 1;
+  uint32_t i = Home (flow);
+  while (m_entries[i].packets != 0 && m_entries[i].flow != flow)
+    {
+      i = (i + 1) & mask;
+    }
+  return i;
+}
+
+void
+FlowOccupancyTable::Add (int32_t flow, uint32_t bytes)
+{
+  NS_LOG_FUNCTION (this << flow << bytes);
+
+  if (2 * (m_nFlows + 1) > m_entries.size ())
+    {
+      Grow ();
+    }
+
+  Entry& entry = m_entries[Find (flow)];
+  if (entry.packets == 0)
+    {
+      entry.flow = flow;
+      entry.bytes = 0;
+      m_nFlows++;
+    }
+  entry.packets++;
+  entry.bytes += bytes;
+}
+
+void
+FlowOccupancyTable::Remove (int32_t flow, uint32_t bytes)
+{
+  NS_LOG_FUNCTION (this << flow << bytes);
+
+  uint32_t i = Find (flow);
+  NS_ASSERT_MSG (m_entries[i].packets > 0, "Flow " << flow << " holds no packets");
+  NS_ASSERT (m_entries[i].bytes >= bytes);
+
+  m_entries[i].bytes -= bytes;
+  if (--m_entries[i].packets > 0)
+    {
+      return;
+    }
+
+  // Shift back the entries that follow the removed one, unless their lookup
+  // would start after the hole
+  m_nFlows--;
+  uint32_t mask = m_entries.size () - 1;
+  uint32_t j = i;
+  while (true)
+    {
+      j = (j + 1) & mask;
+      if (m_entries[j].packets == 0)
+        {
+          break;
+        }
+      uint32_t home = Home (m_entries[j].flow);
+      if (((j - home) & mask) >= ((j - i) & mask))
+        {
+          m_entries[i] = m_entries[j];
+          m_entries[j].packets = 0;
+          i = j;
+        }
+    }
+}
+
+uint32_t
+FlowOccupancyTable::GetNPackets (int32_t flow) const
+{
+  return m_entries[Find (flow)].packets;
+}
+
+uint32_t
+FlowOccupancyTable::GetNBytes (int32_t flow) const
+{
+  const Entry& entry = m_entries[Find (flow)];
+  return (entry.packets > 0 ? entry.bytes : 0);
+}
+
+uint32_t
+FlowOccupancyTable::GetNFlows (void) const
+{
+  return m_nFlows;
+}
+
+void
+FlowOccupancyTable::Clear (void)
+{
+  NS_LOG_FUNCTION (this);
+  for (std::vector<Entry>::iterator it = m_entries.begin (); it != m_entries.end (); it++)
+    {
+      it->packets = 0;
+      it->bytes = 0;
+    }
+  m_nFlows = 0;
+}
+
+uint32_t
+FlowOccupancyTable::GetMaxProbeDistance (void) const
+{
+  uint32_t mask = m_entries.size () - 1;
+  uint32_t maxDistance = 0;
+  for (uint32_t i = 0; i < m_entries.size (); i++)
+    {
+      if (m_entries[i].packets > 0)
+        {
+          maxDistance = std::max (maxDistance, (i - Home (m_entries[i].flow)) & mask);
+        }
+    }
+  return maxDistance;
+}
+
+void
+FlowOccupancyTable::Grow (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  std::vector<Entry> old (2 * m_entries.size ());
+  old.swap (m_entries);
+  m_shift--;
+  Clear ();
+
+  for (std::vector<Entry>::const_iterator it = old.begin (); it != old.end (); it++)
+    {
+      if (it->packets > 0)
+        {
+          m_entries[Find (it->flow)] = *it;
+          m_nFlows++;
+        }
+    }
+}
+
+} // namespace ns3
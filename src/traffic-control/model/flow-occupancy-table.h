@@ -0,0 +1,115 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2017 NITK Surathkal
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef FLOW_OCCUPANCY_TABLE_H
+#define FLOW_OCCUPANCY_TABLE_H
+
+#include <stdint.h>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \ingroup traffic-control
+ *
+ * \brief Number of packets and bytes held by each flow in a queue
+ *
+ * The table is indexed by the flow identifier returned by the packet filters
+ * of a queue disc and is meant to be updated incrementally as packets are
+ * enqueued and removed from the queue. It is an open addressing hash table
+ * with linear probing: flows are removed as soon as they hold no packets
+ * (entries following them are shifted back, so that no tombstone is left)
+ * and the table is doubled when it gets half full. Hence, lookups, insertions
+ * and removals take constant time on average.
+ */
+class FlowOccupancyTable
+{
+public:
+  FlowOccupancyTable ();
+
+  /**
+   * \brief Account for a packet entering the queue
+   * \param flow the flow identifier
+   * \param bytes the size of the packet
+   */
+  void Add (int32_t flow, uint32_t bytes);
+  /**
+   * \brief Account for a packet leaving the queue
+   *
+   * The flow must hold at least one packet.
+   * \param flow the flow identifier
+   * \param bytes the size of the packet
+   */
+  void Remove (int32_t flow, uint32_t bytes);
+  /**
+   * \param flow the flow identifier
+   * \return the number of packets held by the flow
+   */
+  uint32_t GetNPackets (int32_t flow) const;
+  /**
+   * \param flow the flow identifier
+   * \return the number of bytes held by the flow
+   */
+  uint32_t GetNBytes (int32_t flow) const;
+  /**
+   * \return the number of flows holding at least one packet
+   */
+  uint32_t GetNFlows (void) const;
+  /**
+   * \brief Remove all the flows
+   */
+  void Clear (void);
+  /**
+   * \return the largest distance between the slot where the lookup of a
+   *         flow starts and the entry of the flow, over all the flows
+   */
+  uint32_t GetMaxProbeDistance (void) const;
+
+private:
+  /// Table entry. Entries holding no packets are empty
+  struct Entry
+  {
+    int32_t flow;      //!< the flow identifier
+    uint32_t packets;  //!< the number of packets held by the flow
+    uint32_t bytes;    //!< the number of bytes held by the flow
+  };
+
+  /**
+   * \param flow the flow identifier
+   * \return the index of the slot where the lookup of the given flow starts
+   */
+  uint32_t Home (int32_t flow) const;
+  /**
+   * \param flow the flow identifier
+   * \return the index of the entry of the given flow, or of the empty entry
+   *         where it would be inserted
+   */
+  uint32_t Find (int32_t flow) const;
+  /**
+   * \brief Double the size of the table
+   */
+  void Grow (void);
+
+  std::vector<Entry> m_entries;  //!< the entries, whose number is a power of two
+  uint32_t m_shift;              //!< 32 minus the log2 of the number of entries
+  uint32_t m_nFlows;             //!< the number of non-empty entries
+};
+
+} // namespace ns3
+
+#endif /* FLOW_OCCUPANCY_TABLE_H */
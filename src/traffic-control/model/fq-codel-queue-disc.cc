@@ -20,6 +20,7 @@
 */
 
 #include "ns3/log.h"
+#include "ns3/unused.h"
 #include "ns3/string.h"
 #include "ns3/queue.h"
 #include "fq-codel-queue-disc.h"
@@ -44,7 +45,8 @@ TypeId FqCoDelFlow::GetTypeId (void)
 
 FqCoDelFlow::FqCoDelFlow ()
   : m_deficit (0),
-    m_status (INACTIVE)
+    m_status (INACTIVE),
+    m_next (0)
 {
   NS_LOG_FUNCTION (this);
 }
@@ -92,6 +94,9 @@ FqCoDelFlow::GetStatus (void) const
 
 NS_OBJECT_ENSURE_REGISTERED (FqCoDelQueueDisc);
 
+const uint16_t FqCoDelQueueDisc::UNCLASSIFIED_DROP_ID = QueueDisc::InternReason (FqCoDelQueueDisc::UNCLASSIFIED_DROP);
+const uint16_t FqCoDelQueueDisc::OVERLIMIT_DROP_ID = QueueDisc::InternReason (FqCoDelQueueDisc::OVERLIMIT_DROP);
+
 TypeId FqCoDelQueueDisc::GetTypeId (void)
 {
   static TypeId tid = TypeId ("ns3::FqCoDelQueueDisc")
@@ -124,12 +129,15 @@ TypeId FqCoDelQueueDisc::GetTypeId (void)
                    MakeUintegerAccessor (&FqCoDelQueueDisc::m_dropBatchSize),
                    MakeUintegerChecker<uint32_t> ())
   ;
+
   return tid;
 }
 
 FqCoDelQueueDisc::FqCoDelQueueDisc ()
   : m_quantum (0)
 {
+  m_newFlows.head = m_newFlows.tail = 0;
+  m_oldFlows.head = m_oldFlows.tail = 0;
   NS_LOG_FUNCTION (this);
 }
 
@@ -138,6 +146,44 @@ FqCoDelQueueDisc::~FqCoDelQueueDisc ()
   NS_LOG_FUNCTION (this);
 }
 
+void
+FqCoDelQueueDisc::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_newFlows.head = m_newFlows.tail = 0;
+  m_oldFlows.head = m_oldFlows.tail = 0;
+  m_flowTable.clear ();
+  QueueDisc::DoDispose ();
+}
+
+void
+FqCoDelQueueDisc::PushBack (FlowList &list, FqCoDelFlow *flow)
+{
+  NS_ASSERT (flow->m_next == 0 && list.tail != flow);
+  if (list.tail)
+    {
+      list.tail->m_next = flow;
+    }
+  else
+    {
+      list.head = flow;
+    }
+  list.tail = flow;
+}
+
+void
+FqCoDelQueueDisc::PopFront (FlowList &list)
+{
+  NS_ASSERT (list.head);
+  FqCoDelFlow *flow = list.head;
+  list.head = flow->m_next;
+  if (!list.head)
+    {
+      list.tail = 0;
+    }
+  flow->m_next = 0;
+}
+
 void
 FqCoDelQueueDisc::SetQuantum (uint32_t quantum)
 {
@@ -161,39 +207,36 @@ FqCoDelQueueDisc::DoEnqueue (Ptr<QueueDiscItem> item)
   if (ret == PacketFilter::PF_NO_MATCH)
     {
       NS_LOG_ERROR ("No filter has been able to classify this packet, drop it.");
-      DropBeforeEnqueue (item, UNCLASSIFIED_DROP);
+      DropBeforeEnqueue (item, UNCLASSIFIED_DROP_ID);
       return false;
     }
 
   uint32_t h = ret % m_flows;
 
-  Ptr<FqCoDelFlow> flow;
-  if (m_flowsIndices.find (h) == m_flowsIndices.end ())
+  FqCoDelFlow *flow = m_flowTable[h];
+  if (!flow)
     {
       NS_LOG_DEBUG ("Creating a new flow queue with index " << h);
-      flow = m_flowFactory.Create<FqCoDelFlow> ();
+      Ptr<FqCoDelFlow> newFlow = m_flowFactory.Create<FqCoDelFlow> ();
       Ptr<QueueDisc> qd = m_queueDiscFactory.Create<QueueDisc> ();
       qd->Initialize ();
-      flow->SetQueueDisc (qd);
-      AddQueueDiscClass (flow);
+      newFlow->SetQueueDisc (qd);
+      AddQueueDiscClass (newFlow);
 
-      m_flowsIndices[h] = GetNQueueDiscClasses () - 1;
-    }
-  else
-    {
-      flow = StaticCast<FqCoDelFlow> (GetQueueDiscClass (m_flowsIndices[h]));
+      // the queue disc keeps a reference to the flow until it is disposed of
+      flow = m_flowTable[h] = PeekPointer (newFlow);
     }
 
   if (flow->GetStatus () == FqCoDelFlow::INACTIVE)
     {
       flow->SetStatus (FqCoDelFlow::NEW_FLOW);
       flow->SetDeficit (m_quantum);
-      m_newFlows.push_back (flow);
+      PushBack (m_newFlows, flow);
     }
 
   flow->GetQueueDisc ()->Enqueue (item);
 
-  NS_LOG_DEBUG ("Packet enqueued into flow " << h << "; flow index " << m_flowsIndices[h]);
+  NS_LOG_DEBUG ("Packet enqueued into flow " << h);
 
   if (GetNPackets () > m_limit)
     {
@@ -208,23 +251,23 @@ FqCoDelQueueDisc::DoDequeue (void)
 {
   NS_LOG_FUNCTION (this);
 
-  Ptr<FqCoDelFlow> flow;
+  FqCoDelFlow *flow = 0;
   Ptr<QueueDiscItem> item;
 
   do
     {
       bool found = false;
 
-      while (!found && !m_newFlows.empty ())
+      while (!found && m_newFlows.head)
         {
-          flow = m_newFlows.front ();
+          flow = m_newFlows.head;
 
           if (flow->GetDeficit () <= 0)
             {
               flow->IncreaseDeficit (m_quantum);
               flow->SetStatus (FqCoDelFlow::OLD_FLOW);
-              m_oldFlows.push_back (flow);
-              m_newFlows.pop_front ();
+              PopFront (m_newFlows);
+              PushBack (m_oldFlows, flow);
             }
           else
             {
@@ -233,15 +276,15 @@ FqCoDelQueueDisc::DoDequeue (void)
             }
         }
 
-      while (!found && !m_oldFlows.empty ())
+      while (!found && m_oldFlows.head)
         {
-          flow = m_oldFlows.front ();
+          flow = m_oldFlows.head;
 
           if (flow->GetDeficit () <= 0)
             {
               flow->IncreaseDeficit (m_quantum);
-              m_oldFlows.push_back (flow);
-              m_oldFlows.pop_front ();
+              PopFront (m_oldFlows);
+              PushBack (m_oldFlows, flow);
             }
           else
             {
@@ -261,16 +304,16 @@ FqCoDelQueueDisc::DoDequeue (void)
       if (!item)
         {
           NS_LOG_DEBUG ("Could not get a packet from the selected flow queue");
-          if (!m_newFlows.empty ())
+          if (m_newFlows.head)
             {
               flow->SetStatus (FqCoDelFlow::OLD_FLOW);
-              m_oldFlows.push_back (flow);
-              m_newFlows.pop_front ();
+              PopFront (m_newFlows);
+              PushBack (m_oldFlows, flow);
             }
           else
             {
               flow->SetStatus (FqCoDelFlow::INACTIVE);
-              m_oldFlows.pop_front ();
+              PopFront (m_oldFlows);
             }
         }
       else
@@ -289,17 +332,17 @@ FqCoDelQueueDisc::DoPeek (void) const
 {
   NS_LOG_FUNCTION (this);
 
-  Ptr<FqCoDelFlow> flow;
+  FqCoDelFlow *flow;
 
-  if (!m_newFlows.empty ())
+  if (m_newFlows.head)
     {
-      flow = m_newFlows.front ();
+      flow = m_newFlows.head;
     }
   else
     {
-      if (!m_oldFlows.empty ())
+      if (m_oldFlows.head)
         {
-          flow = m_oldFlows.front ();
+          flow = m_oldFlows.head;
         }
       else
         {
@@ -332,6 +375,12 @@ FqCoDelQueueDisc::CheckConfig (void)
       return false;
     }
 
+  if (m_flows == 0)
+    {
+      NS_LOG_ERROR ("FqCoDelQueueDisc needs at least a flow queue");
+      return false;
+    }
+
   return true;
 }
 
@@ -357,6 +406,10 @@ FqCoDelQueueDisc::InitializeParams (void)
   m_queueDiscFactory.Set ("MaxPackets", UintegerValue (m_limit + 1));
   m_queueDiscFactory.Set ("Interval", StringValue (m_interval));
   m_queueDiscFactory.Set ("Target", StringValue (m_target));
+
+  // the flow queues are created on demand, but the table mapping flow hashes
+  // to flow queues is allocated once and for all
+  m_flowTable.assign (m_flows, 0);
 }
 
 uint32_t
@@ -387,7 +440,7 @@ FqCoDelQueueDisc::FqCoDelDrop (void)
   do
     {
       item = qd->GetInternalQueue (0)->Dequeue ();
-      DropAfterDequeue (item, OVERLIMIT_DROP);
+      DropAfterDequeue (item, OVERLIMIT_DROP_ID);
       len += item->GetSize ();
     } while (++count < m_dropBatchSize && len < threshold);
 
@@ -24,8 +24,7 @@
 
 #include "ns3/queue-disc.h"
 #include "ns3/object-factory.h"
-#include <list>
-#include <map>
+#include <vector>
 
 namespace ns3 {
 
@@ -87,8 +86,11 @@ public:
   FlowStatus GetStatus (void) const;
 
 private:
+  friend class FqCoDelQueueDisc;
+
   int32_t m_deficit;    //!< the deficit for this flow
   FlowStatus m_status;  //!< the status of this flow
+  FqCoDelFlow *m_next;  //!< the next flow in the list of new or old flows
 };
 
 
@@ -130,7 +132,41 @@ public:
   static constexpr const char* UNCLASSIFIED_DROP = "Unclassified drop";  //!< No packet filter able to classify packet
   static constexpr const char* OVERLIMIT_DROP = "Overlimit drop";        //!< Overlimit dropped packets
 
+  // Identifiers of the reasons, to pass to the drop and mark methods
+  static const uint16_t UNCLASSIFIED_DROP_ID;  //!< Identifier of UNCLASSIFIED_DROP
+  static const uint16_t OVERLIMIT_DROP_ID;     //!< Identifier of OVERLIMIT_DROP
+
+protected:
+  /**
+   * \brief Dispose of the object
+   */
+  virtual void DoDispose (void);
+
 private:
+  /**
+   * \brief List of flows linked through FqCoDelFlow::m_next
+   *
+   * The flows are owned by the queue disc (as its classes), hence the lists
+   * only store plain pointers and adding or removing a flow never allocates.
+   */
+  struct FlowList
+  {
+    FqCoDelFlow *head;  //!< the first flow in the list
+    FqCoDelFlow *tail;  //!< the last flow in the list
+  };
+
+  /**
+   * \brief Append a flow to a list of flows
+   * \param list the list
+   * \param flow the flow, which must not belong to any list
+   */
+  static void PushBack (FlowList &list, FqCoDelFlow *flow);
+  /**
+   * \brief Remove the first flow of a non-empty list of flows
+   * \param list the list
+   */
+  static void PopFront (FlowList &list);
+
   virtual bool DoEnqueue (Ptr<QueueDiscItem> item);
   virtual Ptr<QueueDiscItem> DoDequeue (void);
   virtual Ptr<const QueueDiscItem> DoPeek (void) const;
@@ -150,10 +186,10 @@ private:
   uint32_t m_flows;          //!< Number of flow queues
   uint32_t m_dropBatchSize;  //!< Max number of packets dropped from the fat flow
 
-  std::list<Ptr<FqCoDelFlow> > m_newFlows;    //!< The list of new flows
-  std::list<Ptr<FqCoDelFlow> > m_oldFlows;    //!< The list of old flows
+  FlowList m_newFlows;    //!< The list of new flows
+  FlowList m_oldFlows;    //!< The list of old flows
 
-  std::map<uint32_t, uint32_t> m_flowsIndices;    //!< Map with the index of class for each flow
+  std::vector<FqCoDelFlow *> m_flowTable;    //!< The flow queue (if created) for each flow hash
 
   ObjectFactory m_flowFactory;         //!< Factory to create a new flow
   ObjectFactory m_queueDiscFactory;    //!< Factory to create a new queue
@@ -21,6 +21,7 @@
  */
 
 #include "ns3/log.h"
+#include "ns3/unused.h"
 #include "ns3/object-factory.h"
 #include "ns3/queue.h"
 #include "ns3/net-device-queue-interface.h"
@@ -33,6 +34,8 @@ NS_LOG_COMPONENT_DEFINE ("PfifoFastQueueDisc");
 
 NS_OBJECT_ENSURE_REGISTERED (PfifoFastQueueDisc);
 
+const uint16_t PfifoFastQueueDisc::LIMIT_EXCEEDED_DROP_ID = QueueDisc::InternReason (PfifoFastQueueDisc::LIMIT_EXCEEDED_DROP);
+
 TypeId PfifoFastQueueDisc::GetTypeId (void)
 {
   static TypeId tid = TypeId ("ns3::PfifoFastQueueDisc")
@@ -45,6 +48,7 @@ TypeId PfifoFastQueueDisc::GetTypeId (void)
                    MakeUintegerAccessor (&PfifoFastQueueDisc::m_limit),
                    MakeUintegerChecker<uint32_t> ())
   ;
+
   return tid;
 }
 
@@ -68,7 +72,7 @@ PfifoFastQueueDisc::DoEnqueue (Ptr<QueueDiscItem> item)
   if (GetNPackets () >= m_limit)
     {
       NS_LOG_LOGIC ("Queue disc limit exceeded -- dropping packet");
-      DropBeforeEnqueue (item, LIMIT_EXCEEDED_DROP);
+      DropBeforeEnqueue (item, LIMIT_EXCEEDED_DROP_ID);
       return false;
     }
 
@@ -112,6 +116,35 @@ PfifoFastQueueDisc::DoDequeue (void)
   return item;
 }
 
+uint32_t
+PfifoFastQueueDisc::DoDequeueBatch (std::vector<Ptr<QueueDiscItem> > &items, uint32_t maxPackets,
+                                    uint32_t maxBytes)
+{
+  NS_LOG_FUNCTION (this << maxPackets << maxBytes);
+
+  // no packet can be enqueued while dequeuing, hence the bands emptied
+  // need not be visited again
+  uint32_t nDequeued = 0;
+  uint32_t nBytes = 0;
+  uint32_t band = 0;
+  while (nDequeued < maxPackets && nBytes < maxBytes && band < GetNInternalQueues ())
+    {
+      Ptr<QueueDiscItem> item = GetInternalQueue (band)->Dequeue ();
+      if (item == 0)
+        {
+          band++;
+          continue;
+        }
+      NS_LOG_LOGIC ("Popped from band " << band << ": " << item);
+      items.push_back (item);
+      nDequeued++;
+      nBytes += item->GetSize ();
+    }
+
+  NS_LOG_LOGIC ("Dequeued " << nDequeued << " packets, " << nBytes << " bytes");
+  return nDequeued;
+}
+
 Ptr<const QueueDiscItem>
 PfifoFastQueueDisc::DoPeek (void) const
 {
@@ -133,6 +166,14 @@ PfifoFastQueueDisc::DoPeek (void) const
   return item;
 }
 
+bool
+PfifoFastQueueDisc::CanBypass (void) const
+{
+  // as in Linux, a packet sent to an empty pfifo_fast queue disc can be
+  // passed to the device right away
+  return true;
+}
+
 bool
 PfifoFastQueueDisc::CheckConfig (void)
 {
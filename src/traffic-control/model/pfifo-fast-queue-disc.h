@@ -65,6 +65,9 @@ public:
   // Reasons for dropping packets
   static constexpr const char* LIMIT_EXCEEDED_DROP = "Queue disc limit exceeded";  //!< Packet dropped due to queue disc limit exceeded
 
+  // Identifiers of the reasons, to pass to the drop and mark methods
+  static const uint16_t LIMIT_EXCEEDED_DROP_ID;  //!< Identifier of LIMIT_EXCEEDED_DROP
+
 private:
   /**
    * Priority to band map. Values are taken from the prio2band array used by
@@ -75,6 +78,9 @@ private:
   virtual bool DoEnqueue (Ptr<QueueDiscItem> item);
   virtual Ptr<QueueDiscItem> DoDequeue (void);
   virtual Ptr<const QueueDiscItem> DoPeek (void) const;
+  virtual uint32_t DoDequeueBatch (std::vector<Ptr<QueueDiscItem> > &items, uint32_t maxPackets,
+                                   uint32_t maxBytes);
+  virtual bool CanBypass (void) const;
   virtual bool CheckConfig (void);
   virtual void InitializeParams (void);
 
@@ -26,6 +26,7 @@
  */
 
 #include "ns3/log.h"
+#include "ns3/unused.h"
 #include "ns3/enum.h"
 #include "ns3/uinteger.h"
 #include "ns3/double.h"
@@ -41,6 +42,9 @@ NS_LOG_COMPONENT_DEFINE ("PieQueueDisc");
 
 NS_OBJECT_ENSURE_REGISTERED (PieQueueDisc);
 
+const uint16_t PieQueueDisc::UNFORCED_DROP_ID = QueueDisc::InternReason (PieQueueDisc::UNFORCED_DROP);
+const uint16_t PieQueueDisc::FORCED_DROP_ID = QueueDisc::InternReason (PieQueueDisc::FORCED_DROP);
+
 TypeId PieQueueDisc::GetTypeId (void)
 {
   static TypeId tid = TypeId ("ns3::PieQueueDisc")
@@ -190,13 +194,13 @@ PieQueueDisc::DoEnqueue (Ptr<QueueDiscItem> item)
       || (GetMode () == QUEUE_DISC_MODE_BYTES && nQueued + item->GetSize () > m_queueLimit))
     {
       // Drops due to queue limit: reactive
-      DropBeforeEnqueue (item, FORCED_DROP);
+      DropBeforeEnqueue (item, FORCED_DROP_ID);
       return false;
     }
   else if (DropEarly (item, nQueued))
     {
       // Early probability drop: proactive
-      DropBeforeEnqueue (item, UNFORCED_DROP);
+      DropBeforeEnqueue (item, UNFORCED_DROP_ID);
       return false;
     }
 
@@ -136,6 +136,10 @@ public:
   static constexpr const char* UNFORCED_DROP = "Unforced drop";  //!< Early probability drops: proactive
   static constexpr const char* FORCED_DROP = "Forced drop";      //!< Drops due to queue limit: reactive
 
+  // Identifiers of the reasons, to pass to the drop and mark methods
+  static const uint16_t UNFORCED_DROP_ID;  //!< Identifier of UNFORCED_DROP
+  static const uint16_t FORCED_DROP_ID;    //!< Identifier of FORCED_DROP
+
 protected:
   /**
    * \brief Dispose of the object
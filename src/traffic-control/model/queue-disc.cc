@@ -28,7 +28,11 @@
 #include "ns3/simulator.h"
 #include "queue-disc.h"
 #include <ns3/drop-tail-queue.h>
+#include <ns3/drop-from-queue.h>
 #include "ns3/net-device-queue-interface.h"
+#include "ns3/queue-limits.h"
+#include <algorithm>
+#include <cstring>
 
 namespace ns3 {
 
@@ -88,6 +92,96 @@ QueueDiscClass::SetQueueDisc (Ptr<QueueDisc> qd)
   m_queueDisc = qd;
 }
 
+namespace {
+
+/**
+ * \ingroup traffic-control
+ *
+ * Registry of the reasons to drop or mark packets. Identifiers are assigned in
+ * order of registration and never released. A small direct-mapped cache indexed
+ * by the address of the reason speeds up the lookup of string literals.
+ */
+struct ReasonRegistry
+{
+  /// Entry of the cache
+  struct CacheEntry
+  {
+    const char* reason;  //!< the address of the reason
+    uint16_t id;         //!< the identifier of the reason
+  };
+
+  static const uint32_t CACHE_SIZE = 64;                //!< Number of cache entries (a power of two)
+  std::map<std::string, uint16_t> ids;                  //!< Identifier of each reason
+  std::vector<const std::string*> names;                //!< Reason of each identifier
+  CacheEntry cache[CACHE_SIZE];                         //!< Cached identifiers
+};
+
+/**
+ * \return the registry of the reasons
+ */
+ReasonRegistry&
+GetReasonRegistry (void)
+{
+  static ReasonRegistry registry = ReasonRegistry ();
+  return registry;
+}
+
+/**
+ * \brief Get the identifier of a reason without interning it
+ * \param reason the reason
+ * \param id set to the identifier of the reason, if found
+ * \return true if the reason was found
+ */
+bool
+FindReason (const std::string &reason, uint16_t &id)
+{
+  ReasonRegistry &registry = GetReasonRegistry ();
+  std::map<std::string, uint16_t>::const_iterator it = registry.ids.find (reason);
+  if (it == registry.ids.end ())
+    {
+      return false;
+    }
+  id = it->second;
+  return true;
+}
+
+} // unnamed namespace
+
+uint16_t
+QueueDisc::InternReason (const char* reason)
+{
+  ReasonRegistry &registry = GetReasonRegistry ();
+  ReasonRegistry::CacheEntry &entry = registry.cache[(reinterpret_cast<uintptr_t> (reason) >> 3)
+                                                     & (ReasonRegistry::CACHE_SIZE - 1)];
+
+  // the content is checked as well, because the address may have been reused
+  if (entry.reason == reason && std::strcmp (registry.names[entry.id]->c_str (), reason) == 0)
+    {
+      return entry.id;
+    }
+
+  std::pair<std::map<std::string, uint16_t>::iterator, bool> ret;
+  ret = registry.ids.insert (std::make_pair (std::string (reason), registry.names.size ()));
+  if (ret.second)
+    {
+      NS_ABORT_MSG_IF (registry.names.size () > std::numeric_limits<uint16_t>::max (),
+                       "Too many reasons to drop or mark packets");
+      registry.names.push_back (&ret.first->first);
+    }
+
+  entry.reason = reason;
+  entry.id = ret.first->second;
+  return entry.id;
+}
+
+const std::string&
+QueueDisc::GetReasonName (uint16_t id)
+{
+  ReasonRegistry &registry = GetReasonRegistry ();
+  NS_ASSERT (id < registry.names.size ());
+  return *registry.names[id];
+}
+
 QueueDisc::Stats::Stats ()
   : nTotalReceivedPackets (0),
     nTotalReceivedBytes (0),
@@ -113,69 +207,89 @@ QueueDisc::Stats::Stats ()
 uint32_t
 QueueDisc::Stats::GetNDroppedPackets (std::string reason) const
 {
-  uint32_t count = 0;
-  auto it = nDroppedPacketsBeforeEnqueue.find (reason);
-
-  if (it != nDroppedPacketsBeforeEnqueue.end ())
+  uint16_t id;
+  if (!FindReason (reason, id) || id >= reasonCounters.size ())
     {
-      count += it->second;
+      return 0;
     }
-
-  it = nDroppedPacketsAfterDequeue.find (reason);
-
-  if (it != nDroppedPacketsAfterDequeue.end ())
-    {
-      count += it->second;
-    }
-
-  return count;
+  return reasonCounters[id].nDroppedPacketsBeforeEnqueue + reasonCounters[id].nDroppedPacketsAfterDequeue;
 }
 
 uint64_t
 QueueDisc::Stats::GetNDroppedBytes (std::string reason) const
 {
-  uint64_t count = 0;
-  auto it = nDroppedBytesBeforeEnqueue.find (reason);
-
-  if (it != nDroppedBytesBeforeEnqueue.end ())
-    {
-      count += it->second;
-    }
-
-  it = nDroppedBytesAfterDequeue.find (reason);
-
-  if (it != nDroppedBytesAfterDequeue.end ())
+  uint16_t id;
+  if (!FindReason (reason, id) || id >= reasonCounters.size ())
     {
-      count += it->second;
+      return 0;
     }
-
-  return count;
+  return reasonCounters[id].nDroppedBytesBeforeEnqueue + reasonCounters[id].nDroppedBytesAfterDequeue;
 }
 
 uint32_t
 QueueDisc::Stats::GetNMarkedPackets (std::string reason) const
 {
-  auto it = nMarkedPackets.find (reason);
-
-  if (it != nMarkedPackets.end ())
+  uint16_t id;
+  if (!FindReason (reason, id) || id >= reasonCounters.size ())
     {
-      return it->second;
+      return 0;
     }
-
-  return 0;
+  return reasonCounters[id].nMarkedPackets;
 }
 
 uint64_t
 QueueDisc::Stats::GetNMarkedBytes (std::string reason) const
 {
-  auto it = nMarkedBytes.find (reason);
+  uint16_t id;
+  if (!FindReason (reason, id) || id >= reasonCounters.size ())
+    {
+      return 0;
+    }
+  return reasonCounters[id].nMarkedBytes;
+}
 
-  if (it != nMarkedBytes.end ())
+QueueDisc::Stats::ReasonCounters&
+QueueDisc::Stats::GetReasonCounters (uint16_t id)
+{
+  if (id >= reasonCounters.size ())
     {
-      return it->second;
+      ReasonCounters zero = ReasonCounters ();
+      reasonCounters.resize (id + 1, zero);
     }
+  return reasonCounters[id];
+}
 
-  return 0;
+void
+QueueDisc::Stats::UpdateReasonMaps (void)
+{
+  nDroppedPacketsBeforeEnqueue.clear ();
+  nDroppedBytesBeforeEnqueue.clear ();
+  nDroppedPacketsAfterDequeue.clear ();
+  nDroppedBytesAfterDequeue.clear ();
+  nMarkedPackets.clear ();
+  nMarkedBytes.clear ();
+
+  // only the reasons for which packets were dropped or marked appear in the maps
+  for (uint16_t id = 0; id < reasonCounters.size (); id++)
+    {
+      const ReasonCounters &counters = reasonCounters[id];
+      const std::string &reason = GetReasonName (id);
+      if (counters.nDroppedPacketsBeforeEnqueue > 0)
+        {
+          nDroppedPacketsBeforeEnqueue[reason] = counters.nDroppedPacketsBeforeEnqueue;
+          nDroppedBytesBeforeEnqueue[reason] = counters.nDroppedBytesBeforeEnqueue;
+        }
+      if (counters.nDroppedPacketsAfterDequeue > 0)
+        {
+          nDroppedPacketsAfterDequeue[reason] = counters.nDroppedPacketsAfterDequeue;
+          nDroppedBytesAfterDequeue[reason] = counters.nDroppedBytesAfterDequeue;
+        }
+      if (counters.nMarkedPackets > 0)
+        {
+          nMarkedPackets[reason] = counters.nMarkedPackets;
+          nMarkedBytes[reason] = counters.nMarkedBytes;
+        }
+    }
 }
 
 void
@@ -264,6 +378,8 @@ std::ostream & operator << (std::ostream &os, const QueueDisc::Stats &stats)
 
 NS_OBJECT_ENSURE_REGISTERED (QueueDisc);
 
+const uint16_t QueueDisc::INTERNAL_QUEUE_DROP_ID = QueueDisc::InternReason (QueueDisc::INTERNAL_QUEUE_DROP);
+
 TypeId QueueDisc::GetTypeId (void)
 {
   static TypeId tid = TypeId ("ns3::QueueDisc")
@@ -338,11 +454,11 @@ QueueDisc::QueueDisc ()
   // why the packet is dropped.
   m_internalQueueDbeFunctor = [this] (Ptr<const QueueDiscItem> item)
     {
-      return DropBeforeEnqueue (item, INTERNAL_QUEUE_DROP);
+      return DropBeforeEnqueue (item, INTERNAL_QUEUE_DROP_ID);
     };
   m_internalQueueDadFunctor = [this] (Ptr<const QueueDiscItem> item)
     {
-      return DropAfterDequeue (item, INTERNAL_QUEUE_DROP);
+      return DropAfterDequeue (item, INTERNAL_QUEUE_DROP_ID);
     };
 
   // These lambdas call the DropBeforeEnqueue or DropAfterDequeue methods of this
@@ -353,13 +469,11 @@ QueueDisc::QueueDisc ()
   // the packet is dropped.
   m_childQueueDiscDbeFunctor = [this] (Ptr<const QueueDiscItem> item, const char* r)
     {
-      return DropBeforeEnqueue (item,
-                                m_childQueueDiscDropMsg.assign (CHILD_QUEUE_DISC_DROP).append (r).data ());
+      return DropBeforeEnqueue (item, GetChildDropReason (r));
     };
   m_childQueueDiscDadFunctor = [this] (Ptr<const QueueDiscItem> item, const char* r)
     {
-      return DropAfterDequeue (item,
-                               m_childQueueDiscDropMsg.assign (CHILD_QUEUE_DISC_DROP).append (r).data ());
+      return DropAfterDequeue (item, GetChildDropReason (r));
     };
 }
 
@@ -377,7 +491,8 @@ QueueDisc::DoDispose (void)
   m_classes.clear ();
   m_device = 0;
   m_devQueueIface = 0;
-  m_requeued = 0;
+  m_requeued.clear ();
+  m_burst.clear ();
   Object::DoDispose ();
 }
 
@@ -419,11 +534,18 @@ QueueDisc::GetStats (void)
   // the total number of sent packets is only updated here to avoid to increase it
   // after a dequeue and then having to decrease it if the packet is dropped after
   // dequeue or requeued
-  m_stats.nTotalSentPackets = m_stats.nTotalDequeuedPackets - (m_requeued ? 1 : 0)
+  uint64_t requeuedBytes = 0;
+  for (std::deque<Ptr<QueueDiscItem> >::const_iterator it = m_requeued.begin (); it != m_requeued.end (); it++)
+    {
+      requeuedBytes += (*it)->GetSize ();
+    }
+  m_stats.nTotalSentPackets = m_stats.nTotalDequeuedPackets - m_requeued.size ()
                               - m_stats.nTotalDroppedPacketsAfterDequeue;
-  m_stats.nTotalSentBytes = m_stats.nTotalDequeuedBytes - (m_requeued ? m_requeued->GetSize () : 0)
+  m_stats.nTotalSentBytes = m_stats.nTotalDequeuedBytes - requeuedBytes
                             - m_stats.nTotalDroppedBytesAfterDequeue;
 
+  m_stats.UpdateReasonMaps ();
+
   return m_stats;
 }
 
@@ -607,87 +729,84 @@ QueueDisc::PacketDequeued (Ptr<const QueueDiscItem> item)
 }
 
 void
-QueueDisc::DropBeforeEnqueue (Ptr<const QueueDiscItem> item, const char* reason)
+QueueDisc::DropBeforeEnqueue (Ptr<const QueueDiscItem> item, uint16_t reason)
 {
-  NS_LOG_FUNCTION (this << item << reason);
+  NS_LOG_FUNCTION (this << item << GetReasonName (reason));
 
   m_stats.nTotalDroppedPackets++;
   m_stats.nTotalDroppedBytes += item->GetSize ();
   m_stats.nTotalDroppedPacketsBeforeEnqueue++;
   m_stats.nTotalDroppedBytesBeforeEnqueue += item->GetSize ();
 
-  // update the number of packets dropped for the given reason
-  std::map<std::string, uint32_t>::iterator itp = m_stats.nDroppedPacketsBeforeEnqueue.find (reason);
-  if (itp != m_stats.nDroppedPacketsBeforeEnqueue.end ())
-    {
-      itp->second++;
-    }
-  else
-    {
-      m_stats.nDroppedPacketsBeforeEnqueue[reason] = 1;
-    }
-  // update the amount of bytes dropped for the given reason
-  std::map<std::string, uint64_t>::iterator itb = m_stats.nDroppedBytesBeforeEnqueue.find (reason);
-  if (itb != m_stats.nDroppedBytesBeforeEnqueue.end ())
-    {
-      itb->second += item->GetSize ();
-    }
-  else
-    {
-      m_stats.nDroppedBytesBeforeEnqueue[reason] = item->GetSize ();
-    }
+  // update the number of packets and bytes dropped for the given reason
+  Stats::ReasonCounters &counters = m_stats.GetReasonCounters (reason);
+  counters.nDroppedPacketsBeforeEnqueue++;
+  counters.nDroppedBytesBeforeEnqueue += item->GetSize ();
 
   NS_LOG_DEBUG ("Total packets/bytes dropped before enqueue: "
                 << m_stats.nTotalDroppedPacketsBeforeEnqueue << " / "
                 << m_stats.nTotalDroppedBytesBeforeEnqueue);
   NS_LOG_LOGIC ("m_traceDropBeforeEnqueue (p)");
   m_traceDrop (item);
-  m_traceDropBeforeEnqueue (item, reason);
+  // the reasons held by the registry are never released
+  m_traceDropBeforeEnqueue (item, GetReasonName (reason).c_str ());
 }
 
 void
-QueueDisc::DropAfterDequeue (Ptr<const QueueDiscItem> item, const char* reason)
+QueueDisc::DropBeforeEnqueue (Ptr<const QueueDiscItem> item, const char* reason)
+{
+  DropBeforeEnqueue (item, InternReason (reason));
+}
+
+void
+QueueDisc::DropAfterDequeue (Ptr<const QueueDiscItem> item, uint16_t reason)
 {
-  NS_LOG_FUNCTION (this << item << reason);
+  NS_LOG_FUNCTION (this << item << GetReasonName (reason));
 
   m_stats.nTotalDroppedPackets++;
   m_stats.nTotalDroppedBytes += item->GetSize ();
   m_stats.nTotalDroppedPacketsAfterDequeue++;
   m_stats.nTotalDroppedBytesAfterDequeue += item->GetSize ();
 
-  // update the number of packets dropped for the given reason
-  std::map<std::string, uint32_t>::iterator itp = m_stats.nDroppedPacketsAfterDequeue.find (reason);
-  if (itp != m_stats.nDroppedPacketsAfterDequeue.end ())
-    {
-      itp->second++;
-    }
-  else
-    {
-      m_stats.nDroppedPacketsAfterDequeue[reason] = 1;
-    }
-  // update the amount of bytes dropped for the given reason
-  std::map<std::string, uint64_t>::iterator itb = m_stats.nDroppedBytesAfterDequeue.find (reason);
-  if (itb != m_stats.nDroppedBytesAfterDequeue.end ())
-    {
-      itb->second += item->GetSize ();
-    }
-  else
-    {
-      m_stats.nDroppedBytesAfterDequeue[reason] = item->GetSize ();
-    }
+  // update the number of packets and bytes dropped for the given reason
+  Stats::ReasonCounters &counters = m_stats.GetReasonCounters (reason);
+  counters.nDroppedPacketsAfterDequeue++;
+  counters.nDroppedBytesAfterDequeue += item->GetSize ();
 
   NS_LOG_DEBUG ("Total packets/bytes dropped after dequeue: "
                 << m_stats.nTotalDroppedPacketsAfterDequeue << " / "
                 << m_stats.nTotalDroppedBytesAfterDequeue);
   NS_LOG_LOGIC ("m_traceDropAfterDequeue (p)");
   m_traceDrop (item);
-  m_traceDropAfterDequeue (item, reason);
+  m_traceDropAfterDequeue (item, GetReasonName (reason).c_str ());
+}
+
+void
+QueueDisc::DropAfterDequeue (Ptr<const QueueDiscItem> item, const char* reason)
+{
+  DropAfterDequeue (item, InternReason (reason));
+}
+
+uint16_t
+QueueDisc::GetChildDropReason (const char* reason)
+{
+  uint16_t id = InternReason (reason);
+  if (id >= m_childDropReasons.size ())
+    {
+      m_childDropReasons.resize (id + 1, -1);
+    }
+  if (m_childDropReasons[id] < 0)
+    {
+      std::string childReason = std::string (CHILD_QUEUE_DISC_DROP).append (reason);
+      m_childDropReasons[id] = InternReason (childReason.c_str ());
+    }
+  return m_childDropReasons[id];
 }
 
 bool
-QueueDisc::Mark (Ptr<QueueDiscItem> item, const char* reason)
+QueueDisc::Mark (Ptr<QueueDiscItem> item, uint16_t reason)
 {
-  NS_LOG_FUNCTION (this << item << reason);
+  NS_LOG_FUNCTION (this << item << GetReasonName (reason));
 
   bool retval = item->Mark ();
 
@@ -699,34 +818,24 @@ QueueDisc::Mark (Ptr<QueueDiscItem> item, const char* reason)
   m_stats.nTotalMarkedPackets++;
   m_stats.nTotalMarkedBytes += item->GetSize ();
 
-  // update the number of packets marked for the given reason
-  std::map<std::string, uint32_t>::iterator itp = m_stats.nMarkedPackets.find (reason);
-  if (itp != m_stats.nMarkedPackets.end ())
-    {
-      itp->second++;
-    }
-  else
-    {
-      m_stats.nMarkedPackets[reason] = 1;
-    }
-  // update the amount of bytes marked for the given reason
-  std::map<std::string, uint64_t>::iterator itb = m_stats.nMarkedBytes.find (reason);
-  if (itb != m_stats.nMarkedBytes.end ())
-    {
-      itb->second += item->GetSize ();
-    }
-  else
-    {
-      m_stats.nMarkedBytes[reason] = item->GetSize ();
-    }
+  // update the number of packets and bytes marked for the given reason
+  Stats::ReasonCounters &counters = m_stats.GetReasonCounters (reason);
+  counters.nMarkedPackets++;
+  counters.nMarkedBytes += item->GetSize ();
 
   NS_LOG_DEBUG ("Total packets/bytes marked: "
                 << m_stats.nTotalMarkedPackets << " / "
                 << m_stats.nTotalMarkedBytes);
-  m_traceMark (item, reason);
+  m_traceMark (item, GetReasonName (reason).c_str ());
   return true;
 }
 
+bool
+QueueDisc::Mark (Ptr<QueueDiscItem> item, const char* reason)
+{
+  return Mark (item, InternReason (reason));
+}
+
 bool
 QueueDisc::Enqueue (Ptr<QueueDiscItem> item)
 {
@@ -775,6 +884,76 @@ QueueDisc::Dequeue (void)
   return item;
 }
 
+uint32_t
+QueueDisc::EnqueueBatch (const std::vector<Ptr<QueueDiscItem> > &items)
+{
+  NS_LOG_FUNCTION (this << items.size ());
+
+  for (std::vector<Ptr<QueueDiscItem> >::const_iterator it = items.begin (); it != items.end (); it++)
+    {
+      m_stats.nTotalReceivedPackets++;
+      m_stats.nTotalReceivedBytes += (*it)->GetSize ();
+    }
+
+  uint32_t nEnqueued = DoEnqueueBatch (items);
+
+  // check that the received packets were either enqueued or dropped
+  NS_ASSERT (m_stats.nTotalReceivedPackets == m_stats.nTotalDroppedPacketsBeforeEnqueue +
+             m_stats.nTotalEnqueuedPackets);
+  NS_ASSERT (m_stats.nTotalReceivedBytes == m_stats.nTotalDroppedBytesBeforeEnqueue +
+             m_stats.nTotalEnqueuedBytes);
+
+  return nEnqueued;
+}
+
+uint32_t
+QueueDisc::DequeueBatch (std::vector<Ptr<QueueDiscItem> > &items, uint32_t maxPackets, uint32_t maxBytes)
+{
+  NS_LOG_FUNCTION (this << maxPackets << maxBytes);
+
+  uint32_t nDequeued = DoDequeueBatch (items, maxPackets, maxBytes);
+
+  NS_ASSERT (m_nPackets == m_stats.nTotalEnqueuedPackets - m_stats.nTotalDequeuedPackets);
+  NS_ASSERT (m_nBytes == m_stats.nTotalEnqueuedBytes - m_stats.nTotalDequeuedBytes);
+
+  return nDequeued;
+}
+
+uint32_t
+QueueDisc::DoEnqueueBatch (const std::vector<Ptr<QueueDiscItem> > &items)
+{
+  NS_LOG_FUNCTION (this << items.size ());
+
+  uint32_t nEnqueued = 0;
+  for (std::vector<Ptr<QueueDiscItem> >::const_iterator it = items.begin (); it != items.end (); it++)
+    {
+      // as in Enqueue, only the packets actually enqueued are time stamped
+      if (DoEnqueue (*it))
+        {
+          (*it)->SetTimeStamp (Simulator::Now ());
+          nEnqueued++;
+        }
+    }
+  return nEnqueued;
+}
+
+uint32_t
+QueueDisc::DoDequeueBatch (std::vector<Ptr<QueueDiscItem> > &items, uint32_t maxPackets, uint32_t maxBytes)
+{
+  NS_LOG_FUNCTION (this << maxPackets << maxBytes);
+
+  uint32_t nDequeued = 0;
+  uint32_t nBytes = 0;
+  Ptr<QueueDiscItem> item;
+  while (nDequeued < maxPackets && nBytes < maxBytes && (item = DoDequeue ()) != 0)
+    {
+      items.push_back (item);
+      nDequeued++;
+      nBytes += item->GetSize ();
+    }
+  return nDequeued;
+}
+
 Ptr<const QueueDiscItem>
 QueueDisc::Peek (void) const
 {
@@ -790,19 +969,55 @@ QueueDisc::Run (void)
   if (RunBegin ())
     {
       uint32_t quota = m_quota;
-      while (Restart ())
+      uint32_t packets = 0;
+      while (Restart (packets))
         {
-          quota -= 1;
-          if (quota <= 0)
+          if (quota <= packets)
             {
               /// \todo netif_schedule (q);
               break;
             }
+          quota -= packets;
         }
       RunEnd ();
     }
 }
 
+bool
+QueueDisc::CanBypass (void) const
+{
+  return false;
+}
+
+bool
+QueueDisc::Bypass (Ptr<QueueDiscItem> item)
+{
+  NS_LOG_FUNCTION (this << item);
+  NS_ASSERT (m_devQueueIface);
+
+  if (!CanBypass () || GetNPackets () > 0 || !m_requeued.empty ()
+      || m_devQueueIface->GetTxQueue (item->GetTxQueueIndex ())->IsStopped ()
+      || !RunBegin ())
+    {
+      return false;
+    }
+
+  NS_LOG_LOGIC ("Bypassing the queue disc");
+  m_stats.nTotalReceivedPackets++;
+  m_stats.nTotalReceivedBytes += item->GetSize ();
+  item->SetTimeStamp (Simulator::Now ());
+  PacketEnqueued (item);
+  PacketDequeued (item);
+
+  item->AddHeader ();
+  bool sent = Transmit (item);
+  NS_ASSERT (sent);
+  NS_UNUSED (sent); // suppress compiler warning
+
+  RunEnd ();
+  return true;
+}
+
 bool
 QueueDisc::RunBegin (void)
 {
@@ -824,36 +1039,62 @@ QueueDisc::RunEnd (void)
 }
 
 bool
-QueueDisc::Restart (void)
+QueueDisc::Restart (uint32_t &packets)
 {
   NS_LOG_FUNCTION (this);
-  Ptr<QueueDiscItem> item = DequeuePacket();
-  if (item == 0)
+  NS_ASSERT (m_burst.empty ());
+  packets = DequeuePackets (m_burst);
+  if (packets == 0)
     {
       NS_LOG_LOGIC ("No packet to send");
       return false;
     }
 
-  return Transmit (item);
+  for (uint32_t i = 0; i < m_burst.size (); i++)
+    {
+      if (!Transmit (m_burst[i]))
+        {
+          // the device queue is stopped: requeue this packet and the following
+          // ones, so that they are sent in the same order later on
+          for (uint32_t j = m_burst.size (); j > i; j--)
+            {
+              Requeue (m_burst[j - 1]);
+            }
+          m_burst.clear ();
+          return false;
+        }
+    }
+
+  uint8_t txq = m_burst.back ()->GetTxQueueIndex ();
+  m_burst.clear ();
+
+  // if the queue disc is empty or the device queue is now stopped, return false so
+  // that the Run method does not attempt to dequeue other packets and exits
+  if ((GetNPackets () == 0 && m_requeued.empty ()) || m_devQueueIface->GetTxQueue (txq)->IsStopped ())
+    {
+      return false;
+    }
+
+  return true;
 }
 
-Ptr<QueueDiscItem>
-QueueDisc::DequeuePacket ()
+uint32_t
+QueueDisc::DequeuePackets (std::vector<Ptr<QueueDiscItem> > &items)
 {
   NS_LOG_FUNCTION (this);
   NS_ASSERT (m_devQueueIface);
-  Ptr<QueueDiscItem> item;
 
-  // First check if there is a requeued packet
-  if (m_requeued != 0)
+  // First check if there are requeued packets
+  if (!m_requeued.empty ())
     {
-        // If the queue where the requeued packet is destined to is not stopped, return
-        // the requeued packet; otherwise, return an empty packet.
+        // If the queue where a requeued packet is destined to is not stopped, return
+        // the requeued packet; otherwise, stop here.
         // If the device does not support flow control, the device queue is never stopped
-        if (!m_devQueueIface->GetTxQueue (m_requeued->GetTxQueueIndex ())->IsStopped ())
+        while (!m_requeued.empty ()
+               && !m_devQueueIface->GetTxQueue (m_requeued.front ()->GetTxQueueIndex ())->IsStopped ())
           {
-            item = m_requeued;
-            m_requeued = 0;
+            items.push_back (m_requeued.front ());
+            m_requeued.pop_front ();
           }
     }
   else
@@ -861,27 +1102,41 @@ QueueDisc::DequeuePacket ()
       // If the device is multi-queue (actually, Linux checks if the queue disc has
       // multiple queues), ask the queue disc to dequeue a packet (a multi-queue aware
       // queue disc should try not to dequeue a packet destined to a stopped queue).
-      // Otherwise, ask the queue disc to dequeue a packet only if the (unique) queue
+      // Otherwise, ask the queue disc to dequeue packets only if the (unique) queue
       // is not stopped.
-      if (m_devQueueIface->GetNTxQueues ()>1 || !m_devQueueIface->GetTxQueue (0)->IsStopped ())
+      if (m_devQueueIface->GetNTxQueues ()>1)
+        {
+          DequeueBatch (items, 1);
+        }
+      else if (!m_devQueueIface->GetTxQueue (0)->IsStopped ())
         {
-          item = Dequeue ();
-          // If the item is not null, add the header to the packet.
-          if (item != 0)
+          // As Linux, try bulk dequeues if byte queue limits are enabled on the
+          // device queue: packets are dequeued until the number of bytes the
+          // device can accept is reached (at least one packet is dequeued)
+          uint32_t maxPackets = 1;
+          uint32_t maxBytes = 1;
+          Ptr<QueueLimits> ql = m_devQueueIface->GetTxQueue (0)->GetQueueLimits ();
+          if (ql != 0 && ql->Available () > 0)
             {
-              item->AddHeader ();
+              maxPackets = std::max<uint32_t> (m_quota, 1);
+              maxBytes = ql->Available ();
             }
-          // Here, Linux tries bulk dequeues
+          DequeueBatch (items, maxPackets, maxBytes);
+        }
+      // If the items are not null, add the header to the packets.
+      for (std::vector<Ptr<QueueDiscItem> >::iterator it = items.begin (); it != items.end (); it++)
+        {
+          (*it)->AddHeader ();
         }
     }
-  return item;
+  return items.size ();
 }
 
 void
 QueueDisc::Requeue (Ptr<QueueDiscItem> item)
 {
   NS_LOG_FUNCTION (this << item);
-  m_requeued = item;
+  m_requeued.push_front (item);
   /// \todo netif_schedule (q);
 
   m_stats.nTotalRequeuedPackets++;
@@ -897,12 +1152,11 @@ QueueDisc::Transmit (Ptr<QueueDiscItem> item)
   NS_LOG_FUNCTION (this << item);
   NS_ASSERT (m_devQueueIface);
 
-  // if the device queue is stopped, requeue the packet and return false.
+  // if the device queue is stopped, return false so that the packet is requeued.
   // Note that if the underlying device is tc-unaware, packets are never
   // requeued because the queues of tc-unaware devices are never stopped
   if (m_devQueueIface->GetTxQueue (item->GetTxQueueIndex ())->IsStopped ())
     {
-      Requeue (item);
       return false;
     }
 
@@ -928,13 +1182,6 @@ QueueDisc::Transmit (Ptr<QueueDiscItem> item)
   // of the value returned by NetDevice::Send does not match that of the value
   // returned by ndo_start_xmit.
 
-  // if the queue disc is empty or the device queue is now stopped, return false so
-  // that the Run method does not attempt to dequeue other packets and exits
-  if (GetNPackets () == 0 || m_devQueueIface->GetTxQueue (item->GetTxQueueIndex ())->IsStopped ())
-    {
-      return false;
-    }
-
   return true;
 }
 
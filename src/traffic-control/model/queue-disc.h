@@ -21,13 +21,16 @@
 #define QUEUE_DISC_H
 
 #include "ns3/object.h"
+#include "ns3/object-handle.h"
 #include "ns3/traced-value.h"
 #include "ns3/net-device.h"
 #include "ns3/queue-item.h"
 #include <vector>
+#include <deque>
 #include <map>
 #include <functional>
 #include <string>
+#include <limits>
 #include "packet-filter.h"
 
 namespace ns3 {
@@ -130,9 +133,12 @@ private:
  * - dropped = dropped before enqueue + dropped after dequeue
  * - received = dropped before enqueue + enqueued
  * - queued = enqueued - dequeued
- * - sent = dequeued - dropped after dequeue (- 1 if there is a requeued packet)
+ * - sent = dequeued - dropped after dequeue - requeued packets still held
  *
  * Separate counters are also kept for each possible reason to drop a packet.
+ * Reasons are interned into small integer identifiers (see InternReason) and
+ * the counters are stored in an array indexed by such identifiers, so that no
+ * string is built nor looked up when a packet is dropped or marked.
  * When a packet is dropped by an internal queue, e.g., because the queue is full,
  * the reason is "Dropped by internal queue". When a packet is dropped by a child
  * queue disc, the reason is "(Dropped by child queue disc) " followed by the
@@ -203,6 +209,22 @@ public:
     /// Marked bytes, for each reason
     std::map<std::string, uint64_t> nMarkedBytes;
 
+    /// Counters kept for each reason to drop or mark a packet
+    struct ReasonCounters
+    {
+      uint32_t nDroppedPacketsBeforeEnqueue;  //!< Packets dropped before enqueue
+      uint64_t nDroppedBytesBeforeEnqueue;    //!< Bytes dropped before enqueue
+      uint32_t nDroppedPacketsAfterDequeue;   //!< Packets dropped after dequeue
+      uint64_t nDroppedBytesAfterDequeue;     //!< Bytes dropped after dequeue
+      uint32_t nMarkedPackets;                //!< Marked packets
+      uint64_t nMarkedBytes;                  //!< Marked bytes
+    };
+    /**
+     * Counters for each reason, indexed by the identifier of the reason. The
+     * maps above are a view of these counters, which is only updated by GetStats.
+     */
+    std::vector<ReasonCounters> reasonCounters;
+
     /// constructor
     Stats ();
 
@@ -235,6 +257,18 @@ public:
      * \param os output stream in which the data should be printed.
      */
     void Print (std::ostream &os) const;
+
+    /**
+     * \brief Get the counters for the reason with the given identifier,
+     *        allocating them if needed
+     * \param id the identifier of the reason
+     * \return the counters for the given reason
+     */
+    ReasonCounters& GetReasonCounters (uint16_t id);
+    /**
+     * \brief Update the maps of the counters for each reason
+     */
+    void UpdateReasonMaps (void);
   };
 
   /**
@@ -309,6 +343,29 @@ public:
    */
   Ptr<QueueDiscItem> Dequeue (void);
 
+  /**
+   * Pass a batch of packets to store to the queue discipline. This function
+   * only updates the statistics and calls the (private) DoEnqueueBatch function,
+   * which enqueues the packets one by one unless overridden by derived classes.
+   * \param items the items to enqueue
+   * \return the number of items that were successfully enqueued
+   */
+  uint32_t EnqueueBatch (const std::vector<Ptr<QueueDiscItem> > &items);
+
+  /**
+   * Request the queue discipline to extract a batch of packets. Packets are
+   * extracted until maxPackets packets or at least maxBytes bytes have been
+   * extracted, or the queue discipline has no more packets to send. This
+   * function only calls the (private) DoDequeueBatch function, which dequeues
+   * the packets one by one unless overridden by derived classes.
+   * \param items the vector the extracted items are appended to
+   * \param maxPackets the maximum number of packets to extract
+   * \param maxBytes the number of bytes after which no more packets are extracted
+   * \return the number of items extracted
+   */
+  uint32_t DequeueBatch (std::vector<Ptr<QueueDiscItem> > &items, uint32_t maxPackets,
+                         uint32_t maxBytes = std::numeric_limits<uint32_t>::max ());
+
   /**
    * Get a copy of the next packet the queue discipline will extract, without
    * actually extracting the packet. This function only calls the (private)
@@ -324,6 +381,18 @@ public:
    */
   void Run (void);
 
+  /**
+   * Modelled after the TCQ_F_CAN_BYPASS path of the Linux function
+   * __dev_xmit_skb (net/core/dev.c)
+   * Sends a packet directly to the device if this queue disc allows it to be
+   * bypassed (see CanBypass), holds no packets, is not running and the device
+   * queue selected for the packet is not stopped. The statistics and the
+   * traces are updated as if the packet was enqueued and dequeued right away.
+   * \param item the packet to send
+   * \return true if the packet was sent; false if it has to be enqueued
+   */
+  bool Bypass (Ptr<QueueDiscItem> item);
+
   /// Internal queues store QueueDiscItem objects
   typedef Queue<QueueDiscItem> InternalQueue;
 
@@ -340,6 +409,19 @@ public:
    */
   Ptr<InternalQueue> GetInternalQueue (uint32_t i) const;
 
+  /**
+   * \brief Resolve a handle to the i-th internal queue seen as a queue of type Q
+   *
+   * Queue discs requiring a specific type of internal queue should resolve a
+   * handle in CheckConfig, so that the queue is accessed through the interface
+   * of Q without a GetObject lookup for every packet.
+   * \param i the index of the queue
+   * \param handle the handle to resolve
+   * \return true if the i-th internal queue is of type Q
+   */
+  template <typename Q>
+  bool GetInternalQueue (uint32_t i, ObjectHandle<Q> &handle) const;
+
   /**
    * \brief Get the number of internal queues
    * \return the number of internal queues.
@@ -418,10 +500,32 @@ public:
    */
   virtual WakeMode GetWakeMode (void) const;
 
+  /**
+   * \brief Get the identifier of a reason to drop or mark packets
+   *
+   * The reason is interned on the first call. Subclasses should store the
+   * identifiers of their reasons in static members, initialized by this
+   * function, and pass them to the drop and mark methods, so that no lookup
+   * takes place when a packet is dropped or marked. The address of the
+   * reasons is cached to speed up the lookups of the other callers.
+   * \param reason the reason
+   * \return the identifier of the reason
+   */
+  static uint16_t InternReason (const char* reason);
+
+  /**
+   * \brief Get the reason with the given identifier
+   * \param id the identifier returned by InternReason
+   * \return the reason
+   */
+  static const std::string& GetReasonName (uint16_t id);
+
   // Reasons for dropping packets
   static constexpr const char* INTERNAL_QUEUE_DROP = "Dropped by internal queue";    //!< Packet dropped by an internal queue
   static constexpr const char* CHILD_QUEUE_DISC_DROP = "(Dropped by child queue disc) "; //!< Packet dropped by a child queue disc
 
+  static const uint16_t INTERNAL_QUEUE_DROP_ID;  //!< Identifier of INTERNAL_QUEUE_DROP
+
 protected:
   /**
    * \brief Dispose of the object
@@ -441,28 +545,59 @@ protected:
    *  \brief Perform the actions required when the queue disc is notified of
    *         a packet dropped before enqueue
    *  \param item item that was dropped
-   *  \param reason the reason why the item was dropped
+   *  \param reason the identifier of the reason why the item was dropped
    *  This method must be called by subclasses to record that a packet was
    *  dropped before enqueue for the specified reason
    */
+  void DropBeforeEnqueue (Ptr<const QueueDiscItem> item, uint16_t reason);
+
+  /**
+   *  \brief Perform the actions required when the queue disc is notified of
+   *         a packet dropped before enqueue
+   *  \param item item that was dropped
+   *  \param reason the reason why the item was dropped
+   *  This method interns the reason and is kept for the subclasses which do
+   *  not store the identifiers of their reasons
+   */
   void DropBeforeEnqueue (Ptr<const QueueDiscItem> item, const char* reason);
 
   /**
    *  \brief Perform the actions required when the queue disc is notified of
    *         a packet dropped after dequeue
    *  \param item item that was dropped
-   *  \param reason the reason why the item was dropped
+   *  \param reason the identifier of the reason why the item was dropped
    *  This method must be called by subclasses to record that a packet was
    *  dropped after dequeue for the specified reason
    */
+  void DropAfterDequeue (Ptr<const QueueDiscItem> item, uint16_t reason);
+
+  /**
+   *  \brief Perform the actions required when the queue disc is notified of
+   *         a packet dropped after dequeue
+   *  \param item item that was dropped
+   *  \param reason the reason why the item was dropped
+   *  This method interns the reason and is kept for the subclasses which do
+   *  not store the identifiers of their reasons
+   */
   void DropAfterDequeue (Ptr<const QueueDiscItem> item, const char* reason);
 
+  /**
+   *  \brief Marks the given packet and, if successful, updates the counters
+   *         associated with the given reason
+   *  \param item item that has to be marked
+   *  \param reason the identifier of the reason why the item has to be marked
+   *  \return true if the item was successfully marked, false otherwise
+   */
+  bool Mark (Ptr<QueueDiscItem> item, uint16_t reason);
+
   /**
    *  \brief Marks the given packet and, if successful, updates the counters
    *         associated with the given reason
    *  \param item item that has to be marked
    *  \param reason the reason why the item has to be marked
    *  \return true if the item was successfully marked, false otherwise
+   *  This method interns the reason and is kept for the subclasses which do
+   *  not store the identifiers of their reasons
    */
   bool Mark (Ptr<QueueDiscItem> item, const char* reason);
 
@@ -497,12 +632,43 @@ private:
    */
   virtual Ptr<QueueDiscItem> DoDequeue (void) = 0;
 
+  /**
+   * This function actually enqueues a batch of packets into the queue disc.
+   * The default implementation calls DoEnqueue on each packet. Overrides must
+   * set the time stamp of the packets they enqueue, as Enqueue does, and only
+   * of those.
+   * \param items the items to enqueue
+   * \return the number of items that were successfully enqueued
+   */
+  virtual uint32_t DoEnqueueBatch (const std::vector<Ptr<QueueDiscItem> > &items);
+
+  /**
+   * This function actually extracts a batch of packets from the queue disc.
+   * The default implementation calls DoDequeue until enough packets are extracted.
+   * \param items the vector the extracted items are appended to
+   * \param maxPackets the maximum number of packets to extract
+   * \param maxBytes the number of bytes after which no more packets are extracted
+   * \return the number of items extracted
+   */
+  virtual uint32_t DoDequeueBatch (std::vector<Ptr<QueueDiscItem> > &items, uint32_t maxPackets,
+                                   uint32_t maxBytes);
+
   /**
    * This function returns a copy of the next packet the queue disc will extract.
    * \return 0 if the operation was not successful; the packet otherwise.
    */
   virtual Ptr<const QueueDiscItem> DoPeek (void) const = 0;
 
+  /**
+   * Check whether packets can be sent directly to the device when the queue
+   * disc is empty, i.e., whether enqueuing a packet in an empty queue disc and
+   * dequeuing it right away leaves the queue disc in the same state. The
+   * default implementation returns false, which suits queue discs that update
+   * some state (e.g., an average queue size) on every enqueue or dequeue.
+   * \return true if the queue disc can be bypassed
+   */
+  virtual bool CanBypass (void) const;
+
   /**
    * Check whether the current configuration is correct. Default objects (such
    * as internal queues) might be created by this method to ensure the
@@ -516,6 +682,15 @@ private:
    */
   virtual void InitializeParams (void) = 0;
 
+  /**
+   * \brief Get the reason passed to the drop methods when a child queue disc
+   *        drops a packet
+   * \param reason the reason why the child queue disc dropped the packet
+   * \return the identifier of the concatenation of CHILD_QUEUE_DISC_DROP and
+   *         the given reason
+   */
+  uint16_t GetChildDropReason (const char* reason);
+
   /**
    * Modelled after the Linux function qdisc_run_begin (include/net/sch_generic.h).
    * \return false if the qdisc is already running; otherwise, set the qdisc as running and return true.
@@ -530,30 +705,39 @@ private:
 
   /**
    * Modelled after the Linux function qdisc_restart (net/sched/sch_generic.c)
-   * Dequeue a packet (by calling DequeuePacket) and send it to the device (by calling Transmit).
-   * \return true if a packet is successfully sent to the device.
+   * Dequeue a burst of packets (by calling DequeuePackets) and send them to the
+   * device (by calling Transmit). The packets that cannot be sent because the
+   * device queue is stopped are requeued.
+   * \param packets set to the number of packets dequeued
+   * \return true if the packets are successfully sent to the device and more
+   *         packets can be sent.
    */
-  bool Restart (void);
+  bool Restart (uint32_t &packets);
 
   /**
    * Modelled after the Linux function dequeue_skb (net/sched/sch_generic.c)
-   * \return the requeued packet, if any, or the packet dequeued by the queue disc, otherwise.
+   *
+   * If there are requeued packets, they are returned. Otherwise, the queue disc
+   * is asked to dequeue packets. As in the Linux bulk dequeue mode, more than
+   * one packet is dequeued if the device has a single transmission queue whose
+   * byte queue limits allow it (and no more than the quota).
+   * \param items the vector the packets are appended to
+   * \return the number of packets appended
    */
-  Ptr<QueueDiscItem> DequeuePacket (void);
+  uint32_t DequeuePackets (std::vector<Ptr<QueueDiscItem> > &items);
 
   /**
    * Modelled after the Linux function dev_requeue_skb (net/sched/sch_generic.c)
-   * Requeues a packet whose transmission failed.
+   * Requeues a packet whose transmission failed, ahead of the packets already requeued.
    * \param item the packet to requeue
    */
   void Requeue (Ptr<QueueDiscItem> item);
 
   /**
    * Modelled after the Linux function sch_direct_xmit (net/sched/sch_generic.c)
-   * Sends a packet to the device if the device queue is not stopped, and requeues
-   * it otherwise.
+   * Sends a packet to the device if the device queue is not stopped.
    * \param item the packet to transmit
-   * \return true if the device queue is not stopped and the queue disc is not empty
+   * \return false if the device queue is stopped and the packet was not sent
    */
   bool Transmit (Ptr<QueueDiscItem> item);
 
@@ -586,8 +770,9 @@ private:
   Ptr<NetDevice> m_device;          //!< The NetDevice on which this queue discipline is installed
   Ptr<NetDeviceQueueInterface> m_devQueueIface;   //!< NetDevice queue interface
   bool m_running;                   //!< The queue disc is performing multiple dequeue operations
-  Ptr<QueueDiscItem> m_requeued;    //!< The last packet that failed to be transmitted
-  std::string m_childQueueDiscDropMsg;  //!< Reason why a packet was dropped by a child queue disc
+  std::deque<Ptr<QueueDiscItem> > m_requeued;  //!< The packets that failed to be transmitted
+  std::vector<Ptr<QueueDiscItem> > m_burst;    //!< The packets dequeued in a Restart
+  std::vector<int32_t> m_childDropReasons;  //!< Identifier of the reason to drop for each reason of the child queue discs
 
   /// Traced callback: fired when a packet is enqueued
   TracedCallback<Ptr<const QueueDiscItem> > m_traceEnqueue;
@@ -628,6 +813,13 @@ private:
  */
 std::ostream& operator<< (std::ostream& os, const QueueDisc::Stats &stats);
 
+template <typename Q>
+bool
+QueueDisc::GetInternalQueue (uint32_t i, ObjectHandle<Q> &handle) const
+{
+  return handle.Resolve (GetInternalQueue (i));
+}
+
 } // namespace ns3
 
 #endif /* QueueDisc */
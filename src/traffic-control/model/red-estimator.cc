@@ -0,0 +1,77 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2017 NITK Surathkal
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/log.h"
+#include "red-estimator.h"
+#include <cmath>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("RedEstimator");
+
+RedEstimator::RedEstimator ()
+{
+  NS_LOG_FUNCTION (this);
+  SetWeight (0.0);
+}
+
+void
+RedEstimator::SetWeight (double qW)
+{
+  NS_LOG_FUNCTION (this << qW);
+  m_qW = qW;
+  for (uint32_t i = 0; i <= TABLE_SIZE; i++)
+    {
+      m_decay[i] = std::pow (1.0 - qW, static_cast<int> (i));
+    }
+}
+
+double
+RedEstimator::GetDecay (uint32_t m, double qW)
+{
+  if (qW != m_qW)
+    {
+      SetWeight (qW);
+    }
+
+  if (m < TABLE_SIZE)
+    {
+      return m_decay[m];
+    }
+
+  // (1 - qW)^m = ((1 - qW)^TABLE_SIZE)^(m / TABLE_SIZE) * (1 - qW)^(m % TABLE_SIZE)
+  double decay = m_decay[m % TABLE_SIZE];
+  double base = m_decay[TABLE_SIZE];
+  for (uint32_t e = m / TABLE_SIZE; e > 0 && decay != 0.0; e >>= 1)
+    {
+      if (e & 1)
+        {
+          decay *= base;
+        }
+      base *= base;
+    }
+  return decay;
+}
+
+double
+RedEstimator::Estimate (uint32_t nQueued, uint32_t m, double qAvg, double qW)
+{
+  return qAvg * GetDecay (m, qW) + qW * nQueued;
+}
+
+} // namespace ns3
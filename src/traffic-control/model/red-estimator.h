@@ -0,0 +1,85 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2017 NITK Surathkal
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef RED_ESTIMATOR_H
+#define RED_ESTIMATOR_H
+
+#include <stdint.h>
+
+namespace ns3 {
+
+/**
+ * \ingroup traffic-control
+ *
+ * \brief Average queue size estimator of the RED family of queue discs
+ *
+ * The average queue size is an exponential weighted moving average (EWMA)
+ * of the queue size sampled at every packet arrival. When a packet arrives
+ * after m - 1 packets could have been transmitted during an idle period,
+ * the average is updated as
+ *
+ *   qAvg = qAvg * (1 - qW)^m + qW * nQueued
+ *
+ * The decay factors (1 - qW)^m are taken from a table for m < TABLE_SIZE,
+ * which is filled with std::pow and hence gives the same averages as calling
+ * std::pow on every arrival. Larger values of m (long idle periods) are
+ * handled by exponentiation by squaring of (1 - qW)^TABLE_SIZE. Each squaring
+ * roughly doubles the relative error, which is hence of the order of
+ * m / TABLE_SIZE ulps instead of staying within one ulp as with std::pow.
+ * This only applies after idle periods longer than TABLE_SIZE transmissions,
+ * when the decayed average is negligible next to the qW * nQueued term.
+ * The table is recomputed whenever the queue weight changes.
+ */
+class RedEstimator
+{
+public:
+  RedEstimator ();
+
+  /**
+   * \brief Compute the new average queue size
+   * \param nQueued the current queue size
+   * \param m the number of packet arrivals since the last update, including
+   *        the arrivals simulated during an idle period
+   * \param qAvg the current average queue size
+   * \param qW the queue weight given to the current queue size sample
+   * \returns the new average queue size
+   */
+  double Estimate (uint32_t nQueued, uint32_t m, double qAvg, double qW);
+  /**
+   * \brief Get the decay factor of the average queue size
+   * \param m the number of packet arrivals since the last update
+   * \param qW the queue weight
+   * \returns (1 - qW)^m
+   */
+  double GetDecay (uint32_t m, double qW);
+
+private:
+  /**
+   * \brief Fill the table of decay factors for the given queue weight
+   * \param qW the queue weight
+   */
+  void SetWeight (double qW);
+
+  static const uint32_t TABLE_SIZE = 64;  //!< Number of precomputed decay factors
+  double m_qW;                            //!< Queue weight the table is computed for
+  double m_decay[TABLE_SIZE + 1];         //!< (1 - m_qW)^i, for i = 0, ..., TABLE_SIZE
+};
+
+} // namespace ns3
+
+#endif /* RED_ESTIMATOR_H */
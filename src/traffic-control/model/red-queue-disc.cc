@@ -57,6 +57,7 @@
  */
 
 #include "ns3/log.h"
+#include "ns3/unused.h"
 #include "ns3/enum.h"
 #include "ns3/uinteger.h"
 #include "ns3/double.h"
@@ -72,6 +73,11 @@ NS_LOG_COMPONENT_DEFINE ("RedQueueDisc");
 
 NS_OBJECT_ENSURE_REGISTERED (RedQueueDisc);
 
+const uint16_t RedQueueDisc::UNFORCED_DROP_ID = QueueDisc::InternReason (RedQueueDisc::UNFORCED_DROP);
+const uint16_t RedQueueDisc::FORCED_DROP_ID = QueueDisc::InternReason (RedQueueDisc::FORCED_DROP);
+const uint16_t RedQueueDisc::UNFORCED_MARK_ID = QueueDisc::InternReason (RedQueueDisc::UNFORCED_MARK);
+const uint16_t RedQueueDisc::FORCED_MARK_ID = QueueDisc::InternReason (RedQueueDisc::FORCED_MARK);
+
 TypeId RedQueueDisc::GetTypeId (void)
 {
   static TypeId tid = TypeId ("ns3::RedQueueDisc")
@@ -446,20 +452,20 @@ RedQueueDisc::DoEnqueue (Ptr<QueueDiscItem> item)
 
   if (dropType == DTYPE_UNFORCED)
     {
-      if (!m_useEcn || !Mark (item, UNFORCED_MARK))
+      if (!m_useEcn || !Mark (item, UNFORCED_MARK_ID))
         {
           NS_LOG_DEBUG ("\t Dropping due to Prob Mark " << m_qAvg);
-          DropBeforeEnqueue (item, UNFORCED_DROP);
+          DropBeforeEnqueue (item, UNFORCED_DROP_ID);
           return false;
         }
       NS_LOG_DEBUG ("\t Marking due to Prob Mark " << m_qAvg);
     }
   else if (dropType == DTYPE_FORCED)
     {
-      if (m_useHardDrop || !m_useEcn || !Mark (item, FORCED_MARK))
+      if (m_useHardDrop || !m_useEcn || !Mark (item, FORCED_MARK_ID))
         {
           NS_LOG_DEBUG ("\t Dropping due to Hard Mark " << m_qAvg);
-          DropBeforeEnqueue (item, FORCED_DROP);
+          DropBeforeEnqueue (item, FORCED_DROP_ID);
           if (m_isNs1Compat)
             {
               m_count = 0;
@@ -669,8 +675,7 @@ RedQueueDisc::Estimator (uint32_t nQueued, uint32_t m, double qAvg, double qW)
 {
   NS_LOG_FUNCTION (this << nQueued << m << qAvg << qW);
 
-  double newAve = qAvg * pow(1.0-qW, m);
-  newAve += qW * nQueued;
+  double newAve = m_estimator.Estimate (nQueued, m, qAvg, qW);
 
   Time now = Simulator::Now ();
   if (m_isAdaptMaxP && now > m_lastSet + m_interval)
@@ -890,6 +895,42 @@ RedQueueDisc::DoDequeue (void)
     }
 }
 
+uint32_t
+RedQueueDisc::DoDequeueBatch (std::vector<Ptr<QueueDiscItem> > &items, uint32_t maxPackets,
+                              uint32_t maxBytes)
+{
+  NS_LOG_FUNCTION (this << maxPackets << maxBytes);
+
+  Ptr<InternalQueue> queue = GetInternalQueue (0);
+  uint32_t nDequeued = 0;
+  uint32_t nBytes = 0;
+  while (nDequeued < maxPackets && nBytes < maxBytes && !queue->IsEmpty ())
+    {
+      Ptr<QueueDiscItem> item = queue->Dequeue ();
+      NS_LOG_LOGIC ("Popped " << item);
+      items.push_back (item);
+      nDequeued++;
+      nBytes += item->GetSize ();
+    }
+
+  // the idle period starts when a dequeue is requested while the queue is empty
+  if (nDequeued < maxPackets && nBytes < maxBytes)
+    {
+      NS_LOG_LOGIC ("Queue empty");
+      m_idle = 1;
+      m_idleTime = Simulator::Now ();
+    }
+  else
+    {
+      m_idle = 0;
+    }
+
+  NS_LOG_LOGIC ("Number packets " << queue->GetNPackets ());
+  NS_LOG_LOGIC ("Number bytes " << queue->GetNBytes ());
+
+  return nDequeued;
+}
+
 Ptr<const QueueDiscItem>
 RedQueueDisc::DoPeek (void) const
 {
@@ -66,6 +66,7 @@
 #include "ns3/boolean.h"
 #include "ns3/data-rate.h"
 #include "ns3/random-variable-stream.h"
+#include "red-estimator.h"
 
 namespace ns3 {
 
@@ -237,6 +238,12 @@ public:
   static constexpr const char* UNFORCED_MARK = "Unforced mark";  //!< Early probability marks
   static constexpr const char* FORCED_MARK = "Forced mark";      //!< Forced marks, m_qAvg > m_maxTh
 
+  // Identifiers of the reasons, to pass to the drop and mark methods
+  static const uint16_t UNFORCED_DROP_ID;  //!< Identifier of UNFORCED_DROP
+  static const uint16_t FORCED_DROP_ID;    //!< Identifier of FORCED_DROP
+  static const uint16_t UNFORCED_MARK_ID;  //!< Identifier of UNFORCED_MARK
+  static const uint16_t FORCED_MARK_ID;    //!< Identifier of FORCED_MARK
+
 protected:
   /**
    * \brief Dispose of the object
@@ -247,6 +254,8 @@ private:
   virtual bool DoEnqueue (Ptr<QueueDiscItem> item);
   virtual Ptr<QueueDiscItem> DoDequeue (void);
   virtual Ptr<const QueueDiscItem> DoPeek (void) const;
+  virtual uint32_t DoDequeueBatch (std::vector<Ptr<QueueDiscItem> > &items, uint32_t maxPackets,
+                                   uint32_t maxBytes);
   virtual bool CheckConfig (void);
 
   /**
@@ -350,6 +359,7 @@ private:
    */
   uint32_t m_cautious;
   Time m_idleTime;          //!< Start of current idle period
+  RedEstimator m_estimator; //!< Average queue size estimator
 
   Ptr<UniformRandomVariable> m_uv;  //!< rng stream
 };
@@ -71,6 +71,7 @@ TrafficControlLayer::DoDispose (void)
   NS_LOG_FUNCTION (this);
   m_node = 0;
   m_handlers.clear ();
+  m_netDevicesByIndex.clear ();
   m_netDevices.clear ();
   Object::DoDispose ();
 }
@@ -170,6 +171,35 @@ TrafficControlLayer::SetupDevice (Ptr<NetDevice> device)
                         std::forward_as_tuple ((Ptr<QueueDisc>) 0, devQueueIface, QueueDiscVector (), cb));
 }
 
+TrafficControlLayer::NetDeviceInfo*
+TrafficControlLayer::GetNetDeviceInfo (Ptr<NetDevice> device)
+{
+  uint32_t index = device->GetIfIndex ();
+
+  if (index < m_netDevicesByIndex.size () && m_netDevicesByIndex[index] != 0
+      && m_netDevicesByIndex[index]->first == device)
+    {
+      return &m_netDevicesByIndex[index]->second;
+    }
+
+  // the device has not been looked up yet (or its interface index was not
+  // set when it was looked up). The elements of a map are never moved, hence
+  // pointers to them can be cached until the map is cleared
+  NetDeviceInfoMap::iterator ndi = m_netDevices.find (device);
+
+  if (ndi == m_netDevices.end ())
+    {
+      return 0;
+    }
+
+  if (index >= m_netDevicesByIndex.size ())
+    {
+      m_netDevicesByIndex.resize (index + 1, 0);
+    }
+  m_netDevicesByIndex[index] = &(*ndi);
+  return &ndi->second;
+}
+
 void
 TrafficControlLayer::RegisterProtocolHandler (Node::ProtocolHandler handler,
                                               uint16_t protocolType, Ptr<NetDevice> device)
@@ -320,18 +350,18 @@ TrafficControlLayer::Send (Ptr<NetDevice> device, Ptr<QueueDiscItem> item)
   NS_LOG_DEBUG ("Send packet to device " << device << " protocol number " <<
                 item->GetProtocol ());
 
-  std::map<Ptr<NetDevice>, NetDeviceInfo>::iterator ndi = m_netDevices.find (device);
-  NS_ASSERT (ndi != m_netDevices.end ());
-  Ptr<NetDeviceQueueInterface> devQueueIface = ndi->second.m_ndqi;
+  NetDeviceInfo *ndi = GetNetDeviceInfo (device);
+  NS_ASSERT (ndi != 0);
+  NetDeviceQueueInterface *devQueueIface = PeekPointer (ndi->m_ndqi);
   NS_ASSERT (devQueueIface);
 
   // determine the transmission queue of the device where the packet will be enqueued
   uint8_t txq = 0;
   if (devQueueIface->GetNTxQueues () > 1)
     {
-      if (!ndi->second.m_selectQueueCallback.IsNull ())
+      if (!ndi->m_selectQueueCallback.IsNull ())
         {
-          txq = ndi->second.m_selectQueueCallback (item);
+          txq = ndi->m_selectQueueCallback (item);
         }
       // otherwise, Linux determines the queue index by using a hash function
       // and associates such index to the socket which the packet belongs to,
@@ -343,7 +373,7 @@ TrafficControlLayer::Send (Ptr<NetDevice> device, Ptr<QueueDiscItem> item)
 
   NS_ASSERT (txq < devQueueIface->GetNTxQueues ());
 
-  if (ndi->second.m_rootQueueDisc == 0)
+  if (ndi->m_rootQueueDisc == 0)
     {
       // The device has no attached queue disc, thus add the header to the packet and
       // send it directly to the device if the selected queue is not stopped
@@ -362,11 +392,16 @@ TrafficControlLayer::Send (Ptr<NetDevice> device, Ptr<QueueDiscItem> item)
   else
     {
       // Enqueue the packet in the queue disc associated with the netdevice queue
-      // selected for the packet and try to dequeue packets from such queue disc
+      // selected for the packet and try to dequeue packets from such queue disc,
+      // unless the packet can be sent to the device right away
       item->SetTxQueueIndex (txq);
 
-      Ptr<QueueDisc> qDisc = ndi->second.m_queueDiscsToWake[txq];
+      QueueDisc *qDisc = PeekPointer (ndi->m_queueDiscsToWake[txq]);
       NS_ASSERT (qDisc);
+      if (qDisc->Bypass (item))
+        {
+          return;
+        }
       qDisc->Enqueue (item);
       qDisc->Run ();
     }
@@ -267,6 +267,20 @@ private:
   /// Typedef for protocol handlers container
   typedef std::vector<struct ProtocolHandlerEntry> ProtocolHandlerList;
 
+  /// Typedef for the map storing the information for each device
+  typedef std::map<Ptr<NetDevice>, NetDeviceInfo> NetDeviceInfoMap;
+
+  /**
+   * \brief Get the information stored for the given device
+   *
+   * The entries of the m_netDevices map are cached in a vector indexed by
+   * the interface index of the devices, so that the map is only searched the
+   * first time a device is looked up.
+   * \param device the device
+   * \return the information stored for the device, or 0 if none
+   */
+  NetDeviceInfo* GetNetDeviceInfo (Ptr<NetDevice> device);
+
   /**
    * \brief Required by the object map accessor
    * \return the number of devices in the m_netDevices map
@@ -282,7 +296,9 @@ private:
   /// The node this TrafficControlLayer object is aggregated to
   Ptr<Node> m_node;
   /// Map storing the required information for each device with a queue disc installed
-  std::map<Ptr<NetDevice>, NetDeviceInfo> m_netDevices;
+  NetDeviceInfoMap m_netDevices;
+  /// Entries of the m_netDevices map indexed by the interface index of the device
+  std::vector<NetDeviceInfoMap::value_type *> m_netDevicesByIndex;
   ProtocolHandlerList m_handlers;  //!< List of upper-layer handlers
 };
 
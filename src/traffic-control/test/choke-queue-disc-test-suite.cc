@@ -0,0 +1,921 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2017 NITK Surathkal
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include "ns3/test.h"
+#include "ns3/choke-queue-disc.h"
+#include "ns3/flow-occupancy-table.h"
+#include "ns3/choke-shard-group.h"
+#include "ns3/packet-filter.h"
+#include "ns3/packet.h"
+#include "ns3/uinteger.h"
+#include "ns3/double.h"
+#include "ns3/boolean.h"
+#include "ns3/string.h"
+#include "ns3/pointer.h"
+#include "ns3/simulator.h"
+#include <cmath>
+#include <vector>
+#include <map>
+
+using namespace ns3;
+
+/**
+ * \ingroup traffic-control-test
+ * \ingroup tests
+ *
+ * \brief Choke Queue Disc Test Item, carrying the identifier of its flow
+ */
+class ChokeQueueDiscTestItem : public QueueDiscItem {
+public:
+  /**
+   * Constructor
+   *
+   * \param p packet
+   * \param flow the flow identifier
+   * \param ecnCapable ECN capable flag
+   * \param dscp the DSCP
+   */
+  ChokeQueueDiscTestItem (Ptr<Packet> p, int32_t flow, bool ecnCapable, uint8_t dscp = 0);
+  virtual ~ChokeQueueDiscTestItem ();
+  virtual void AddHeader (void);
+  virtual bool Mark (void);
+  virtual bool GetUint8Value (Uint8Values field, uint8_t &value) const;
+  /**
+   * \return the flow identifier
+   */
+  int32_t GetFlow (void) const;
+
+private:
+  ChokeQueueDiscTestItem ();
+  /**
+   * \brief Copy constructor
+   * Disable default implementation to avoid misuse
+   */
+  ChokeQueueDiscTestItem (const ChokeQueueDiscTestItem &);
+  /**
+   * \brief Assignment operator
+   * \return this object
+   * Disable default implementation to avoid misuse
+   */
+  ChokeQueueDiscTestItem &operator = (const ChokeQueueDiscTestItem &);
+  int32_t m_flow; ///< the flow identifier
+  bool m_ecnCapablePacket; ///< ECN capable packet?
+  uint8_t m_dscp; ///< the DSCP
+};
+
+ChokeQueueDiscTestItem::ChokeQueueDiscTestItem (Ptr<Packet> p, int32_t flow, bool ecnCapable, uint8_t dscp)
+  : QueueDiscItem (p, Address (), 0),
+    m_flow (flow),
+    m_ecnCapablePacket (ecnCapable),
+    m_dscp (dscp)
+{
+}
+
+ChokeQueueDiscTestItem::~ChokeQueueDiscTestItem ()
+{
+}
+
+void
+ChokeQueueDiscTestItem::AddHeader (void)
+{
+}
+
+bool
+ChokeQueueDiscTestItem::Mark (void)
+{
+  if (m_ecnCapablePacket)
+    {
+      return true;
+    }
+  return false;
+}
+
+bool
+ChokeQueueDiscTestItem::GetUint8Value (Uint8Values field, uint8_t &value) const
+{
+  if (field == IP_DSFIELD)
+    {
+      value = m_dscp << 2;
+      return true;
+    }
+  return false;
+}
+
+int32_t
+ChokeQueueDiscTestItem::GetFlow (void) const
+{
+  return m_flow;
+}
+
+/**
+ * \ingroup traffic-control-test
+ * \ingroup tests
+ *
+ * \brief Choke Queue Disc Test Filter, classifying packets by their flow identifier
+ */
+class ChokeQueueDiscTestFilter : public PacketFilter
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+
+private:
+  virtual bool CheckProtocol (Ptr<QueueDiscItem> item) const;
+  virtual int32_t DoClassify (Ptr<QueueDiscItem> item) const;
+};
+
+TypeId
+ChokeQueueDiscTestFilter::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::ChokeQueueDiscTestFilter")
+    .SetParent<PacketFilter> ()
+    .SetGroupName ("TrafficControl")
+    .AddConstructor<ChokeQueueDiscTestFilter> ()
+  ;
+  return tid;
+}
+
+bool
+ChokeQueueDiscTestFilter::CheckProtocol (Ptr<QueueDiscItem> item) const
+{
+  return true;
+}
+
+int32_t
+ChokeQueueDiscTestFilter::DoClassify (Ptr<QueueDiscItem> item) const
+{
+  return StaticCast<ChokeQueueDiscTestItem> (item)->GetFlow ();
+}
+
+/**
+ * \ingroup traffic-control-test
+ * \ingroup tests
+ *
+ * \brief Choke Queue Disc Test Case
+ */
+class ChokeQueueDiscTestCase : public TestCase
+{
+public:
+  ChokeQueueDiscTestCase ();
+  virtual void DoRun (void);
+private:
+  /**
+   * Enqueue function
+   * \param queue the queue disc
+   * \param size the size
+   * \param nPkt the number of packets
+   * \param flow the flow of the packets, or -1 to use a distinct flow for each packet
+   * \param ecnCapable ECN capable flag
+   */
+  void Enqueue (Ptr<ChokeQueueDisc> queue, uint32_t size, uint32_t nPkt, int32_t flow, bool ecnCapable);
+  /**
+   * Create a CHOKe queue disc
+   * \param mode the mode
+   * \param modeSize 1 for packets, the packet size for bytes
+   * \param minTh the minimum threshold, in packets
+   * \param maxTh the maximum threshold, in packets
+   * \param qSize the queue limit, in packets
+   * \return the queue disc
+   */
+  Ptr<ChokeQueueDisc> CreateQueueDisc (StringValue mode, uint32_t modeSize, double minTh, double maxTh, uint32_t qSize);
+  /**
+   * Run CHOKe test function
+   * \param mode the mode
+   */
+  void RunChokeTest (StringValue mode);
+  int32_t m_nextFlow; //!< the next distinct flow identifier
+};
+
+ChokeQueueDiscTestCase::ChokeQueueDiscTestCase ()
+  : TestCase ("Sanity check on the choke queue implementation"),
+    m_nextFlow (1)
+{
+}
+
+Ptr<ChokeQueueDisc>
+ChokeQueueDiscTestCase::CreateQueueDisc (StringValue mode, uint32_t modeSize, double minTh, double maxTh, uint32_t qSize)
+{
+  Ptr<ChokeQueueDisc> queue = CreateObject<ChokeQueueDisc> ();
+  NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("Mode", mode), true,
+                         "Verify that we can actually set the attribute Mode");
+  NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("MinTh", DoubleValue (minTh * modeSize)), true,
+                         "Verify that we can actually set the attribute MinTh");
+  NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("MaxTh", DoubleValue (maxTh * modeSize)), true,
+                         "Verify that we can actually set the attribute MaxTh");
+  NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("QueueLimit", UintegerValue (qSize * modeSize)), true,
+                         "Verify that we can actually set the attribute QueueLimit");
+  NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("QW", DoubleValue (1)), true,
+                         "Verify that we can actually set the attribute QW");
+  queue->AddPacketFilter (CreateObject<ChokeQueueDiscTestFilter> ());
+  queue->AssignStreams (1);
+  queue->Initialize ();
+  return queue;
+}
+
+void
+ChokeQueueDiscTestCase::RunChokeTest (StringValue mode)
+{
+  uint32_t pktSize = 1000;
+  // 1 for packets; pktSize for bytes
+  uint32_t modeSize = 1;
+  if (mode.Get () == "QUEUE_DISC_MODE_BYTES")
+    {
+      modeSize = pktSize;
+    }
+  Ptr<ChokeQueueDisc> queue;
+  QueueDisc::Stats st;
+
+  // test 1: simple enqueue/dequeue with no drops
+  queue = CreateQueueDisc (mode, modeSize, 2, 5, 8);
+  queue->SetAttribute ("QW", DoubleValue (0.002));
+  Ptr<QueueDiscItem> items[3];
+  for (uint32_t i = 0; i < 3; i++)
+    {
+      items[i] = Create<ChokeQueueDiscTestItem> (Create<Packet> (pktSize), m_nextFlow++, false);
+      queue->Enqueue (items[i]);
+    }
+  NS_TEST_EXPECT_MSG_EQ (queue->GetQueueSize (), 3 * modeSize, "There should be three packets in there");
+  for (uint32_t i = 0; i < 3; i++)
+    {
+      Ptr<QueueDiscItem> item = queue->Dequeue ();
+      NS_TEST_EXPECT_MSG_EQ ((item != 0), true, "I want to remove a packet");
+      NS_TEST_EXPECT_MSG_EQ (item->GetPacket ()->GetUid (), items[i]->GetPacket ()->GetUid (), "Was this the right packet?");
+    }
+  NS_TEST_EXPECT_MSG_EQ (queue->GetQueueSize (), 0, "There should be no packets in there");
+  NS_TEST_EXPECT_MSG_EQ ((queue->Dequeue () == 0), true, "There are really no packets in there");
+  queue->Dispose ();
+
+  // test 2: packets of distinct flows are dropped (forced) only when the
+  // average queue size exceeds MaxTh
+  queue = CreateQueueDisc (mode, modeSize, 2, 5, 8);
+  Enqueue (queue, pktSize, 7, -1, false);
+  st = queue->GetStats ();
+  NS_TEST_EXPECT_MSG_EQ (queue->GetQueueSize (), 5 * modeSize, "There should be five packets in there");
+  NS_TEST_EXPECT_MSG_EQ (st.GetNDroppedPackets (ChokeQueueDisc::FORCED_DROP), 2, "There should be two forced drops");
+  NS_TEST_EXPECT_MSG_EQ (st.GetNDroppedPackets (ChokeQueueDisc::UNFORCED_DROP), 0, "There should be no unforced drops");
+  NS_TEST_EXPECT_MSG_EQ (st.GetNDroppedPackets (ChokeQueueDisc::CHOKE_DROP), 0, "There should be no CHOKe drops");
+  queue->Dispose ();
+
+  // test 3: with ECN and no hard drop, ECN capable packets are marked instead
+  queue = CreateQueueDisc (mode, modeSize, 2, 5, 8);
+  queue->SetAttribute ("UseEcn", BooleanValue (true));
+  queue->SetAttribute ("UseHardDrop", BooleanValue (false));
+  Enqueue (queue, pktSize, 7, -1, true);
+  st = queue->GetStats ();
+  NS_TEST_EXPECT_MSG_EQ (queue->GetQueueSize (), 7 * modeSize, "There should be seven packets in there");
+  NS_TEST_EXPECT_MSG_EQ (st.GetNMarkedPackets (ChokeQueueDisc::FORCED_MARK), 2, "There should be two forced marks");
+  NS_TEST_EXPECT_MSG_EQ (st.nTotalDroppedPackets, 0, "There should be no drops");
+  queue->Dispose ();
+
+  // test 4: with ECN and hard drop, packets are dropped above MaxTh
+  queue = CreateQueueDisc (mode, modeSize, 2, 5, 8);
+  queue->SetAttribute ("UseEcn", BooleanValue (true));
+  Enqueue (queue, pktSize, 7, -1, true);
+  st = queue->GetStats ();
+  NS_TEST_EXPECT_MSG_EQ (st.GetNDroppedPackets (ChokeQueueDisc::FORCED_DROP), 2, "There should be two forced drops");
+  NS_TEST_EXPECT_MSG_EQ (st.GetNMarkedPackets (ChokeQueueDisc::FORCED_MARK), 0, "There should be no forced marks");
+  queue->Dispose ();
+
+  // test 5: above MinTh, an arriving packet and a victim of the same flow are
+  // dropped. The average queue size alternates between 1 and 2 packets, hence
+  // every other arriving packet is dropped together with a victim
+  queue = CreateQueueDisc (mode, modeSize, 2, 5, 8);
+  Enqueue (queue, pktSize, 10, 0, false);
+  st = queue->GetStats ();
+  NS_TEST_EXPECT_MSG_EQ (queue->GetQueueSize (), 2 * modeSize, "There should be two packets in there");
+  NS_TEST_EXPECT_MSG_EQ (st.GetNDroppedPackets (ChokeQueueDisc::CHOKE_DROP), 8, "There should be eight CHOKe drops");
+  NS_TEST_EXPECT_MSG_EQ (st.nTotalDroppedPackets, 8, "There should be no other drops");
+  queue->Dispose ();
+
+  // test 6: unforced drops and marks between MinTh and MaxTh
+  queue = CreateQueueDisc (mode, modeSize, 2, 500, 1000);
+  queue->SetAttribute ("LInterm", DoubleValue (1));
+  queue->SetAttribute ("Wait", BooleanValue (false));
+  Enqueue (queue, pktSize, 400, -1, false);
+  st = queue->GetStats ();
+  uint32_t unforcedDrops = st.GetNDroppedPackets (ChokeQueueDisc::UNFORCED_DROP);
+  NS_TEST_EXPECT_MSG_GT (unforcedDrops, 0, "There should be some unforced drops");
+  NS_TEST_EXPECT_MSG_EQ (st.nTotalMarkedPackets, 0, "There should be no marks");
+  queue->Dispose ();
+
+  queue = CreateQueueDisc (mode, modeSize, 2, 500, 1000);
+  queue->SetAttribute ("LInterm", DoubleValue (1));
+  queue->SetAttribute ("Wait", BooleanValue (false));
+  queue->SetAttribute ("UseEcn", BooleanValue (true));
+  Enqueue (queue, pktSize, 400, -1, true);
+  st = queue->GetStats ();
+  NS_TEST_EXPECT_MSG_GT (st.GetNMarkedPackets (ChokeQueueDisc::UNFORCED_MARK), 0, "There should be some unforced marks");
+  NS_TEST_EXPECT_MSG_EQ (st.nTotalDroppedPackets, 0, "There should be no drops");
+  NS_TEST_EXPECT_MSG_EQ (queue->GetQueueSize (), 400 * modeSize, "All the packets should be in there");
+  queue->Dispose ();
+}
+
+void
+ChokeQueueDiscTestCase::Enqueue (Ptr<ChokeQueueDisc> queue, uint32_t size, uint32_t nPkt, int32_t flow, bool ecnCapable)
+{
+  for (uint32_t i = 0; i < nPkt; i++)
+    {
+      queue->Enqueue (Create<ChokeQueueDiscTestItem> (Create<Packet> (size), (flow < 0 ? m_nextFlow++ : flow), ecnCapable));
+    }
+}
+
+void
+ChokeQueueDiscTestCase::DoRun (void)
+{
+  RunChokeTest (StringValue ("QUEUE_DISC_MODE_PACKETS"));
+  RunChokeTest (StringValue ("QUEUE_DISC_MODE_BYTES"));
+  Simulator::Destroy ();
+}
+
+/**
+ * \ingroup traffic-control-test
+ * \ingroup tests
+ *
+ * \brief Choke Queue Disc Multiple Draws Test Case
+ */
+class ChokeQueueDiscMultiDrawTestCase : public TestCase
+{
+public:
+  ChokeQueueDiscMultiDrawTestCase ();
+  virtual void DoRun (void);
+private:
+  /**
+   * Create a CHOKe queue disc whose average queue size is the current queue size
+   * \param nDraws the number of victims drawn for each arriving packet
+   * \param adaptive whether the number of victims depends on the average queue size
+   * \param maxTh the maximum threshold
+   * \param stream the random variable stream to use
+   * \return the queue disc
+   */
+  Ptr<ChokeQueueDisc> CreateQueueDisc (uint32_t nDraws, bool adaptive, double maxTh, int64_t stream);
+  /**
+   * Fill the queue disc without running the CHOKe algorithm
+   * \param queue the queue disc
+   * \param nPkt the number of packets
+   * \param period one packet of flow 0 is enqueued every period packets, the
+   *        others belong to distinct flows
+   */
+  void Fill (Ptr<ChokeQueueDisc> queue, uint32_t nPkt, uint32_t period);
+};
+
+ChokeQueueDiscMultiDrawTestCase::ChokeQueueDiscMultiDrawTestCase ()
+  : TestCase ("Check the drops of CHOKe when multiple victims are drawn")
+{
+}
+
+Ptr<ChokeQueueDisc>
+ChokeQueueDiscMultiDrawTestCase::CreateQueueDisc (uint32_t nDraws, bool adaptive, double maxTh, int64_t stream)
+{
+  Ptr<ChokeQueueDisc> queue = CreateObject<ChokeQueueDisc> ();
+  queue->SetAttribute ("QueueLimit", UintegerValue (10000));
+  queue->SetAttribute ("MinTh", DoubleValue (1));
+  queue->SetAttribute ("MaxTh", DoubleValue (maxTh));
+  queue->SetAttribute ("NumDraws", UintegerValue (nDraws));
+  queue->SetAttribute ("AdaptiveDraws", BooleanValue (adaptive));
+  queue->AddPacketFilter (CreateObject<ChokeQueueDiscTestFilter> ());
+  queue->AssignStreams (stream);
+  queue->Initialize ();
+  return queue;
+}
+
+void
+ChokeQueueDiscMultiDrawTestCase::Fill (Ptr<ChokeQueueDisc> queue, uint32_t nPkt, uint32_t period)
+{
+  // the average queue size is kept null while filling the queue disc
+  queue->SetAttribute ("QW", DoubleValue (0));
+  for (uint32_t i = 0; i < nPkt; i++)
+    {
+      queue->Enqueue (Create<ChokeQueueDiscTestItem> (Create<Packet> (500), (i % period == period - 1) ? 0 : i + 1, false));
+    }
+  queue->SetAttribute ("QW", DoubleValue (1));
+}
+
+void
+ChokeQueueDiscMultiDrawTestCase::DoRun (void)
+{
+  Ptr<ChokeQueueDisc> queue;
+  uint32_t nPkt = 100;
+
+  // test 1: no victim belongs to the flow of the arriving packet
+  queue = CreateQueueDisc (4, false, 10000, 1);
+  Fill (queue, nPkt, nPkt + 1);
+  queue->Enqueue (Create<ChokeQueueDiscTestItem> (Create<Packet> (500), 0, false));
+  NS_TEST_EXPECT_MSG_EQ (queue->GetNPackets (), nPkt + 1, "The arriving packet should have been enqueued");
+  NS_TEST_EXPECT_MSG_EQ (queue->GetStats ().GetNDroppedPackets (ChokeQueueDisc::CHOKE_DROP), 0,
+                         "There should be no CHOKe drops");
+  queue->Dispose ();
+
+  // test 2: all the victims belong to the flow of the arriving packet
+  queue = CreateQueueDisc (4, false, 10000, 2);
+  Fill (queue, nPkt, 1);
+  queue->Enqueue (Create<ChokeQueueDiscTestItem> (Create<Packet> (500), 0, false));
+  uint32_t nVictims = nPkt - queue->GetNPackets ();
+  NS_TEST_EXPECT_MSG_GT (nVictims, 0, "At least one victim should have been dropped");
+  NS_TEST_EXPECT_MSG_LT_OR_EQ (nVictims, 4, "At most NumDraws victims should have been dropped");
+  NS_TEST_EXPECT_MSG_EQ (queue->GetStats ().GetNDroppedPackets (ChokeQueueDisc::CHOKE_DROP), nVictims + 1,
+                         "The arriving packet and the victims should have been dropped");
+  queue->Dispose ();
+
+  // test 3: the arriving packet is dropped with probability 1 - (1 - f)^k, where
+  // f is the fraction of the queue (except the head) occupied by its flow
+  for (uint32_t nDraws = 1; nDraws <= 4; nDraws *= 2)
+    {
+      uint32_t nTrials = 1000;
+      uint32_t nDrops = 0;
+      uint32_t maxVictims = 0;
+      for (uint32_t i = 0; i < nTrials; i++)
+        {
+          queue = CreateQueueDisc (nDraws, false, 10000, 3 + 2 * i);
+          Fill (queue, nPkt, 2);
+          queue->Enqueue (Create<ChokeQueueDiscTestItem> (Create<Packet> (500), 0, false));
+          if (queue->GetNPackets () <= nPkt)
+            {
+              nDrops++;
+              maxVictims = std::max (maxVictims, nPkt - queue->GetNPackets ());
+            }
+          queue->Dispose ();
+        }
+      double expected = 1 - std::pow (1 - (nPkt / 2.0) / (nPkt - 1), nDraws);
+      NS_TEST_EXPECT_MSG_EQ_TOL (double (nDrops) / nTrials, expected, 0.05,
+                                 "Unexpected CHOKe drop probability with " << nDraws << " draws");
+      NS_TEST_EXPECT_MSG_LT_OR_EQ (maxVictims, nDraws, "At most NumDraws victims should have been dropped");
+    }
+
+  // test 4: in adaptive mode, the number of victims grows with the average queue size.
+  // With MinTh = 1 and MaxTh = 2 * nPkt, less than half of NumDraws victims are drawn
+  queue = CreateQueueDisc (8, true, 2 * nPkt, 4);
+  Fill (queue, nPkt, 1);
+  queue->Enqueue (Create<ChokeQueueDiscTestItem> (Create<Packet> (500), 0, false));
+  nVictims = nPkt - queue->GetNPackets ();
+  NS_TEST_EXPECT_MSG_GT (nVictims, 0, "At least one victim should have been dropped");
+  NS_TEST_EXPECT_MSG_LT_OR_EQ (nVictims, 4, "At most half of NumDraws victims should have been dropped");
+  queue->Dispose ();
+
+  // above MaxTh, NumDraws victims are drawn
+  queue = CreateQueueDisc (8, true, nPkt / 2, 5);
+  Fill (queue, nPkt, 1);
+  queue->Enqueue (Create<ChokeQueueDiscTestItem> (Create<Packet> (500), 0, false));
+  nVictims = nPkt - queue->GetNPackets ();
+  NS_TEST_EXPECT_MSG_GT (nVictims, 4, "More than half of NumDraws victims should have been dropped");
+  NS_TEST_EXPECT_MSG_LT_OR_EQ (nVictims, 8, "At most NumDraws victims should have been dropped");
+  queue->Dispose ();
+
+  Simulator::Destroy ();
+}
+
+/**
+ * \ingroup traffic-control-test
+ * \ingroup tests
+ *
+ * \brief Choke Queue Disc Stream Test Case, checking that the victims drawn
+ * only depend on the random variable stream assigned to the queue disc
+ */
+class ChokeQueueDiscStreamTestCase : public TestCase
+{
+public:
+  ChokeQueueDiscStreamTestCase ();
+  virtual void DoRun (void);
+private:
+  /**
+   * Push packets of a few flows through a CHOKe queue disc
+   * \param stream the random variable stream to use
+   * \return the uids of the packets left in the queue disc
+   */
+  std::vector<uint64_t> Run (int64_t stream);
+};
+
+ChokeQueueDiscStreamTestCase::ChokeQueueDiscStreamTestCase ()
+  : TestCase ("Check that the CHOKe victims are reproducible through AssignStreams")
+{
+}
+
+std::vector<uint64_t>
+ChokeQueueDiscStreamTestCase::Run (int64_t stream)
+{
+  Ptr<ChokeQueueDisc> queue = CreateObject<ChokeQueueDisc> ();
+  queue->SetAttribute ("QueueLimit", UintegerValue (1000));
+  queue->SetAttribute ("QW", DoubleValue (1));
+  queue->SetAttribute ("MinTh", DoubleValue (1));
+  queue->SetAttribute ("MaxTh", DoubleValue (1000));
+  queue->SetAttribute ("NumDraws", UintegerValue (2));
+  queue->AddPacketFilter (CreateObject<ChokeQueueDiscTestFilter> ());
+  queue->AssignStreams (stream);
+  queue->Initialize ();
+
+  Ptr<Packet> p = Create<Packet> (500);
+  std::vector<Ptr<Packet> > packets;
+  for (uint32_t i = 0; i < 500; i++)
+    {
+      packets.push_back (p->Copy ());
+      queue->Enqueue (Create<ChokeQueueDiscTestItem> (packets.back (), i % 7, false));
+    }
+
+  std::vector<uint64_t> uids;
+  Ptr<QueueDiscItem> item;
+  while ((item = queue->Dequeue ()) != 0)
+    {
+      uids.push_back (item->GetPacket ()->GetUid () - packets.front ()->GetUid ());
+    }
+  queue->Dispose ();
+  return uids;
+}
+
+void
+ChokeQueueDiscStreamTestCase::DoRun (void)
+{
+  std::vector<uint64_t> run1 = Run (10);
+  std::vector<uint64_t> run2 = Run (10);
+  std::vector<uint64_t> run3 = Run (20);
+
+  NS_TEST_EXPECT_MSG_LT (run1.size (), 500, "Some packets should have been dropped");
+  NS_TEST_EXPECT_MSG_EQ ((run1 == run2), true, "The same stream should drop the same packets");
+  NS_TEST_EXPECT_MSG_EQ ((run1 == run3), false, "Different streams should drop different packets");
+
+  Simulator::Destroy ();
+}
+
+/**
+ * \ingroup traffic-control-test
+ * \ingroup tests
+ *
+ * \brief Flow Occupancy Table Test Case, comparing the table with a map
+ */
+class FlowOccupancyTableTestCase : public TestCase
+{
+public:
+  FlowOccupancyTableTestCase ();
+  virtual void DoRun (void);
+};
+
+FlowOccupancyTableTestCase::FlowOccupancyTableTestCase ()
+  : TestCase ("Check the packets and bytes held by each flow in a FlowOccupancyTable")
+{
+}
+
+void
+FlowOccupancyTableTestCase::DoRun (void)
+{
+  FlowOccupancyTable table;
+  std::map<int32_t, std::pair<uint32_t, uint32_t> > reference;
+  Ptr<UniformRandomVariable> rv = CreateObject<UniformRandomVariable> ();
+  rv->SetStream (1);
+
+  // flows are few consecutive integers, large random integers and -1
+  for (uint32_t i = 0; i < 20000; i++)
+    {
+      int32_t flow = rv->GetInteger (0, 99);
+      if (flow >= 90)
+        {
+          flow = (flow == 99) ? -1 : 0x7ff00000 + (flow << 16);
+        }
+      uint32_t bytes = 1 + (flow & 7);
+      std::map<int32_t, std::pair<uint32_t, uint32_t> >::iterator it = reference.find (flow);
+      if (rv->GetInteger (0, 2) > 0 || it == reference.end ())
+        {
+          table.Add (flow, bytes);
+          reference[flow].first++;
+          reference[flow].second += bytes;
+        }
+      else
+        {
+          table.Remove (flow, bytes);
+          it->second.first--;
+          it->second.second -= bytes;
+          if (it->second.first == 0)
+            {
+              reference.erase (it);
+            }
+        }
+    }
+
+  NS_TEST_EXPECT_MSG_EQ (table.GetNFlows (), reference.size (), "Unexpected number of flows");
+  for (int32_t flow = -1; flow < 90; flow++)
+    {
+      std::map<int32_t, std::pair<uint32_t, uint32_t> >::iterator it = reference.find (flow);
+      uint32_t packets = (it == reference.end () ? 0 : it->second.first);
+      uint32_t bytes = (it == reference.end () ? 0 : it->second.second);
+      NS_TEST_EXPECT_MSG_EQ (table.GetNPackets (flow), packets, "Unexpected number of packets of flow " << flow);
+      NS_TEST_EXPECT_MSG_EQ (table.GetNBytes (flow), bytes, "Unexpected number of bytes of flow " << flow);
+    }
+
+  // empty the table
+  for (std::map<int32_t, std::pair<uint32_t, uint32_t> >::iterator it = reference.begin (); it != reference.end (); it++)
+    {
+      for (uint32_t i = 0; i < it->second.first; i++)
+        {
+          table.Remove (it->first, (i == 0) ? it->second.second - it->second.first + 1 : 1);
+        }
+    }
+  NS_TEST_EXPECT_MSG_EQ (table.GetNFlows (), 0, "The table should be empty");
+  NS_TEST_EXPECT_MSG_EQ (table.GetNPackets (0), 0, "The table should be empty");
+
+  // flows differing only in their high bits do not share the same slot
+  for (int32_t flow = 0; flow < 200; flow++)
+    {
+      table.Add (flow << 20, 1);
+    }
+  NS_TEST_EXPECT_MSG_EQ (table.GetNFlows (), 200, "Unexpected number of flows");
+  NS_TEST_EXPECT_MSG_LT_OR_EQ (table.GetMaxProbeDistance (), 8, "Lookups should take few probes");
+  for (int32_t flow = 0; flow < 200; flow++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (table.GetNPackets (flow << 20), 1, "Unexpected number of packets of flow " << flow);
+    }
+}
+
+/**
+ * \ingroup traffic-control-test
+ * \ingroup tests
+ *
+ * \brief Choke Queue Disc Flow Stats Test Case, checking that the flows holding
+ * more than their fair share of the queue are dropped
+ */
+class ChokeQueueDiscFlowStatsTestCase : public TestCase
+{
+public:
+  ChokeQueueDiscFlowStatsTestCase ();
+  virtual void DoRun (void);
+private:
+  /**
+   * Push the packets of an unresponsive flow and of a few other flows through
+   * a CHOKe queue disc
+   * \param useFlowStats whether UseFlowStats is enabled
+   * \return the number of packets of the unresponsive flow in the queue disc
+   */
+  uint32_t Run (bool useFlowStats);
+};
+
+ChokeQueueDiscFlowStatsTestCase::ChokeQueueDiscFlowStatsTestCase ()
+  : TestCase ("Check that CHOKe drops the packets of the flows holding too much buffer")
+{
+}
+
+uint32_t
+ChokeQueueDiscFlowStatsTestCase::Run (bool useFlowStats)
+{
+  Ptr<ChokeQueueDisc> queue = CreateObject<ChokeQueueDisc> ();
+  queue->SetAttribute ("QueueLimit", UintegerValue (1000));
+  queue->SetAttribute ("QW", DoubleValue (1));
+  queue->SetAttribute ("MinTh", DoubleValue (10));
+  queue->SetAttribute ("MaxTh", DoubleValue (1000));
+  queue->SetAttribute ("UseFlowStats", BooleanValue (useFlowStats));
+  queue->SetAttribute ("HotFlowFactor", DoubleValue (2));
+  queue->AddPacketFilter (CreateObject<ChokeQueueDiscTestFilter> ());
+  queue->AssignStreams (1);
+  queue->Initialize ();
+
+  // flow 0 sends 10 packets every time each of flows 1 to 10 sends one. One
+  // packet is dequeued for every 2 enqueued
+  for (uint32_t i = 0; i < 4000; i++)
+    {
+      int32_t flow = (i % 20 < 10) ? 0 : i % 20 - 9;
+      queue->Enqueue (Create<ChokeQueueDiscTestItem> (Create<Packet> (500), flow, false));
+      if (i % 2)
+        {
+          queue->Dequeue ();
+        }
+    }
+
+  uint32_t nPackets = queue->GetNPackets ();
+  uint32_t nFlow0 = 0;
+  Ptr<QueueDiscItem> item;
+  while ((item = queue->Dequeue ()) != 0)
+    {
+      if (StaticCast<ChokeQueueDiscTestItem> (item)->GetFlow () == 0)
+        {
+          nFlow0++;
+        }
+    }
+  NS_TEST_EXPECT_MSG_GT (nPackets, 20, "The queue disc should not be empty");
+  if (useFlowStats)
+    {
+      // flow 0 cannot hold more than twice the fair share (1/11) of the queue
+      NS_TEST_EXPECT_MSG_LT_OR_EQ (nFlow0, 2 * nPackets / 11 + 1, "Flow 0 holds too many packets");
+      NS_TEST_EXPECT_MSG_GT (queue->GetStats ().GetNDroppedPackets (ChokeQueueDisc::HOT_FLOW_DROP), 0,
+                             "There should be hot flow drops");
+    }
+  else
+    {
+      NS_TEST_EXPECT_MSG_EQ (queue->GetStats ().GetNDroppedPackets (ChokeQueueDisc::HOT_FLOW_DROP), 0,
+                             "There should be no hot flow drops");
+    }
+  queue->Dispose ();
+  return nFlow0;
+}
+
+void
+ChokeQueueDiscFlowStatsTestCase::DoRun (void)
+{
+  uint32_t nFlow0 = Run (false);
+  uint32_t nFlow0Stats = Run (true);
+  NS_TEST_EXPECT_MSG_LT (nFlow0Stats, nFlow0, "Flow 0 should hold less buffer with UseFlowStats");
+
+  Simulator::Destroy ();
+}
+
+/**
+ * \ingroup traffic-control-test
+ * \ingroup tests
+ *
+ * \brief Choke Queue Disc DSCP Test Case, checking the parameters of the DiffServ classes
+ */
+class ChokeQueueDiscDscpTestCase : public TestCase
+{
+public:
+  ChokeQueueDiscDscpTestCase ();
+  virtual void DoRun (void);
+private:
+  /**
+   * Enqueue the packets of a single flow into a CHOKe queue disc having an
+   * expedited forwarding class that spares flow matches and an assured
+   * forwarding class with a high minimum threshold
+   * \param dscp the DSCP of the packets
+   * \param nPackets the number of packets to enqueue
+   * \return the queue disc
+   */
+  Ptr<ChokeQueueDisc> Run (uint8_t dscp, uint32_t nPackets);
+};
+
+ChokeQueueDiscDscpTestCase::ChokeQueueDiscDscpTestCase ()
+  : TestCase ("Check the CHOKe parameters of the DiffServ classes")
+{
+}
+
+Ptr<ChokeQueueDisc>
+ChokeQueueDiscDscpTestCase::Run (uint8_t dscp, uint32_t nPackets)
+{
+  Ptr<ChokeQueueDisc> queue = CreateObject<ChokeQueueDisc> ();
+  queue->SetAttribute ("QueueLimit", UintegerValue (1000));
+  queue->SetAttribute ("QW", DoubleValue (1));
+  queue->SetAttribute ("MinTh", DoubleValue (5));
+  queue->SetAttribute ("MaxTh", DoubleValue (1000));
+  queue->SetDscpClass (46, 5, 1000, 0);      // EF
+  queue->SetDscpClass (10, 200, 1000, 1);    // AF11
+  queue->AddPacketFilter (CreateObject<ChokeQueueDiscTestFilter> ());
+  queue->AssignStreams (1);
+  queue->Initialize ();
+
+  for (uint32_t i = 0; i < nPackets; i++)
+    {
+      queue->Enqueue (Create<ChokeQueueDiscTestItem> (Create<Packet> (500), 1, false, dscp));
+    }
+  return queue;
+}
+
+void
+ChokeQueueDiscDscpTestCase::DoRun (void)
+{
+  // best effort packets use MinTh and are dropped on every flow match
+  Ptr<ChokeQueueDisc> queue = Run (0, 100);
+  QueueDisc::Stats st = queue->GetStats ();
+  NS_TEST_EXPECT_MSG_GT (st.GetNDroppedPackets (ChokeQueueDisc::CHOKE_DROP), 0, "There should be CHOKe drops");
+  NS_TEST_EXPECT_MSG_LT (queue->GetNPackets (), 10, "A single flow cannot fill the queue");
+
+  queue->Dispose ();
+
+  // expedited forwarding packets are never dropped on a flow match
+  queue = Run (46, 100);
+  st = queue->GetStats ();
+  NS_TEST_EXPECT_MSG_EQ (st.nTotalDroppedPackets, 0, "There should be no drops");
+  NS_TEST_EXPECT_MSG_EQ (queue->GetNPackets (), 100, "All the packets should be queued");
+
+  queue->Dispose ();
+
+  // assured forwarding packets are not dropped below their minimum threshold
+  queue = Run (10, 200);
+  st = queue->GetStats ();
+  NS_TEST_EXPECT_MSG_EQ (st.nTotalDroppedPackets, 0, "There should be no drops");
+  queue->Dispose ();
+  queue = Run (10, 300);
+  st = queue->GetStats ();
+  NS_TEST_EXPECT_MSG_GT (st.GetNDroppedPackets (ChokeQueueDisc::CHOKE_DROP), 0, "There should be CHOKe drops");
+  NS_TEST_EXPECT_MSG_GT_OR_EQ (queue->GetNPackets (), 200, "The minimum threshold should have been reached");
+  queue->Dispose ();
+
+  Simulator::Destroy ();
+}
+
+/**
+ * \ingroup traffic-control-test
+ * \ingroup tests
+ *
+ * \brief Choke Queue Disc Shard Test Case, checking that the shards of a
+ * multi-queue CHOKe compare the average total queue size with their thresholds
+ */
+class ChokeQueueDiscShardTestCase : public TestCase
+{
+public:
+  ChokeQueueDiscShardTestCase ();
+  virtual void DoRun (void);
+private:
+  /**
+   * Create a CHOKe queue disc belonging to a shard group
+   * \param group the shard group
+   * \param minTh the minimum threshold
+   * \param maxTh the maximum threshold
+   * \return the queue disc
+   */
+  Ptr<ChokeQueueDisc> CreateShard (Ptr<ChokeShardGroup> group, double minTh, double maxTh);
+};
+
+ChokeQueueDiscShardTestCase::ChokeQueueDiscShardTestCase ()
+  : TestCase ("Check the average queue size of the shards of a multi-queue CHOKe")
+{
+}
+
+Ptr<ChokeQueueDisc>
+ChokeQueueDiscShardTestCase::CreateShard (Ptr<ChokeShardGroup> group, double minTh, double maxTh)
+{
+  Ptr<ChokeQueueDisc> queue = CreateObject<ChokeQueueDisc> ();
+  queue->SetAttribute ("QueueLimit", UintegerValue (100));
+  queue->SetAttribute ("QW", DoubleValue (1));
+  queue->SetAttribute ("MinTh", DoubleValue (minTh));
+  queue->SetAttribute ("MaxTh", DoubleValue (maxTh));
+  queue->SetAttribute ("ShardGroup", PointerValue (group));
+  queue->AddPacketFilter (CreateObject<ChokeQueueDiscTestFilter> ());
+  queue->AssignStreams (1);
+  queue->Initialize ();
+  return queue;
+}
+
+void
+ChokeQueueDiscShardTestCase::DoRun (void)
+{
+  Ptr<ChokeShardGroup> group = CreateObject<ChokeShardGroup> ();
+  Ptr<ChokeQueueDisc> shard0 = CreateShard (group, 100, 100);
+  Ptr<ChokeQueueDisc> shard1 = CreateShard (group, 5, 10);
+  NS_TEST_EXPECT_MSG_EQ (group->GetNShards (), 2, "There should be 2 shards");
+
+  // the packets of shard 0 are below its thresholds
+  for (uint32_t i = 0; i < 20; i++)
+    {
+      shard0->Enqueue (Create<ChokeQueueDiscTestItem> (Create<Packet> (500), i, false));
+    }
+  NS_TEST_EXPECT_MSG_EQ (shard0->GetNPackets (), 20, "There should be 20 packets in shard 0");
+  NS_TEST_EXPECT_MSG_EQ (group->GetSize (), 20, "There should be 20 packets in the shards");
+
+  // shard 1 holds no more than 2 packets, but the average total queue size
+  // exceeds its maximum threshold
+  for (uint32_t i = 0; i < 10; i++)
+    {
+      shard1->Enqueue (Create<ChokeQueueDiscTestItem> (Create<Packet> (500), 100 + i, false));
+    }
+  NS_TEST_EXPECT_MSG_EQ (shard1->GetNPackets (), 2, "There should be 2 packets in shard 1");
+  NS_TEST_EXPECT_MSG_EQ (shard1->GetStats ().GetNDroppedPackets (ChokeQueueDisc::FORCED_DROP), 8,
+                         "There should be 8 forced drops in shard 1");
+  NS_TEST_EXPECT_MSG_EQ (group->GetSize (), 22, "There should be 22 packets in the shards");
+  NS_TEST_EXPECT_MSG_EQ (group->GetAverage (), 22, "The average should be the total size of the shards");
+
+  // once shard 0 is drained, shard 1 accepts packets again
+  while (shard0->Dequeue () != 0)
+    {
+    }
+  NS_TEST_EXPECT_MSG_EQ (group->GetSize (), 2, "There should be 2 packets in the shards");
+  shard1->Enqueue (Create<ChokeQueueDiscTestItem> (Create<Packet> (500), 200, false));
+  NS_TEST_EXPECT_MSG_EQ (shard1->GetNPackets (), 3, "There should be 3 packets in shard 1");
+  NS_TEST_EXPECT_MSG_EQ (group->GetShardSize (1), 3, "The size of shard 1 does not match");
+
+  shard0->Dispose ();
+  shard1->Dispose ();
+  Simulator::Destroy ();
+}
+
+/**
+ * \ingroup traffic-control-test
+ * \ingroup tests
+ *
+ * \brief Choke Queue Disc Test Suite
+ */
+static class ChokeQueueDiscTestSuite : public TestSuite
+{
+public:
+  ChokeQueueDiscTestSuite ()
+    : TestSuite ("choke-queue-disc", UNIT)
+  {
+    AddTestCase (new ChokeQueueDiscTestCase (), TestCase::QUICK);
+    AddTestCase (new ChokeQueueDiscMultiDrawTestCase (), TestCase::QUICK);
+    AddTestCase (new ChokeQueueDiscStreamTestCase (), TestCase::QUICK);
+    AddTestCase (new FlowOccupancyTableTestCase (), TestCase::QUICK);
+    AddTestCase (new ChokeQueueDiscFlowStatsTestCase (), TestCase::QUICK);
+    AddTestCase (new ChokeQueueDiscDscpTestCase (), TestCase::QUICK);
+    AddTestCase (new ChokeQueueDiscShardTestCase (), TestCase::QUICK);
+  }
+} g_chokeQueueTestSuite; ///< the test suite
@@ -22,12 +22,14 @@
 
 #include "ns3/test.h"
 #include "ns3/red-queue-disc.h"
+#include "ns3/red-estimator.h"
 #include "ns3/packet.h"
 #include "ns3/uinteger.h"
 #include "ns3/string.h"
 #include "ns3/double.h"
 #include "ns3/log.h"
 #include "ns3/simulator.h"
+#include <cmath>
 
 using namespace ns3;
 
@@ -542,6 +544,129 @@ RedQueueDiscTestCase::DoRun (void)
 
 }
 
+/**
+ * \ingroup traffic-control-test
+ * \ingroup tests
+ *
+ * \brief Red Estimator Test Case, comparing the averages with those computed by std::pow
+ */
+class RedEstimatorTestCase : public TestCase
+{
+public:
+  RedEstimatorTestCase ();
+  virtual void DoRun (void);
+};
+
+RedEstimatorTestCase::RedEstimatorTestCase ()
+  : TestCase ("Check the average queue size computed by the RED estimator")
+{
+}
+
+void
+RedEstimatorTestCase::DoRun (void)
+{
+  RedEstimator estimator;
+  double weights[] = { 0.002, 0.02, 0.5, 1.0, 0.0, 1.0 - std::exp (-1.0 / 375) };
+
+  for (uint32_t w = 0; w < sizeof (weights) / sizeof (weights[0]); w++)
+    {
+      double qW = weights[w];
+      double qAvg = 0;
+      double refAvg = 0;
+      // short gaps between arrivals, as in a busy period, give the same averages
+      for (uint32_t i = 0; i < 1000; i++)
+        {
+          uint32_t m = 1 + i % 64;
+          qAvg = estimator.Estimate (i % 100, m, qAvg, qW);
+          refAvg = refAvg * std::pow (1.0 - qW, m);
+          refAvg += qW * (i % 100);
+          NS_TEST_EXPECT_MSG_EQ (qAvg, refAvg, "The averages should be the same with qW " << qW << " and m " << m);
+        }
+
+      // long idle periods give the same decay within a small relative error
+      uint32_t idle[] = { 64, 65, 100, 1000, 12345, 1000000, 4000000000u };
+      for (uint32_t i = 0; i < sizeof (idle) / sizeof (idle[0]); i++)
+        {
+          double decay = estimator.GetDecay (idle[i], qW);
+          double refDecay = std::pow (1.0 - qW, idle[i]);
+          NS_TEST_EXPECT_MSG_EQ_TOL (decay, refDecay, refDecay * 1e-12 + 1e-300,
+                                     "The decay factors should be close with qW " << qW << " and m " << idle[i]);
+        }
+    }
+}
+
+/**
+ * \ingroup traffic-control-test
+ * \ingroup tests
+ *
+ * \brief Red Queue Disc Batch Test Case, checking the batch enqueue and dequeue operations
+ */
+class RedQueueDiscBatchTestCase : public TestCase
+{
+public:
+  RedQueueDiscBatchTestCase ();
+  virtual void DoRun (void);
+};
+
+RedQueueDiscBatchTestCase::RedQueueDiscBatchTestCase ()
+  : TestCase ("Sanity check on the batch operations of the red queue disc")
+{
+}
+
+void
+RedQueueDiscBatchTestCase::DoRun (void)
+{
+  Ptr<RedQueueDisc> queue = CreateObjectWithAttributes<RedQueueDisc> ("MinTh", DoubleValue (20),
+                                                                      "MaxTh", DoubleValue (40),
+                                                                      "QueueLimit", UintegerValue (10));
+  queue->Initialize ();
+
+  Address dest;
+  std::vector<Ptr<QueueDiscItem> > items;
+  for (uint32_t i = 0; i < 12; i++)
+    {
+      items.push_back (Create<RedQueueDiscTestItem> (Create<Packet> (100 + i), dest, 0, false));
+    }
+
+  // the last two packets exceed the queue limit
+  NS_TEST_EXPECT_MSG_EQ (queue->EnqueueBatch (items), 10, "10 packets should have been enqueued");
+  NS_TEST_EXPECT_MSG_EQ (queue->GetNPackets (), 10, "There should be 10 packets in there");
+  QueueDisc::Stats st = queue->GetStats ();
+  NS_TEST_EXPECT_MSG_EQ (st.nTotalReceivedPackets, 12, "12 packets should have been received");
+  NS_TEST_EXPECT_MSG_EQ (st.nTotalDroppedPackets, 2, "2 packets should have been dropped");
+  // the reason is found by content, whatever its address
+  std::string reason (QueueDisc::INTERNAL_QUEUE_DROP);
+  NS_TEST_EXPECT_MSG_EQ (QueueDisc::InternReason (reason.c_str ()), QueueDisc::InternReason (QueueDisc::INTERNAL_QUEUE_DROP),
+                         "A reason should have a single identifier");
+  NS_TEST_EXPECT_MSG_EQ (QueueDisc::InternReason (reason.c_str ()), QueueDisc::INTERNAL_QUEUE_DROP_ID,
+                         "The stored identifier of a reason should be its interned identifier");
+  NS_TEST_EXPECT_MSG_EQ (QueueDisc::GetReasonName (RedQueueDisc::FORCED_DROP_ID), RedQueueDisc::FORCED_DROP,
+                         "The stored identifier of a reason should map back to the reason");
+  NS_TEST_EXPECT_MSG_EQ (st.GetNDroppedPackets (reason), 2, "2 packets should have been dropped by the internal queue");
+  NS_TEST_EXPECT_MSG_EQ (st.nDroppedPacketsBeforeEnqueue.size (), 1, "Packets should have been dropped for a single reason");
+  NS_TEST_EXPECT_MSG_EQ (st.nDroppedBytesBeforeEnqueue[reason], 110 + 111, "The bytes dropped by the internal queue do not match");
+  NS_TEST_EXPECT_MSG_EQ (st.GetNDroppedPackets ("Unknown reason"), 0, "No packet should have been dropped for an unknown reason");
+
+  std::vector<Ptr<QueueDiscItem> > dequeued;
+  NS_TEST_EXPECT_MSG_EQ (queue->DequeueBatch (dequeued, 4), 4, "4 packets should have been dequeued");
+  // the byte limit is exceeded by the third packet (104 + 105 + 106 bytes)
+  NS_TEST_EXPECT_MSG_EQ (queue->DequeueBatch (dequeued, 10, 300), 3, "3 packets should have been dequeued");
+  NS_TEST_EXPECT_MSG_EQ (queue->DequeueBatch (dequeued, 10), 3, "3 packets should have been dequeued");
+  NS_TEST_EXPECT_MSG_EQ (queue->DequeueBatch (dequeued, 10), 0, "No packet should have been dequeued");
+
+  NS_TEST_EXPECT_MSG_EQ (dequeued.size (), 10, "10 packets should have been dequeued");
+  for (uint32_t i = 0; i < dequeued.size (); i++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (dequeued[i], items[i], "The packets should be dequeued in order");
+    }
+
+  st = queue->GetStats ();
+  NS_TEST_EXPECT_MSG_EQ (st.nTotalDequeuedPackets, 10, "10 packets should have been dequeued");
+  NS_TEST_EXPECT_MSG_EQ (queue->GetNPackets (), 0, "There should be no packets in there");
+
+  Simulator::Destroy ();
+}
+
 /**
  * \ingroup traffic-control-test
  * \ingroup tests
@@ -555,5 +680,7 @@ public:
     : TestSuite ("red-queue-disc", UNIT)
   {
     AddTestCase (new RedQueueDiscTestCase (), TestCase::QUICK);
+    AddTestCase (new RedEstimatorTestCase (), TestCase::QUICK);
+    AddTestCase (new RedQueueDiscBatchTestCase (), TestCase::QUICK);
   }
 } g_redQueueTestSuite; ///< the test suite
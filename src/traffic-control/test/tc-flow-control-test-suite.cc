@@ -33,6 +33,7 @@
 #include "ns3/simple-channel.h"
 #include "ns3/drop-tail-queue.h"
 #include "ns3/net-device-queue-interface.h"
+#include "ns3/queue-limits.h"
 #include "ns3/config.h"
 
 using namespace ns3;
@@ -142,6 +143,14 @@ private:
    * \param msg the message to print if a different number of packets are stored
    */
   void CheckPacketsInQueueDisc (Ptr<NetDevice> dev, uint16_t nPackets, const char* msg);
+  /**
+   * Check if the expected number of packets bypassed the queue disc, i.e.,
+   * were sent to the device without being stored in the internal queues
+   * \param dev the device the queue disc is installed on
+   * \param nPackets the expected number of packets that bypassed the queue disc
+   * \param msg the message to print if a different number of packets bypassed the queue disc
+   */
+  void CheckBypassedPackets (Ptr<NetDevice> dev, uint16_t nPackets, const char* msg);
   TestType m_type;       //!< the test type
 };
 
@@ -189,6 +198,21 @@ TcFlowControlTestCase::CheckPacketsInQueueDisc (Ptr<NetDevice> dev, uint16_t nPa
   NS_TEST_EXPECT_MSG_EQ (qdisc->GetNPackets (), nPackets, msg);
 }
 
+void
+TcFlowControlTestCase::CheckBypassedPackets (Ptr<NetDevice> dev, uint16_t nPackets, const char* msg)
+{
+  Ptr<TrafficControlLayer> tc = dev->GetNode ()->GetObject<TrafficControlLayer> ();
+  Ptr<QueueDisc> qdisc = tc->GetRootQueueDiscOnDevice (dev);
+  uint32_t nQueued = 0;
+  for (uint32_t i = 0; i < qdisc->GetNInternalQueues (); i++)
+    {
+      nQueued += qdisc->GetInternalQueue (i)->GetTotalReceivedPackets ();
+    }
+  const QueueDisc::Stats& stats = qdisc->GetStats ();
+  NS_TEST_EXPECT_MSG_EQ (stats.nTotalSentPackets, stats.nTotalReceivedPackets, "All the packets must have been sent");
+  NS_TEST_EXPECT_MSG_EQ (stats.nTotalReceivedPackets - nQueued, nPackets, msg);
+}
+
 
 void
 TcFlowControlTestCase::DoRun (void)
@@ -296,6 +320,10 @@ TcFlowControlTestCase::DoRun (void)
                           this, txDev, false, "The device queue must not be stopped after 81ms");
       Simulator::Schedule (Time (MilliSeconds (81)), &TcFlowControlTestCase::CheckPacketsInQueueDisc,
                           this, txDev, 0, "The queue disc must be empty after 81ms");
+
+      // The packets sent before the device queue was stopped bypassed the queue disc
+      Simulator::Schedule (Time (MilliSeconds (81)), &TcFlowControlTestCase::CheckBypassedPackets,
+                          this, txDev, 6, "6 packets must have bypassed the queue disc");
     }
   else
     {
@@ -377,12 +405,187 @@ TcFlowControlTestCase::DoRun (void)
                           this, txDev, false, "The device queue must not be stopped after 81ms");
       Simulator::Schedule (Time (MilliSeconds (81)), &TcFlowControlTestCase::CheckPacketsInQueueDisc,
                           this, txDev, 0, "The queue disc must be empty after 81ms");
+
+      // The packets sent before the device queue was stopped bypassed the queue disc
+      Simulator::Schedule (Time (MilliSeconds (81)), &TcFlowControlTestCase::CheckBypassedPackets,
+                          this, txDev, 4, "4 packets must have bypassed the queue disc");
     }
 
   Simulator::Run ();
   Simulator::Destroy ();
 }
 
+/**
+ * \ingroup traffic-control-test
+ * \ingroup tests
+ *
+ * \brief Queue limits which never limit the number of bytes
+ */
+class TcUnboundedQueueLimits : public QueueLimits
+{
+public:
+  virtual void Reset ()
+  {
+  }
+  virtual void Completed (uint32_t count)
+  {
+  }
+  virtual int32_t Available () const
+  {
+    return 1000000;
+  }
+  virtual void Queued (uint32_t count)
+  {
+  }
+};
+
+/**
+ * \ingroup traffic-control-test
+ * \ingroup tests
+ *
+ * \brief Traffic Control Burst Requeue Test Case
+ *
+ * The device queue holds 5 packets and has queue limits, so that the queue
+ * disc dequeues all its packets in a burst each time the device queue is
+ * woken up. The device queue is stopped again after the first packet of the
+ * burst, hence the other packets are requeued, and must be transmitted
+ * later on in the order they were sent.
+ */
+class TcBurstRequeueTestCase : public TestCase
+{
+public:
+  TcBurstRequeueTestCase ();
+  virtual ~TcBurstRequeueTestCase ();
+private:
+  virtual void DoRun (void);
+  /**
+   * Send packets through the traffic control layer and record their uids
+   * \param dev the device to send the packets on
+   * \param nPackets the number of packets to send
+   */
+  void SendPackets (Ptr<NetDevice> dev, uint32_t nPackets);
+  /**
+   * Record a packet received by the receiving device
+   * \param dev the device
+   * \param p the packet
+   * \param protocol the protocol
+   * \param from the source address
+   * \param to the destination address
+   * \param type the packet type
+   * \return true
+   */
+  bool Receive (Ptr<NetDevice> dev, Ptr<const Packet> p, uint16_t protocol,
+                const Address &from, const Address &to, NetDevice::PacketType type);
+  /**
+   * Check the number of packets requeued and stored in the queue disc
+   * \param qdisc the queue disc
+   * \param nRequeued the expected number of packets requeued so far
+   * \param nPackets the expected number of packets in the queue disc
+   * \param msg the message to print if the numbers are different
+   */
+  void CheckRequeued (Ptr<QueueDisc> qdisc, uint32_t nRequeued, uint32_t nPackets, const char* msg);
+  std::vector<uint64_t> m_sent;      //!< the uids of the packets, in the order they were sent
+  std::vector<uint64_t> m_received;  //!< the uids of the packets, in the order they were received
+};
+
+TcBurstRequeueTestCase::TcBurstRequeueTestCase ()
+  : TestCase ("Test the requeue of the packets of a burst which cannot be transmitted")
+{
+}
+
+TcBurstRequeueTestCase::~TcBurstRequeueTestCase ()
+{
+}
+
+void
+TcBurstRequeueTestCase::SendPackets (Ptr<NetDevice> dev, uint32_t nPackets)
+{
+  Ptr<TrafficControlLayer> tc = dev->GetNode ()->GetObject<TrafficControlLayer> ();
+  for (uint32_t i = 0; i < nPackets; i++)
+    {
+      Ptr<Packet> p = Create<Packet> (1000);
+      m_sent.push_back (p->GetUid ());
+      tc->Send (dev, Create<QueueDiscTestItem> (p));
+    }
+}
+
+bool
+TcBurstRequeueTestCase::Receive (Ptr<NetDevice> dev, Ptr<const Packet> p, uint16_t protocol,
+                                 const Address &from, const Address &to, NetDevice::PacketType type)
+{
+  m_received.push_back (p->GetUid ());
+  return true;
+}
+
+void
+TcBurstRequeueTestCase::CheckRequeued (Ptr<QueueDisc> qdisc, uint32_t nRequeued, uint32_t nPackets, const char* msg)
+{
+  NS_TEST_EXPECT_MSG_EQ (qdisc->GetStats ().nTotalRequeuedPackets, nRequeued, msg);
+  NS_TEST_EXPECT_MSG_EQ (qdisc->GetNPackets (), nPackets, msg);
+}
+
+void
+TcBurstRequeueTestCase::DoRun (void)
+{
+  NodeContainer n;
+  n.Create (2);
+
+  n.Get (0)->AggregateObject (CreateObject<TrafficControlLayer> ());
+  n.Get (1)->AggregateObject (CreateObject<TrafficControlLayer> ());
+
+  Ptr<Queue<Packet> > queue;
+  queue = CreateObjectWithAttributes<DropTailQueue<Packet> > ("Mode", EnumValue (QueueBase::QUEUE_MODE_PACKETS),
+                                                              "MaxPackets", UintegerValue (5));
+
+  Ptr<SimpleNetDevice> txDev, rxDev;
+  txDev = CreateObjectWithAttributes<SimpleNetDevice> ("TxQueue", PointerValue (queue),
+                                                       "DataRate", DataRateValue (DataRate ("1Mb/s")));
+  rxDev = CreateObject<SimpleNetDevice> ();
+  n.Get (0)->AddDevice (txDev);
+  n.Get (1)->AddDevice (rxDev);
+  Ptr<SimpleChannel> channel = CreateObject<SimpleChannel> ();
+  txDev->SetChannel (channel);
+  rxDev->SetChannel (channel);
+  rxDev->SetPromiscReceiveCallback (MakeCallback (&TcBurstRequeueTestCase::Receive, this));
+
+  txDev->SetMtu (2500);
+
+  TrafficControlHelper tch = TrafficControlHelper::Default ();
+  Ptr<QueueDisc> qdisc = tch.Install (txDev).Get (0);
+  txDev->GetObject<NetDeviceQueueInterface> ()->GetTxQueue (0)->SetQueueLimits (CreateObject<TcUnboundedQueueLimits> ());
+
+  // transmit 10 packets at time 0: 6 packets bypass the queue disc (one is
+  // transmitted, 5 fill the device queue) and 4 are enqueued in the queue disc
+  Simulator::Schedule (Seconds (0), &TcBurstRequeueTestCase::SendPackets, this, txDev, 10);
+  Simulator::Schedule (MilliSeconds (1), &TcBurstRequeueTestCase::CheckRequeued,
+                       this, qdisc, 0, 4, "No packet must have been requeued after 1ms");
+
+  // The transmission of each packet takes 1000B/1Mbps = 8ms. After 8ms, the 4
+  // packets of the queue disc are dequeued in a burst, the first one fills
+  // the device queue and the other 3 are requeued
+  Simulator::Schedule (MilliSeconds (9), &TcBurstRequeueTestCase::CheckRequeued,
+                       this, qdisc, 3, 0, "3 packets of the first burst must have been requeued");
+  // After 16ms, the 3 requeued packets are dequeued in a burst, and 2 of them
+  // are requeued again
+  Simulator::Schedule (MilliSeconds (17), &TcBurstRequeueTestCase::CheckRequeued,
+                       this, qdisc, 5, 0, "2 packets of the second burst must have been requeued");
+  Simulator::Schedule (MilliSeconds (25), &TcBurstRequeueTestCase::CheckRequeued,
+                       this, qdisc, 6, 0, "1 packet of the third burst must have been requeued");
+
+  Simulator::Run ();
+
+  CheckRequeued (qdisc, 6, 0, "No packet must have been requeued after the third burst");
+  const QueueDisc::Stats& stats = qdisc->GetStats ();
+  NS_TEST_EXPECT_MSG_EQ (stats.nTotalSentPackets, 10, "All the packets must have been sent");
+  NS_TEST_ASSERT_MSG_EQ (m_received.size (), m_sent.size (), "All the packets must have been received");
+  for (uint32_t i = 0; i < m_sent.size (); i++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (m_received[i], m_sent[i], "The packets must be received in the order they were sent");
+    }
+
+  Simulator::Destroy ();
+}
+
 /**
  * \ingroup traffic-control-test
  * \ingroup tests
@@ -397,5 +600,6 @@ public:
   {
     AddTestCase (new TcFlowControlTestCase (TcFlowControlTestCase::PACKET_MODE), TestCase::QUICK);
     AddTestCase (new TcFlowControlTestCase (TcFlowControlTestCase::BYTE_MODE), TestCase::QUICK);
+    AddTestCase (new TcBurstRequeueTestCase (), TestCase::QUICK);
   }
 } g_tcFlowControlTestSuite; ///< the test suite
@@ -0,0 +1,174 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+// This program can be used to benchmark the demultiplexing of received
+// segments by Ipv4EndPointDemux, for various numbers of sockets. The
+// sockets are those of a server: a listening socket and one socket per
+// connection, all on the same port. The lookups are done for segments of
+// the established connections and for new connections, which go to the
+// listening socket. A scan of the list of endpoints comparing the
+// four-tuples, as a lower bound of the cost of the former linear lookup,
+// is given for reference.
+// Sample usage:  ./waf --run 'bench-end-point-demux --n=1000000'
+
+#include "ns3/command-line.h"
+#include "ns3/system-wall-clock-ms.h"
+#include "ns3/random-variable-stream.h"
+#include "ns3/ipv4-end-point.h"
+#include "ns3/ipv4-end-point-demux.h"
+#include "ns3/ipv4-interface.h"
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <algorithm>
+#include <stdlib.h> // for exit ()
+
+using namespace ns3;
+
+/**
+ * Find an endpoint by scanning the list of endpoints.
+ *
+ * \param endPoints the list of endpoints
+ * \param daddr the destination address
+ * \param dport the destination port
+ * \param saddr the source address
+ * \param sport the source port
+ * \returns the connection with this four-tuple, or else the listener on the port
+ */
+static Ipv4EndPoint *
+ScanLookup (const Ipv4EndPointDemux::EndPoints &endPoints,
+            Ipv4Address daddr, uint16_t dport, Ipv4Address saddr, uint16_t sport)
+{
+  Ipv4EndPoint *listener = 0;
+  for (Ipv4EndPointDemux::EndPoints::const_iterator i = endPoints.begin (); i != endPoints.end (); i++)
+    {
+      if ((*i)->GetLocalPort () != dport)
+        {
+          continue;
+        }
+      if ((*i)->GetPeerPort () == sport && (*i)->GetPeerAddress () == saddr
+          && (*i)->GetLocalAddress () == daddr)
+        {
+          return *i;
+        }
+      if ((*i)->GetPeerPort () == 0)
+        {
+          listener = *i;
+        }
+    }
+  return listener;
+}
+
+/**
+ * Run the benchmark for a number of connections.
+ *
+ * \param size the number of connections
+ * \param n the number of lookups
+ */
+static void
+runBench (uint32_t size, uint32_t n)
+{
+  Ptr<UniformRandomVariable> rand = CreateObject<UniformRandomVariable> ();
+  rand->SetStream (1);
+  Ptr<Ipv4Interface> interface = CreateObject<Ipv4Interface> ();
+  Ipv4Address local ("10.0.0.1");
+  interface->AddAddress (Ipv4InterfaceAddress (local, Ipv4Mask ("255.255.255.0")));
+
+  SystemWallClockMs time;
+  Ipv4EndPointDemux demux;
+  time.Start ();
+  demux.Allocate (0, 80);
+  for (uint32_t i = 0; i < size; i++)
+    {
+      demux.Allocate (0, local, 80, Ipv4Address (0x0b000000 + i), 1024 + (i % 1024));
+    }
+  uint64_t allocateMs = time.End ();
+
+  // one new connection for every 16 segments
+  std::vector<uint32_t> peers (1024);
+  for (uint32_t i = 0; i < peers.size (); i++)
+    {
+      peers[i] = (i % 16 == 0) ? size + i : rand->GetInteger (0, size - 1);
+    }
+
+  uint64_t nFound = 0;
+  time.Start ();
+  for (uint32_t i = 0; i < n; i++)
+    {
+      uint32_t peer = peers[i & 1023];
+      nFound += demux.Lookup (local, 80, Ipv4Address (0x0b000000 + peer), 1024 + (peer % 1024), interface).size ();
+    }
+  uint64_t demuxMs = time.End ();
+  if (nFound != n)
+    {
+      std::cerr << "Error-- " << nFound << " endpoints found for " << n << " lookups" << std::endl;
+      exit (1);
+    }
+
+  // the scan takes time proportional to the number of connections:
+  // do fewer lookups with many connections, so that the run completes
+  uint32_t nScans = std::min<uint32_t> (n, std::max<uint32_t> (1024, n / std::max<uint32_t> (1, size / 16)));
+  Ipv4EndPointDemux::EndPoints endPoints = demux.GetAllEndPoints ();
+  uint64_t nScanFound = 0;
+  time.Start ();
+  for (uint32_t i = 0; i < nScans; i++)
+    {
+      uint32_t peer = peers[i & 1023];
+      nScanFound += (ScanLookup (endPoints, local, 80, Ipv4Address (0x0b000000 + peer), 1024 + (peer % 1024)) != 0);
+    }
+  uint64_t scanMs = time.End ();
+  if (nScanFound != nScans)
+    {
+      std::cerr << "Error-- " << nScanFound << " endpoints scanned for " << nScans << " lookups" << std::endl;
+      exit (1);
+    }
+
+  std::cout << std::setw (12) << size
+            << std::setw (14) << scanMs * 1e6 / nScans
+            << std::setw (14) << demuxMs * 1e6 / n
+            << std::setw (14) << allocateMs << std::endl;
+}
+
+int main (int argc, char *argv[])
+{
+  uint32_t n = 0;
+  uint32_t maxSize = 65536;
+
+  CommandLine cmd;
+  cmd.Usage ("Benchmark the demultiplexing of segments to the sockets of a server");
+  cmd.AddValue ("n", "number of lookups", n);
+  cmd.AddValue ("max-size", "maximum number of connections", maxSize);
+  cmd.Parse (argc, argv);
+
+  if (n == 0)
+    {
+      std::cerr << "Error-- number of lookups must be specified " <<
+        "by command-line argument --n=(number of lookups)" << std::endl;
+      exit (1);
+    }
+  std::cout << "Running bench-end-point-demux with n=" << n << std::endl;
+  std::cout << std::setw (12) << "sockets"
+            << std::setw (14) << "ns/scan"
+            << std::setw (14) << "ns/demux"
+            << std::setw (14) << "alloc (ms)" << std::endl;
+
+  for (uint32_t size = 16; size <= maxSize; size *= 4)
+    {
+      runBench (size, n);
+    }
+
+  return 0;
+}
@@ -0,0 +1,192 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+// This program can be used to benchmark the lookup of the network routes
+// of Ipv4GlobalRouting, for various routing table sizes. The routes are
+// point-to-point subnets (/30) and LANs (/24), as installed by the global
+// route manager, plus a default route. The linear scan of the list of
+// routes, formerly done for every packet, is compared with the lookup in
+// the Ipv4RouteTrie index. Both must find the same routes. The linear
+// scan is run fewer times on large tables, so that the run completes.
+// Sample usage:  ./waf --run 'bench-global-routing --n=1000000'
+
+#include "ns3/command-line.h"
+#include "ns3/system-wall-clock-ms.h"
+#include "ns3/random-variable-stream.h"
+#include "ns3/ipv4-routing-table-entry.h"
+#include "ns3/ipv4-route-trie.h"
+#include <iostream>
+#include <iomanip>
+#include <list>
+#include <vector>
+#include <algorithm>
+#include <stdlib.h> // for exit ()
+
+using namespace ns3;
+
+/**
+ * Find the routes to an address by scanning a list of routes.
+ *
+ * \param routes the list of routes
+ * \param dest the address
+ * \param found the vector the routes found are appended to
+ */
+static void
+LinearLookup (const std::list<Ipv4RoutingTableEntry *> &routes, Ipv4Address dest,
+              std::vector<Ipv4RoutingTableEntry *> &found)
+{
+  for (std::list<Ipv4RoutingTableEntry *>::const_iterator i = routes.begin ();
+       i != routes.end (); i++)
+    {
+      Ipv4Mask mask = (*i)->GetDestNetworkMask ();
+      Ipv4Address entry = (*i)->GetDestNetwork ();
+      if (mask.IsMatch (dest, entry))
+        {
+          found.push_back (*i);
+        }
+    }
+}
+
+/**
+ * Run the benchmark for a routing table of the given size.
+ *
+ * \param size the number of routes
+ * \param n the number of lookups
+ */
+static void
+runBench (uint32_t size, uint32_t n)
+{
+  Ptr<UniformRandomVariable> rand = CreateObject<UniformRandomVariable> ();
+  rand->SetStream (1);
+
+  std::list<Ipv4RoutingTableEntry *> routes;
+  std::vector<Ipv4Address> dests;
+  for (uint32_t i = 0; i < size - 1; i++)
+    {
+      // one LAN for every 8 point-to-point subnets
+      Ipv4Address network;
+      Ipv4Mask mask;
+      if (i % 8 == 0)
+        {
+          network = Ipv4Address (0x0b000000 + (i << 8));
+          mask = Ipv4Mask ("255.255.255.0");
+        }
+      else
+        {
+          network = Ipv4Address (0x0a000000 + (i << 2));
+          mask = Ipv4Mask ("255.255.255.252");
+        }
+      Ipv4RoutingTableEntry *route = new Ipv4RoutingTableEntry ();
+      *route = Ipv4RoutingTableEntry::CreateNetworkRouteTo (network, mask, Ipv4Address ("1.1.1.1"), i % 4);
+      routes.push_back (route);
+      dests.push_back (Ipv4Address (network.Get () + 1));
+    }
+  Ipv4RoutingTableEntry *route = new Ipv4RoutingTableEntry ();
+  *route = Ipv4RoutingTableEntry::CreateNetworkRouteTo (Ipv4Address ("0.0.0.0"), Ipv4Mask ("0.0.0.0"),
+                                                        Ipv4Address ("1.1.1.1"), 0);
+  routes.push_back (route);
+  dests.push_back (Ipv4Address ("192.168.0.1"));
+
+  std::vector<uint32_t> order (1024);
+  for (uint32_t i = 0; i < order.size (); i++)
+    {
+      order[i] = rand->GetInteger (0, dests.size () - 1);
+    }
+
+  SystemWallClockMs time;
+  Ipv4RouteTrie trie;
+  time.Start ();
+  for (std::list<Ipv4RoutingTableEntry *>::const_iterator i = routes.begin ();
+       i != routes.end (); i++)
+    {
+      trie.Insert ((*i)->GetDestNetwork (), (*i)->GetDestNetworkMask (), *i);
+    }
+  uint64_t buildMs = time.End ();
+
+  // the linear scan takes time proportional to the size of the table:
+  // do fewer lookups on large tables, so that the run completes
+  uint32_t nLinearLookups = std::min<uint32_t> (n, std::max<uint32_t> (1024, n / std::max<uint32_t> (1, size / 16)));
+  std::vector<Ipv4RoutingTableEntry *> found;
+  uint64_t nLinear = 0;
+  time.Start ();
+  for (uint32_t i = 0; i < nLinearLookups; i++)
+    {
+      found.clear ();
+      LinearLookup (routes, dests[order[i & 1023]], found);
+      nLinear += found.size ();
+    }
+  uint64_t linearMs = time.End ();
+
+  uint64_t nTrie = 0;
+  time.Start ();
+  for (uint32_t i = 0; i < n; i++)
+    {
+      found.clear ();
+      trie.Lookup (dests[order[i & 1023]], found);
+      if (i < nLinearLookups)
+        {
+          nTrie += found.size ();
+        }
+    }
+  uint64_t trieMs = time.End ();
+
+  if (nLinear != nTrie)
+    {
+      std::cerr << "Error-- the trie found " << nTrie << " routes instead of " << nLinear << std::endl;
+      exit (1);
+    }
+
+  std::cout << std::setw (12) << size
+            << std::setw (14) << linearMs * 1e6 / nLinearLookups
+            << std::setw (14) << trieMs * 1e6 / n
+            << std::setw (14) << buildMs << std::endl;
+
+  for (std::list<Ipv4RoutingTableEntry *>::iterator i = routes.begin (); i != routes.end (); i++)
+    {
+      delete *i;
+    }
+}
+
+int main (int argc, char *argv[])
+{
+  uint32_t n = 0;
+  uint32_t maxSize = 65536;
+
+  CommandLine cmd;
+  cmd.Usage ("Benchmark the lookup of Ipv4GlobalRouting network routes");
+  cmd.AddValue ("n", "number of lookups", n);
+  cmd.AddValue ("max-size", "maximum number of routes", maxSize);
+  cmd.Parse (argc, argv);
+
+  if (n == 0)
+    {
+      std::cerr << "Error-- number of lookups must be specified " <<
+        "by command-line argument --n=(number of lookups)" << std::endl;
+      exit (1);
+    }
+  std::cout << "Running bench-global-routing with n=" << n << std::endl;
+  std::cout << std::setw (12) << "routes"
+            << std::setw (14) << "ns/linear"
+            << std::setw (14) << "ns/trie"
+            << std::setw (14) << "build (ms)" << std::endl;
+
+  for (uint32_t size = 16; size <= maxSize; size *= 4)
+    {
+      runBench (size, n);
+    }
+
+  return 0;
+}
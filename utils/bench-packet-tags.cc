@@ -0,0 +1,240 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+// This program can be used to benchmark the packet tags, for the patterns
+// of the usual hot paths: the priority tag added by the sockets and removed
+// by the traffic control layer, the tags of the sockets and the flow id tag
+// looked up by the lower layers, copies of tagged packets, and more tags
+// than the ones stored inline in the packet.  It reports the time and the
+// number of heap allocations per packet, counted by replacing the global
+// operator new (see bench-allocations.h); the "none" row is the cost of the
+// packet itself.
+// Sample usage:  ./waf --run 'bench-packet-tags --n=1000000'
+
+#include "ns3/command-line.h"
+#include "ns3/system-wall-clock-ms.h"
+#include "ns3/packet.h"
+#include "ns3/socket.h"
+#include "ns3/flow-id-tag.h"
+#include "bench-allocations.h"
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <cstdlib>
+
+using namespace ns3;
+
+/**
+ * Create a packet without tags.
+ *
+ * \param n the number of packets
+ * \returns the number of packets
+ */
+static uint32_t
+benchNone (uint32_t n)
+{
+  uint32_t nOk = 0;
+  for (uint32_t i = 0; i < n; i++)
+    {
+      Ptr<Packet> p = Create<Packet> (100);
+      nOk += (p->GetSize () == 100);
+    }
+  return nOk;
+}
+
+/**
+ * Add the priority tag, then remove it, as the traffic control layer does.
+ *
+ * \param n the number of packets
+ * \returns the number of tags found
+ */
+static uint32_t
+benchPriority (uint32_t n)
+{
+  uint32_t nOk = 0;
+  for (uint32_t i = 0; i < n; i++)
+    {
+      Ptr<Packet> p = Create<Packet> (100);
+      SocketPriorityTag priorityTag;
+      priorityTag.SetPriority (i & 7);
+      p->AddPacketTag (priorityTag);
+      SocketPriorityTag tag;
+      nOk += p->RemovePacketTag (tag);
+    }
+  return nOk;
+}
+
+/**
+ * Add the tags of a socket and a flow id, look them up and remove some.
+ *
+ * \param n the number of packets
+ * \returns the number of tags found
+ */
+static uint32_t
+benchSocket (uint32_t n)
+{
+  uint32_t nOk = 0;
+  for (uint32_t i = 0; i < n; i++)
+    {
+      Ptr<Packet> p = Create<Packet> (100);
+      SocketIpTtlTag ttlTag;
+      ttlTag.SetTtl (64);
+      p->AddPacketTag (ttlTag);
+      SocketIpTosTag tosTag;
+      tosTag.SetTos (i & 0xff);
+      p->AddPacketTag (tosTag);
+      SocketPriorityTag priorityTag;
+      priorityTag.SetPriority (i & 7);
+      p->AddPacketTag (priorityTag);
+      p->AddPacketTag (FlowIdTag (i));
+
+      SocketPriorityTag priority;
+      nOk += p->RemovePacketTag (priority);
+      nOk += p->RemovePacketTag (ttlTag);
+      nOk += p->RemovePacketTag (tosTag);
+      FlowIdTag flowId;
+      nOk += p->PeekPacketTag (flowId);
+      SocketIpv6HopLimitTag hopLimit;
+      nOk += !p->PeekPacketTag (hopLimit);
+    }
+  return nOk;
+}
+
+/**
+ * Copy a tagged packet, then change the tags of the copy.
+ *
+ * \param n the number of packets
+ * \returns the number of tags found
+ */
+static uint32_t
+benchCopy (uint32_t n)
+{
+  uint32_t nOk = 0;
+  for (uint32_t i = 0; i < n; i++)
+    {
+      Ptr<Packet> p = Create<Packet> (100);
+      SocketPriorityTag priorityTag;
+      priorityTag.SetPriority (i & 7);
+      p->AddPacketTag (priorityTag);
+      p->AddPacketTag (FlowIdTag (i));
+
+      Ptr<Packet> copy = p->Copy ();
+      SocketPriorityTag priority;
+      nOk += copy->RemovePacketTag (priority);
+      FlowIdTag newFlowId (i + 1);
+      nOk += copy->ReplacePacketTag (newFlowId);
+      FlowIdTag flowId;
+      nOk += p->PeekPacketTag (flowId) && flowId.GetFlowId () == i;
+    }
+  return nOk;
+}
+
+/**
+ * Add more tags than the ones stored inline, then copy the packet.
+ *
+ * \param n the number of packets
+ * \returns the number of tags found
+ */
+static uint32_t
+benchOverflow (uint32_t n)
+{
+  uint32_t nOk = 0;
+  for (uint32_t i = 0; i < n; i++)
+    {
+      Ptr<Packet> p = Create<Packet> (100);
+      SocketIpTtlTag ttlTag;
+      ttlTag.SetTtl (64);
+      p->AddPacketTag (ttlTag);
+      SocketIpTosTag tosTag;
+      tosTag.SetTos (i & 0xff);
+      p->AddPacketTag (tosTag);
+      SocketPriorityTag priorityTag;
+      priorityTag.SetPriority (i & 7);
+      p->AddPacketTag (priorityTag);
+      p->AddPacketTag (FlowIdTag (i));
+      SocketIpv6HopLimitTag hopLimitTag;
+      hopLimitTag.SetHopLimit (64);
+      p->AddPacketTag (hopLimitTag);
+      SocketSetDontFragmentTag dontFragmentTag;
+      dontFragmentTag.Enable ();
+      p->AddPacketTag (dontFragmentTag);
+
+      Ptr<Packet> copy = p->Copy ();
+      nOk += copy->RemovePacketTag (ttlTag);
+      nOk += p->PeekPacketTag (ttlTag);
+    }
+  return nOk;
+}
+
+/**
+ * Run a benchmark.
+ *
+ * \param bench the benchmark
+ * \param n the number of packets
+ * \param expected the expected number of tags found per packet
+ * \param name the name of the benchmark
+ */
+static void
+runBench (uint32_t (*bench) (uint32_t), uint32_t n, uint32_t expected, const std::string &name)
+{
+  // warm up the pools of the buffers and the tags
+  bench (1000);
+
+  SystemWallClockMs time;
+  uint64_t nAllocations = GetNAllocations ();
+  time.Start ();
+  uint32_t nOk = bench (n);
+  uint64_t elapsed = time.End ();
+  nAllocations = GetNAllocations () - nAllocations;
+  if (nOk != n * expected)
+    {
+      std::cerr << "Error-- " << name << ": " << nOk << " tags found instead of "
+                << n * expected << std::endl;
+      exit (1);
+    }
+  std::cout << std::setw (12) << name
+            << std::setw (14) << elapsed * 1e6 / n
+            << std::setw (14) << (double) nAllocations / n << std::endl;
+}
+
+int main (int argc, char *argv[])
+{
+  uint32_t n = 0;
+
+  CommandLine cmd;
+  cmd.Usage ("Benchmark the packet tags of the usual hot paths");
+  cmd.AddValue ("n", "number of packets", n);
+  cmd.Parse (argc, argv);
+
+  if (n == 0)
+    {
+      std::cerr << "Error-- number of packets must be specified " <<
+        "by command-line argument --n=(number of packets)" << std::endl;
+      exit (1);
+    }
+  std::cout << "Running bench-packet-tags with n=" << n << std::endl;
+  std::cout << std::setw (12) << "pattern"
+            << std::setw (14) << "ns/packet"
+            << std::setw (14) << "allocs/packet" << std::endl;
+
+  runBench (&benchNone, n, 1, "none");
+  runBench (&benchPriority, n, 1, "priority");
+  runBench (&benchSocket, n, 5, "socket");
+  runBench (&benchCopy, n, 3, "copy");
+  runBench (&benchOverflow, n, 2, "overflow");
+
+  return 0;
+}
@@ -26,6 +26,7 @@
 #include "ns3/system-wall-clock-ms.h"
 #include "ns3/packet.h"
 #include "ns3/packet-metadata.h"
+#include "ns3/packet-data-pool.h"
 #include <iostream>
 #include <sstream>
 #include <string>
@@ -362,12 +363,14 @@ int main (int argc, char *argv[])
   uint32_t n = 0;
   uint32_t minIterations = 1;
   bool enablePrinting = false;
+  bool pool = true;
 
   CommandLine cmd;
   cmd.Usage ("Benchmark Packet class");
   cmd.AddValue ("n", "number of iterations", n);
   cmd.AddValue ("min-iterations", "number of subiterations to minimize iteration time over", minIterations);
   cmd.AddValue ("enable-printing", "enable packet printing", enablePrinting);
+  cmd.AddValue ("pool", "allocate the packet data from the pool (default true)", pool);
   cmd.Parse (argc, argv);
 
   if (n == 0)
@@ -378,6 +381,7 @@ int main (int argc, char *argv[])
     }
   std::cout << "Running bench-packets with n=" << n << std::endl;
   std::cout << "All tests begin by adding UDP and IPv4 headers." << std::endl;
+  PacketDataPool::EnablePool (pool);
 
   runBench (&benchA, n, minIterations, "Copy packet, remove headers");
   runBench (&benchB, n, minIterations, "Just add headers");
@@ -385,6 +389,7 @@ int main (int argc, char *argv[])
   runBench (&benchD, n, minIterations, "Intermixed add/remove headers and tags");
   runBench (&benchFragment, n, minIterations, "Fragmentation and concatenation");
   runBench (&benchByteTags, n, minIterations, "Benchmark byte tags");
+  std::cout << "Packet data pool: " << PacketDataPool::GetStatistics () << std::endl;
 
   return 0;
 }
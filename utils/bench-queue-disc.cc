@@ -0,0 +1,374 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2017 NITK Surathkal
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+// This program can be used to benchmark the enqueue and dequeue operations
+// of queue discs, for various queue limits. Synthetic items, classified by
+// a flow identifier chosen at random among 'flows' flows, are pushed through
+// a queue disc kept filled up to the given fraction of its limit. The time
+// and the number of heap allocations per enqueued item are reported. CHOKe
+// is also benchmarked against the number of victims drawn for each packet.
+// With --estimator, the average queue size estimator of the RED family is
+// compared with a direct computation of the decay factor by std::pow.
+// Sample usage:  ./waf --run 'bench-queue-disc --n=1000000'
+//                ./waf --run 'bench-queue-disc --n=1000000 --queue-disc=RED'
+//                ./waf --run 'bench-queue-disc --n=1000000 --estimator'
+
+#include "ns3/command-line.h"
+#include "ns3/system-wall-clock-ms.h"
+#include "ns3/packet.h"
+#include "ns3/uinteger.h"
+#include "ns3/double.h"
+#include "ns3/string.h"
+#include "ns3/object-factory.h"
+#include "ns3/random-variable-stream.h"
+#include "ns3/queue-disc.h"
+#include "ns3/packet-filter.h"
+#include "ns3/red-estimator.h"
+#include "bench-allocations.h"
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <stdlib.h> // for exit ()
+#include <limits>
+#include <algorithm>
+#include <cmath>
+
+using namespace ns3;
+
+/// BenchItem class, a queue disc item carrying the identifier of its flow
+class BenchItem : public QueueDiscItem
+{
+public:
+  /**
+   * Constructor
+   *
+   * \param p packet
+   * \param flow the flow identifier
+   */
+  BenchItem (Ptr<Packet> p, uint32_t flow);
+  virtual ~BenchItem ();
+  virtual void AddHeader (void);
+  virtual bool Mark (void);
+  /**
+   * \return the flow identifier
+   */
+  uint32_t GetFlow (void) const;
+private:
+  uint32_t m_flow; ///< the flow identifier
+};
+
+BenchItem::BenchItem (Ptr<Packet> p, uint32_t flow)
+  : QueueDiscItem (p, Address (), 0),
+    m_flow (flow)
+{
+}
+
+BenchItem::~BenchItem ()
+{
+}
+
+void
+BenchItem::AddHeader (void)
+{
+}
+
+bool
+BenchItem::Mark (void)
+{
+  return false;
+}
+
+uint32_t
+BenchItem::GetFlow (void) const
+{
+  return m_flow;
+}
+
+/// BenchFilter class, a packet filter returning the flow identifier of a BenchItem
+class BenchFilter : public PacketFilter
+{
+public:
+  /**
+   * Register this type.
+   * \return The TypeId.
+   */
+  static TypeId GetTypeId (void);
+private:
+  virtual bool CheckProtocol (Ptr<QueueDiscItem> item) const;
+  virtual int32_t DoClassify (Ptr<QueueDiscItem> item) const;
+};
+
+TypeId
+BenchFilter::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::BenchFilter")
+    .SetParent<PacketFilter> ()
+    .SetGroupName ("TrafficControl")
+    .AddConstructor<BenchFilter> ()
+  ;
+  return tid;
+}
+
+bool
+BenchFilter::CheckProtocol (Ptr<QueueDiscItem> item) const
+{
+  return true;
+}
+
+int32_t
+BenchFilter::DoClassify (Ptr<QueueDiscItem> item) const
+{
+  return StaticCast<BenchItem> (item)->GetFlow ();
+}
+
+/**
+ * Create and initialize a queue disc.
+ *
+ * \param type the TypeId name of the queue disc
+ * \param limit the queue limit, in packets
+ * \param draws the number of victims drawn by CHOKe for each packet
+ * \return the queue disc
+ */
+static Ptr<QueueDisc>
+CreateQueueDisc (std::string type, uint32_t limit, uint32_t draws)
+{
+  ObjectFactory factory;
+  factory.SetTypeId (type);
+  if (type == "ns3::RedQueueDisc")
+    {
+      // keep the average queue size between the thresholds
+      factory.Set ("QueueLimit", UintegerValue (limit));
+      factory.Set ("QW", DoubleValue (1));
+      factory.Set ("MinTh", DoubleValue (1));
+      factory.Set ("MaxTh", DoubleValue (2 * limit));
+    }
+  else if (type == "ns3::ChokeQueueDisc")
+    {
+      // keep the average queue size between the thresholds, so that a random
+      // victim is drawn for every arriving packet and forced drops never occur
+      factory.Set ("QueueLimit", UintegerValue (limit));
+      factory.Set ("QW", DoubleValue (1));
+      factory.Set ("MinTh", DoubleValue (1));
+      factory.Set ("MaxTh", DoubleValue (2 * limit));
+      factory.Set ("NumDraws", UintegerValue (draws));
+    }
+  Ptr<QueueDisc> qd = factory.Create<QueueDisc> ();
+  if (type == "ns3::ChokeQueueDisc")
+    {
+      qd->AddPacketFilter (CreateObject<BenchFilter> ());
+    }
+  qd->Initialize ();
+  return qd;
+}
+
+/**
+ * Run the benchmark on a queue disc.
+ *
+ * \param qd the queue disc
+ * \param n the number of packets to enqueue
+ * \param depth the number of packets to keep in the queue disc
+ * \param flows the number of flows
+ * \param nAllocations set to the number of heap allocations
+ * \return the elapsed time in milliseconds
+ */
+static uint64_t
+runBenchOneIteration (Ptr<QueueDisc> qd, uint32_t n, uint32_t depth, uint32_t flows,
+                      uint64_t &nAllocations)
+{
+  Ptr<UniformRandomVariable> flow = CreateObject<UniformRandomVariable> ();
+  flow->SetStream (1);
+  Ptr<Packet> p = Create<Packet> (1000);
+  std::vector<Ptr<QueueDiscItem> > items;
+  for (uint32_t i = 0; i < n; i++)
+    {
+      items.push_back (Create<BenchItem> (p, flow->GetInteger (0, flows - 1)));
+    }
+
+  // fill the queue disc up to the given depth
+  for (uint32_t i = 0; i < depth; i++)
+    {
+      qd->Enqueue (Create<BenchItem> (p, flow->GetInteger (0, flows - 1)));
+    }
+
+  SystemWallClockMs time;
+  uint64_t allocationsBefore = GetNAllocations ();
+  time.Start ();
+  for (uint32_t i = 0; i < n; i++)
+    {
+      qd->Enqueue (items[i]);
+      while (qd->GetNPackets () > depth)
+        {
+          qd->Dequeue ();
+        }
+    }
+  uint64_t deltaMs = time.End ();
+  nAllocations = GetNAllocations () - allocationsBefore;
+
+  while (qd->Dequeue ())
+    {
+    }
+  return deltaMs;
+}
+
+/**
+ * Run the benchmark on a queue disc for a range of queue limits.
+ *
+ * \param type the TypeId name of the queue disc
+ * \param n the number of packets to enqueue
+ * \param minIterations number of subiterations to minimize iteration time over
+ * \param flows the number of flows
+ * \param fill the fraction of the queue limit kept occupied
+ * \param draws the number of victims drawn by CHOKe for each packet
+ */
+static void
+runBench (std::string type, uint32_t n, uint32_t minIterations, uint32_t flows, double fill,
+          uint32_t draws = 1)
+{
+  std::cout << type << " (draws=" << draws << ")" << std::endl;
+  std::cout << std::setw (12) << "QueueLimit"
+            << std::setw (12) << "depth"
+            << std::setw (14) << "ns/enqueue"
+            << std::setw (14) << "allocs/enq"
+            << std::setw (14) << "drops" << std::endl;
+
+  for (uint32_t limit = 64; limit <= 16384; limit *= 4)
+    {
+      uint32_t depth = std::max<uint32_t> (2, limit * fill);
+      uint64_t minDelay = std::numeric_limits<uint64_t>::max ();
+      uint32_t drops = 0;
+      uint64_t nAllocations = 0;
+      for (uint32_t i = 0; i < minIterations; i++)
+        {
+          Ptr<QueueDisc> qd = CreateQueueDisc (type, limit, draws);
+          minDelay = std::min (minDelay, runBenchOneIteration (qd, n, depth, flows, nAllocations));
+          drops = qd->GetStats ().nTotalDroppedPackets;
+          qd->Dispose ();
+        }
+      std::cout << std::setw (12) << limit
+                << std::setw (12) << depth
+                << std::setw (14) << minDelay * 1e6 / n
+                << std::setw (14) << static_cast<double> (nAllocations) / n
+                << std::setw (14) << drops << std::endl;
+    }
+}
+
+/**
+ * Run the benchmark on the average queue size estimator, for various
+ * numbers of arrivals since the last update.
+ *
+ * \param n the number of updates of the average queue size
+ */
+static void
+runEstimatorBench (uint32_t n)
+{
+  std::cout << "Average queue size estimator" << std::endl;
+  std::cout << std::setw (12) << "m"
+            << std::setw (14) << "ns/pow"
+            << std::setw (14) << "ns/estimator" << std::endl;
+
+  double qW = 0.002;
+  uint32_t gaps[] = { 1, 10, 100, 10000 };
+  for (uint32_t g = 0; g < sizeof (gaps) / sizeof (gaps[0]); g++)
+    {
+      // let m vary around the given value, so that it cannot be hoisted
+      std::vector<uint32_t> m (1024);
+      for (uint32_t i = 0; i < m.size (); i++)
+        {
+          m[i] = gaps[g] + i % 3;
+        }
+
+      SystemWallClockMs time;
+      double qAvg = 0;
+      time.Start ();
+      for (uint32_t i = 0; i < n; i++)
+        {
+          qAvg = qAvg * std::pow (1.0 - qW, m[i & 1023]) + qW * (i & 255);
+        }
+      uint64_t powMs = time.End ();
+      double powAvg = qAvg;
+
+      RedEstimator estimator;
+      qAvg = 0;
+      time.Start ();
+      for (uint32_t i = 0; i < n; i++)
+        {
+          qAvg = estimator.Estimate (i & 255, m[i & 1023], qAvg, qW);
+        }
+      uint64_t estimatorMs = time.End ();
+
+      std::cout << std::setw (12) << gaps[g]
+                << std::setw (14) << powMs * 1e6 / n
+                << std::setw (14) << estimatorMs * 1e6 / n;
+      // print the averages to prevent the loops from being optimized out
+      std::cout << "   (qAvg " << powAvg << " / " << qAvg << ")" << std::endl;
+    }
+}
+
+int main (int argc, char *argv[])
+{
+  uint32_t n = 0;
+  uint32_t minIterations = 1;
+  uint32_t flows = 1000;
+  double fill = 0.5;
+  uint32_t maxDraws = 8;
+  std::string queueDisc = "CHOKe";
+  bool estimator = false;
+
+  CommandLine cmd;
+  cmd.Usage ("Benchmark QueueDisc enqueue/dequeue operations");
+  cmd.AddValue ("n", "number of packets", n);
+  cmd.AddValue ("min-iterations", "number of subiterations to minimize iteration time over", minIterations);
+  cmd.AddValue ("flows", "number of flows", flows);
+  cmd.AddValue ("fill", "fraction of the queue limit kept occupied", fill);
+  cmd.AddValue ("queue-disc", "the queue disc to benchmark (CHOKe or RED)", queueDisc);
+  cmd.AddValue ("estimator", "benchmark the average queue size estimator instead", estimator);
+  cmd.AddValue ("max-draws", "maximum number of victims drawn by CHOKe for each packet", maxDraws);
+  cmd.Parse (argc, argv);
+
+  if (n == 0)
+    {
+      std::cerr << "Error-- number of packets must be specified " <<
+        "by command-line argument --n=(number of packets)" << std::endl;
+      exit (1);
+    }
+  std::cout << "Running bench-queue-disc with n=" << n << " and " << flows << " flows" << std::endl;
+
+  if (estimator)
+    {
+      runEstimatorBench (n);
+    }
+  else if (queueDisc == "RED")
+    {
+      runBench ("ns3::RedQueueDisc", n, minIterations, flows, fill);
+    }
+  else if (queueDisc == "CHOKe")
+    {
+      for (uint32_t draws = 1; draws <= maxDraws; draws *= 2)
+        {
+          runBench ("ns3::ChokeQueueDisc", n, minIterations, flows, fill, draws);
+        }
+    }
+  else
+    {
+      std::cerr << "Error-- unknown queue disc " << queueDisc << std::endl;
+      exit (1);
+    }
+
+  return 0;
+}
@@ -145,59 +145,152 @@ Bench::Cb (void)
 }
 
 
-Ptr<RandomVariableStream>
-GetRandomStream (std::string filename)
+/**
+ * Read the relative event times from a file
+ * \param filename the file name, "-" for standard input, or "" for none
+ * \return the event times in ns, or an empty vector if filename is ""
+ */
+std::vector<double>
+ReadDistribution (std::string filename)
 {
-  Ptr<RandomVariableStream> stream = 0;
+  std::vector<double> nsValues;
 
   if (filename == "")
     {
       LOGME ("using default exponential distribution");
-      Ptr<ExponentialRandomVariable> erv = CreateObject<ExponentialRandomVariable> ();
-      erv->SetAttribute ("Mean", DoubleValue (100));
-      stream = erv;
+      return nsValues;
+    }
+
+  std::istream *input;
+
+  if (filename == "-")
+    {
+      LOGME ("using event distribution from stdin");
+      input = &std::cin;
     }
   else
     {
-      std::istream *input;
+      LOGME ("using event distribution from " << filename);
+      input = new std::ifstream (filename.c_str ());
+    }
+
+  double value;
 
-      if (filename == "-")
+  while (!input->eof ())
+    {
+      if (*input >> value)
         {
-          LOGME ("using event distribution from stdin");
-          input = &std::cin;
+          uint64_t ns = (uint64_t) (value * 1000000000);
+          nsValues.push_back (ns);
         }
       else
         {
-          LOGME ("using event distribution from " << filename);
-          input = new std::ifstream (filename.c_str ());
+          input->clear ();
+          std::string line;
+          *input >> line;
         }
+    }
+  LOGME ("found " << nsValues.size () << " entries");
+
+  if (input != &std::cin)
+    {
+      delete input;
+    }
+  return nsValues;
+}
 
-      double value;
-      std::vector<double> nsValues;
+/**
+ * Create a stream of event times. Every stream created from the same
+ * values returns the same sequence, so that all the schedulers are
+ * benchmarked against the same events.
+ * \param nsValues the event times in ns, or an empty vector to use an
+ *        exponential distribution
+ * \return the stream
+ */
+Ptr<RandomVariableStream>
+GetRandomStream (const std::vector<double> &nsValues)
+{
+  Ptr<RandomVariableStream> stream = 0;
 
-      while (!input->eof ())
-        {
-          if (*input >> value)
-            {
-              uint64_t ns = (uint64_t) (value * 1000000000);
-              nsValues.push_back (ns);
-            }
-          else
-            {
-              input->clear ();
-              std::string line;
-              *input >> line;
-            }
-        }
-      LOGME ("found " << nsValues.size () << " entries");
+  if (nsValues.empty ())
+    {
+      Ptr<ExponentialRandomVariable> erv = CreateObject<ExponentialRandomVariable> ();
+      erv->SetAttribute ("Mean", DoubleValue (100));
+      erv->SetStream (1);
+      stream = erv;
+    }
+  else
+    {
       Ptr<DeterministicRandomVariable> drv = CreateObject<DeterministicRandomVariable> ();
-      drv->SetValueArray (&nsValues[0], nsValues.size ());
+      drv->SetValueArray (const_cast<double *> (&nsValues[0]), nsValues.size ());
       stream = drv;
     }
 
   return stream;
 }
 
+/**
+ * Benchmark a scheduler
+ * \param scheduler the TypeId name of the scheduler
+ * \param nsValues the event times in ns, or an empty vector to use an
+ *        exponential distribution
+ * \param pop the event population size
+ * \param total the total number of events to run
+ * \param runs the number of runs
+ */
+void
+BenchScheduler (std::string scheduler, const std::vector<double> &nsValues,
+                uint32_t pop, uint32_t total, uint32_t runs)
+{
+  ObjectFactory factory (scheduler);
+  Simulator::SetScheduler (factory);
+
+  LOGME ("scheduler: " << factory.GetTypeId ().GetName ());
+
+  Bench *bench = new Bench (pop, total);
+  bench->SetRandomStream (GetRandomStream (nsValues));
+
+  // table header
+  LOG ("");
+  LOG (std::left << std::setw (g_fwidth) << "Run #" <<
+       std::left << std::setw (3 * g_fwidth) << "Inititialization:" <<
+       std::left << std::setw (3 * g_fwidth) << "Simulation:");
+  LOG (std::left << std::setw (g_fwidth) << "" <<
+       std::left << std::setw (g_fwidth) << "Time (s)" <<
+       std::left << std::setw (g_fwidth) << "Rate (ev/s)" <<
+       std::left << std::setw (g_fwidth) << "Per (s/ev)" <<
+       std::left << std::setw (g_fwidth) << "Time (s)" <<
+       std::left << std::setw (g_fwidth) << "Rate (ev/s)" <<
+       std::left << std::setw (g_fwidth) << "Per (s/ev)" );
+  LOG (std::setfill ('-') <<
+       std::right << std::setw (g_fwidth) << " " <<
+       std::right << std::setw (g_fwidth) << " " <<
+       std::right << std::setw (g_fwidth) << " " <<
+       std::right << std::setw (g_fwidth) << " " <<
+       std::right << std::setw (g_fwidth) << " " <<
+       std::right << std::setw (g_fwidth) << " " <<
+       std::right << std::setw (g_fwidth) << " " <<
+       std::setfill (' ')
+       );
+
+  // prime
+  DEB ("priming");
+  std::cout << std::left << std::setw (g_fwidth) << "(prime)";
+  bench->RunBench ();
+
+  bench->SetPopulation (pop);
+  bench->SetTotal (total);
+  for (uint32_t i = 0; i < runs; i++)
+    {
+      std::cout << std::setw (g_fwidth) << i;
+
+      bench->RunBench ();
+    }
+
+  LOG ("");
+  Simulator::Destroy ();
+  delete bench;
+}
 
 
 int main (int argc, char *argv[])
@@ -207,6 +300,9 @@ int main (int argc, char *argv[])
   bool schedHeap = false;
   bool schedList = false;
   bool schedMap  = true;
+  bool schedDary = false;
+  bool schedAll  = false;
+  bool pool      = true;
 
   uint32_t pop   =  100000;
   uint32_t total = 1000000;
@@ -221,11 +317,16 @@ int main (int argc, char *argv[])
              "  an ascii file, given by the --file=\"<filename>\" argument,\n"
              "  or standard input, by the argument --file=\"-\"\n"
              "In the case of either --file form, the input is expected\n"
-             "to be ascii, giving the relative event times in ns.");
+             "to be ascii, giving the relative event times in ns.\n"
+             "With --all, the same event times are replayed against\n"
+             "every scheduler.");
   cmd.AddValue ("cal",   "use CalendarSheduler",          schedCal);
   cmd.AddValue ("heap",  "use HeapScheduler",             schedHeap);
   cmd.AddValue ("list",  "use ListSheduler",              schedList);
   cmd.AddValue ("map",   "use MapScheduler (default)",    schedMap);
+  cmd.AddValue ("dary",  "use DaryHeapScheduler",         schedDary);
+  cmd.AddValue ("all",   "benchmark all the schedulers",  schedAll);
+  cmd.AddValue ("pool",  "allocate events from the event pools (default true)", pool);
   cmd.AddValue ("debug", "enable debugging output",       g_debug);
   cmd.AddValue ("pop",   "event population size (default 1E5)",         pop);
   cmd.AddValue ("total", "total number of events to run (default 1E6)", total);
@@ -236,71 +337,52 @@ int main (int argc, char *argv[])
   g_me = cmd.GetName () + ": ";
   g_fwidth += 6;  // 5 extra chars in '2.000002e+07 ': . e+0 _
 
-  ObjectFactory factory ("ns3::MapScheduler");
-  if (schedCal)
+  std::vector<std::string> schedulers;
+  if (schedAll)
     {
-      factory.SetTypeId ("ns3::CalendarScheduler");
+      schedulers.push_back ("ns3::MapScheduler");
+      schedulers.push_back ("ns3::ListScheduler");
+      schedulers.push_back ("ns3::HeapScheduler");
+      schedulers.push_back ("ns3::CalendarScheduler");
+      schedulers.push_back ("ns3::DaryHeapScheduler");
     }
-  if (schedHeap)
+  else if (schedCal)
     {
-      factory.SetTypeId ("ns3::HeapScheduler");
+      schedulers.push_back ("ns3::CalendarScheduler");
     }
-  if (schedList)
+  else if (schedHeap)
     {
-      factory.SetTypeId ("ns3::ListScheduler");
+      schedulers.push_back ("ns3::HeapScheduler");
     }
-  Simulator::SetScheduler (factory);
+  else if (schedList)
+    {
+      schedulers.push_back ("ns3::ListScheduler");
+    }
+  else if (schedDary)
+    {
+      schedulers.push_back ("ns3::DaryHeapScheduler");
+    }
+  else
+    {
+      schedulers.push_back ("ns3::MapScheduler");
+    }
+  EventImpl::EnablePool (pool);
 
   LOGME (std::setprecision (g_fwidth - 6));
   DEB ("debugging is ON");
 
-  LOGME ("scheduler: " << factory.GetTypeId ().GetName ());
+  LOGME ("event pools: " << (pool ? "enabled" : "disabled"));
   LOGME ("population: " << pop);
   LOGME ("total events: " << total);
   LOGME ("runs: " << runs);
 
-  Bench *bench = new Bench (pop, total);
-  bench->SetRandomStream (GetRandomStream (filename));
-
-  // table header
-  LOG ("");
-  LOG (std::left << std::setw (g_fwidth) << "Run #" <<
-       std::left << std::setw (3 * g_fwidth) << "Inititialization:" <<
-       std::left << std::setw (3 * g_fwidth) << "Simulation:");
-  LOG (std::left << std::setw (g_fwidth) << "" <<
-       std::left << std::setw (g_fwidth) << "Time (s)" <<
-       std::left << std::setw (g_fwidth) << "Rate (ev/s)" <<
-       std::left << std::setw (g_fwidth) << "Per (s/ev)" <<
-       std::left << std::setw (g_fwidth) << "Time (s)" <<
-       std::left << std::setw (g_fwidth) << "Rate (ev/s)" <<
-       std::left << std::setw (g_fwidth) << "Per (s/ev)" );
-  LOG (std::setfill ('-') <<
-       std::right << std::setw (g_fwidth) << " " <<
-       std::right << std::setw (g_fwidth) << " " <<
-       std::right << std::setw (g_fwidth) << " " <<
-       std::right << std::setw (g_fwidth) << " " <<
-       std::right << std::setw (g_fwidth) << " " <<
-       std::right << std::setw (g_fwidth) << " " <<
-       std::right << std::setw (g_fwidth) << " " <<
-       std::setfill (' ')
-       );
-
-  // prime
-  DEB ("priming");
-  std::cout << std::left << std::setw (g_fwidth) << "(prime)";
-  bench->RunBench ();
+  std::vector<double> nsValues = ReadDistribution (filename);
 
-  bench->SetPopulation (pop);
-  bench->SetTotal (total);
-  for (uint32_t i = 0; i < runs; i++)
+  for (std::vector<std::string>::const_iterator it = schedulers.begin ();
+       it != schedulers.end (); it++)
     {
-      std::cout << std::setw (g_fwidth) << i;
-
-      bench->RunBench ();
+      BenchScheduler (*it, nsValues, pop, total, runs);
     }
 
-  LOG ("");
-  Simulator::Destroy ();
-  delete bench;
   return 0;
 }
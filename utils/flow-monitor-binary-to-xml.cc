@@ -0,0 +1,86 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+// This program converts the results written by FlowMonitor in binary
+// format (FlowMonitor::SerializeToBinaryFile or the snapshots of
+// FlowMonitor::StartBinarySnapshots) to the XML format of
+// FlowMonitor::SerializeToXmlFile, so that they can be processed by
+// the existing scripts (e.g., flowmon-parse-results.py). With --summary,
+// it only prints the number of snapshots and flows read.
+// Sample usage:  ./waf --run 'flow-monitor-binary-to-xml --input=flows.bin --output=flows.xml'
+
+#include "ns3/command-line.h"
+#include "ns3/flow-monitor-binary-reader.h"
+#include <iostream>
+#include <fstream>
+#include <stdlib.h> // for exit ()
+
+using namespace ns3;
+
+int main (int argc, char *argv[])
+{
+  std::string input;
+  std::string output;
+  bool histograms = true;
+  bool summary = false;
+
+  CommandLine cmd;
+  cmd.Usage ("Convert the results of FlowMonitor from binary to XML format");
+  cmd.AddValue ("input", "name of the binary file", input);
+  cmd.AddValue ("output", "name of the XML file (standard output if empty)", output);
+  cmd.AddValue ("histograms", "include the histograms in the XML file", histograms);
+  cmd.AddValue ("summary", "only print the number of snapshots and flows", summary);
+  cmd.Parse (argc, argv);
+
+  if (input.empty ())
+    {
+      std::cerr << "Error-- the binary file must be specified " <<
+        "by command-line argument --input=(file name)" << std::endl;
+      exit (1);
+    }
+
+  FlowMonitorBinaryReader reader;
+  if (!reader.ReadFile (input))
+    {
+      std::cerr << "Error-- " << input << " is not a complete FlowMonitor binary file" << std::endl;
+      exit (1);
+    }
+
+  if (summary)
+    {
+      std::cout << reader.GetNSnapshots () << " snapshots up to "
+                << reader.GetLastSnapshotTime ().GetSeconds () << " s, "
+                << reader.GetFlowStats ().size () << " flows, "
+                << reader.GetIpv4Flows ().size () << " IPv4 flows, "
+                << reader.GetIpv6Flows ().size () << " IPv6 flows" << std::endl;
+      return 0;
+    }
+
+  if (output.empty ())
+    {
+      std::cout << "<?xml version=\"1.0\" ?>\n";
+      reader.SerializeToXmlStream (std::cout, 0, histograms);
+    }
+  else
+    {
+      std::ofstream os (output.c_str (), std::ios::out|std::ios::binary);
+      os << "<?xml version=\"1.0\" ?>\n";
+      reader.SerializeToXmlStream (os, 0, histograms);
+      os.close ();
+    }
+
+  return 0;
+}